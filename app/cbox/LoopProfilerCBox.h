@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Values.h"
+#include "ProcessObserver.h"
+#include "LoopProfiler.h"
+
+#if BREWPI_PROFILING && CONTROLBOX_PROFILING
+
+/**
+ * Exposes the loop profiler as a read-only value in the system container, and feeds it the time each
+ * controlbox object takes to prepare and update.
+ *
+ * Stream layout, all multi-byte values little endian:
+ * - loop period: max micros (4 bytes), then the histogram (TimingHistogram::BUCKETS x 2 bytes)
+ * - pwm edge lateness: max millis (4 bytes), then the histogram
+ * - number of objects with an entry (1 byte)
+ * - for each of the PROFILER_MAX_OBJECTS entries: phase (1 byte) and max micros (4 bytes).
+ *   Entries are in the order the objects were first processed, which is the container order.
+ *   Unused entries are zero.
+ */
+class LoopProfilerCBox : public Value, public ProcessObserver {
+
+    static const uint8_t HISTOGRAM_SIZE = 4 + 2 * TimingHistogram::BUCKETS;
+    static const uint16_t STREAM_SIZE = 2 * HISTOGRAM_SIZE + 1 + 5 * PROFILER_MAX_OBJECTS;
+    static_assert(STREAM_SIZE < 256, "profiler stream does not fit in a value");
+
+    static void write32(DataOut& out, uint32_t v) {
+        out.write(v & 0xFF);
+        out.write((v >> 8) & 0xFF);
+        out.write((v >> 16) & 0xFF);
+        out.write(v >> 24);
+    }
+
+    static void writeHistogram(DataOut& out, const TimingHistogram& h) {
+        write32(out, h.max());
+        for (uint8_t i = 0; i < TimingHistogram::BUCKETS; i++) {
+            out.write(h.bucket(i) & 0xFF);
+            out.write(h.bucket(i) >> 8);
+        }
+    }
+
+public:
+    uint32_t micros() override {
+        return ticks.micros();
+    }
+
+    void processed(Object* o, ProcessPhase phase, uint32_t micros) override {
+        profiler.record(o, phase == ProcessPhase::prepare ? ProfilePhase::Prepare : ProfilePhase::Update, micros);
+    }
+
+    void readTo(DataOut& out) override {
+        writeHistogram(out, profiler.loopPeriods());
+        writeHistogram(out, profiler.pwmLateness());
+        out.write(profiler.entryCount());
+        for (uint8_t i = 0; i < PROFILER_MAX_OBJECTS; i++) {
+            if (i < profiler.entryCount()) {
+                const LoopProfiler::Entry& e = profiler.entry(i);
+                out.write(uint8_t(e.phase));
+                write32(out, e.micros.max());
+            } else {
+                out.write(0);
+                write32(out, 0);
+            }
+        }
+    }
+
+    uint8_t readStreamSize() override {
+        return STREAM_SIZE;
+    }
+};
+
+#endif
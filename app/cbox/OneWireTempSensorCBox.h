@@ -20,12 +20,19 @@ class OneWireTempSensorCBox : public WritableValue {
 
 public:
 
+	/**
+	 * Starts a conversion on all sensors on the bus. Only the first sensor on the bus sends the request,
+	 * the others wait for the same conversion, so the loop waits for the slowest sensor only.
+	 */
 	virtual prepare_t prepare() override {
-		// this works, but is kind of backwards, since the sensor caches the current value, and then
-		// sends a conversion request. It would be clearer if there is a
-		// separate "prepare" phase and then a fetch phase (which is the model expected here.)
+		return sensor.requestConversion();
+	}
+
+	/**
+	 * Fetches the converted value. The first sensor on the bus reads back all sensors.
+	 */
+	virtual void update() override {
 		sensor.update();
-		return 750;
 	}
 
 	 /**
@@ -26,6 +26,10 @@ INCLUDE_DIRS += $(SOURCE_PATH)/app
 
 INCLUDE_DIRS += $(BOOST_ROOT)
 
+# set PROFILING=1 to time the control loop, the results are readable from the system container
+PROFILING ?= 0
+CFLAGS += -DBREWPI_PROFILING=$(PROFILING) -DCONTROLBOX_PROFILING=$(PROFILING)
+
 CSRC += $(call target_files,app/cbox,*.c)
 CPPSRC += $(call target_files,app/cbox,*.cpp)
 
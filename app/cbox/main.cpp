@@ -1,6 +1,7 @@
 
 #include "OneWireBusCBox.h"
 #include "OneWireTempSensorCBox.h"
+#include "LoopProfilerCBox.h"
 #include "EepromTypes.h"
 #include "EepromAccessImpl.h"
 
@@ -37,6 +38,16 @@ void connectionStarted(StandardConnection& connection, DataOut& out)
 
 OneWireBusCBox oneWireBus;
 
+#if BREWPI_PROFILING && CONTROLBOX_PROFILING
+LoopProfilerCBox loopProfiler;
+
+/**
+ * The loop profiler is read-only and not created by createObjectHandlers. Its type id follows the ids of the types
+ * that are created, which are their index in createObjectHandlers.
+ */
+const obj_type_t LOOP_PROFILER_TYPE_ID = 7;
+#endif
+
 Container& systemRootContainer()
 {
 	static data_block_ref id;
@@ -48,7 +59,12 @@ Container& systemRootContainer()
 	// todo - lookup the type ID from the xxx::create function. This can
 	// be resolved at compile-time.
 
+#if BREWPI_PROFILING && CONTROLBOX_PROFILING
+	loopProfiler.setTypeID(LOOP_PROFILER_TYPE_ID);
+	static Object* values[] = { &idValue, &ticks, &oneWireBus, &loopProfiler };
+#else
 	static Object* values[] = { &idValue, &ticks, &oneWireBus };
+#endif
 	static FixedContainer root(arraySize(values), values);
 	return root;
 }
@@ -73,6 +89,7 @@ Commands::ObjectFactory createObjectHandlers[] = {
 	PersistChangeValue::create,								// type 4
 	IndirectValue::create,									// type 5
 	OneWireTempSensorCBox::create,					// type 6
+	// type 7 is LOOP_PROFILER_TYPE_ID, which is read-only
 	NULL
 
 	// When defining a new object type, add the handler above the last NULL value (it's just there to make
@@ -113,6 +130,9 @@ void setup()
 	Serial.begin(9600);
 	eepromAccess.init();
 	controlbox_setup(0);
+#if BREWPI_PROFILING && CONTROLBOX_PROFILING
+	processObserver = &loopProfiler;
+#endif
 	platform_init();
 
 	WiFi.on();
@@ -136,6 +156,7 @@ void setup()
 
 void loop()
 {
+	PROFILE_LOOP_STARTED();
 	controlbox_loop();
 	mdns.processQueries();
 }
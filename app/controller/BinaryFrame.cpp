@@ -0,0 +1,195 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BinaryFrame.h"
+#include <string.h>
+
+// CRC-16/CCITT (polynomial 0x1021), a nibble at a time
+static const uint16_t crcTable[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+};
+
+static uint16_t crc16(uint16_t crc, uint8_t data){
+    crc = uint16_t(crc << 4) ^ crcTable[(crc >> 12) ^ (data >> 4)];
+    crc = uint16_t(crc << 4) ^ crcTable[(crc >> 12) ^ (data & 0x0F)];
+    return crc;
+}
+
+void BinaryFrameWriter::appendString(const char * s){
+    size_t n = strlen(s);
+    appendUnsigned(n);
+    while(n--){
+        append(uint8_t(*s++));
+    }
+}
+
+void BinaryFrameWriter::putString(const char * s){
+    if(!schemaOnly){
+        appendString(s);
+    }
+}
+
+void BinaryFrameWriter::describeText(const char * text, uint8_t field){
+    if(field == BINARY_LITERAL){
+        for(const char * c = text; *c; c++){
+            schema = schemaHash(schema, uint8_t(*c));
+        }
+    }
+    if(schemaOnly){
+        append(field);
+        appendString(text);
+    }
+}
+
+void BinaryFrameWriter::flush(){
+    uint16_t id = schemaId();
+    append(uint8_t(id));
+    append(uint8_t(id >> 8));
+    sendFrame(false);
+}
+
+void BinaryFrameWriter::sendFrame(bool more){
+    buffer[0] = SYNC;
+    buffer[1] = more ? (type | MORE) : type;
+    buffer[2] = length;
+    uint16_t crc = 0xFFFF;
+    for(uint8_t i = 1; i < HEADER_SIZE + length; i++){
+        crc = crc16(crc, buffer[i]);
+    }
+    buffer[HEADER_SIZE + length] = uint8_t(crc);
+    buffer[HEADER_SIZE + length + 1] = uint8_t(crc >> 8);
+    uint8_t frameSize = HEADER_SIZE + length + CRC_SIZE;
+    write(buffer, frameSize);
+    written += frameSize;
+    length = 0;
+}
+
+void BinaryFrameDecoder::drop(){
+    errors++;
+    messageLength = 0;
+    continued = false;
+    state = WAIT_SYNC;
+}
+
+bool BinaryFrameDecoder::receive(uint8_t b){
+    switch(state){
+    case WAIT_SYNC:
+        if(b == BinaryFrameWriter::SYNC){
+            state = TYPE;
+        }
+        break;
+    case TYPE:
+        frameType = b;
+        crc = crc16(0xFFFF, b);
+        if(continued && (b & ~BinaryFrameWriter::MORE) != messageType){
+            drop(); // the rest of the previous message is missing
+            break;
+        }
+        if(!continued){
+            messageType = b & ~BinaryFrameWriter::MORE;
+            messageLength = 0;
+        }
+        state = LENGTH;
+        break;
+    case LENGTH:
+        frameLength = b;
+        crc = crc16(crc, b);
+        received = 0;
+        if(messageLength + b > MAX_MESSAGE){
+            drop();
+            break;
+        }
+        state = b ? PAYLOAD : CRC_LOW;
+        break;
+    case PAYLOAD:
+        message[messageLength++] = b;
+        crc = crc16(crc, b);
+        if(++received == frameLength){
+            state = CRC_LOW;
+        }
+        break;
+    case CRC_LOW:
+        crcLow = b;
+        state = CRC_HIGH;
+        break;
+    case CRC_HIGH:
+        if(uint16_t(crcLow | (b << 8)) != crc){
+            drop();
+            break;
+        }
+        state = WAIT_SYNC;
+        continued = (frameType & BinaryFrameWriter::MORE) != 0;
+        return !continued;
+    }
+    return false;
+}
+
+bool BinaryPayloadReader::getUnsigned(uint32_t & value){
+    value = 0;
+    for(uint8_t shift = 0; shift < 35; shift += 7){
+        if(data == end){
+            return false;
+        }
+        uint8_t b = *data++;
+        value |= uint32_t(b & 0x7F) << shift;
+        if(!(b & 0x80)){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BinaryPayloadReader::getSigned(int32_t & value){
+    uint32_t zigzag;
+    if(!getUnsigned(zigzag)){
+        return false;
+    }
+    value = int32_t(zigzag >> 1) ^ -int32_t(zigzag & 1);
+    return true;
+}
+
+bool BinaryPayloadReader::getDouble(double & value){
+    if(end - data < 8){
+        return false;
+    }
+    uint64_t bits = 0;
+    for(uint8_t i = 0; i < 8; i++){
+        bits |= uint64_t(*data++) << (8 * i);
+    }
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+bool BinaryPayloadReader::getString(char * out, uint16_t size){
+    uint32_t n;
+    if(!getUnsigned(n) || uint32_t(end - data) < n){
+        return false;
+    }
+    for(uint32_t i = 0; i < n; i++){
+        if(i + 1 < size){
+            out[i] = char(data[i]);
+        }
+    }
+    if(size > 0){
+        out[n + 1 < size ? n : size - 1] = '\0';
+    }
+    data += n;
+    return true;
+}
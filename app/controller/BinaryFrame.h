@@ -0,0 +1,252 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Frames of the binary PiLink mode.
+ *
+ * A frame is: sync byte 0xA5, type, payload length, payload, CRC-16/CCITT of type, length and payload (little endian).
+ * The type is the response character of the JSON mode. When a message does not fit in one frame, the MORE bit is set
+ * in the type of all frames but the last, and the payloads are concatenated.
+ *
+ * The payload holds the values in the order of the JSON response, without keys. Unsigned values are LEB128 varints,
+ * signed values are zigzag encoded varints and fixed point values are sent as their raw value. Temperatures are
+ * always in Celsius. The last 2 bytes of a message are a schema id: a hash of the value types, the structure and the
+ * literals like type names. Keys are not part of it, they only change with the firmware version.
+ *
+ * A schema message lists the keys and types instead of the values, as pairs of a BinaryField, JSON::TokenType or 0 for
+ * a key, and a string: the key, the literal or empty. It ends with the same schema id as the values it describes, so
+ * the host only needs to ask for the schema again when the id changes.
+ * A schema request that cannot be answered gets an error message of type ERROR_TYPE. Its only value is the requested
+ * character as a signed value, or -1 when the request was not one character followed by the end of the line.
+ */
+
+enum BinaryField : uint8_t {
+    BINARY_UNSIGNED = 'u',
+    BINARY_SIGNED = 'i',
+    BINARY_BOOL = 'b',
+    BINARY_STRING = 's',
+    BINARY_DOUBLE = 'd', // 8 bytes, IEEE 754 little endian
+    BINARY_TEMP = 't', // raw temp_t
+    BINARY_TEMP_PRECISE = 'p', // raw temp_precise_t
+    BINARY_TEMP_LONG = 'l', // raw temp_long_t
+    BINARY_LITERAL = 'n', // a literal like a type name, only in the schema
+};
+
+class BinaryFrameWriter
+{
+public:
+    static const uint8_t SYNC = 0xA5;
+    static const uint8_t MORE = 0x80;
+    static const uint8_t MAX_PAYLOAD = 128;
+    static const uint8_t HEADER_SIZE = 3;
+    static const uint8_t CRC_SIZE = 2;
+    static const char ERROR_TYPE = '!';
+
+    /*
+     * @param type response character
+     * @param schemaOnly write the schema message instead of the values
+     */
+    BinaryFrameWriter(char type, bool schemaOnly = false) :
+        type(uint8_t(type)), schemaOnly(schemaOnly), length(0), written(0), schema(5381) {}
+    virtual ~BinaryFrameWriter() = default;
+
+    void putByte(uint8_t b){
+        if(!schemaOnly){
+            append(b);
+        }
+    }
+    void putUnsigned(uint32_t value){
+        if(!schemaOnly){
+            appendUnsigned(value);
+        }
+    }
+    void putSigned(int32_t value){
+        // zigzag: small negative values get small codes too
+        putUnsigned((uint32_t(value) << 1) ^ uint32_t(value >> 31));
+    }
+    void putString(const char * s);
+
+    /*
+     * Adds a key or literal to the schema, followed by the type of the value. Values without a key use nullptr.
+     * Keys only change with the firmware version, so only the literals are part of the schema id. Hashing the keys
+     * would make the id cost more than the values.
+     */
+    void describe(const char * key, uint8_t field){
+        schema = schemaHash(schema, field);
+        if(field == BINARY_LITERAL || schemaOnly){
+            describeText(key ? key : "", field);
+        }
+    }
+
+    /*
+     * Adds a structure element that is not sent, like the start of an object, to the schema.
+     */
+    void describe(uint8_t token){
+        describe(nullptr, token);
+    }
+
+    /*
+     * Appends the schema id and writes the last frame.
+     */
+    void flush();
+
+    /*
+     * Total number of bytes written, including framing and the payload still in the buffer.
+     */
+    size_t size() const {
+        return written + length;
+    }
+
+    uint16_t schemaId() const {
+        return uint16_t(schema ^ (schema >> 16));
+    }
+
+protected:
+    /*
+     * Writes a complete frame.
+     */
+    virtual void write(const uint8_t * data, uint8_t length) = 0;
+
+private:
+    void append(uint8_t b){
+        if(length == MAX_PAYLOAD){
+            sendFrame(true);
+        }
+        buffer[HEADER_SIZE + length++] = b;
+    }
+    void appendUnsigned(uint32_t value){
+        while(value >= 0x80){
+            append(uint8_t(value) | 0x80);
+            value >>= 7;
+        }
+        append(uint8_t(value));
+    }
+    void appendString(const char * s);
+    void describeText(const char * text, uint8_t field);
+
+    // djb2 (xor variant): the schema id only needs to change when the schema does, and it is updated for every value
+    static uint32_t schemaHash(uint32_t hash, uint8_t data){
+        return (hash * 33) ^ data;
+    }
+
+    void sendFrame(bool more);
+
+    uint8_t buffer[HEADER_SIZE + MAX_PAYLOAD + CRC_SIZE];
+    uint8_t type;
+    bool schemaOnly;
+    uint8_t length;
+    size_t written;
+    uint32_t schema;
+};
+
+/*
+ * Reassembles the messages from a stream of frames, for the host side and for tests.
+ */
+class BinaryFrameDecoder
+{
+public:
+    static const uint16_t MAX_MESSAGE = 4096; // the schema of the control object is about 3.5 kB
+
+    BinaryFrameDecoder() : state(WAIT_SYNC), messageLength(0), continued(false), errors(0) {}
+
+    /*
+     * Processes a received byte. Returns true when the byte completes a message.
+     * Bytes before a sync byte are skipped. A frame with a CRC error drops the message it belongs to.
+     */
+    bool receive(uint8_t b);
+
+    char type() const {
+        return char(messageType);
+    }
+
+    /*
+     * The values of the last message, without the schema id.
+     */
+    const uint8_t * payload() const {
+        return message;
+    }
+
+    uint16_t length() const {
+        return messageLength >= 2 ? messageLength - 2 : 0;
+    }
+
+    uint16_t schemaId() const {
+        return messageLength >= 2 ? uint16_t(message[messageLength - 2] | (message[messageLength - 1] << 8)) : 0;
+    }
+
+    uint32_t errorCount() const {
+        return errors;
+    }
+
+private:
+    enum State : uint8_t {
+        WAIT_SYNC,
+        TYPE,
+        LENGTH,
+        PAYLOAD,
+        CRC_LOW,
+        CRC_HIGH,
+    };
+
+    void drop();
+
+    State state;
+    uint8_t frameType;
+    uint8_t messageType;
+    uint8_t frameLength;
+    uint8_t received;
+    uint16_t crc;
+    uint8_t crcLow;
+    uint16_t messageLength;
+    bool continued; // the previous frame had the MORE bit set
+    uint32_t errors;
+    uint8_t message[MAX_MESSAGE];
+};
+
+/*
+ * Reads the values from the payload of a message.
+ */
+class BinaryPayloadReader
+{
+public:
+    BinaryPayloadReader(const uint8_t * data, uint16_t length) : data(data), end(data + length) {}
+
+    bool getUnsigned(uint32_t & value);
+    bool getSigned(int32_t & value);
+    bool getDouble(double & value);
+
+    /*
+     * Reads a string into out, which has room for size characters including the \0. Longer strings are truncated.
+     * With a size of 0 the string is skipped.
+     */
+    bool getString(char * out, uint16_t size);
+
+    bool atEnd() const {
+        return data == end;
+    }
+
+private:
+    const uint8_t * data;
+    const uint8_t * end;
+};
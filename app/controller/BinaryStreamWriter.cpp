@@ -0,0 +1,180 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BinaryStreamWriter.h"
+#include <string.h>
+
+void BinaryStreamWriter::serialize(JSON::TokenType type){
+    out.describe(uint8_t(type));
+}
+
+void BinaryStreamWriter::serialize(const char* literal){
+    out.describe(literal, BINARY_LITERAL);
+}
+
+// sent as UTF-8, like any other string
+void BinaryStreamWriter::serialize(std::wstring& value){
+    std::string utf8;
+    for(wchar_t w : value){
+        uint32_t c = uint32_t(w) & 0xFFFF;
+        if(c < 0x80){
+            utf8 += char(c);
+        }
+        else if(c < 0x800){
+            utf8 += char(0xC0 | (c >> 6));
+            utf8 += char(0x80 | (c & 0x3F));
+        }
+        else {
+            utf8 += char(0xE0 | (c >> 12));
+            utf8 += char(0x80 | ((c >> 6) & 0x3F));
+            utf8 += char(0x80 | (c & 0x3F));
+        }
+    }
+    serialize(utf8);
+}
+
+void BinaryStreamWriter::serialize(std::string& value){
+    out.describe(nullptr, BINARY_STRING);
+    out.putString(value.c_str());
+}
+
+void BinaryStreamWriter::serialize(int8_t& value){
+    out.describe(nullptr, BINARY_SIGNED);
+    out.putSigned(value);
+}
+
+void BinaryStreamWriter::serialize(int16_t& value){
+    out.describe(nullptr, BINARY_SIGNED);
+    out.putSigned(value);
+}
+
+void BinaryStreamWriter::serialize(int32_t& value){
+    out.describe(nullptr, BINARY_SIGNED);
+    out.putSigned(value);
+}
+
+void BinaryStreamWriter::serialize(uint8_t& value){
+    out.describe(nullptr, BINARY_UNSIGNED);
+    out.putUnsigned(value);
+}
+
+void BinaryStreamWriter::serialize(uint16_t& value){
+    out.describe(nullptr, BINARY_UNSIGNED);
+    out.putUnsigned(value);
+}
+
+void BinaryStreamWriter::serialize(uint32_t& value){
+    out.describe(nullptr, BINARY_UNSIGNED);
+    out.putUnsigned(value);
+}
+
+#ifndef ESJ_DISABLE_DOUBLE
+void BinaryStreamWriter::serialize(double& value){
+    out.describe(nullptr, BINARY_DOUBLE);
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for(uint8_t i = 0; i < 8; i++){
+        out.putByte(uint8_t(bits >> (8 * i)));
+    }
+}
+#endif
+
+void BinaryStreamWriter::serialize(bool& value){
+    out.describe(nullptr, BINARY_BOOL);
+    out.putUnsigned(value);
+}
+
+void BinaryStreamWriter::serialize(temp_t& value){
+    out.describe(nullptr, BINARY_TEMP);
+    out.putSigned(value.getRaw());
+}
+
+void BinaryStreamWriter::serialize(temp_precise_t& value){
+    out.describe(nullptr, BINARY_TEMP_PRECISE);
+    out.putSigned(value.getRaw());
+}
+
+void BinaryStreamWriter::serialize(temp_long_t& value){
+    out.describe(nullptr, BINARY_TEMP_LONG);
+    out.putSigned(value.getRaw());
+}
+
+// the key is only part of the schema, the value adds its type
+template<typename T>
+void BinaryStreamWriter::serializeWithKey(const char* key, T& value, bool more){
+    out.describe(key, 0);
+    serialize(value);
+    if(more){
+        out.describe(uint8_t(JSON::T_COMMA));
+    }
+}
+
+void BinaryStreamWriter::serialize(const char* key, std::wstring& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, std::string& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, int8_t& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, int16_t& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, int32_t& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, uint8_t& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, uint16_t& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, uint32_t& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+#ifndef ESJ_DISABLE_DOUBLE
+void BinaryStreamWriter::serialize(const char* key, double& value, bool more){
+    serializeWithKey(key, value, more);
+}
+#endif
+
+void BinaryStreamWriter::serialize(const char* key, bool& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, temp_t& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, temp_precise_t& value, bool more){
+    serializeWithKey(key, value, more);
+}
+
+void BinaryStreamWriter::serialize(const char* key, temp_long_t& value, bool more){
+    serializeWithKey(key, value, more);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "json_adapter.h"
+#include "BinaryFrame.h"
+
+/*
+ * Writer for the ESJ serialize() functions that sends the values in binary frames, for the binary PiLink mode.
+ *
+ * Values are written in the order JsonStreamWriter would print them. Keys, literals like type names and the structure
+ * of the document are not sent. They make up the schema, which is written instead of the values when the frame writer
+ * is created with schemaOnly set.
+ */
+class BinaryStreamWriter : public JSON::Adapter
+{
+public:
+    explicit BinaryStreamWriter(BinaryFrameWriter & out) : out(out) {}
+    virtual ~BinaryStreamWriter() = default;
+
+    bool storing() override final { return true; }
+
+    void serialize(JSON::TokenType type) override final;
+
+    void serialize(const char* literal) override final;
+    void serialize(std::wstring& value) override final;
+    void serialize(std::string& value) override final;
+    void serialize(int8_t& value) override final;
+    void serialize(int16_t& value) override final;
+    void serialize(int32_t& value) override final;
+    void serialize(uint8_t& value) override final;
+    void serialize(uint16_t& value) override final;
+    void serialize(uint32_t& value) override final;
+#ifndef ESJ_DISABLE_DOUBLE
+    void serialize(double& value) override final;
+#endif
+    void serialize(bool& value) override final;
+    void serialize(temp_t& value) override final;
+    void serialize(temp_precise_t& value) override final;
+    void serialize(temp_long_t& value) override final;
+
+    void serialize(const char* key, std::wstring& value, bool more) override final;
+    void serialize(const char* key, std::string& value, bool more) override final;
+    void serialize(const char* key, int8_t& value, bool more) override final;
+    void serialize(const char* key, int16_t& value, bool more) override final;
+    void serialize(const char* key, int32_t& value, bool more) override final;
+    void serialize(const char* key, uint8_t& value, bool more) override final;
+    void serialize(const char* key, uint16_t& value, bool more) override final;
+    void serialize(const char* key, uint32_t& value, bool more) override final;
+#ifndef ESJ_DISABLE_DOUBLE
+    void serialize(const char* key, double& value, bool more) override final;
+#endif
+    void serialize(const char* key, bool& value, bool more) override final;
+    void serialize(const char* key, temp_t& value, bool more) override final;
+    void serialize(const char* key, temp_precise_t& value, bool more) override final;
+    void serialize(const char* key, temp_long_t& value, bool more) override final;
+
+private:
+    template<typename T>
+    void serializeWithKey(const char* key, T& value, bool more);
+
+    BinaryFrameWriter & out;
+};
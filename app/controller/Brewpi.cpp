@@ -21,8 +21,10 @@
 #include "Brewpi.h"
 #include "Ticks.h"
 #include "Control.h"
+#include "LoopProfiler.h"
 #include "PiLink.h"
 #include "SettingsManager.h"
+#include "DeviceManager.h"
 #include "UI.h"
 
 #if BREWPI_SIMULATE
@@ -85,6 +87,8 @@ void brewpiLoop(void)
 {
     static unsigned long lastUpdate = -1000; // init at -1000 to update immediately
 
+    PROFILE_LOOP_STARTED();
+
     if(ticks.millis() > lastUpdate + 1000) { //update settings every second
         lastUpdate = ticks.millis();
         control.update();
@@ -93,6 +97,8 @@ void brewpiLoop(void)
 
     control.fastUpdate(); // update actuators as often as possible for PWM
 
+    DeviceManager::updateOneWireTopologies(); // at most one short OneWire transaction
+
     ui.ticks();
 
     //listen for incoming serial and wifi connections while waiting to update
@@ -22,7 +22,6 @@
 #include "Control.h"
 #include "Platform.h"
 
-#include <vector>
 #include "Pid.h"
 #include "defaultDevices.h"
 #include "ActuatorInterfaces.h"
@@ -118,29 +117,40 @@ Control::~Control(){
 
 // This update function should be called every second
 void Control::update(){
-    for ( auto &obj : objects ) {
-        obj->update();
+    if(graph.isStale(objects)){
+        graph.compile(objects);
     }
+    graph.update();
 }
 
 void Control::fastUpdate(){
-    for ( auto &obj : objects ) {
-    	obj->fastUpdate();
+    if(graph.isStale(objects)){
+        graph.compile(objects);
     }
+    graph.fastUpdate();
 }
 
 void Control::serialize(JSON::Adapter& adapter){
     JSON::Class root(adapter, "Control");
-    std::vector<Interface *> pids;
+    // stream the PIDs as an array of objects, filtered in place to not build a temporary list
+    adapter.serialize("pids");
+    adapter.serialize(JSON::T_COLON);
+    adapter.serialize(JSON::T_ARRAY_BEGIN);
     VisitorCast<Pid> vcp;
-    // filter out only PIDs
+    bool first = true;
     for ( auto &obj : objects ) {
         obj->accept(vcp);
         if(vcp.getCastResult() != nullptr){
-            pids.push_back(obj);
+            if(!first){
+                adapter.serialize(JSON::T_COMMA);
+            }
+            first = false;
+            adapter.serialize(JSON::T_OBJ_BEGIN);
+            obj->serialize(adapter);
+            adapter.serialize(JSON::T_OBJ_END);
         }
     }
-    JSON_T(adapter, pids);
+    adapter.serialize(JSON::T_ARRAY_END);
 }
 
 Control control;
@@ -35,6 +35,7 @@
 #include "TempSensorDelegate.h"
 #include "ActuatorDigitalDelegate.h"
 #include "SensorSetPointPair.h"
+#include "ControlGraph.h"
 
 
 
@@ -52,6 +53,9 @@ public:
 
     std::vector<Interface*> objects;
 
+private:
+    ControlGraph graph; // objects, sorted by data dependencies
+
     // static setup below, we should support generating this dynamically later
 protected:
     TempSensorDelegate fridgeSensor;
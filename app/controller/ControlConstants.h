@@ -0,0 +1,63 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "temperatureFormats.h"
+
+// Stored in and loaded from EEPROM by TempControl. Not in TempControl.h, so the PiLink output map builds in the host tests.
+struct ControlConstants {
+    char tempFormat;
+
+    //settings for heater 1
+    temp_long_t heater1_kp;
+    uint16_t heater1_ti;
+    uint16_t heater1_td;
+    uint8_t heater1_infilt;
+    uint8_t heater1_dfilt;
+
+    //settings for heater 2
+    temp_long_t heater2_kp;
+    uint16_t heater2_ti;
+    uint16_t heater2_td;
+    uint8_t heater2_infilt;
+    uint8_t heater2_dfilt;
+
+    //settings for cooler
+    temp_long_t cooler_kp;
+    uint16_t cooler_ti;
+    uint16_t cooler_td;
+    uint8_t cooler_infilt;
+    uint8_t cooler_dfilt;
+
+    //settings for beer2fridge PID
+    temp_long_t beer2fridge_kp;
+    uint16_t beer2fridge_ti;
+    uint16_t beer2fridge_td;
+    uint8_t beer2fridge_infilt;
+    uint8_t beer2fridge_dfilt;
+    temp_t beer2fridge_pidMax;
+
+    uint16_t minCoolTime;
+    uint16_t minCoolIdleTime;
+    uint16_t heater1PwmPeriod;
+    uint16_t heater2PwmPeriod;
+    uint16_t coolerPwmPeriod;
+    uint16_t mutexDeadTime;
+};
@@ -30,8 +30,10 @@
 #include "PiLink.h"
 #include "EepromFormat.h"
 #include "EepromManager.h"
+#include "DeviceTable.h"
 #include "defaultDevices.h"
 #include "OneWireAddress.h"
+#include "RefTo.h"
 
 #ifdef WIRING
 
@@ -253,6 +255,8 @@ bool DeviceManager::installDevice(Interface * device, DeviceConfig config, devic
         case DEVICE_CHAMBER_MANUAL_ACTUATOR :
         	break; // not installed for now, only exists in device list
     }
+    // device list has changed, references to devices have to look up their target again
+    RefToGeneric::invalidateAll();
     if(device == nullptr){
         config.deviceFunction = DEVICE_NONE; // if the device ptr is cleared, also clear EEPROM slot
     }
@@ -277,6 +281,7 @@ void DeviceManager::uninstallDevice(device_slot_t slot, bool eraseEeprom)
         installDevice(nullptr, config, slot, eraseEeprom);
         delete device;
         devices[slot] = nullptr;
+        RefToGeneric::invalidateAll();
     }
 }
 
@@ -655,67 +660,14 @@ bool matchAddress(uint8_t * detected,
  *   pinNr+address+pio for 2413 and 2408
  */
 device_slot_t findHardwareDevice(DeviceConfig & find) {
-    DeviceConfig config;
-
-    for (device_slot_t slot = 0; deviceManager.allDevices(config, slot);
-            slot++) {
-        if (find.deviceHardware == config.deviceHardware) {
-            bool match = true;
-
-            switch (find.deviceHardware) {
-#if BREWPI_DS2413
-                case DEVICE_HARDWARE_ONEWIRE_2413:
-#endif
-#if BREWPI_DS2408
-                case DEVICE_HARDWARE_ONEWIRE_2408:
-#endif
-#if BREWPI_DS2413 || BREWPI_DS2408
-                    match &= find.hw.settings.actuator.pio
-                            == config.hw.settings.actuator.pio;
-
-                    // fall through
-#endif
-
-                case DEVICE_HARDWARE_ONEWIRE_TEMP:
-                    match &= matchAddress(find.hw.address, config.hw.address,
-                            8);
-
-                    // fall through
-                case DEVICE_HARDWARE_PIN:
-                    match &= find.hw.pinNr == config.hw.pinNr;
-                    break;
-                case DEVICE_HARDWARE_NONE:
-                    match = false; // don't return a match for no type
-                    break;
-                default: // this should not happen - if it does the device will be returned as matching.
-                    break;
-            }
-
-            if (match) {
-                return slot;
-            }
-        }
-    }
-
-    return INVALID_SLOT;
+    return eepromManager.devices().findHardware(find);
 }
 
 /*
  * Find a device based on the function.
  */
 device_slot_t findDeviceFunction(DeviceConfig & find) {
-    DeviceConfig config;
-
-    for (device_slot_t slot = 0; deviceManager.allDevices(config, slot);
-            slot++) {
-        if (find.deviceFunction == config.deviceFunction) {
-            bool match = true;
-            if (match) {
-                return slot;
-            }
-        }
-    }
-    return INVALID_SLOT;
+    return eepromManager.devices().findFunction(find.deviceFunction);
 }
 
 void DeviceManager::readTempSensorValue(DeviceConfig::Hardware hw,
@@ -884,6 +836,20 @@ void DeviceManager::enumeratePinDevices(EnumerateHardware & h,
 
 }
 
+#if !BREWPI_SIMULATE
+/*
+ * Gets the address of the next device on a OneWire bus. Devices come from the topology when the bus has one,
+ * otherwise the bus is searched. The search must be reset before the first call.
+ */
+static bool nextOneWireAddress(OneWire * wire, OneWireTopology * topology, uint8_t index, uint8_t * address)
+{
+    if (topology != nullptr) {
+        return topology->address(index, address);
+    }
+    return wire->search(address);
+}
+#endif
+
 void DeviceManager::enumerateOneWireDevices(EnumerateHardware & h,
         EnumDevicesCallback callback, DeviceCallbackInfo * info) {
 #if !BREWPI_SIMULATE
@@ -905,9 +871,12 @@ void DeviceManager::enumerateOneWireDevices(EnumerateHardware & h,
         OneWire * wire = oneWireBus(pin);
 
         if (wire != nullptr){
-            wire -> reset_search();
+            OneWireTopology * topology = oneWireTopology(pin);
+            if (topology == nullptr) {
+                wire -> reset_search();
+            }
 
-            while (wire->search(config.hw.address)) {
+            for (uint8_t index = 0; nextOneWireAddress(wire, topology, index, config.hw.address); index++) {
                 // hardware device type from OneWire family ID
                 switch (config.hw.address[0]) {
 #if BREWPI_DS2413
@@ -993,6 +962,17 @@ void DeviceManager::enumerateHardwareToStream(Stream & p) {
     // logDebug("Enumerating Hardware");
     firstDeviceOutput = true;
 
+#if !BREWPI_SIMULATE
+    // a device that was just plugged in should be listed, so don't wait for the background search
+    int8_t pin;
+    for (uint8_t count = 0; (pin = enumOneWirePins(count)) >= 0; count++) {
+        OneWireTopology * topology = oneWireTopology(pin);
+        if (topology != nullptr && (spec.pin == -1 || spec.pin == pin)) {
+            topology->refresh(ticks.millis());
+        }
+    }
+#endif
+
     enumerateHardware(spec, OutputEnumeratedDevices, &info);
 
     // logDebug("Enumerating Hardware Complete");
@@ -1009,6 +989,19 @@ void DeviceManager::enumerateHardware(EnumerateHardware & spec,
     }
 }
 
+void DeviceManager::updateOneWireTopologies()
+{
+#if !BREWPI_SIMULATE
+    int8_t pin;
+    for (uint8_t count = 0; (pin = enumOneWirePins(count)) >= 0; count++) {
+        OneWireTopology * topology = oneWireTopology(pin);
+        if (topology != nullptr) {
+            topology->update(ticks.millis());
+        }
+    }
+#endif
+}
+
 void HandleDeviceDisplay(const char * key, const char * val, void * pv) {
     DeviceDisplay & dd = *(DeviceDisplay *) pv;
 
@@ -27,6 +27,10 @@
 #include "Board.h"
 #include "OneWire.h"
 #include "OneWireAddress.h"
+#include "OneWireTopology.h"
+
+class Stream;
+class Print;
 
 /*
  * A user has freedom to connect various devices to the controller, either via extending the oneWire bus,
@@ -154,6 +158,11 @@ struct DeviceConfig {
                 actuator = c.actuator;
                 sensor = c.sensor;
             }
+            Settings& operator=(const Settings& c) {  // like the copy constructor, so DeviceConfig can be assigned
+                actuator = c.actuator;
+                sensor = c.sensor;
+                return *this;
+            }
         } settings;
 
     } hw;
@@ -313,6 +322,11 @@ public:
 
     static void listDevices(Stream & p);
 
+    /*
+     * Lets the OneWire topologies do their next presence check or search step. Call it from the main loop.
+     */
+    static void updateOneWireTopologies();
+
     static Interface * fetch(uint8_t i){
         return devices[i];
     }
@@ -370,6 +384,11 @@ private:
 
     static OneWire * oneWireBus(uint8_t pin);
 
+    /*
+     * The devices found on a OneWire bus, or NULL if the bus is searched each time it is enumerated.
+     */
+    static OneWireTopology * oneWireTopology(uint8_t pin);
+
     static bool firstDeviceOutput;
     static Interface* devices[NUM_DEVICE_SLOTS];
 
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DeviceTable.h"
+
+static_assert(NUM_DEVICE_SLOTS <= 32, "anyAddress has a bit per slot");
+
+DeviceTable::DeviceTable()
+{
+    invalidate();
+}
+
+void DeviceTable::loaded()
+{
+    valid = true;
+    rebuildIndexes();
+}
+
+void DeviceTable::invalidate()
+{
+    valid = false;
+    for (DeviceConfig & config : configs) {
+        config = DeviceConfig();
+    }
+    rebuildIndexes();
+}
+
+bool DeviceTable::fetch(DeviceConfig & config, uint8_t slot) const
+{
+    bool ok = valid && slot < NUM_DEVICE_SLOTS;
+    if (ok) {
+        config = configs[slot];
+    }
+    return ok;
+}
+
+void DeviceTable::store(const DeviceConfig & config, uint8_t slot)
+{
+    set(config, slot);
+    rebuildIndexes();
+}
+
+void DeviceTable::set(const DeviceConfig & config, uint8_t slot)
+{
+    if (slot < NUM_DEVICE_SLOTS) {
+        configs[slot] = config;
+    }
+}
+
+bool DeviceTable::hasAddress(DeviceHardware hardware)
+{
+    return hardware == DEVICE_HARDWARE_ONEWIRE_TEMP || hasPio(hardware);
+}
+
+bool DeviceTable::hasPio(DeviceHardware hardware)
+{
+    switch (hardware) {
+#if BREWPI_DS2413
+        case DEVICE_HARDWARE_ONEWIRE_2413:
+#endif
+#if BREWPI_DS2408
+        case DEVICE_HARDWARE_ONEWIRE_2408:
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * FNV-1a hash of the fields that make up the hardware location. Unknown hardware types only hash the type, because
+ * they match on type alone.
+ */
+uint8_t DeviceTable::hardwareHash(const DeviceConfig & config)
+{
+    uint32_t hash = 2166136261u;
+    auto add = [&hash](uint8_t b) {
+        hash = (hash ^ b) * 16777619u;
+    };
+
+    add(uint8_t(config.deviceHardware));
+    if (config.deviceHardware == DEVICE_HARDWARE_PIN || hasAddress(config.deviceHardware)) {
+        add(config.hw.pinNr);
+    }
+    if (hasAddress(config.deviceHardware)) {
+        for (uint8_t i = 0; i < 8; i++) {
+            add(config.hw.address[i]);
+        }
+    }
+    if (hasPio(config.deviceHardware)) {
+        add(config.hw.settings.actuator.pio);
+    }
+    return uint8_t(hash ^ (hash >> 16)) & (HASH_BUCKETS - 1);
+}
+
+bool DeviceTable::sameHardware(const DeviceConfig & find, const DeviceConfig & config)
+{
+    if (find.deviceHardware != config.deviceHardware) {
+        return false;
+    }
+    if (find.deviceHardware == DEVICE_HARDWARE_NONE) {
+        return false; // don't return a match for no type
+    }
+    if (find.deviceHardware != DEVICE_HARDWARE_PIN && !hasAddress(find.deviceHardware)) {
+        return true; // this should not happen - if it does the device will be returned as matching.
+    }
+    if (find.hw.pinNr != config.hw.pinNr) {
+        return false;
+    }
+    if (hasAddress(find.deviceHardware) && config.hw.address[0]
+            && memcmp(find.hw.address, config.hw.address, 8) != 0) {
+        return false;
+    }
+    if (hasPio(find.deviceHardware) && find.hw.settings.actuator.pio != config.hw.settings.actuator.pio) {
+        return false;
+    }
+    return true;
+}
+
+void DeviceTable::rebuildIndexes()
+{
+    for (uint8_t i = 0; i < HASH_BUCKETS; i++) {
+        byHardware[i] = INVALID_SLOT;
+    }
+    for (uint8_t i = 0; i < DEVICE_FUNCTION_MAX; i++) {
+        byFunction[i] = INVALID_SLOT;
+    }
+    anyAddress = 0;
+
+    for (device_slot_t slot = 0; slot < NUM_DEVICE_SLOTS; slot++) {
+        const DeviceConfig & config = configs[slot];
+        unsigned function = unsigned(config.deviceFunction); // can be anything in an uninitialized slot
+        if (function < DEVICE_FUNCTION_MAX && byFunction[function] == INVALID_SLOT) {
+            byFunction[function] = slot;
+        }
+
+        if (config.deviceHardware == DEVICE_HARDWARE_NONE) {
+            continue;
+        }
+        if (hasAddress(config.deviceHardware) && !config.hw.address[0]) {
+            anyAddress |= uint32_t(1) << slot; // cannot be hashed, because it matches any address
+            continue;
+        }
+        uint8_t bucket = hardwareHash(config);
+        while (byHardware[bucket] != INVALID_SLOT) {
+            bucket = (bucket + 1) & (HASH_BUCKETS - 1);
+        }
+        byHardware[bucket] = slot;
+    }
+}
+
+device_slot_t DeviceTable::findHardware(const DeviceConfig & find) const
+{
+    if (!valid || find.deviceHardware == DEVICE_HARDWARE_NONE) {
+        return INVALID_SLOT;
+    }
+
+    // return the lowest matching slot, as a scan in slot order would
+    device_slot_t result = INVALID_SLOT;
+    for (uint8_t bucket = hardwareHash(find); byHardware[bucket] != INVALID_SLOT;
+            bucket = (bucket + 1) & (HASH_BUCKETS - 1)) {
+        device_slot_t slot = byHardware[bucket];
+        if ((result == INVALID_SLOT || slot < result) && sameHardware(find, configs[slot])) {
+            result = slot;
+        }
+    }
+    for (uint32_t remaining = anyAddress; remaining; remaining &= remaining - 1) {
+        device_slot_t slot = device_slot_t(__builtin_ctz(remaining));
+        if (result != INVALID_SLOT && slot > result) {
+            break;
+        }
+        if (sameHardware(find, configs[slot])) {
+            result = slot;
+            break;
+        }
+    }
+    return result;
+}
+
+device_slot_t DeviceTable::findFunction(DeviceFunction function) const
+{
+    if (!valid) {
+        return INVALID_SLOT;
+    }
+    if (unsigned(function) < DEVICE_FUNCTION_MAX) {
+        return byFunction[unsigned(function)];
+    }
+    for (device_slot_t slot = 0; slot < NUM_DEVICE_SLOTS; slot++) {
+        if (configs[slot].deviceFunction == function) {
+            return slot;
+        }
+    }
+    return INVALID_SLOT;
+}
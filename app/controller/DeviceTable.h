@@ -0,0 +1,92 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "DeviceManager.h"
+
+/*
+ * RAM copy of the device definitions in EEPROM, indexed by hardware location and by device function.
+ *
+ * EepromManager loads the table when the EEPROM has settings and updates it each time a device is stored, so looking
+ * up or iterating devices does not read from EEPROM emulation. The indexes are rebuilt on each store, which is rare
+ * compared to lookups.
+ */
+class DeviceTable
+{
+public:
+    DeviceTable();
+
+    /*
+     * Marks the table as loaded. The slots must be filled with set() first.
+     */
+    void loaded();
+
+    /*
+     * Empties the table, for when the EEPROM does not have settings. fetch() fails until the table is loaded again.
+     */
+    void invalidate();
+
+    bool isLoaded() const
+    {
+        return valid;
+    }
+
+    /*
+     * Copies the config in a slot, returns false when the table is not loaded or the slot is out of range.
+     */
+    bool fetch(DeviceConfig & config, uint8_t slot) const;
+
+    /*
+     * Sets the config of a slot and updates the indexes.
+     */
+    void store(const DeviceConfig & config, uint8_t slot);
+
+    /*
+     * Sets the config of a slot without updating the indexes, for loading all slots.
+     */
+    void set(const DeviceConfig & config, uint8_t slot);
+
+    /*
+     * Finds the lowest slot with the same hardware location: hardware type and pin, plus the address for OneWire
+     * devices and the pio for DS2413 and DS2408. A stored OneWire device without an address matches any address.
+     */
+    device_slot_t findHardware(const DeviceConfig & find) const;
+
+    /*
+     * Finds the lowest slot with the given function.
+     */
+    device_slot_t findFunction(DeviceFunction function) const;
+
+private:
+    static const uint8_t HASH_BUCKETS = 64; // power of 2, at least twice the number of slots to keep probing short
+
+    DeviceConfig configs[NUM_DEVICE_SLOTS];
+    device_slot_t byHardware[HASH_BUCKETS]; // open addressing with linear probing, INVALID_SLOT marks an empty bucket
+    device_slot_t byFunction[DEVICE_FUNCTION_MAX];
+    uint32_t anyAddress; // bit per slot with a OneWire device that has no address, these are not in byHardware
+    bool valid;
+
+    void rebuildIndexes();
+
+    static bool hasAddress(DeviceHardware hardware);
+    static bool hasPio(DeviceHardware hardware);
+    static uint8_t hardwareHash(const DeviceConfig & config);
+    static bool sameHardware(const DeviceConfig & find, const DeviceConfig & config);
+};
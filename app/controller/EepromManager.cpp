@@ -24,10 +24,13 @@
 #include "EepromManager.h"
 #include "TempControl.h"
 #include "EepromFormat.h"
+#include "DeviceTable.h"
 #include "PiLink.h"
 
 #define pointerOffset(x) offsetof(EepromFormat, x)
 
+static DeviceTable deviceTable;
+
 EepromManager::EepromManager()
 {
     eepromSizeCheck();
@@ -35,6 +38,26 @@ EepromManager::EepromManager()
 
 void EepromManager::init() 
 {    
+    loadDevices();
+}
+
+void EepromManager::loadDevices()
+{
+    if (!hasSettings()) {
+        deviceTable.invalidate();
+        return;
+    }
+    DeviceConfig config;
+    for (uint8_t index = 0; index < EepromFormat::MAX_DEVICES; index++) {
+        eepromAccess.get(pointerOffset(devices)+sizeof(DeviceConfig)*index, config);
+        deviceTable.set(config, index);
+    }
+    deviceTable.loaded();
+}
+
+const DeviceTable& EepromManager::devices()
+{
+    return deviceTable;
 }
 
 
@@ -47,6 +70,7 @@ bool EepromManager::hasSettings()
 void EepromManager::zapEeprom()
 {
 	eepromAccess.clear();
+	deviceTable.invalidate();
 }
 
 
@@ -72,6 +96,7 @@ void EepromManager::initializeEeprom()
 
     // set the version flag - so that storeDevice will work
     eepromAccess.writeByte(pointerOffset(version), EEPROM_FORMAT_VERSION);
+    loadDevices();
 
     saveDefaultDevices();
 }
@@ -133,18 +158,15 @@ void EepromManager::storeTempSettings()
 
 bool EepromManager::fetchDevice(DeviceConfig& config, uint8_t deviceIndex)
 {
-	bool ok = (hasSettings() && deviceIndex<EepromFormat::MAX_DEVICES);
-	if (ok){
-		eepromAccess.get(pointerOffset(devices)+sizeof(DeviceConfig)*deviceIndex, config);
-	}
-	return ok;
+	return deviceTable.fetch(config, deviceIndex);
 }	
 
 bool EepromManager::storeDevice(const DeviceConfig& config, uint8_t deviceIndex)
 {
-	bool ok = (hasSettings() && deviceIndex<EepromFormat::MAX_DEVICES);
+	bool ok = (deviceTable.isLoaded() && deviceIndex<EepromFormat::MAX_DEVICES);
 	if (ok){
 		eepromAccess.put(pointerOffset(devices)+sizeof(DeviceConfig)*deviceIndex, config);
+		deviceTable.store(config, deviceIndex);
 	}
 	return ok;
 }
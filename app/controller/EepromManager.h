@@ -30,6 +30,7 @@ void fill(int8_t* p, uint8_t size);
 void clear(uint8_t* p, uint8_t size);
 
 struct DeviceConfig;
+class DeviceTable;
 
 class EepromManager {
 public:		
@@ -40,6 +41,11 @@ public:
          * Initialize the eeprom manager.
          */
     static void init();
+
+	/**
+	 * Copies the device definitions from eeprom to the device table in RAM.
+	 */
+	static void loadDevices();
 	
 	/**
 	 * Write -1 to the entire eeprom, emulating the reset performed by avrdude.
@@ -74,8 +80,13 @@ public:
 	 */
 	static void storeTempSettings();
 
+	/**
+	 * Device definitions are read from the device table in RAM, stores are written to both the table and eeprom.
+	 */
 	static bool fetchDevice(DeviceConfig& config, uint8_t deviceIndex);
 	static bool storeDevice(const DeviceConfig& config, uint8_t deviceIndex);
+
+	static const DeviceTable& devices();
 	
 	static uint8_t saveDefaultDevices();
 };
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JsonOutputMap.h"
+#include "ControlConstants.h"
+#include "JsonKeys.h"
+#include "BinaryFrame.h"
+#include "BinaryStreamWriter.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define JSON_OUTPUT_CC_MAP(name, fn) { JSONKEY_ ## name,  offsetof(ControlConstants, name), fn }
+
+const JsonOutput jsonOutputCCMap[] = {
+        JSON_OUTPUT_CC_MAP(tempFormat, JOCC_CHAR),
+
+        JSON_OUTPUT_CC_MAP(heater1_kp, JOCC_FIXED_POINT_LONG),
+        JSON_OUTPUT_CC_MAP(heater1_ti, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(heater1_td, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(heater1_infilt, JOCC_UINT8),
+        JSON_OUTPUT_CC_MAP(heater1_dfilt, JOCC_UINT8),
+
+        JSON_OUTPUT_CC_MAP(heater2_kp, JOCC_FIXED_POINT_LONG),
+        JSON_OUTPUT_CC_MAP(heater2_ti, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(heater2_td, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(heater2_infilt, JOCC_UINT8),
+        JSON_OUTPUT_CC_MAP(heater2_dfilt, JOCC_UINT8),
+
+        JSON_OUTPUT_CC_MAP(cooler_kp, JOCC_FIXED_POINT_LONG),
+        JSON_OUTPUT_CC_MAP(cooler_ti, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(cooler_td, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(cooler_infilt, JOCC_UINT8),
+        JSON_OUTPUT_CC_MAP(cooler_dfilt, JOCC_UINT8),
+
+        JSON_OUTPUT_CC_MAP(beer2fridge_kp, JOCC_FIXED_POINT_LONG),
+        JSON_OUTPUT_CC_MAP(beer2fridge_ti, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(beer2fridge_td, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(beer2fridge_infilt, JOCC_UINT8),
+        JSON_OUTPUT_CC_MAP(beer2fridge_dfilt, JOCC_UINT8),
+        JSON_OUTPUT_CC_MAP(beer2fridge_pidMax, JOCC_TEMP_DIFF),
+
+        JSON_OUTPUT_CC_MAP(minCoolTime, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(minCoolIdleTime, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(heater1PwmPeriod, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(heater2PwmPeriod, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(coolerPwmPeriod, JOCC_UINT16),
+        JSON_OUTPUT_CC_MAP(mutexDeadTime, JOCC_UINT16)
+};
+
+const uint8_t jsonOutputCCMapCount = sizeof(jsonOutputCCMap)/sizeof(jsonOutputCCMap[0]);
+
+const char * formatJsonOutput(char * buf, const uint8_t * base, const JsonOutput & output, char tempFormat){
+    const uint8_t * value = base + output.offset;
+    switch(output.handlerOffset){
+    case JOCC_UINT8:
+        snprintf(buf, JSON_OUTPUT_VALUE_SIZE, "%u", *value);
+        break;
+    case JOCC_UINT16:
+        snprintf(buf, JSON_OUTPUT_VALUE_SIZE, "%u", *((const uint16_t*) value));
+        break;
+    case JOCC_TEMP_FORMAT:
+        ((const temp_t*) value)->toTempString(buf, 2, JSON_OUTPUT_VALUE_SIZE, tempFormat, true);
+        break;
+    case JOCC_FIXED_POINT:
+        ((const temp_t*) value)->toString(buf, 2, JSON_OUTPUT_VALUE_SIZE);
+        break;
+    case JOCC_TEMP_DIFF:
+        ((const temp_t*) value)->toTempString(buf, 2, JSON_OUTPUT_VALUE_SIZE, tempFormat, false);
+        break;
+    case JOCC_CHAR:
+        snprintf(buf, JSON_OUTPUT_VALUE_SIZE, "\"%c\"", *((const char*) value));
+        break;
+    case JOCC_FIXED_POINT_LONG:
+        ((const temp_long_t*) value)->toString(buf, 2, JSON_OUTPUT_VALUE_SIZE);
+        break;
+    default:
+        buf[0] = '\0';
+        break;
+    }
+    return buf;
+}
+
+void writeJsonOutputs(BinaryFrameWriter & out, uint8_t * base, const JsonOutput * map, uint8_t mapCount){
+    BinaryStreamWriter adapter(out);
+    adapter.serialize(JSON::T_OBJ_BEGIN);
+    for(uint8_t i = 0; i < mapCount; i++){
+        JsonOutput output;
+        memcpy(&output, &map[i], sizeof(output));
+        bool more = i + 1 < mapCount;
+        uint8_t * value = base + output.offset;
+        switch(output.handlerOffset){
+        case JOCC_UINT8:
+            adapter.serialize(output.key, *value, more);
+            break;
+        case JOCC_CHAR:
+        {
+            // the JSON response quotes the char, so it is a string
+            char s[2] = { *((char*) value), '\0' };
+            out.describe(output.key, 0);
+            out.describe(nullptr, BINARY_STRING);
+            out.putString(s);
+            if(more){
+                out.describe(JSON::T_COMMA);
+            }
+            break;
+        }
+        case JOCC_UINT16:
+            adapter.serialize(output.key, *((uint16_t*) value), more);
+            break;
+        case JOCC_TEMP_FORMAT:
+        case JOCC_FIXED_POINT:
+        case JOCC_TEMP_DIFF:
+            adapter.serialize(output.key, *((temp_t*) value), more);
+            break;
+        case JOCC_FIXED_POINT_LONG:
+            adapter.serialize(output.key, *((temp_long_t*) value), more);
+            break;
+        }
+    }
+    adapter.serialize(JSON::T_OBJ_END);
+}
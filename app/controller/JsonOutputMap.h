@@ -0,0 +1,62 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+class BinaryFrameWriter;
+
+/*
+ * Maps a JSON key to a value at an offset in a struct, like the control constants of the 'C' response.
+ * PiLink sends the values of a map as JSON pairs or, in binary mode, as the values of a binary frame.
+ */
+struct JsonOutput {
+    const char* key;            // JSON key
+    uint8_t offset;             // offset into the struct
+    uint8_t handlerOffset;      // JsonOutputIndex: the type of the value and how it is formatted
+};
+
+enum JsonOutputIndex {
+    JOCC_UINT8=0,
+    JOCC_TEMP_FORMAT=1,
+    JOCC_FIXED_POINT=2,
+    JOCC_TEMP_DIFF=3,
+    JOCC_CHAR=4,
+    JOCC_UINT16=5,
+    JOCC_FIXED_POINT_LONG=6,
+};
+
+extern const JsonOutput jsonOutputCCMap[];
+extern const uint8_t jsonOutputCCMapCount;
+
+static const uint8_t JSON_OUTPUT_VALUE_SIZE = 12;
+
+/*
+ * Formats the value of a map entry as it is sent in a JSON pair, into buf of JSON_OUTPUT_VALUE_SIZE characters.
+ * Temperatures are converted to tempFormat and chars are quoted.
+ * @return buf
+ */
+const char * formatJsonOutput(char * buf, const uint8_t * base, const JsonOutput & output, char tempFormat);
+
+/*
+ * Writes the values of a map as a JSON object to a binary frame. Temperatures stay in Celsius, chars are sent as a
+ * string of one character.
+ */
+void writeJsonOutputs(BinaryFrameWriter & out, uint8_t * base, const JsonOutput * map, uint8_t mapCount);
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "JsonStreamWriter.h"
+#include <stdio.h>
+
+void JsonStreamWriter::flush(){
+    if(length > 0){
+        write(buffer, length);
+        written += length;
+        length = 0;
+    }
+}
+
+void JsonStreamWriter::put(const char* s){
+    while(*s){
+        put(*s++);
+    }
+}
+
+void JsonStreamWriter::putKey(const char* key){
+    put('"');
+    put(key);
+    put('"');
+    put(':');
+}
+
+void JsonStreamWriter::putEnd(bool more){
+    if(more){
+        put(',');
+    }
+}
+
+// same escapes as Chordia::escape
+void JsonStreamWriter::putEscaped(char c){
+    switch(c){
+    case '"':
+    case '\\':
+    case '/':
+        put('\\');
+        put(c);
+        break;
+    case '\b':
+        put("\\b");
+        break;
+    case '\f':
+        put("\\f");
+        break;
+    case '\n':
+        put("\\n");
+        break;
+    case '\r':
+        put("\\r");
+        break;
+    case '\t':
+        put("\\t");
+        break;
+    default:
+        put(c);
+    }
+}
+
+void JsonStreamWriter::putUnsigned(uint32_t value){
+    char digits[10];
+    uint8_t n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while(value);
+    while(n){
+        put(digits[--n]);
+    }
+}
+
+void JsonStreamWriter::putSigned(int32_t value){
+    if(value < 0){
+        put('-');
+        putUnsigned(uint32_t(0) - uint32_t(value));
+    }
+    else {
+        putUnsigned(value);
+    }
+}
+
+template<typename T>
+void JsonStreamWriter::putTemp(const T& value, uint8_t decimals){
+    char s[15]; // max 7 integer digits, 8 decimals, period, minus sign and \0 for the widest format
+    put(value.toString(s, decimals, sizeof(s)));
+}
+
+void JsonStreamWriter::serialize(JSON::TokenType type){
+    switch(type){
+    case JSON::T_OBJ_BEGIN:
+        put('{');
+        break;
+    case JSON::T_OBJ_END:
+        put('}');
+        break;
+    case JSON::T_ARRAY_BEGIN:
+        put('[');
+        break;
+    case JSON::T_ARRAY_END:
+        put(']');
+        break;
+    case JSON::T_COMMA:
+        put(',');
+        break;
+    case JSON::T_COLON:
+        put(':');
+        break;
+    case JSON::T_NULL:
+        put("null");
+        break;
+    default:
+        break;
+    }
+}
+
+void JsonStreamWriter::serialize(const char* literal){
+    put('"');
+    put(literal);
+    put('"');
+}
+
+void JsonStreamWriter::serialize(std::wstring& value){
+    put('"');
+    for(wchar_t c : value){
+        if(c < 0x80){
+            putEscaped(char(c));
+        }
+        else {
+            char s[7];
+            snprintf(s, sizeof(s), "\\u%04x", unsigned(c & 0xFFFF));
+            put(s);
+        }
+    }
+    put('"');
+}
+
+void JsonStreamWriter::serialize(std::string& value){
+    put('"');
+    for(char c : value){
+        putEscaped(c);
+    }
+    put('"');
+}
+
+void JsonStreamWriter::serialize(int8_t& value){
+    putSigned(value);
+}
+
+void JsonStreamWriter::serialize(int16_t& value){
+    putSigned(value);
+}
+
+void JsonStreamWriter::serialize(int32_t& value){
+    putSigned(value);
+}
+
+void JsonStreamWriter::serialize(uint8_t& value){
+    putUnsigned(value);
+}
+
+void JsonStreamWriter::serialize(uint16_t& value){
+    putUnsigned(value);
+}
+
+void JsonStreamWriter::serialize(uint32_t& value){
+    putUnsigned(value);
+}
+
+#ifndef ESJ_DISABLE_DOUBLE
+void JsonStreamWriter::serialize(double& value){
+    char s[24];
+    snprintf(s, sizeof(s), "%g", value);
+    put(s);
+}
+#endif
+
+void JsonStreamWriter::serialize(bool& value){
+    put(value ? "true" : "false");
+}
+
+void JsonStreamWriter::serialize(temp_t& value){
+    putTemp(value, 4);
+}
+
+void JsonStreamWriter::serialize(temp_precise_t& value){
+    putTemp(value, 8);
+}
+
+void JsonStreamWriter::serialize(temp_long_t& value){
+    putTemp(value, 4);
+}
+
+void JsonStreamWriter::serialize(const char* key, std::wstring& value, bool more){
+    putKey(key);
+    serialize(value);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, std::string& value, bool more){
+    putKey(key);
+    serialize(value);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, int8_t& value, bool more){
+    putKey(key);
+    putSigned(value);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, int16_t& value, bool more){
+    putKey(key);
+    putSigned(value);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, int32_t& value, bool more){
+    putKey(key);
+    putSigned(value);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, uint8_t& value, bool more){
+    putKey(key);
+    putUnsigned(value);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, uint16_t& value, bool more){
+    putKey(key);
+    putUnsigned(value);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, uint32_t& value, bool more){
+    putKey(key);
+    putUnsigned(value);
+    putEnd(more);
+}
+
+#ifndef ESJ_DISABLE_DOUBLE
+void JsonStreamWriter::serialize(const char* key, double& value, bool more){
+    putKey(key);
+    serialize(value);
+    putEnd(more);
+}
+#endif
+
+void JsonStreamWriter::serialize(const char* key, bool& value, bool more){
+    putKey(key);
+    serialize(value);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, temp_t& value, bool more){
+    putKey(key);
+    putTemp(value, 4);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, temp_precise_t& value, bool more){
+    putKey(key);
+    putTemp(value, 8);
+    putEnd(more);
+}
+
+void JsonStreamWriter::serialize(const char* key, temp_long_t& value, bool more){
+    putKey(key);
+    putTemp(value, 4);
+    putEnd(more);
+}
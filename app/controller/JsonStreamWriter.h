@@ -0,0 +1,117 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "json_adapter.h"
+
+/*
+ * JSON writer for the ESJ serialize() functions that streams its output through a small fixed buffer.
+ *
+ * JSON::Writer formats every value into a std::string and, on the host, collects the whole document in a string too.
+ * This writer formats keys, numbers and temperatures straight into its buffer and hands the buffer to write() when it
+ * is full, so serializing does not use the heap. Call flush() when done to write the last partial buffer.
+ *
+ * The output is the same as JSON::Writer, except for doubles, which are printed with %g.
+ */
+class JsonStreamWriter : public JSON::Adapter
+{
+public:
+    static const uint8_t BUFFER_SIZE = 64;
+
+    JsonStreamWriter() : length(0), written(0) {}
+    virtual ~JsonStreamWriter() = default;
+
+    bool storing() override final { return true; }
+
+    void serialize(JSON::TokenType type) override final;
+
+    void serialize(const char* literal) override final;
+    void serialize(std::wstring& value) override final;
+    void serialize(std::string& value) override final;
+    void serialize(int8_t& value) override final;
+    void serialize(int16_t& value) override final;
+    void serialize(int32_t& value) override final;
+    void serialize(uint8_t& value) override final;
+    void serialize(uint16_t& value) override final;
+    void serialize(uint32_t& value) override final;
+#ifndef ESJ_DISABLE_DOUBLE
+    void serialize(double& value) override final;
+#endif
+    void serialize(bool& value) override final;
+    void serialize(temp_t& value) override final;
+    void serialize(temp_precise_t& value) override final;
+    void serialize(temp_long_t& value) override final;
+
+    void serialize(const char* key, std::wstring& value, bool more) override final;
+    void serialize(const char* key, std::string& value, bool more) override final;
+    void serialize(const char* key, int8_t& value, bool more) override final;
+    void serialize(const char* key, int16_t& value, bool more) override final;
+    void serialize(const char* key, int32_t& value, bool more) override final;
+    void serialize(const char* key, uint8_t& value, bool more) override final;
+    void serialize(const char* key, uint16_t& value, bool more) override final;
+    void serialize(const char* key, uint32_t& value, bool more) override final;
+#ifndef ESJ_DISABLE_DOUBLE
+    void serialize(const char* key, double& value, bool more) override final;
+#endif
+    void serialize(const char* key, bool& value, bool more) override final;
+    void serialize(const char* key, temp_t& value, bool more) override final;
+    void serialize(const char* key, temp_precise_t& value, bool more) override final;
+    void serialize(const char* key, temp_long_t& value, bool more) override final;
+
+    /**
+     * Writes the buffered output.
+     */
+    void flush();
+
+    /**
+     * Total number of characters written, including the ones still in the buffer.
+     */
+    size_t size() const {
+        return written + length;
+    }
+
+protected:
+    /**
+     * Writes a full buffer, or the rest of the output on flush().
+     */
+    virtual void write(const char* data, uint8_t length) = 0;
+
+private:
+    void put(char c){
+        if(length == BUFFER_SIZE){
+            flush();
+        }
+        buffer[length++] = c;
+    }
+    void put(const char* s);
+    void putKey(const char* key);
+    void putEnd(bool more);
+    void putEscaped(char c);
+    void putSigned(int32_t value);
+    void putUnsigned(uint32_t value);
+    template<typename T>
+    void putTemp(const T& value, uint8_t decimals);
+
+    char buffer[BUFFER_SIZE];
+    uint8_t length;
+    size_t written;
+};
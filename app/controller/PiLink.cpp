@@ -36,7 +36,10 @@
 #include "ActuatorInterfaces.h"
 #include "ActuatorMocks.h"
 #include "Control.h"
-#include "json_writer.h"
+#include "JsonStreamWriter.h"
+#include "BinaryFrame.h"
+#include "BinaryStreamWriter.h"
+#include "JsonOutputMap.h"
 
 class NetworkSerialMuxer : public Stream
 {
@@ -140,6 +143,7 @@ public:
 static NetworkSerialMuxer piStream;
 
 bool PiLink::firstPair;
+bool PiLink::binaryMode = false;
 char PiLink::printfBuff[PRINTF_BUFFER_SIZE];
 
 void PiLink::init(void){
@@ -195,6 +199,19 @@ bool readCrLf(){
     return found;
 }
 
+int readNext();
+
+// Streams binary frames to piStream
+class PiStreamFrameWriter : public BinaryFrameWriter {
+public:
+    PiStreamFrameWriter(char type, bool schemaOnly = false) : BinaryFrameWriter(type, schemaOnly) {}
+
+protected:
+    void write(const uint8_t * data, uint8_t length) override final {
+        piStream.write(data, length);
+    }
+};
+
 void PiLink::receive(void){
     while (piStream.available() > 0) {
         char inByte = piStream.read();
@@ -247,6 +264,11 @@ void PiLink::receive(void){
         case 'v': // Control variables requested, send Control Object as json
             sendControlVariables();
             break;
+#if BREWPI_PROFILING
+        case 'p': // loop timing requested
+            sendProfile();
+            break;
+#endif
         case 'n':
             // v version
             // s shield type
@@ -280,6 +302,25 @@ void PiLink::receive(void){
         case 'j': // Receive settings as json
             receiveJson();
             break;
+        case 'B': // B1 switches 't', 's', 'c' and 'v' to binary frames, B0 back to JSON
+        {
+            int enable = readNext();
+            if(readCrLf() && (enable == '0' || enable == '1')){
+                binaryMode = enable == '1';
+            }
+            print("B:{\"binary\":%d}", binaryMode);
+            printNewLine();
+            break;
+        }
+        case 'K': // schema of a binary response, followed by its request character
+        {
+            int request = readNext();
+            if(!readCrLf()){
+                request = -1; // like 'B', the request character must end the line
+            }
+            sendSchema(request);
+            break;
+        }
 
 #if BREWPI_EEPROM_HELPER_COMMANDS
         case 'e': // dump contents of eeprom
@@ -370,31 +411,27 @@ void PiLink::receive(void){
 void PiLink::printTemperaturesJSON(char * beerAnnotation, char * fridgeAnnotation){
     printResponse('T');
 
-    temp_t t;
-    t = tempControl.getBeerTemp();
-    sendJsonTemp(JSON_BEER_TEMP, t);
-
-    t = tempControl.getBeerSetting();
-    sendJsonTemp(JSON_BEER_SET, t);
-
+    // format all temperatures in one pass, as consecutive strings
+    temp_t temps[] = {
+        tempControl.getBeerTemp(), tempControl.getBeerSetting(),
+        tempControl.getFridgeTemp(), tempControl.getFridgeSetting(),
+        tempControl.getLog1Temp(), tempControl.getLog2Temp(), tempControl.getLog3Temp()
+    };
+    char tempStrings[7 * 8 + 1]; // 7 characters for -198.40 in F and a separator for each temperature
+    temp_t::toTempStrings(temps, 7, tempStrings, sizeof(tempStrings), 2, '\0', tempControl.cc.tempFormat, true);
+    const char * next = tempStrings;
+
+    sendJsonTemp(JSON_BEER_TEMP, next);
+    sendJsonTemp(JSON_BEER_SET, next);
     sendJsonAnnotation(JSON_BEER_ANN, beerAnnotation);
 
-    t = tempControl.getFridgeTemp();
-    sendJsonTemp(JSON_FRIDGE_TEMP, t);
-
-    t = tempControl.getFridgeSetting();
-    sendJsonTemp(JSON_FRIDGE_SET, t);
-
+    sendJsonTemp(JSON_FRIDGE_TEMP, next);
+    sendJsonTemp(JSON_FRIDGE_SET, next);
     sendJsonAnnotation(JSON_FRIDGE_ANN, fridgeAnnotation);
 
-    t = tempControl.getLog1Temp();
-    sendJsonTemp(JSON_LOG1_TEMP, tempControl.getLog1Temp());
-
-    t = tempControl.getLog2Temp();
-    sendJsonTemp(JSON_LOG2_TEMP, tempControl.getLog2Temp());
-
-    t = tempControl.getLog3Temp();
-    sendJsonTemp(JSON_LOG3_TEMP, tempControl.getLog3Temp());
+    sendJsonTemp(JSON_LOG1_TEMP, next);
+    sendJsonTemp(JSON_LOG2_TEMP, next);
+    sendJsonTemp(JSON_LOG3_TEMP, next);
 
     sendJsonPair(JSON_STATE, (uint8_t)tempControl.getState());
 
@@ -413,17 +450,27 @@ void PiLink::sendJsonAnnotation(const char* name, const char* annotation)
     print(fmtAnn, annotation);
 }
 
-void PiLink::sendJsonTemp(const char* name, const temp_t & temp)
+// prints a temperature formatted by temp_t::toTempStrings and moves to the next one
+void PiLink::sendJsonTemp(const char* name, const char * & formatted)
 {
-    char tempString[9];
-    char * withoutSpaces = temp.toTempString(tempString, 2, 9, tempControl.cc.tempFormat, true);
     printJsonName(name);
-    piStream.print(withoutSpaces);
+    piStream.print(formatted);
+    formatted += strlen(formatted) + 1;
 }
 
 void PiLink::printTemperatures(void){
     // print all temperatures with empty annotations
-    printTemperaturesJSON(0, 0);
+    sendTemperatures(0, 0);
+}
+
+void PiLink::sendTemperatures(char * beerAnnotation, char * fridgeAnnotation){
+    if(binaryMode){
+        PiStreamFrameWriter out('T');
+        writeTemperatures(out, beerAnnotation, fridgeAnnotation);
+        out.flush();
+        return;
+    }
+    printTemperaturesJSON(beerAnnotation, fridgeAnnotation);
 }
 
 void PiLink::printBeerAnnotation(const char * annotation, ...){
@@ -432,7 +479,7 @@ void PiLink::printBeerAnnotation(const char * annotation, ...){
     va_start (args, annotation );
     vsnprintf(tempString, 128, annotation, args);
     va_end (args);
-    printTemperaturesJSON(tempString, 0);
+    sendTemperatures(tempString, 0);
 }
 
 void PiLink::printFridgeAnnotation(const char * annotation, ...){
@@ -441,7 +488,7 @@ void PiLink::printFridgeAnnotation(const char * annotation, ...){
     va_start (args, annotation );
     vsnprintf(tempString, 128, annotation, args);
     va_end (args);
-    printTemperaturesJSON(0, tempString);
+    sendTemperatures(0, tempString);
 }
 
 void PiLink::printResponse(char type) {
@@ -480,6 +527,12 @@ void PiLink::sendJsonClose() {
 
 // Send settings as JSON string
 void PiLink::sendControlSettings(void){
+    if(binaryMode){
+        PiStreamFrameWriter out('S');
+        writeControlSettings(out);
+        out.flush();
+        return;
+    }
     char tempString[12];
     printResponse('S');
     ControlSettings& cs = tempControl.cs;
@@ -494,128 +547,182 @@ void PiLink::sendControlSettings(void){
 // rather than offset from tempControl.
 uint8_t* jsonOutputBase;
 
-void PiLink::jsonOutputUint8(const char* key, uint8_t offset) {
-    piLink.sendJsonPair(key, *(jsonOutputBase+offset));
-}
-
-void PiLink::jsonOutputUint16(const char* key, uint8_t offset) {
-    piLink.sendJsonPair(key, *((uint16_t*) (jsonOutputBase+offset)));
-}
-
-/**
- * outputs the temp_t at the given offset from tempControl.cc.
- * The temp_t is assumed to be an internal fixed point value.
- */
-void PiLink::jsonOutputTempToString(const char* key,  uint8_t offset) {
-    char buf[12];
-    piLink.sendJsonPair(key, ((temp_t*)(jsonOutputBase+offset))->toTempString(buf, 2, 12, tempControl.cc.tempFormat, true));
-}
-
-void PiLink::jsonOutputFixedPointToString(const char* key, uint8_t offset) {
-    char buf[12];
-    piLink.sendJsonPair(key, ((temp_t*)(jsonOutputBase+offset))->toString(buf, 2, 12));
-}
-
-void PiLink::jsonOutputFixedPointLongToString(const char* key, uint8_t offset) {
-    char buf[12];
-    piLink.sendJsonPair(key, ((temp_long_t*)(jsonOutputBase+offset))->toString(buf, 2, 12));
-}
-
-void PiLink::jsonOutputTempDiffToString(const char* key, uint8_t offset) {
-    char buf[12];
-    piLink.sendJsonPair(key, ((temp_t*)(jsonOutputBase+offset))->toTempString(buf, 2, 12, tempControl.cc.tempFormat, false));
-}
-
-void PiLink::jsonOutputChar(const char* key, uint8_t offset) {
-    piLink.sendJsonPair(key, *((char*)(jsonOutputBase+offset)));
-}
-
-typedef void (*JsonOutputCCHandler)(const char* key, uint8_t offset);
-
-enum JsonOutputIndex {
-    JOCC_UINT8=0,
-    JOCC_TEMP_FORMAT=1,
-    JOCC_FIXED_POINT=2,
-    JOCC_TEMP_DIFF=3,
-    JOCC_CHAR=4,
-    JOCC_UINT16=5,
-    JOCC_FIXED_POINT_LONG=6,
-};
-
-const PiLink::JsonOutputHandler PiLink::JsonOutputHandlers[] = {
-        PiLink::jsonOutputUint8,
-        PiLink::jsonOutputTempToString,
-        PiLink::jsonOutputFixedPointToString,
-        PiLink::jsonOutputTempDiffToString,
-        PiLink::jsonOutputChar,
-        PiLink::jsonOutputUint16,
-        PiLink::jsonOutputFixedPointLongToString,
-};
-
-#define JSON_OUTPUT_CC_MAP(name, fn) { JSONKEY_ ## name,  offsetof(ControlConstants, name), fn }
 #define JSON_OUTPUT_CV_MAP(name, fn) { JSONKEY_ ## name,  offsetof(ControlVariables, name), fn }
 #define JSON_OUTPUT_CS_MAP(name, fn) { JSONKEY_ ## name,  offsetof(ControlSettings, name), fn }
 
-const PiLink::JsonOutput PiLink::jsonOutputCCMap[] = {
-        JSON_OUTPUT_CC_MAP(tempFormat, JOCC_CHAR),
-
-        JSON_OUTPUT_CC_MAP(heater1_kp, JOCC_FIXED_POINT_LONG),
-        JSON_OUTPUT_CC_MAP(heater1_ti, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(heater1_td, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(heater1_infilt, JOCC_UINT8),
-        JSON_OUTPUT_CC_MAP(heater1_dfilt, JOCC_UINT8),
-
-        JSON_OUTPUT_CC_MAP(heater2_kp, JOCC_FIXED_POINT_LONG),
-        JSON_OUTPUT_CC_MAP(heater2_ti, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(heater2_td, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(heater2_infilt, JOCC_UINT8),
-        JSON_OUTPUT_CC_MAP(heater2_dfilt, JOCC_UINT8),
-
-        JSON_OUTPUT_CC_MAP(cooler_kp, JOCC_FIXED_POINT_LONG),
-        JSON_OUTPUT_CC_MAP(cooler_ti, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(cooler_td, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(cooler_infilt, JOCC_UINT8),
-        JSON_OUTPUT_CC_MAP(cooler_dfilt, JOCC_UINT8),
-
-        JSON_OUTPUT_CC_MAP(beer2fridge_kp, JOCC_FIXED_POINT_LONG),
-        JSON_OUTPUT_CC_MAP(beer2fridge_ti, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(beer2fridge_td, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(beer2fridge_infilt, JOCC_UINT8),
-        JSON_OUTPUT_CC_MAP(beer2fridge_dfilt, JOCC_UINT8),
-        JSON_OUTPUT_CC_MAP(beer2fridge_pidMax, JOCC_TEMP_DIFF),
-
-        JSON_OUTPUT_CC_MAP(minCoolTime, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(minCoolIdleTime, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(heater1PwmPeriod, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(heater2PwmPeriod, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(coolerPwmPeriod, JOCC_UINT16),
-        JSON_OUTPUT_CC_MAP(mutexDeadTime, JOCC_UINT16)
-};
-
 void PiLink::sendJsonValues(char responseType, const JsonOutput* jsonOutputMap, uint8_t mapCount) {
+    char buf[JSON_OUTPUT_VALUE_SIZE];
     printResponse(responseType);
     while (mapCount-->0) {
         JsonOutput output;
         memcpy(&output, jsonOutputMap++, sizeof(output));
-        JsonOutputHandlers[output.handlerOffset](output.key,output.offset);
+        printJsonName(output.key);
+        piStream.print(formatJsonOutput(buf, jsonOutputBase, output, tempControl.cc.tempFormat));
     }
     sendJsonClose();
 }
 
 // Send control constants as JSON string. Might contain spaces between minus sign and number. Python will have to strip these
 void PiLink::sendControlConstants(void){
+    if(binaryMode){
+        PiStreamFrameWriter out('C');
+        writeControlConstants(out);
+        out.flush();
+        return;
+    }
     jsonOutputBase = (uint8_t*)&tempControl.cc;
-    sendJsonValues('C', jsonOutputCCMap, sizeof(jsonOutputCCMap)/sizeof(jsonOutputCCMap[0]));
+    sendJsonValues('C', jsonOutputCCMap, jsonOutputCCMapCount);
 }
 
+// Streams the JSON output of the ESJ serialize functions to piStream
+class PiStreamJsonWriter : public JsonStreamWriter {
+protected:
+    void write(const char* data, uint8_t length) override final {
+        piStream.write(reinterpret_cast<const uint8_t*>(data), length);
+    }
+};
+
 // This function now sends the entire Control object as json using ESJ
 void PiLink::sendControlVariables(void){
+    if(binaryMode){
+        PiStreamFrameWriter out('V');
+        writeControlVariables(out);
+        out.flush();
+        return;
+    }
     piStream.print('V');
     piStream.print(':');
-    JSON::serial_producer<Control>::convert(control, piStream);
+    PiStreamJsonWriter writer;
+    control.serialize(writer);
+    writer.flush();
     piStream.println();
 }
 
+void PiLink::writeTemperatures(BinaryFrameWriter & out, const char * beerAnnotation, const char * fridgeAnnotation){
+    BinaryStreamWriter adapter(out);
+    temp_t beerTemp = tempControl.getBeerTemp();
+    temp_t beerSet = tempControl.getBeerSetting();
+    temp_t fridgeTemp = tempControl.getFridgeTemp();
+    temp_t fridgeSet = tempControl.getFridgeSetting();
+    temp_t log1Temp = tempControl.getLog1Temp();
+    temp_t log2Temp = tempControl.getLog2Temp();
+    temp_t log3Temp = tempControl.getLog3Temp();
+    uint8_t state = tempControl.getState();
+
+    adapter.serialize(JSON::T_OBJ_BEGIN);
+    adapter.serialize(JSON_BEER_TEMP, beerTemp, true);
+    adapter.serialize(JSON_BEER_SET, beerSet, true);
+    // an empty annotation is null in the JSON response
+    out.describe(JSON_BEER_ANN, 0);
+    out.describe(nullptr, BINARY_STRING);
+    out.putString(beerAnnotation ? beerAnnotation : "");
+    out.describe(JSON::T_COMMA);
+    adapter.serialize(JSON_FRIDGE_TEMP, fridgeTemp, true);
+    adapter.serialize(JSON_FRIDGE_SET, fridgeSet, true);
+    out.describe(JSON_FRIDGE_ANN, 0);
+    out.describe(nullptr, BINARY_STRING);
+    out.putString(fridgeAnnotation ? fridgeAnnotation : "");
+    out.describe(JSON::T_COMMA);
+    adapter.serialize(JSON_LOG1_TEMP, log1Temp, true);
+    adapter.serialize(JSON_LOG2_TEMP, log2Temp, true);
+    adapter.serialize(JSON_LOG3_TEMP, log3Temp, true);
+    adapter.serialize(JSON_STATE, state, false);
+    adapter.serialize(JSON::T_OBJ_END);
+}
+
+void PiLink::writeControlSettings(BinaryFrameWriter & out){
+    BinaryStreamWriter adapter(out);
+    ControlSettings& cs = tempControl.cs;
+    uint8_t mode = cs.mode;
+    adapter.serialize(JSON::T_OBJ_BEGIN);
+    adapter.serialize(JSONKEY_mode, mode, true);
+    adapter.serialize(JSONKEY_beerSetting, cs.beerSetting, true);
+    adapter.serialize(JSONKEY_fridgeSetting, cs.fridgeSetting, false);
+    adapter.serialize(JSON::T_OBJ_END);
+}
+
+// walks the same map as the JSON response, temperatures are sent as raw values in Celsius
+void PiLink::writeControlConstants(BinaryFrameWriter & out){
+    writeJsonOutputs(out, (uint8_t*)&tempControl.cc, jsonOutputCCMap, jsonOutputCCMapCount);
+}
+
+void PiLink::writeControlVariables(BinaryFrameWriter & out){
+    BinaryStreamWriter adapter(out);
+    control.serialize(adapter);
+}
+
+// The schema lists the keys and types of a binary response, the host asks for it when the schema id changes
+void PiLink::sendSchema(int request){
+    PiStreamFrameWriter out(char(request), true);
+    switch(request){
+    case 't':
+        writeTemperatures(out, 0, 0);
+        break;
+    case 's':
+        writeControlSettings(out);
+        break;
+    case 'c':
+        writeControlConstants(out);
+        break;
+    case 'v':
+        writeControlVariables(out);
+        break;
+    default:
+    {
+        // answer anyway, so the host does not wait for a schema that does not exist
+        PiStreamFrameWriter error(BinaryFrameWriter::ERROR_TYPE);
+        error.describe(nullptr, BINARY_SIGNED);
+        error.putSigned(request);
+        error.flush();
+        return;
+    }
+    }
+    out.flush();
+}
+
+#if BREWPI_PROFILING
+// Send loop timing as JSON. Loop periods and object times are in microseconds, PWM edge lateness in milliseconds.
+// Objects are identified by their index in control.objects, or -1 when the object is not in that list.
+void PiLink::sendProfile(void){
+    printResponse('P');
+    printJsonName("loop");
+    printHistogram(profiler.loopPeriods());
+    printJsonName("pwmLate");
+    printHistogram(profiler.pwmLateness());
+    printJsonName("other");
+    printHistogram(profiler.overflow());
+    printJsonName("objects");
+    piStream.print('[');
+    for(uint8_t i = 0; i < profiler.entryCount(); i++){
+        const LoopProfiler::Entry & e = profiler.entry(i);
+        int index = -1;
+        for(size_t j = 0; j < control.objects.size(); j++){
+            if(control.objects[j] == e.object){
+                index = j;
+                break;
+            }
+        }
+        if(i > 0){
+            piStream.print(',');
+        }
+        print("{\"i\":%d,\"p\":%d,\"t\":", index, int(e.phase));
+        printHistogram(e.micros);
+        piStream.print('}');
+    }
+    piStream.print(']');
+    sendJsonClose();
+}
+
+// Print a histogram as {"max":m,"n":count,"h":[bucket counts]}, see TimingHistogram for the bucket ranges
+void PiLink::printHistogram(const TimingHistogram & h){
+    print("{\"max\":%lu,\"n\":%lu,\"h\":[", (unsigned long) h.max(), (unsigned long) h.count());
+    for(uint8_t i = 0; i < TimingHistogram::BUCKETS; i++){
+        print(i > 0 ? ",%u" : "%u", (unsigned) h.bucket(i));
+    }
+    print("]}");
+}
+#endif
+
 void PiLink::printJsonName(const char * name)
 {
     printJsonSeparator();
@@ -24,10 +24,13 @@
 #include "temperatureFormats.h"
 #include "DeviceManager.h"
 #include "Logger.h"
+#include "LoopProfiler.h"
+#include "JsonOutputMap.h"
 
 #define PRINTF_BUFFER_SIZE 128
 
 struct DeviceConfig;
+class BinaryFrameWriter;
 
 
 class PiLink{
@@ -57,6 +60,10 @@ class PiLink{
 	static void receiveControlConstants(void);
 	static void sendControlConstants(void);
 	static void sendControlVariables(void);
+#if BREWPI_PROFILING
+	static void sendProfile(void);
+	static void printHistogram(const TimingHistogram & h);
+#endif
 	
 	static void receiveJson(void); // receive settings as JSON key:value pairs
 	
@@ -68,13 +75,14 @@ class PiLink{
 	static void soundAlarm(bool enabled);
 	static void printResponse(char responseChar);
 
+	static void sendTemperatures(char * beerAnnotation, char * fridgeAnnotation);
 	static void printTemperaturesJSON(char * beerAnnotation, char * fridgeAnnotation);
 	static void sendJsonPair(const char * name, const char * val); // send one JSON pair with a string value as name:val,
 	static void sendJsonPair(const char * name, char val); // send one JSON pair with a char value as name:val,
 	static void sendJsonPair(const char * name, uint16_t val); // send one JSON pair with a uint16_t value as name:val,
 	static void sendJsonPair(const char * name, uint8_t val); // send one JSON pair with a uint8_t value as name:val,
 	static void sendJsonAnnotation(const char* name, const char* annotation);
-	static void sendJsonTemp(const char* name, const temp_t & temp);
+	static void sendJsonTemp(const char* name, const char * & formatted);
 	
 	static void processJsonPair(const char * key, const char * val, void* pv); // process one pair
 	
@@ -86,26 +94,14 @@ class PiLink{
 	static void openListResponse(char type);
 	static void closeListResponse();
 
-	struct JsonOutput {
-		const char* key;			// JSON key
-		uint8_t offset;			// offset into TempControl class
-		uint8_t handlerOffset;		// handler index
-	};
-	typedef void (*JsonOutputHandler)(const char* key, uint8_t offset);
 	static void sendJsonValues(char responseType, const JsonOutput* /*PROGMEM*/ jsonOutputMap, uint8_t mapCount);
 
-
-	// handler functions for JSON output
-	static void jsonOutputUint8(const char* key, uint8_t offset);
-	static void jsonOutputTempToString(const char* key, uint8_t offset);
-	static void jsonOutputFixedPointToString(const char* key, uint8_t offset);
-	static void jsonOutputFixedPointLongToString(const char* key, uint8_t offset);
-	static void jsonOutputTempDiffToString(const char* key, uint8_t offset);
-	static void jsonOutputChar(const char* key, uint8_t offset);
-	static void jsonOutputUint16(const char* key, uint8_t offset);
-	static const JsonOutputHandler JsonOutputHandlers[];		
-	static const JsonOutput jsonOutputCCMap[];
-	static const JsonOutput jsonOutputCVMap[];
+	// binary mode: the same responses as values in binary frames, see BinaryFrame.h
+	static void sendSchema(int request);
+	static void writeTemperatures(BinaryFrameWriter & out, const char * beerAnnotation, const char * fridgeAnnotation);
+	static void writeControlSettings(BinaryFrameWriter & out);
+	static void writeControlConstants(BinaryFrameWriter & out);
+	static void writeControlVariables(BinaryFrameWriter & out);
 
 	// Json parsing
 
@@ -135,6 +131,7 @@ class PiLink{
 
 	private:
 	static bool firstPair;
+	static bool binaryMode;
 	friend class DeviceManager;
 	friend class PiLinkTest;
 	friend class BrewPiLogger;
@@ -26,53 +26,15 @@
 #include "ModeControl.h"
 #include "Ticks.h"
 #include "Control.h"
+#include "ControlConstants.h"
 
-// These two structs are stored in and loaded from EEPROM
+// Stored in and loaded from EEPROM, like ControlConstants
 struct ControlSettings {
     control_mode_t mode;
     temp_t beerSetting;
     temp_t fridgeSetting;
 };
 
-struct ControlConstants {
-    char tempFormat;
-
-    //settings for heater 1
-    temp_long_t heater1_kp;
-    uint16_t heater1_ti;
-    uint16_t heater1_td;
-    uint8_t heater1_infilt;
-    uint8_t heater1_dfilt;
-
-    //settings for heater 2
-    temp_long_t heater2_kp;
-    uint16_t heater2_ti;
-    uint16_t heater2_td;
-    uint8_t heater2_infilt;
-    uint8_t heater2_dfilt;
-
-    //settings for cooler
-    temp_long_t cooler_kp;
-    uint16_t cooler_ti;
-    uint16_t cooler_td;
-    uint8_t cooler_infilt;
-    uint8_t cooler_dfilt;
-
-    //settings for beer2fridge PID
-    temp_long_t beer2fridge_kp;
-    uint16_t beer2fridge_ti;
-    uint16_t beer2fridge_td;
-    uint8_t beer2fridge_infilt;
-    uint8_t beer2fridge_dfilt;
-    temp_t beer2fridge_pidMax;
-
-    uint16_t minCoolTime;
-    uint16_t minCoolIdleTime;
-    uint16_t heater1PwmPeriod;
-    uint16_t heater2PwmPeriod;
-    uint16_t coolerPwmPeriod;
-    uint16_t mutexDeadTime;
-};
 
 #define EEPROM_TC_SETTINGS_BASE_ADDRESS 0
 #define EEPROM_CONTROL_SETTINGS_ADDRESS (EEPROM_TC_SETTINGS_BASE_ADDRESS+sizeof(uint8_t))
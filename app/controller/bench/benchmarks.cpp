@@ -0,0 +1,185 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Benchmark.h"
+
+#include "Control.h"
+#include "json_writer.h"
+#include "JsonStreamWriter.h"
+#include "BinaryFrame.h"
+#include "BinaryStreamWriter.h"
+#include <vector>
+
+/*
+ * Formats values like the SerialSink that PiLink used on the device, but drops the output.
+ */
+class DiscardSink : public JSON::ISink {
+public:
+    size_t size = 0;
+
+    JSON::ISink& operator<<(const char* arg) override final           { size += strlen(arg); return (*this); }
+    JSON::ISink& operator<<(const std::string& arg) override final    { size += arg.size(); return (*this); }
+    JSON::ISink& operator<<(const std::wstring& arg) override final   { size += Chordia::convert(arg).size(); return (*this); }
+    JSON::ISink& operator<<(const char& arg) override final           { size += 1; return (*this); }
+    JSON::ISink& operator<<(const int8_t& arg) override final         { size += Chordia::toString(arg,10).size(); return (*this); }
+    JSON::ISink& operator<<(const int16_t& arg) override final        { size += Chordia::toString(arg,10).size(); return (*this); }
+    JSON::ISink& operator<<(const int32_t& arg) override final        { size += Chordia::toString(arg,10).size(); return (*this); }
+    JSON::ISink& operator<<(const uint8_t& arg) override final        { size += Chordia::toString(arg,10).size(); return (*this); }
+    JSON::ISink& operator<<(const uint16_t& arg) override final       { size += Chordia::toString(arg,10).size(); return (*this); }
+    JSON::ISink& operator<<(const uint32_t& arg) override final       { size += Chordia::toString(arg,10).size(); return (*this); }
+#ifndef ESJ_DISABLE_DOUBLE
+    JSON::ISink& operator<<(const double& arg) override final         { size += Chordia::DoubleConverter<>::Convert(arg).size(); return (*this); }
+#endif
+    JSON::ISink& operator<<(const bool& arg) override final           { size += arg ? 4 : 5; return (*this); }
+    JSON::ISink& operator<<(const temp_t& arg) override final         { size += arg.toCstring().size(); return (*this); }
+    JSON::ISink& operator<<(const temp_precise_t& arg) override final { size += arg.toCstring().size(); return (*this); }
+    JSON::ISink& operator<<(const temp_long_t& arg) override final    { size += arg.toCstring().size(); return (*this); }
+};
+
+class DiscardJsonWriter : public JsonStreamWriter {
+protected:
+    void write(const char* data, uint8_t length) override final {
+        doNotOptimize(data[length - 1]);
+    }
+};
+
+class DiscardBinaryWriter : public BinaryFrameWriter {
+public:
+    DiscardBinaryWriter() : BinaryFrameWriter('V') {}
+
+protected:
+    void write(const uint8_t * data, uint8_t length) override final {
+        doNotOptimize(data[length - 1]);
+    }
+};
+
+class VectorBinaryWriter : public BinaryFrameWriter {
+public:
+    VectorBinaryWriter() : BinaryFrameWriter('V') {}
+
+    std::vector<uint8_t> output;
+
+protected:
+    void write(const uint8_t * data, uint8_t length) override final {
+        output.insert(output.end(), data, data + length);
+    }
+};
+
+class StringJsonWriter : public JsonStreamWriter {
+public:
+    std::string output;
+
+protected:
+    void write(const char* data, uint8_t length) override final {
+        output.append(data, length);
+    }
+};
+
+// the full 'v' dump, built as a std::string by the ESJ producer
+BENCHMARK(control_json_esj_string) {
+    control.update();
+    bench.measure([&] {
+        std::string json = JSON::producer<Control>::convert(control);
+        doNotOptimize(json.size());
+    });
+}
+
+// the full 'v' dump, written by the ESJ writer to a stream sink, like PiLink did on the device
+BENCHMARK(control_json_esj_sink) {
+    control.update();
+    bench.measure([&] {
+        DiscardSink sink;
+        JSON::Writer writer(&sink);
+        control.serialize(writer);
+        doNotOptimize(sink.size);
+    });
+}
+
+// the full 'v' dump, written by the buffered stream writer that PiLink uses now
+BENCHMARK(control_json_stream) {
+    control.update();
+    bench.measure([&] {
+        DiscardJsonWriter writer;
+        control.serialize(writer);
+        writer.flush();
+        doNotOptimize(writer.size());
+    });
+}
+
+// the full 'v' dump in the binary PiLink mode
+BENCHMARK(control_binary_stream) {
+    control.update();
+    bench.measure([&] {
+        DiscardBinaryWriter writer;
+        BinaryStreamWriter adapter(writer);
+        control.serialize(adapter);
+        writer.flush();
+        doNotOptimize(writer.size());
+    });
+}
+
+// what the host does with a 'v' dump in JSON at the least: find the values and convert the numbers
+BENCHMARK(control_json_scan) {
+    control.update();
+    StringJsonWriter writer;
+    control.serialize(writer);
+    writer.flush();
+    bench.measure([&] {
+        double sum = 0;
+        const char * p = writer.output.c_str();
+        while(*p){
+            char c = *p++;
+            if(c == ':' || c == ',' || c == '['){
+                if(*p == '-' || (*p >= '0' && *p <= '9')){
+                    char * end;
+                    sum += strtod(p, &end);
+                    p = end;
+                }
+            }
+            else if(c == '"'){
+                while(*p && *p++ != '"'){
+                }
+            }
+        }
+        doNotOptimize(sum);
+    });
+}
+
+// what the host does with a 'v' dump in binary: check the frames and read the values
+BENCHMARK(control_binary_decode) {
+    control.update();
+    VectorBinaryWriter writer;
+    BinaryStreamWriter adapter(writer);
+    control.serialize(adapter);
+    writer.flush();
+    BinaryFrameDecoder decoder;
+    bench.measure([&] {
+        int32_t sum = 0;
+        for(uint8_t b : writer.output){
+            if(decoder.receive(b)){
+                BinaryPayloadReader in(decoder.payload(), decoder.length());
+                int32_t value;
+                while(in.getSigned(value)){
+                    sum += value;
+                }
+            }
+        }
+        doNotOptimize(sum);
+    });
+}
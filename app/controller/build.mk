@@ -25,6 +25,7 @@ CPPSRC += $(call target_files,app/controller,*.cpp)
 
 CEXCLUDES += $(call target_files,app/controller/test,*.c)
 CPPEXCLUDES += $(call target_files,app/controller/test,*.cpp) 
+CPPEXCLUDES += $(call target_files,app/controller/bench,*.cpp)
 
 CSRC += $(call target_files,lib/src,*.c)
 CPPSRC += $(call target_files,lib/src,*.cpp)
@@ -107,7 +107,7 @@ class Adapter
 	virtual void serialize(TokenType) = 0;
 
 	// support for fundamental types so we can stream vector<T>
-	virtual void serialize(const std::string&) = 0;
+	virtual void serialize(const char*) = 0;
 	virtual void serialize(std::wstring&) = 0;
 	virtual void serialize(std::string&) = 0;
 	virtual void serialize(int8_t&) = 0;
@@ -125,21 +125,21 @@ class Adapter
 	virtual void serialize(temp_long_t&) = 0;
 	
 	// key/value pairs
-	virtual void serialize(const std::string&,std::wstring&,bool) = 0;
-	virtual void serialize(const std::string&,std::string&,bool) = 0;
-	virtual void serialize(const std::string&,int8_t&,bool) = 0;
-	virtual void serialize(const std::string&,int16_t&,bool) = 0;
-	virtual void serialize(const std::string&,int32_t&,bool) = 0;
-	virtual void serialize(const std::string&,uint8_t&,bool) = 0;
-    virtual void serialize(const std::string&,uint16_t&,bool) = 0;
-    virtual void serialize(const std::string&,uint32_t&,bool) = 0;
+	virtual void serialize(const char*,std::wstring&,bool) = 0;
+	virtual void serialize(const char*,std::string&,bool) = 0;
+	virtual void serialize(const char*,int8_t&,bool) = 0;
+	virtual void serialize(const char*,int16_t&,bool) = 0;
+	virtual void serialize(const char*,int32_t&,bool) = 0;
+	virtual void serialize(const char*,uint8_t&,bool) = 0;
+    virtual void serialize(const char*,uint16_t&,bool) = 0;
+    virtual void serialize(const char*,uint32_t&,bool) = 0;
 #ifndef ESJ_DISABLE_DOUBLE
-    virtual void serialize(const std::string&,double&,bool) = 0;
+    virtual void serialize(const char*,double&,bool) = 0;
 #endif
-	virtual void serialize(const std::string&,bool&,bool) = 0;
-	virtual void serialize(const std::string&,temp_t&,bool) = 0;
-	virtual void serialize(const std::string&,temp_precise_t&,bool) = 0;
-	virtual void serialize(const std::string&,temp_long_t&,bool) = 0;
+	virtual void serialize(const char*,bool&,bool) = 0;
+	virtual void serialize(const char*,temp_t&,bool) = 0;
+	virtual void serialize(const char*,temp_precise_t&,bool) = 0;
+	virtual void serialize(const char*,temp_long_t&,bool) = 0;
 
 };
 
@@ -171,7 +171,7 @@ inline void stream(Adapter& adapter,TokenType type)
 }
 
 //-----------------------------------------------------------------------------
-inline void stream(Adapter& adapter,const std::string& value)
+inline void stream(Adapter& adapter,const char* value)
 {
 	//
 	adapter.serialize(value);
@@ -272,7 +272,7 @@ inline void stream(Adapter& adapter,temp_long_t& value)
 
 //-----------------------------------------------------------------------------
 // string
-inline void	stream(Adapter& adapter,const std::string& key,std::string& value,bool more)
+inline void	stream(Adapter& adapter,const char* key,std::string& value,bool more)
 {
 	//
 	adapter.serialize(key,value,more);
@@ -280,7 +280,7 @@ inline void	stream(Adapter& adapter,const std::string& key,std::string& value,bo
 
 //-----------------------------------------------------------------------------
 // wstring
-inline void stream(Adapter& adapter,const std::string& key,std::wstring& value,bool more)
+inline void stream(Adapter& adapter,const char* key,std::wstring& value,bool more)
 {
 	//
 	adapter.serialize(key,value,more);
@@ -289,7 +289,7 @@ inline void stream(Adapter& adapter,const std::string& key,std::wstring& value,b
 #ifndef ESJ_DISABLE_DOUBLE
 //-----------------------------------------------------------------------------
 // doubles
-inline void	stream(Adapter& adapter,const std::string& key,double& value,bool more)
+inline void	stream(Adapter& adapter,const char* key,double& value,bool more)
 {
 	adapter.serialize(key,value,more);
 }
@@ -297,70 +297,70 @@ inline void	stream(Adapter& adapter,const std::string& key,double& value,bool mo
 
 //-----------------------------------------------------------------------------
 // int8_t
-inline void	stream(Adapter& adapter,const std::string& key,int8_t& value,bool more)
+inline void	stream(Adapter& adapter,const char* key,int8_t& value,bool more)
 {
 	adapter.serialize(key,value,more);
 }
 
 //-----------------------------------------------------------------------------
 // int16_t
-inline void stream(Adapter& adapter,const std::string& key,int16_t& value,bool more)
+inline void stream(Adapter& adapter,const char* key,int16_t& value,bool more)
 {
     adapter.serialize(key,value,more);
 }
 
 //-----------------------------------------------------------------------------
 // int32_t
-inline void stream(Adapter& adapter,const std::string& key,int32_t& value,bool more)
+inline void stream(Adapter& adapter,const char* key,int32_t& value,bool more)
 {
     adapter.serialize(key,value,more);
 }
 
 //-----------------------------------------------------------------------------
 // uint8_t
-inline void stream(Adapter& adapter,const std::string& key,uint8_t& value,bool more)
+inline void stream(Adapter& adapter,const char* key,uint8_t& value,bool more)
 {
     adapter.serialize(key,value,more);
 }
 
 //-----------------------------------------------------------------------------
 // uint16_t
-inline void stream(Adapter& adapter,const std::string& key,uint16_t& value,bool more)
+inline void stream(Adapter& adapter,const char* key,uint16_t& value,bool more)
 {
     adapter.serialize(key,value,more);
 }
 
 //-----------------------------------------------------------------------------
 // uint32_t
-inline void stream(Adapter& adapter,const std::string& key,uint32_t& value,bool more)
+inline void stream(Adapter& adapter,const char* key,uint32_t& value,bool more)
 {
     adapter.serialize(key,value,more);
 }
 
 //-----------------------------------------------------------------------------
 // bool
-inline void	stream(Adapter& adapter,const std::string& key,bool& value,bool more)
+inline void	stream(Adapter& adapter,const char* key,bool& value,bool more)
 {
 	adapter.serialize(key,value,more);
 }
 
 //-----------------------------------------------------------------------------
 // temp_t
-inline void stream(Adapter& adapter,const std::string& key,temp_t& value,bool more)
+inline void stream(Adapter& adapter,const char* key,temp_t& value,bool more)
 {
     adapter.serialize(key,value,more);
 }
 
 //-----------------------------------------------------------------------------
 // temp_precise_t
-inline void stream(Adapter& adapter,const std::string& key,temp_precise_t& value,bool more)
+inline void stream(Adapter& adapter,const char* key,temp_precise_t& value,bool more)
 {
     adapter.serialize(key,value,more);
 }
 
 //-----------------------------------------------------------------------------
 // temp_long_t
-inline void stream(Adapter& adapter,const std::string& key,temp_long_t& value,bool more)
+inline void stream(Adapter& adapter,const char* key,temp_long_t& value,bool more)
 {
     adapter.serialize(key,value,more);
 }
@@ -387,7 +387,7 @@ inline void stream(Adapter& adapter,T* arg)
 // serialize a single instance of T. 
 // Highlights an asymmetry in JSON (or more likely Javascript ...)
 template <typename T>
-inline void stream(Adapter& adapter,const std::string& key,T& value,bool more)
+inline void stream(Adapter& adapter,const char* key,T& value,bool more)
 {
     // use class pointer function below
     stream(adapter,key, &value, more);
@@ -396,7 +396,7 @@ inline void stream(Adapter& adapter,const std::string& key,T& value,bool more)
 //-----------------------------------------------------------------------------
 // serialize a single instance of T, where T is a class pointer.
 template <typename T>
-inline void stream(Adapter& adapter,const std::string& key,T * value,bool more)
+inline void stream(Adapter& adapter,const char* key,T * value,bool more)
 {
     // handle the value
     adapter.serialize(key);
@@ -428,7 +428,7 @@ inline void stream(Adapter& adapter,const std::string& key,T * value,bool more)
 // array : [ { e0 }, { e1 }, ..., { eN } ]
 // 
 template <typename T>
-inline void stream_primitives(Adapter& adapter,const std::string& key,std::vector<T>& value,bool more)
+inline void stream_primitives(Adapter& adapter,const char* key,std::vector<T>& value,bool more)
 {
 	typedef typename::std::vector<T>::iterator iterator_t;
 	if (adapter.storing())
@@ -494,7 +494,7 @@ inline void stream_primitives(Adapter& adapter,const std::string& key,std::vecto
 //-----------------------------------------------------------------------------
 // this is the serializer for any non-primitive types including your own ...
 template <typename T>
-inline void stream_classes(Adapter& adapter,const std::string& key,std::vector<T>& value,bool more)
+inline void stream_classes(Adapter& adapter,const char* key,std::vector<T>& value,bool more)
 {
 	typedef typename::std::vector<T>::iterator iterator_t;
 	if (adapter.storing())
@@ -580,7 +580,7 @@ inline void stream_classes(Adapter& adapter,const std::string& key,std::vector<T
 
 	public:
 
-		Class(Adapter& adapter,const std::string& type_name) : m_pAdapter(&adapter) 
+		Class(Adapter& adapter,const char* type_name) : m_pAdapter(&adapter) 
 		{
 			// monitor the nesting level - this could be checked at runtime
 			// to ensure nesting is not excessively deep to protect stack resources.
@@ -619,13 +619,13 @@ inline void stream_classes(Adapter& adapter,const std::string& key,std::vector<T
 
 
 template <typename T>
-inline void stream_selector(Adapter& adapter,const std::string& key,std::vector<T>& value,bool more, std::true_type)
+inline void stream_selector(Adapter& adapter,const char* key,std::vector<T>& value,bool more, std::true_type)
 {
     stream_primitives<T>(adapter,key,value,more);
 }
 
 template <typename T>
-inline void stream_selector(Adapter& adapter,const std::string& key,std::vector<T>& value,bool more, std::false_type)
+inline void stream_selector(Adapter& adapter,const char* key,std::vector<T>& value,bool more, std::false_type)
 {
     stream_classes<T>(adapter,key,value,more);
 }
@@ -633,7 +633,7 @@ inline void stream_selector(Adapter& adapter,const std::string& key,std::vector<
 //-----------------------------------------------------------------------------
 // serialize a vector of T
 template <typename T>
-inline void stream(Adapter& adapter,const std::string& key,std::vector<T>& value,bool more)
+inline void stream(Adapter& adapter,const char* key,std::vector<T>& value,bool more)
 {
     constexpr bool is_primitive = std::is_same<T,std::wstring>::value ||
             std::is_same<T,std::string>::value ||
@@ -180,78 +180,78 @@ namespace JSON
 
 		//---------------------------------------------------------------------
 		// write a key/value pair with optional continuation
-		virtual void serialize(const std::string& key,std::string& value,bool more) override final
+		virtual void serialize(const char* key,std::string& value,bool more) override final
 		{
 			(*_sink) << "\"" << key << Quote() << ':' << Quote() << Chordia::escape(value) << Quote() << (more ? "," : "");
 		}
 
 
-		virtual void serialize(const std::string& key,std::wstring& value,bool more) override final
+		virtual void serialize(const char* key,std::wstring& value,bool more) override final
 		{
 			(*_sink) << Quote() << key << Quote() << ':' << Quote() << Chordia::escape(Chordia::w2n(value)) << Quote() << (more ? "," : "");
 		}
 
-		virtual void serialize(const std::string& key,int8_t& value,bool more) override final
+		virtual void serialize(const char* key,int8_t& value,bool more) override final
 		{
 			(*_sink) << Quote() << key << Quote() << ':' << value << (more ? "," : "");
 		}
 		
-		virtual void serialize(const std::string& key,int16_t& value,bool more) override final
+		virtual void serialize(const char* key,int16_t& value,bool more) override final
         {
             (*_sink) << Quote() << key << Quote() << ':' << value << (more ? "," : "");
         }
 
-		virtual void serialize(const std::string& key,int32_t& value,bool more) override final
+		virtual void serialize(const char* key,int32_t& value,bool more) override final
         {
             (*_sink) << Quote() << key << Quote() << ':' << value << (more ? "," : "");
         }
 
-        virtual void serialize(const std::string& key,uint8_t& value,bool more) override final
+        virtual void serialize(const char* key,uint8_t& value,bool more) override final
         {
             (*_sink) << Quote() << key << Quote() << ':' << value << (more ? "," : "");
         }
 
-        virtual void serialize(const std::string& key,uint16_t& value,bool more) override final
+        virtual void serialize(const char* key,uint16_t& value,bool more) override final
         {
             (*_sink) << Quote() << key << Quote() << ':' << value << (more ? "," : "");
         }
 
-        virtual void serialize(const std::string& key,uint32_t& value,bool more) override final
+        virtual void serialize(const char* key,uint32_t& value,bool more) override final
         {
             (*_sink) << Quote() << key << Quote() << ':' << value << (more ? "," : "");
         }
 
 #ifndef ESJ_DISABLE_DOUBLE
-		virtual void serialize(const std::string& key,double& value,bool more) 
+		virtual void serialize(const char* key,double& value,bool more) 
 		{
 			(*_sink) << Quote() << key << Quote() << ':' << value << (more ? "," : "");
 		}
 #endif
 
-		virtual void serialize(const std::string& key,bool& value,bool more) override final
+		virtual void serialize(const char* key,bool& value,bool more) override final
 		{
 			// literal true of false
 			(*_sink) << Quote() << key << Quote() << ':' << value << (more ? "," : "");
 		}
 
-		virtual void serialize(const std::string& key,temp_t& value,bool more) override final
+		virtual void serialize(const char* key,temp_t& value,bool more) override final
         {
             (*_sink) << Quote() << key << Quote() << ':' << value.toCstring() << (more ? "," : "");
         }
 
-		virtual void serialize(const std::string& key,temp_precise_t& value,bool more) override final
+		virtual void serialize(const char* key,temp_precise_t& value,bool more) override final
         {
             (*_sink) << Quote() << key << Quote() << ':' << value.toCstring() << (more ? "," : "");
         }
 
-		virtual void serialize(const std::string& key,temp_long_t& value,bool more) override final
+		virtual void serialize(const char* key,temp_long_t& value,bool more) override final
         {
             (*_sink) << Quote() << key << Quote() << ':' << value.toCstring() << (more ? "," : "");
         }
 
 		//---------------------------------------------------------------------
 		// write a literal
-		virtual void serialize(const std::string& value) override final
+		virtual void serialize(const char* value) override final
 		{
 			(*_sink) << Quote() << value << Quote() ;
 		}
@@ -0,0 +1,496 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Control.h"
+#include "BinaryFrame.h"
+#include "BinaryStreamWriter.h"
+#include "JsonStreamWriter.h"
+#include "JsonOutputMap.h"
+#include "ControlConstants.h"
+
+/*
+ * Collects the frames
+ */
+class StringBinaryWriter : public BinaryFrameWriter {
+public:
+    StringBinaryWriter(char type, bool schemaOnly = false) : BinaryFrameWriter(type, schemaOnly) {}
+
+    std::vector<uint8_t> output;
+    std::vector<uint8_t> frames;
+
+protected:
+    void write(const uint8_t * data, uint8_t length) override final {
+        output.insert(output.end(), data, data + length);
+        frames.push_back(length);
+    }
+};
+
+class StringJsonOutput : public JsonStreamWriter {
+public:
+    std::string output;
+
+protected:
+    void write(const char* data, uint8_t length) override final {
+        output.append(data, length);
+    }
+};
+
+struct Message {
+    char type;
+    std::vector<uint8_t> payload;
+    uint16_t schemaId;
+};
+
+std::vector<Message> decode(const std::vector<uint8_t> & stream, BinaryFrameDecoder & decoder){
+    std::vector<Message> messages;
+    for(uint8_t b : stream){
+        if(decoder.receive(b)){
+            Message m;
+            m.type = decoder.type();
+            m.payload.assign(decoder.payload(), decoder.payload() + decoder.length());
+            m.schemaId = decoder.schemaId();
+            messages.push_back(m);
+        }
+    }
+    return messages;
+}
+
+std::vector<Message> decode(const std::vector<uint8_t> & stream){
+    BinaryFrameDecoder decoder;
+    return decode(stream, decoder);
+}
+
+template<typename T>
+std::vector<uint8_t> streamBinary(T & source, char type = 'V', bool schemaOnly = false){
+    StringBinaryWriter writer(type, schemaOnly);
+    BinaryStreamWriter adapter(writer);
+    source.serialize(adapter);
+    writer.flush();
+    return writer.output;
+}
+
+template<typename T>
+std::string streamJson(T & source){
+    StringJsonOutput writer;
+    source.serialize(writer);
+    writer.flush();
+    return writer.output;
+}
+
+/*
+ * What the host does: walks the schema and replays the keys, literals and values into a JSON writer
+ */
+std::string toJson(const Message & schema, const Message & values){
+    StringJsonOutput json;
+    BinaryPayloadReader entries(schema.payload.data(), schema.payload.size());
+    BinaryPayloadReader in(values.payload.data(), values.payload.size());
+    uint32_t field;
+    char text[64];
+    while(entries.getUnsigned(field)){
+        BOOST_REQUIRE(entries.getString(text, sizeof(text)));
+        uint32_t u = 0;
+        int32_t i = 0;
+        switch(field){
+        case 0: // key
+            json.serialize(text);
+            json.serialize(JSON::T_COLON);
+            break;
+        case BINARY_LITERAL:
+            json.serialize(text);
+            break;
+        case BINARY_UNSIGNED:
+            BOOST_REQUIRE(in.getUnsigned(u));
+            json.serialize(u);
+            break;
+        case BINARY_SIGNED:
+            BOOST_REQUIRE(in.getSigned(i));
+            json.serialize(i);
+            break;
+        case BINARY_BOOL: {
+            BOOST_REQUIRE(in.getUnsigned(u));
+            bool b = u != 0;
+            json.serialize(b);
+            break;
+        }
+        case BINARY_STRING: {
+            BOOST_REQUIRE(in.getString(text, sizeof(text)));
+            std::string s = text;
+            json.serialize(s);
+            break;
+        }
+#ifndef ESJ_DISABLE_DOUBLE
+        case BINARY_DOUBLE: {
+            double d;
+            BOOST_REQUIRE(in.getDouble(d));
+            json.serialize(d);
+            break;
+        }
+#endif
+        case BINARY_TEMP: {
+            BOOST_REQUIRE(in.getSigned(i));
+            temp_t t;
+            t.setRaw(int16_t(i));
+            json.serialize(t);
+            break;
+        }
+        case BINARY_TEMP_PRECISE: {
+            BOOST_REQUIRE(in.getSigned(i));
+            temp_precise_t t;
+            t.setRaw(i);
+            json.serialize(t);
+            break;
+        }
+        case BINARY_TEMP_LONG: {
+            BOOST_REQUIRE(in.getSigned(i));
+            temp_long_t t;
+            t.setRaw(i);
+            json.serialize(t);
+            break;
+        }
+        default: // structure
+            json.serialize(JSON::TokenType(field));
+        }
+    }
+    BOOST_CHECK(entries.atEnd());
+    BOOST_CHECK(in.atEnd());
+    json.flush();
+    return json.output;
+}
+
+struct BinaryTypes {
+    std::string text = "quote\" slash\\ tab\t";
+    int8_t i8 = -128;
+    int16_t i16 = -32768;
+    int32_t i32 = -2147483647 - 1;
+    uint8_t u8 = 255;
+    uint16_t u16 = 65535;
+    uint32_t u32 = 4294967295u;
+    bool flag = true;
+    temp_t temp = -12.25;
+    temp_precise_t precise = 0.00390625;
+    temp_long_t wide = 123456.5;
+    temp_t invalid = temp_t::invalid();
+
+    void serialize(JSON::Adapter & adapter){
+        JSON::Class root(adapter, "BinaryTypes");
+        JSON_E(adapter, text);
+        JSON_E(adapter, i8);
+        JSON_E(adapter, i16);
+        JSON_E(adapter, i32);
+        JSON_E(adapter, u8);
+        JSON_E(adapter, u16);
+        JSON_E(adapter, u32);
+        JSON_E(adapter, flag);
+        JSON_E(adapter, temp);
+        JSON_E(adapter, precise);
+        JSON_E(adapter, wide);
+        JSON_T(adapter, invalid);
+    }
+};
+
+/*
+ * The JSON object PiLink::sendJsonValues prints for a map, without the response character
+ */
+std::string printJsonValues(uint8_t * base, const JsonOutput * map, uint8_t mapCount, char tempFormat){
+    std::string json;
+    char buf[JSON_OUTPUT_VALUE_SIZE];
+    for(uint8_t i = 0; i < mapCount; i++){
+        json += i == 0 ? '{' : ',';
+        json += std::string("\"") + map[i].key + "\":";
+        json += formatJsonOutput(buf, base, map[i], tempFormat);
+    }
+    return json + '}';
+}
+
+/*
+ * Splits a flat JSON object in its keys and values. Numbers are compared by value, because the 'C' response prints
+ * them with 2 decimals and JsonStreamWriter with 4.
+ */
+std::map<std::string, std::string> jsonPairs(const std::string & json){
+    std::map<std::string, std::string> pairs;
+    std::istringstream in(json.substr(1, json.size() - 2));
+    std::string pair;
+    while(std::getline(in, pair, ',')){
+        size_t colon = pair.find(':');
+        std::string value = pair.substr(colon + 1);
+        if(value[0] != '"'){
+            std::ostringstream number;
+            number << std::stod(value);
+            value = number.str();
+        }
+        pairs[pair.substr(0, colon)] = value;
+    }
+    return pairs;
+}
+
+BOOST_AUTO_TEST_SUITE(BinaryStreamWriterTest)
+
+BOOST_AUTO_TEST_CASE(varints_use_as_few_bytes_as_possible) {
+    const uint32_t unsignedValues[] = {0, 127, 128, 16383, 16384, 4294967295u};
+    const size_t unsignedSizes[] = {1, 1, 2, 2, 3, 5};
+    const int32_t signedValues[] = {0, -1, 1, -64, 64, 2147483647, -2147483647 - 1};
+    const size_t signedSizes[] = {1, 1, 1, 1, 2, 5, 5};
+
+    StringBinaryWriter writer('X');
+    for(uint32_t v : unsignedValues){
+        writer.putUnsigned(v);
+    }
+    for(int32_t v : signedValues){
+        writer.putSigned(v);
+    }
+    writer.flush();
+
+    std::vector<Message> messages = decode(writer.output);
+    BOOST_REQUIRE_EQUAL(messages.size(), 1u);
+    BOOST_CHECK_EQUAL(messages[0].type, 'X');
+
+    size_t expectedSize = 0;
+    BinaryPayloadReader in(messages[0].payload.data(), messages[0].payload.size());
+    for(size_t i = 0; i < 6; i++){
+        uint32_t v;
+        BOOST_REQUIRE(in.getUnsigned(v));
+        BOOST_CHECK_EQUAL(v, unsignedValues[i]);
+        expectedSize += unsignedSizes[i];
+    }
+    for(size_t i = 0; i < 7; i++){
+        int32_t v;
+        BOOST_REQUIRE(in.getSigned(v));
+        BOOST_CHECK_EQUAL(v, signedValues[i]);
+        expectedSize += signedSizes[i];
+    }
+    BOOST_CHECK(in.atEnd());
+    BOOST_CHECK_EQUAL(messages[0].payload.size(), expectedSize);
+}
+
+BOOST_AUTO_TEST_CASE(reading_past_the_end_fails) {
+    const uint8_t truncated[] = {0x80, 0x80};
+    BinaryPayloadReader in(truncated, sizeof(truncated));
+    uint32_t v;
+    BOOST_CHECK(!in.getUnsigned(v));
+
+    const uint8_t shortString[] = {5, 'a', 'b'};
+    BinaryPayloadReader strings(shortString, sizeof(shortString));
+    char s[8];
+    BOOST_CHECK(!strings.getString(s, sizeof(s)));
+}
+
+BOOST_AUTO_TEST_CASE(string_without_room_is_skipped) {
+    const uint8_t payload[] = {3, 'a', 'b', 'c', 7};
+    BinaryPayloadReader in(payload, sizeof(payload));
+    char text[] = "xyz";
+    BOOST_CHECK(in.getString(text + 1, 0));
+    BOOST_CHECK_EQUAL(text, "xyz"); // nothing is written, also not before the buffer
+    uint32_t v;
+    BOOST_REQUIRE(in.getUnsigned(v));
+    BOOST_CHECK_EQUAL(v, 7u);
+    BOOST_CHECK(in.atEnd());
+}
+
+BOOST_AUTO_TEST_CASE(all_types_decode_to_the_same_json) {
+    BinaryTypes source;
+    std::vector<Message> values = decode(streamBinary(source));
+    std::vector<Message> schema = decode(streamBinary(source, 'K', true));
+    BOOST_REQUIRE_EQUAL(values.size(), 1u);
+    BOOST_REQUIRE_EQUAL(schema.size(), 1u);
+    BOOST_CHECK_EQUAL(values[0].schemaId, schema[0].schemaId);
+
+    BOOST_CHECK_EQUAL(toJson(schema[0], values[0]), streamJson(source));
+}
+
+BOOST_AUTO_TEST_CASE(control_decodes_to_the_same_json) {
+    ticks.reset();
+    auto control = Control();
+    control.update();
+
+    std::vector<uint8_t> binary = streamBinary(control);
+    std::vector<Message> values = decode(binary);
+    std::vector<Message> schema = decode(streamBinary(control, 'K', true));
+    BOOST_REQUIRE_EQUAL(values.size(), 1u);
+    BOOST_REQUIRE_EQUAL(schema.size(), 1u);
+
+    std::string json = streamJson(control);
+    BOOST_CHECK_EQUAL(toJson(schema[0], values[0]), json);
+
+    BOOST_TEST_MESSAGE("Control: " << binary.size() << " bytes binary, " << json.size() << " bytes JSON");
+    BOOST_CHECK_LT(4 * binary.size(), json.size());
+}
+
+BOOST_AUTO_TEST_CASE(control_constants_decode_to_the_same_values_as_json) {
+    ControlConstants cc;
+    cc.tempFormat = 'C';
+    cc.heater1_kp = 10.5;
+    cc.heater1_ti = 600;
+    cc.heater1_td = 60;
+    cc.heater1_infilt = 0;
+    cc.heater1_dfilt = 4;
+    cc.heater2_kp = 10.0;
+    cc.heater2_ti = 600;
+    cc.heater2_td = 60;
+    cc.heater2_infilt = 0;
+    cc.heater2_dfilt = 4;
+    cc.cooler_kp = 5.0;
+    cc.cooler_ti = 1800;
+    cc.cooler_td = 200;
+    cc.cooler_infilt = 2;
+    cc.cooler_dfilt = 5;
+    cc.beer2fridge_kp = 5.25;
+    cc.beer2fridge_ti = 3600;
+    cc.beer2fridge_td = 0;
+    cc.beer2fridge_infilt = 1;
+    cc.beer2fridge_dfilt = 3;
+    cc.beer2fridge_pidMax = 10.0;
+    cc.minCoolTime = 180;
+    cc.minCoolIdleTime = 300;
+    cc.heater1PwmPeriod = 4;
+    cc.heater2PwmPeriod = 4;
+    cc.coolerPwmPeriod = 1200;
+    cc.mutexDeadTime = 1800;
+    uint8_t * base = (uint8_t*) &cc;
+
+    StringBinaryWriter writer('C');
+    writeJsonOutputs(writer, base, jsonOutputCCMap, jsonOutputCCMapCount);
+    writer.flush();
+    StringBinaryWriter schemaWriter('C', true);
+    writeJsonOutputs(schemaWriter, base, jsonOutputCCMap, jsonOutputCCMapCount);
+    schemaWriter.flush();
+
+    std::vector<Message> values = decode(writer.output);
+    std::vector<Message> schema = decode(schemaWriter.output);
+    BOOST_REQUIRE_EQUAL(values.size(), 1u);
+    BOOST_REQUIRE_EQUAL(schema.size(), 1u);
+
+    std::string json = printJsonValues(base, jsonOutputCCMap, jsonOutputCCMapCount, cc.tempFormat);
+    std::string rebuilt = toJson(schema[0], values[0]);
+    BOOST_TEST_MESSAGE("JSON: " << json);
+    BOOST_TEST_MESSAGE("rebuilt: " << rebuilt);
+    std::map<std::string, std::string> expected = jsonPairs(json);
+    std::map<std::string, std::string> actual = jsonPairs(rebuilt);
+    BOOST_CHECK_EQUAL(actual.size(), size_t(jsonOutputCCMapCount));
+    for(const auto & pair : expected){
+        BOOST_CHECK_MESSAGE(actual[pair.first] == pair.second,
+                pair.first << " is " << actual[pair.first] << " instead of " << pair.second);
+    }
+    BOOST_CHECK_EQUAL(actual["\"tempFormat\""], "\"C\"");
+}
+
+BOOST_AUTO_TEST_CASE(schema_id_only_changes_with_the_keys_and_types) {
+    BinaryTypes a;
+    BinaryTypes b;
+    b.temp = 30.0;
+    b.text = "other";
+    b.u32 = 1;
+    std::vector<Message> first = decode(streamBinary(a));
+    std::vector<Message> second = decode(streamBinary(b));
+    BOOST_REQUIRE_EQUAL(first.size(), 1u);
+    BOOST_REQUIRE_EQUAL(second.size(), 1u);
+    BOOST_CHECK(first[0].payload != second[0].payload);
+    BOOST_CHECK_EQUAL(first[0].schemaId, second[0].schemaId);
+
+    ticks.reset();
+    auto control = Control();
+    std::vector<Message> other = decode(streamBinary(control));
+    BOOST_REQUIRE_EQUAL(other.size(), 1u);
+    BOOST_CHECK_NE(first[0].schemaId, other[0].schemaId);
+}
+
+BOOST_AUTO_TEST_CASE(long_messages_are_split_in_frames) {
+    StringBinaryWriter writer('L');
+    for(uint16_t i = 0; i < 300; i++){
+        writer.putByte(uint8_t(i));
+    }
+    writer.flush();
+
+    // 302 bytes including the schema id
+    BOOST_REQUIRE_EQUAL(writer.frames.size(), 3u);
+    BOOST_CHECK_EQUAL(writer.frames[0], 5 + BinaryFrameWriter::MAX_PAYLOAD);
+    BOOST_CHECK_EQUAL(writer.frames[2], 5 + 302 - 2 * BinaryFrameWriter::MAX_PAYLOAD);
+    BOOST_CHECK_EQUAL(writer.output[1], 'L' | BinaryFrameWriter::MORE);
+    BOOST_CHECK_EQUAL(writer.size(), writer.output.size());
+
+    std::vector<Message> messages = decode(writer.output);
+    BOOST_REQUIRE_EQUAL(messages.size(), 1u);
+    BOOST_CHECK_EQUAL(messages[0].type, 'L');
+    BOOST_REQUIRE_EQUAL(messages[0].payload.size(), 300u);
+    for(uint16_t i = 0; i < 300; i++){
+        BOOST_CHECK_EQUAL(messages[0].payload[i], uint8_t(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(text_between_frames_is_skipped) {
+    BinaryTypes source;
+    std::vector<uint8_t> frame = streamBinary(source);
+    std::string log = "D:{\"logID\":1}\n";
+
+    std::vector<uint8_t> stream(log.begin(), log.end());
+    stream.insert(stream.end(), frame.begin(), frame.end());
+    stream.insert(stream.end(), log.begin(), log.end());
+    stream.insert(stream.end(), frame.begin(), frame.end());
+
+    BinaryFrameDecoder decoder;
+    std::vector<Message> messages = decode(stream, decoder);
+    BOOST_CHECK_EQUAL(messages.size(), 2u);
+    BOOST_CHECK_EQUAL(decoder.errorCount(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(corrupted_frame_is_dropped_and_decoder_resyncs) {
+    BinaryTypes source;
+    std::vector<uint8_t> frame = streamBinary(source);
+    std::vector<uint8_t> corrupted = frame;
+    corrupted[10] ^= 0x04;
+
+    std::vector<uint8_t> stream = corrupted;
+    stream.insert(stream.end(), frame.begin(), frame.end());
+
+    BinaryFrameDecoder decoder;
+    std::vector<Message> messages = decode(stream, decoder);
+    BOOST_REQUIRE_EQUAL(messages.size(), 1u);
+    BOOST_CHECK_EQUAL(decoder.errorCount(), 1u);
+    BOOST_CHECK(messages[0].payload == decode(frame)[0].payload);
+}
+
+BOOST_AUTO_TEST_CASE(continuation_of_another_type_drops_the_message) {
+    StringBinaryWriter first('L');
+    for(uint16_t i = 0; i < 200; i++){
+        first.putByte(uint8_t(i));
+    }
+    first.flush();
+    BinaryTypes source;
+    std::vector<uint8_t> other = streamBinary(source);
+
+    // a message that was cut off after its first frame, followed by a message of another type
+    std::vector<uint8_t> stream(first.output.begin(), first.output.begin() + first.frames[0]);
+    stream.insert(stream.end(), other.begin(), other.end());
+    stream.insert(stream.end(), other.begin(), other.end());
+
+    BinaryFrameDecoder decoder;
+    std::vector<Message> messages = decode(stream, decoder);
+    BOOST_CHECK_EQUAL(decoder.errorCount(), 1u);
+    BOOST_REQUIRE_EQUAL(messages.size(), 1u);
+    BOOST_CHECK_EQUAL(messages[0].type, 'V');
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include "DeviceTable.h"
+#include <cstring>
+#include <random>
+
+/*
+ * The linear scans that findHardwareDevice() and findDeviceFunction() did before the table had indexes.
+ */
+static bool matchAddress(const uint8_t * detected, const uint8_t * configured, uint8_t count){
+    if (!configured[0]){
+        return true;
+    }
+    while (count-- > 0) {
+        if (detected[count] != configured[count]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static device_slot_t scanHardware(const DeviceConfig * configs, const DeviceConfig & find){
+    for (device_slot_t slot = 0; slot < NUM_DEVICE_SLOTS; slot++) {
+        const DeviceConfig & config = configs[slot];
+        if (find.deviceHardware == config.deviceHardware) {
+            bool match = true;
+
+            switch (find.deviceHardware) {
+                case DEVICE_HARDWARE_ONEWIRE_2413:
+                case DEVICE_HARDWARE_ONEWIRE_2408:
+                    match &= find.hw.settings.actuator.pio == config.hw.settings.actuator.pio;
+                    // fall through
+                case DEVICE_HARDWARE_ONEWIRE_TEMP:
+                    match &= matchAddress(find.hw.address, config.hw.address, 8);
+                    // fall through
+                case DEVICE_HARDWARE_PIN:
+                    match &= find.hw.pinNr == config.hw.pinNr;
+                    break;
+                case DEVICE_HARDWARE_NONE:
+                    match = false;
+                    break;
+                default:
+                    break;
+            }
+
+            if (match) {
+                return slot;
+            }
+        }
+    }
+    return INVALID_SLOT;
+}
+
+static device_slot_t scanFunction(const DeviceConfig * configs, DeviceFunction function){
+    for (device_slot_t slot = 0; slot < NUM_DEVICE_SLOTS; slot++) {
+        if (configs[slot].deviceFunction == function) {
+            return slot;
+        }
+    }
+    return INVALID_SLOT;
+}
+
+static bool sameConfig(const DeviceConfig & a, const DeviceConfig & b){
+    return a.chamber == b.chamber && a.beer == b.beer && a.deviceFunction == b.deviceFunction
+        && a.deviceHardware == b.deviceHardware && a.hw.pinNr == b.hw.pinNr && a.hw.invert == b.hw.invert
+        && a.hw.deactivate == b.hw.deactivate && memcmp(a.hw.address, b.hw.address, sizeof(a.hw.address)) == 0
+        && a.hw.settings.actuator.pio == b.hw.settings.actuator.pio
+        && a.hw.settings.actuator.val == b.hw.settings.actuator.val
+        && a.hw.settings.actuator.period == b.hw.settings.actuator.period;
+}
+
+/*
+ * Generates device configs from small value ranges, so that devices often share a location or a function.
+ */
+struct RandomDevices {
+    std::mt19937 rng;
+
+    RandomDevices() : rng(2017) {}
+
+    uint8_t pick(uint8_t n){
+        return uint8_t(std::uniform_int_distribution<int>(0, n - 1)(rng));
+    }
+
+    void device(DeviceConfig & config){
+        config = DeviceConfig();
+        // hardware type 5 is unknown and matches on type alone
+        config.deviceHardware = DeviceHardware(pick(6));
+        // a function past DEVICE_FUNCTION_MAX, like in an uninitialized slot, is not in the function index
+        config.deviceFunction = DeviceFunction(pick(8) == 0 ? 40 : pick(DEVICE_FUNCTION_MAX));
+        config.hw.pinNr = pick(3);
+        config.hw.address[0] = pick(3) == 0 ? 0 : 0x28; // no address matches any address
+        for (uint8_t i = 1; i < 8; i++) {
+            config.hw.address[i] = pick(2);
+        }
+        config.hw.settings.actuator.pio = pick(2);
+    }
+};
+
+struct DeviceTableFixture {
+    DeviceTableFixture() : configs() {}
+
+    void checkLookups(){
+        // random locations and the locations of the stored devices, with a different address for some of them
+        for (int i = 0; i < 100; i++) {
+            DeviceConfig find;
+            random.device(find);
+            if (i % 2) {
+                find = configs[random.pick(NUM_DEVICE_SLOTS)];
+                find.hw.address[7] ^= random.pick(2);
+            }
+            device_slot_t expected = scanHardware(configs, find);
+            BOOST_REQUIRE_EQUAL(table.findHardware(find), expected);
+            hits += expected != INVALID_SLOT;
+        }
+        for (uint8_t f = 0; f < DEVICE_FUNCTION_MAX; f++) {
+            BOOST_REQUIRE_EQUAL(table.findFunction(DeviceFunction(f)), scanFunction(configs, DeviceFunction(f)));
+        }
+        BOOST_REQUIRE_EQUAL(table.findFunction(DeviceFunction(40)), scanFunction(configs, DeviceFunction(40)));
+    }
+
+    RandomDevices random;
+    DeviceConfig configs[NUM_DEVICE_SLOTS];
+    DeviceTable table;
+    unsigned hits = 0;
+};
+
+BOOST_FIXTURE_TEST_SUITE(DeviceTableTest, DeviceTableFixture)
+
+BOOST_AUTO_TEST_CASE(table_is_empty_until_loaded){
+    DeviceConfig config;
+    random.device(config);
+    config.deviceHardware = DEVICE_HARDWARE_PIN;
+    table.set(config, 0);
+    BOOST_CHECK(!table.isLoaded());
+    BOOST_CHECK(!table.fetch(config, 0));
+    BOOST_CHECK_EQUAL(table.findHardware(config), INVALID_SLOT);
+    BOOST_CHECK_EQUAL(table.findFunction(config.deviceFunction), INVALID_SLOT);
+
+    table.loaded();
+    BOOST_CHECK(table.fetch(config, 0));
+    BOOST_CHECK_EQUAL(table.findHardware(config), 0);
+    BOOST_CHECK(!table.fetch(config, NUM_DEVICE_SLOTS));
+}
+
+BOOST_AUTO_TEST_CASE(lookups_match_a_linear_scan_of_random_devices){
+    for (int round = 0; round < 50; round++) {
+        // fill a random part of the slots, like an eeprom with some devices installed
+        uint8_t used = random.pick(NUM_DEVICE_SLOTS + 1);
+        for (uint8_t slot = 0; slot < NUM_DEVICE_SLOTS; slot++) {
+            if (slot < used) {
+                random.device(configs[slot]);
+            }
+            else {
+                configs[slot] = DeviceConfig();
+            }
+            table.set(configs[slot], slot);
+        }
+        table.loaded();
+        checkLookups();
+
+        // install, update and remove single devices, like DeviceManager does
+        for (int change = 0; change < 20; change++) {
+            uint8_t slot = random.pick(NUM_DEVICE_SLOTS);
+            switch (random.pick(3)) {
+                case 0: // removed devices are stored as a cleared config
+                    configs[slot] = DeviceConfig();
+                    break;
+                case 1: // another function for the same hardware
+                    configs[slot].deviceFunction = DeviceFunction(random.pick(DEVICE_FUNCTION_MAX));
+                    break;
+                default:
+                    random.device(configs[slot]);
+                    break;
+            }
+            table.store(configs[slot], slot);
+            checkLookups();
+
+            DeviceConfig fetched;
+            BOOST_REQUIRE(table.fetch(fetched, slot));
+            BOOST_REQUIRE(sameConfig(fetched, configs[slot]));
+        }
+    }
+    // the lookups are only a useful comparison when many of them find a device
+    BOOST_CHECK_GT(hits, 25000u);
+}
+
+BOOST_AUTO_TEST_CASE(invalidated_table_finds_nothing){
+    for (uint8_t slot = 0; slot < NUM_DEVICE_SLOTS; slot++) {
+        random.device(configs[slot]);
+        table.set(configs[slot], slot);
+    }
+    table.loaded();
+    checkLookups();
+
+    table.invalidate();
+    BOOST_CHECK(!table.isLoaded());
+    BOOST_CHECK_EQUAL(table.findHardware(configs[0]), INVALID_SLOT);
+    BOOST_CHECK_EQUAL(table.findFunction(configs[0].deviceFunction), INVALID_SLOT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
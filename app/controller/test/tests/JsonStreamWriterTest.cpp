@@ -0,0 +1,126 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include <string>
+
+#include "Control.h"
+#include "json_writer.h"
+#include "JsonStreamWriter.h"
+
+/*
+ * Collects the output, and records the size of each write
+ */
+class StringJsonWriter : public JsonStreamWriter {
+public:
+    std::string output;
+    std::vector<uint8_t> writes;
+
+protected:
+    void write(const char* data, uint8_t length) override final {
+        output.append(data, length);
+        writes.push_back(length);
+    }
+};
+
+template<typename T>
+std::string streamJson(T & source){
+    StringJsonWriter writer;
+    source.serialize(writer);
+    writer.flush();
+    return writer.output;
+}
+
+struct AllTypes {
+    std::string text = "quote\" slash\\ tab\t";
+    int8_t i8 = -128;
+    int16_t i16 = -32768;
+    int32_t i32 = -2147483647 - 1;
+    uint8_t u8 = 255;
+    uint16_t u16 = 65535;
+    uint32_t u32 = 4294967295u;
+    bool flag = true;
+    temp_t temp = -12.25;
+    temp_precise_t precise = 0.00390625;
+    temp_long_t wide = 123456.5;
+    temp_t invalid = temp_t::invalid();
+
+    void serialize(JSON::Adapter & adapter){
+        JSON::Class root(adapter, "AllTypes");
+        JSON_E(adapter, text);
+        JSON_E(adapter, i8);
+        JSON_E(adapter, i16);
+        JSON_E(adapter, i32);
+        JSON_E(adapter, u8);
+        JSON_E(adapter, u16);
+        JSON_E(adapter, u32);
+        JSON_E(adapter, flag);
+        JSON_E(adapter, temp);
+        JSON_E(adapter, precise);
+        JSON_E(adapter, wide);
+        JSON_T(adapter, invalid);
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(JsonStreamWriterTest)
+
+BOOST_AUTO_TEST_CASE(all_types_are_written_like_esj_writer) {
+    AllTypes source;
+
+    std::string expected = JSON::producer<AllTypes>::convert(source);
+    std::string streamed = streamJson(source);
+
+    BOOST_CHECK_EQUAL(streamed, expected);
+    BOOST_CHECK_EQUAL(streamed,
+        R"({"kind":"AllTypes","text":"quote\" slash\\ tab\t","i8":-128,"i16":-32768,"i32":-2147483648,)"
+        R"("u8":255,"u16":65535,"u32":4294967295,"flag":true,"temp":-12.2500,"precise":0.00390625,)"
+        R"("wide":123456.5000,"invalid":null})");
+}
+
+BOOST_AUTO_TEST_CASE(control_is_written_like_esj_writer) {
+    ticks.reset();
+    auto control = Control();
+    control.update();
+
+    std::string expected = JSON::producer<Control>::convert(control);
+
+    StringJsonWriter writer;
+    control.serialize(writer);
+    BOOST_CHECK_EQUAL(writer.size(), expected.size());
+    writer.flush();
+
+    BOOST_CHECK_EQUAL(writer.output, expected);
+
+    // all writes but the last one are a full buffer
+    BOOST_REQUIRE(writer.writes.size() > 1);
+    for(size_t i = 0; i + 1 < writer.writes.size(); i++){
+        BOOST_CHECK_EQUAL(writer.writes[i], uint8_t(JsonStreamWriter::BUFFER_SIZE));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(flush_without_output_does_not_write) {
+    StringJsonWriter writer;
+    writer.flush();
+    BOOST_CHECK(writer.writes.empty());
+    BOOST_CHECK_EQUAL(writer.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
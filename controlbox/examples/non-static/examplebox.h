@@ -24,6 +24,7 @@
 
 #include "Ticks.h"
 #include "ArrayEepromAccess.h"
+#include "CachedEepromAccess.h"
 #include "ValueTicks.h"
 #include "ValueModels.h"
 #include "Values.h"
@@ -47,6 +48,7 @@ class ExampleBox : public CommandCallbacks
 {
     bool quit;
     ArrayEepromAccess<1024> eepromAccess;
+    CachedEepromAccess eepromCache;
     SystemTicks ticks;
     StdIOConnection connection;
     Box box;
@@ -56,7 +58,7 @@ class ExampleBox : public CommandCallbacks
 public:
 
     ExampleBox(const std::string& eeprom_="") :
-            quit(false), box(connection, eepromAccess, ticks, *this, systemRoot), eeprom(eeprom_) {}
+            quit(false), eepromCache(eepromAccess), box(connection, eepromCache, ticks, *this, systemRoot), eeprom(eeprom_) {}
 
     Box& get_box() { return box; }
 
@@ -74,11 +76,17 @@ public:
         {
             box.loop();
             save_eeprom();
+            connection.waitForInput(10);	// sleep until the next command instead of polling
         }
     }
 
+    /**
+     * Writes the eeprom cache to the eeprom, and the eeprom to its file when it changed.
+     * This is done after each loop, when the commands and the control update are done.
+     */
     void save_eeprom()
     {
+        eepromCache.flush();
         if (eepromAccess.hasChanged())
         {
             std::ofstream file;
@@ -97,6 +105,7 @@ public:
                 eepromAccess.load(infile);
                 writeAnnotation("loaded eeprom file %s", eeprom.c_str());
                 infile.close();
+                eepromCache.reload();
             }
             else {
                 std::ofstream outfile(eeprom);
@@ -139,6 +148,7 @@ public:
         {
             case as_int(object_type::ValueTicksScaled):
                 result = new ScaledTicksValue(ticks);
+                break;
 
             default:
                 result = nullFactory(def);
@@ -9,6 +9,11 @@ public:
 	{
 		return ticks_millis_t(millisSinceStartup());
 	}
+
+	ticks_micros_t micros()
+	{
+		return ticks_micros_t(millisSinceStartup() * 1000);
+	}
 };
 
 class Delay
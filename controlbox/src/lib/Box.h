@@ -24,6 +24,7 @@
 #include "Comms.h"
 #include "Commands.h"
 #include "SystemProfile.h"
+#include "ProcessObserver.h"
 
 
 /**
@@ -37,11 +38,12 @@ class Box
 	SystemProfile systemProfile_;
 	Commands commands_;
 	bool logValuesFlag;
+	bool deltaLogging;
 
 public:
 	Box(StandardConnection& connection, EepromAccess& eepromAccess, Ticks& ticks, CommandCallbacks& callbacks, Container& systemRoot)
 	: /*eepromAccess_(eepromAccess),*/ ticks_(ticks), comms_(connection),
-	  systemProfile_(eepromAccess, systemRoot), commands_(comms_, systemProfile_, callbacks, eepromAccess), logValuesFlag(false)
+	  systemProfile_(eepromAccess, systemRoot), commands_(comms_, systemProfile_, callbacks, eepromAccess), logValuesFlag(false), deltaLogging(false)
 	{
 	}
 
@@ -56,6 +58,15 @@ public:
 	{
 		process();
 		comms_.receive();
+		maintain();
+	}
+
+	/**
+	 * Performs a bounded amount of background work on the active profile, such as compaction.
+	 */
+	void maintain()
+	{
+		systemProfile_.compactStep();
 	}
 
 	/**
@@ -66,6 +77,22 @@ public:
 		comms_.handleCommand(in, out);
 	}
 
+	/**
+	 * Requests an automatic log of all values at the end of the next control loop.
+	 */
+	void requestLogValues()
+	{
+		logValuesFlag = true;
+	}
+
+	/**
+	 * When enabled, automatic logs only contain the values that changed since the previous log.
+	 */
+	void setDeltaLogging(bool enabled)
+	{
+		deltaLogging = enabled;
+	}
+
 private:
 
 	/**
@@ -79,10 +106,12 @@ private:
 	    prepare_t d = 0;
 	    Container* root = systemProfile_.rootContainer();
 	    if (root)
-	        d = root->prepare();
+	        d = prepareObject(root);
 
 	    uint32_t end = ticks_.millis()+d;
-	    while (ticks_.millis()<end) {
+	    uint32_t now;
+	    while ((now = ticks_.millis())<end) {
+	        comms_.waitForInput(end-now);
 	        comms_.receive();
 	    }
 
@@ -90,7 +119,7 @@ private:
 	        // root may have been changed by commands, so original prepare may not be valid
 	        // should watch out for newly created objects, since these will then also need preparing
 		if (root==root2 && root) {
-	        root->update();
+	        updateObject(root);
 
 	        if (logValuesFlag) {
 	            logValuesFlag = false;
@@ -102,8 +131,14 @@ private:
 	void logValues(container_id* ids)
 	{
 		DataOut& out = comms_.dataOut();
-		out.write(int(Commands::CMD_LOG_VALUES_AUTO));
-		commands_.logValuesImpl(ids, out);
+		if (deltaLogging) {
+			out.write(int(Commands::CMD_LOG_VALUES_DELTA_AUTO));
+			commands_.logValuesDeltaImpl(ids, out);
+		}
+		else {
+			out.write(int(Commands::CMD_LOG_VALUES_AUTO));
+			commands_.logValuesImpl(ids, out);
+		}
 		out.close();
 	}
 
@@ -195,7 +195,7 @@ protected:
             va_start(ap, fmt_str);
             final_n = vsnprintf(&formatted[0], n, fmt_str.c_str(), ap);
             va_end(ap);
-            if (final_n >= 0 || size_t(final_n) >= n)
+            if (final_n < 0 || size_t(final_n) >= n)
                 n += size_t(abs(final_n - int(n) + 1));
             else
                 break;
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BoxHost.h"
+
+#if !CONTROLBOX_STATIC && !CONTROLBOX_WIRING
+
+#include <chrono>
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+static int64_t steadyNanos()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * CPU time of the calling thread. Falls back to wall time where that is not available.
+ */
+static int64_t threadCpuNanos()
+{
+#if defined(__linux__)
+	timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return int64_t(now.tv_sec) * 1000000000 + now.tv_nsec;
+#else
+	return steadyNanos();
+#endif
+}
+
+BoxHost::BoxHost(unsigned threads)
+	: generation(0), remaining(0), stopping(false), running(false), startedNanos(0)
+{
+	if (!threads) {
+		threads = 1;
+	}
+	for (unsigned i = 0; i < threads; i++) {
+		workers.emplace_back(new Worker());
+	}
+	for (unsigned i = 0; i < threads; i++) {
+		workers[i]->thread = std::thread(&BoxHost::work, this, i);
+	}
+}
+
+BoxHost::~BoxHost()
+{
+	stop();
+	{
+		std::lock_guard<std::mutex> lock(roundLock);
+		stopping = true;
+	}
+	roundStart.notify_all();
+	for (auto& worker : workers) {
+		worker->thread.join();
+	}
+}
+
+size_t BoxHost::add(std::unique_ptr<BoxTenant> tenant)
+{
+	unsigned home = unsigned(tenants.size() % workers.size());
+	tenants.emplace_back(new Tenant(std::move(tenant), home));
+	return tenants.size() - 1;
+}
+
+void BoxHost::runRound()
+{
+	if (tenants.empty()) {
+		return;
+	}
+	int64_t unset = 0;
+	startedNanos.compare_exchange_strong(unset, steadyNanos());
+
+	std::unique_lock<std::mutex> lock(roundLock);
+	for (auto& worker : workers) {
+		std::lock_guard<std::mutex> queueLock(worker->lock);
+		worker->queue.clear();
+	}
+	for (size_t i = 0; i < tenants.size(); i++) {
+		Worker& home = *workers[tenants[i]->home];
+		std::lock_guard<std::mutex> queueLock(home.lock);
+		home.queue.push_back(i);
+	}
+	remaining = tenants.size();
+	generation++;
+	roundStart.notify_all();
+	roundDone.wait(lock, [this]() { return remaining == 0; });
+}
+
+void BoxHost::runRounds(uint32_t rounds)
+{
+	while (rounds--) {
+		runRound();
+	}
+}
+
+void BoxHost::start(uint32_t periodMicros)
+{
+	if (running.exchange(true)) {
+		return;
+	}
+	scheduler = std::thread([this, periodMicros]() {
+		auto next = std::chrono::steady_clock::now();
+		while (running.load()) {
+			next += std::chrono::microseconds(periodMicros);
+			runRound();
+			std::this_thread::sleep_until(next);
+		}
+	});
+}
+
+void BoxHost::stop()
+{
+	if (running.exchange(false)) {
+		scheduler.join();
+	}
+}
+
+/**
+ * Takes the next tenant from the worker's own queue, or steals one from the back of another worker's queue.
+ */
+bool BoxHost::take(unsigned index, size_t& tenant)
+{
+	{
+		Worker& own = *workers[index];
+		std::lock_guard<std::mutex> lock(own.lock);
+		if (!own.queue.empty()) {
+			tenant = own.queue.front();
+			own.queue.pop_front();
+			return true;
+		}
+	}
+	for (unsigned i = 1; i < workers.size(); i++) {
+		Worker& victim = *workers[(index + i) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.lock);
+		if (!victim.queue.empty()) {
+			tenant = victim.queue.back();
+			victim.queue.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+void BoxHost::runTenant(unsigned worker, size_t index)
+{
+	Tenant& tenant = *tenants[index];
+	int64_t cpu = threadCpuNanos();
+	tenant.instance->loop();
+	tenant.cpuNanos.fetch_add(uint64_t(threadCpuNanos() - cpu), std::memory_order_relaxed);
+	tenant.loops.fetch_add(1, std::memory_order_relaxed);
+	if (tenant.home != worker) {
+		tenant.stolen.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void BoxHost::work(unsigned index)
+{
+	uint64_t seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(roundLock);
+			roundStart.wait(lock, [this, seen]() { return stopping || generation != seen; });
+			if (stopping) {
+				return;
+			}
+			seen = generation;
+		}
+		size_t tenant;
+		while (take(index, tenant)) {
+			runTenant(index, tenant);
+			std::lock_guard<std::mutex> lock(roundLock);
+			if (--remaining == 0) {
+				roundDone.notify_all();
+			}
+		}
+	}
+}
+
+BoxHost::Metrics BoxHost::metrics(const Tenant& tenant) const
+{
+	Metrics result;
+	result.loops = tenant.loops.load(std::memory_order_relaxed);
+	result.cpuMicros = tenant.cpuNanos.load(std::memory_order_relaxed) / 1000;
+	result.stolen = tenant.stolen.load(std::memory_order_relaxed);
+	int64_t started = startedNanos.load();
+	double seconds = started ? double(steadyNanos() - started) / 1e9 : 0;
+	result.loopsPerSecond = seconds > 0 ? double(result.loops) / seconds : 0;
+	return result;
+}
+
+BoxHost::Metrics BoxHost::metrics(size_t tenant) const
+{
+	return metrics(*tenants[tenant]);
+}
+
+BoxHost::Metrics BoxHost::totals() const
+{
+	Metrics result = {};
+	for (auto& tenant : tenants) {
+		Metrics m = metrics(*tenant);
+		result.loops += m.loops;
+		result.cpuMicros += m.cpuMicros;
+		result.stolen += m.stolen;
+		result.loopsPerSecond += m.loopsPerSecond;
+	}
+	return result;
+}
+
+#endif
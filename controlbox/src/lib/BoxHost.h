@@ -0,0 +1,145 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "ControlboxWiring.h"
+
+#if !CONTROLBOX_STATIC && !CONTROLBOX_WIRING
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * One virtual controller run by a BoxHost: a Box together with its own EepromAccess, Ticks and connection.
+ */
+struct BoxTenant
+{
+	virtual ~BoxTenant() = default;
+
+	/**
+	 * Runs one iteration of the box, usually Box::loop() followed by saving the eeprom.
+	 * The host never runs the same tenant on two threads at once.
+	 */
+	virtual void loop() = 0;
+};
+
+/**
+ * Runs many boxes in one process on a work-stealing thread pool.
+ *
+ * The host runs in rounds: each round, every tenant loops once. A tenant has a home worker, and each round starts
+ * with the tenants queued on their home worker, so a box normally stays on the same thread and keeps its data in
+ * that core's cache. A worker that runs out of tenants steals from the back of another worker's queue, so one slow
+ * box does not hold back the boxes queued behind it.
+ *
+ * Tenants are added before the host is started and must be set up already.
+ */
+class BoxHost
+{
+public:
+	struct Metrics
+	{
+		uint64_t loops;
+		uint64_t cpuMicros;			// thread CPU time spent in loop()
+		uint64_t stolen;			// loops run by a worker other than the home worker
+		double loopsPerSecond;		// since the first round started
+	};
+
+	explicit BoxHost(unsigned threads);
+	~BoxHost();
+
+	BoxHost(const BoxHost&) = delete;
+	BoxHost& operator=(const BoxHost&) = delete;
+
+	/**
+	 * Adds a tenant, with a home worker assigned round robin.
+	 * @return The index of the tenant, for metrics().
+	 */
+	size_t add(std::unique_ptr<BoxTenant> tenant);
+
+	/**
+	 * Runs the given number of rounds as fast as possible, and returns when they are done.
+	 */
+	void runRounds(uint32_t rounds);
+
+	/**
+	 * Starts a round every periodMicros in the background, until stop(). A round that takes longer than the period
+	 * delays the next one.
+	 */
+	void start(uint32_t periodMicros);
+	void stop();
+
+	Metrics metrics(size_t tenant) const;
+
+	/**
+	 * Sum of the metrics of all tenants.
+	 */
+	Metrics totals() const;
+
+	size_t size() const { return tenants.size(); }
+	unsigned threads() const { return unsigned(workers.size()); }
+
+private:
+	struct Tenant
+	{
+		std::unique_ptr<BoxTenant> instance;
+		unsigned home;
+		std::atomic<uint64_t> loops;
+		std::atomic<uint64_t> cpuNanos;
+		std::atomic<uint64_t> stolen;
+
+		Tenant(std::unique_ptr<BoxTenant> instance_, unsigned home_)
+			: instance(std::move(instance_)), home(home_), loops(0), cpuNanos(0), stolen(0) {}
+	};
+
+	struct Worker
+	{
+		std::mutex lock;
+		std::deque<size_t> queue;
+		std::thread thread;
+	};
+
+	std::vector<std::unique_ptr<Tenant>> tenants;
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	std::mutex roundLock;
+	std::condition_variable roundStart;
+	std::condition_variable roundDone;
+	uint64_t generation;
+	size_t remaining;
+	bool stopping;
+
+	std::thread scheduler;
+	std::atomic<bool> running;
+	std::atomic<int64_t> startedNanos;	// steady clock time of the first round, 0 before
+
+	void work(unsigned index);
+	bool take(unsigned index, size_t& tenant);
+	void runTenant(unsigned worker, size_t tenant);
+	void runRound();
+	Metrics metrics(const Tenant& tenant) const;
+};
+
+#endif
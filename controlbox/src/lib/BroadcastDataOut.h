@@ -0,0 +1,191 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "DataStream.h"
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * The destination of a broadcast reader, like a network client.
+ */
+struct BroadcastSink
+{
+	/**
+	 * Writes up to length bytes without waiting for the destination.
+	 * @return The number of bytes written, which is 0 when the destination cannot take more data now.
+	 */
+	virtual uint16_t writeAvailable(const uint8_t* data, uint16_t length)=0;
+};
+
+/**
+ * The position of one reader in a BroadcastDataOut.
+ */
+struct BroadcastCursor
+{
+	/**
+	 * Offset of the next byte to send, counted from the start of the broadcast.
+	 */
+	uint32_t position;
+
+	/**
+	 * When set, data is skipped up to the start of the next frame.
+	 */
+	bool resync;
+
+	/**
+	 * Set when the last byte sent did not end a frame.
+	 */
+	bool midFrame;
+
+	/**
+	 * Number of times the reader fell behind and skipped data.
+	 */
+	uint16_t overruns;
+};
+
+/**
+ * An output stream that is written once and sent to any number of readers, each at its own pace.
+ *
+ * Data is stored in a ring buffer. Each reader has a cursor in the buffer, and pump() sends a reader as much as its
+ * sink accepts without waiting. Writing never waits for a reader. When a reader falls so far behind that its unsent
+ * data is overwritten, it skips to the start of the next frame. A frame is a line ending in '\n', which is how
+ * the hex output of controlbox is framed, so a slow reader misses whole frames instead of receiving garbled ones.
+ *
+ * @param Size The size of the ring buffer, a power of 2.
+ */
+template <uint16_t Size>
+class BroadcastDataOut : public DataOut
+{
+	static_assert(Size && !(Size & (Size - 1)), "size must be a power of 2");
+	static_assert(Size >= 256, "size must hold the largest writeBuffer()");
+
+	uint8_t buffer[Size];
+	uint32_t head;	// total number of bytes written
+
+	const uint8_t* at(uint32_t position) const {
+		return buffer + (position & (Size - 1));
+	}
+
+	/**
+	 * Moves a cursor past the partial frame it resynchronizes from.
+	 * @return true when the cursor is at the start of a frame.
+	 */
+	bool skipToFrame(BroadcastCursor& cursor) {
+		while (cursor.position != head) {
+			uint16_t chunk = contiguous(cursor);
+			const uint8_t* start = at(cursor.position);
+			const uint8_t* end = static_cast<const uint8_t*>(memchr(start, '\n', chunk));
+			if (end) {
+				cursor.position += uint32_t(end - start) + 1;
+				cursor.resync = false;
+				return true;
+			}
+			cursor.position += chunk;
+		}
+		return false;
+	}
+
+	/**
+	 * The number of bytes a cursor can send without wrapping around the end of the buffer.
+	 */
+	uint16_t contiguous(const BroadcastCursor& cursor) const {
+		uint32_t pending = head - cursor.position;
+		uint32_t toEnd = Size - (cursor.position & (Size - 1));
+		return uint16_t(pending < toEnd ? pending : toEnd);
+	}
+
+public:
+	BroadcastDataOut() : head(0) {}
+
+	/**
+	 * Creates a cursor for a new reader. The reader starts at the next frame.
+	 */
+	BroadcastCursor attach() const {
+		BroadcastCursor cursor;
+		cursor.position = head;
+		cursor.resync = head && *at(head - 1) != '\n';
+		cursor.midFrame = false;
+		cursor.overruns = 0;
+		return cursor;
+	}
+
+	virtual bool write(uint8_t data) override {
+		buffer[head & (Size - 1)] = data;
+		head++;
+		return true;
+	}
+
+	virtual bool writeBuffer(const void* data, stream_size_t len) override {
+		const uint8_t* d = static_cast<const uint8_t*>(data);
+		uint16_t offset = head & (Size - 1);
+		uint16_t first = uint16_t(Size - offset) < len ? uint16_t(Size - offset) : len;
+		memcpy(buffer + offset, d, first);
+		memcpy(buffer, d + first, len - first);
+		head += len;
+		return true;
+	}
+
+	/**
+	 * The number of bytes a reader has not been sent yet.
+	 */
+	uint32_t pending(const BroadcastCursor& cursor) const {
+		return head - cursor.position;
+	}
+
+	/**
+	 * Sends a reader what its sink accepts now.
+	 * @return true when the reader has been sent everything.
+	 */
+	bool pump(BroadcastCursor& cursor, BroadcastSink& sink) {
+		if (head - cursor.position > Size) {
+			// the unsent data has been overwritten
+			cursor.position = head - Size;
+			cursor.resync = true;
+			cursor.overruns++;
+		}
+		if (cursor.resync) {
+			if (cursor.midFrame) {
+				// end the partial frame, so the receiver drops it instead of joining it to the next
+				const uint8_t newline = '\n';
+				if (!sink.writeAvailable(&newline, 1)) {
+					return false;
+				}
+				cursor.midFrame = false;
+			}
+			if (!skipToFrame(cursor)) {
+				return true;
+			}
+		}
+		while (cursor.position != head) {
+			uint16_t chunk = contiguous(cursor);
+			const uint8_t* start = at(cursor.position);
+			uint16_t sent = sink.writeAvailable(start, chunk);
+			if (sent) {
+				cursor.position += sent;
+				cursor.midFrame = start[sent - 1] != '\n';
+			}
+			if (sent < chunk) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
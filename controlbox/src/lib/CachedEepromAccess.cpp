@@ -0,0 +1,383 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CachedEepromAccess.h"
+
+#if !CONTROLBOX_STATIC
+
+#include <string.h>
+
+static_assert(EEPROM_JOURNAL_SLOTS<127, "sequence numbers must identify the newest record");
+static_assert(EEPROM_CACHE_PAGES<=EEPROM_JOURNAL_SLOTS, "a transaction must fit in the journal");
+static_assert(EEPROM_CACHE_PAGE_SIZE<=16, "the record mask has a bit per byte of the page");
+
+const uint8_t CachedEepromAccess::PAGE_SIZE;
+const uint8_t CachedEepromAccess::RECORD_SIZE;
+const uint16_t CachedEepromAccess::NO_PAGE;
+const uint8_t CachedEepromAccess::NO_SEQUENCE;
+const uint8_t CachedEepromAccess::COMMIT;
+const uint8_t CachedEepromAccess::SEQUENCE_MASK;
+
+CachedEepromAccess::CachedEepromAccess(EepromAccess& backend_)
+	: backend(backend_)
+{
+	eptr_t journalSize = EEPROM_JOURNAL_SLOTS*RECORD_SIZE;
+	journalStart = backend.length()>journalSize ? eptr_t(backend.length()-journalSize) : 0;
+	reload();
+}
+
+void CachedEepromAccess::reload()
+{
+	for (Page& page : pages) {
+		page.index = NO_PAGE;
+		page.lastUse = 0;
+		page.dirty = false;
+	}
+	for (Slot& slot : slots) {
+		slot.index = NO_PAGE;
+		slot.mask = 0;
+	}
+	useCount = 0;
+	nextSlot = 0;
+	nextSequence = 0;
+	recover();
+}
+
+uint8_t CachedEepromAccess::readByte(eptr_t offset) const
+{
+	if (offset>=length())
+		return 0;
+	uint16_t index = offset/PAGE_SIZE;
+	uint8_t i = offset%PAGE_SIZE;
+	const Page* page = find(index);
+	if (page)
+		return page->data[i];
+	uint8_t slot;
+	if (newestRecord(index, slot) && (slots[slot].mask & (1<<i)))
+		return backend.readByte(eptr_t(slotOffset(slot)+5+i));
+	return backend.readByte(offset);
+}
+
+void CachedEepromAccess::writeByte(eptr_t offset, uint8_t value)
+{
+	if (offset>=length())
+		return;
+	Page& page = load(offset/PAGE_SIZE);
+	uint8_t& current = page.data[offset%PAGE_SIZE];
+	if (current!=value) {
+		current = value;
+		page.dirty = true;
+	}
+}
+
+void CachedEepromAccess::readBlock(void* target, eptr_t offset, uint16_t size) const
+{
+	uint8_t* p = (uint8_t*)target;
+	while (size--) {
+		*p++ = readByte(offset++);
+	}
+}
+
+void CachedEepromAccess::writeBlock(eptr_t target, const void* source, uint16_t size)
+{
+	const uint8_t* p = (const uint8_t*)source;
+	while (size--) {
+		writeByte(target++, *p++);
+	}
+}
+
+bool CachedEepromAccess::flush(uint8_t maxPages)
+{
+	Page* batch[EEPROM_CACHE_PAGES];
+	uint8_t count = 0;
+	bool remaining = false;
+	for (Page& page : pages) {
+		if (!page.dirty)
+			continue;
+		if (count==maxPages) {
+			remaining = true;
+			continue;
+		}
+		uint8_t stored[PAGE_SIZE];
+		read(page.index, stored);
+		if (memcmp(stored, page.data, PAGE_SIZE)) {
+			batch[count++] = &page;
+		}
+		else {
+			page.dirty = false;		// changed back to what the backend has
+		}
+	}
+
+	if (!journalStart) {
+		for (uint8_t i=0; i<count; i++) {
+			writeHome(batch[i]->index, changes(*batch[i]), batch[i]->data);
+			batch[i]->dirty = false;
+		}
+		return !remaining;
+	}
+
+	// Free the slots of the transaction before writing any record. Reclaiming a slot can write a page home,
+	// which changes the bytes that a record of that page has to hold.
+	uint8_t first = nextSlot;
+	for (uint8_t i=0; i<count; i++) {
+		reclaim(uint8_t((first+i)%EEPROM_JOURNAL_SLOTS));
+	}
+	uint16_t masks[EEPROM_CACHE_PAGES];
+	for (uint8_t i=0; i<count; i++) {
+		masks[i] = changes(*batch[i]);
+		writeRecord(*batch[i], masks[i], i+1==count);
+	}
+	// the records are only used once the transaction is committed
+	for (uint8_t i=0; i<count; i++) {
+		Slot& slot = slots[(first+i)%EEPROM_JOURNAL_SLOTS];
+		slot.index = batch[i]->index;
+		slot.mask = masks[i];
+		batch[i]->dirty = false;
+	}
+	return !remaining;
+}
+
+bool CachedEepromAccess::dirty() const
+{
+	for (const Page& page : pages) {
+		if (page.dirty)
+			return true;
+	}
+	return false;
+}
+
+const CachedEepromAccess::Page* CachedEepromAccess::find(uint16_t index) const
+{
+	for (const Page& page : pages) {
+		if (page.index==index)
+			return &page;
+	}
+	return NULL;
+}
+
+CachedEepromAccess::Page& CachedEepromAccess::load(uint16_t index)
+{
+	Page* page = const_cast<Page*>(find(index));
+	if (!page) {
+		// reuse the least recently used page, preferring one that doesn't have to be written
+		page = &pages[0];
+		for (Page& candidate : pages) {
+			if (candidate.dirty!=page->dirty ? !candidate.dirty : uint16_t(useCount-candidate.lastUse)>uint16_t(useCount-page->lastUse))
+				page = &candidate;
+		}
+		if (page->dirty)
+			flush();
+		read(index, page->data);
+		page->index = index;
+	}
+	page->lastUse = ++useCount;
+	return *page;
+}
+
+void CachedEepromAccess::read(uint16_t index, uint8_t* data) const
+{
+	eptr_t offset = eptr_t(index*PAGE_SIZE);
+	eptr_t size = length()-offset<PAGE_SIZE ? eptr_t(length()-offset) : PAGE_SIZE;
+	memset(data, 0xFF, PAGE_SIZE);
+	backend.readBlock(data, offset, size);
+	uint8_t slot;
+	if (newestRecord(index, slot)) {
+		eptr_t record = slotOffset(slot);
+		for (uint8_t i=0; i<PAGE_SIZE; i++) {
+			if (slots[slot].mask & (1<<i))
+				data[i] = backend.readByte(eptr_t(record+5+i));
+		}
+	}
+}
+
+bool CachedEepromAccess::newestRecord(uint16_t index, uint8_t& slot) const
+{
+	for (uint8_t i=1; i<=EEPROM_JOURNAL_SLOTS; i++) {
+		uint8_t s = uint8_t((nextSlot+EEPROM_JOURNAL_SLOTS-i)%EEPROM_JOURNAL_SLOTS);
+		if (slots[s].index==index) {
+			slot = s;
+			return true;
+		}
+	}
+	return false;
+}
+
+uint16_t CachedEepromAccess::changes(const Page& page) const
+{
+	eptr_t offset = eptr_t(page.index*PAGE_SIZE);
+	uint16_t mask = 0;
+	for (uint8_t i=0; i<PAGE_SIZE && eptr_t(offset+i)<length(); i++) {
+		if (backend.readByte(eptr_t(offset+i))!=page.data[i])
+			mask |= uint16_t(1<<i);
+	}
+	return mask;
+}
+
+void CachedEepromAccess::reclaim(uint8_t slot)
+{
+	uint16_t index = slots[slot].index;
+	if (index==NO_PAGE)
+		return;
+	slots[slot].index = NO_PAGE;
+	uint8_t newer;
+	if (!newestRecord(index, newer)) {
+		// Until the slot is overwritten, the record still holds the same content as home after a reset
+		uint8_t data[PAGE_SIZE];
+		backend.readBlock(data, eptr_t(slotOffset(slot)+5), PAGE_SIZE);
+		writeHome(index, slots[slot].mask, data);
+	}
+}
+
+void CachedEepromAccess::writeRecord(const Page& page, uint16_t mask, bool commit)
+{
+	eptr_t record = slotOffset(nextSlot);
+	// the slot can hold an older record, which must not be valid while it is partly overwritten
+	uint8_t erased = NO_SEQUENCE;
+	update(record, &erased, 1);
+	uint8_t header[4] = { uint8_t(page.index), uint8_t(page.index>>8), uint8_t(mask), uint8_t(mask>>8) };
+	update(eptr_t(record+1), header, sizeof(header));
+	// only the changed bytes are journaled, the rest of the data is not covered by the checksum
+	for (uint8_t i=0; i<PAGE_SIZE; i++) {
+		if (mask & (1<<i))
+			update(eptr_t(record+5+i), &page.data[i], 1);
+	}
+	uint8_t sum = checksum(page.index, mask, page.data);
+	update(eptr_t(record+5+PAGE_SIZE), &sum, 1);
+	// the record is only valid once the sequence byte is written, which is done last
+	backend.writeByte(record, commit ? uint8_t(nextSequence|COMMIT) : nextSequence);
+
+	nextSlot = uint8_t((nextSlot+1)%EEPROM_JOURNAL_SLOTS);
+	nextSequence = nextSequenceAfter(nextSequence);
+}
+
+void CachedEepromAccess::writeHome(uint16_t index, uint16_t mask, const uint8_t* data)
+{
+	eptr_t offset = eptr_t(index*PAGE_SIZE);
+	for (uint8_t i=0; i<PAGE_SIZE; i++) {
+		if (mask & (1<<i))
+			update(eptr_t(offset+i), &data[i], 1);
+	}
+}
+
+void CachedEepromAccess::update(eptr_t offset, const uint8_t* data, uint16_t size)
+{
+	while (size--) {
+		if (backend.readByte(offset)!=*data)
+			backend.writeByte(offset, *data);
+		offset++;
+		data++;
+	}
+}
+
+bool CachedEepromAccess::readRecord(uint8_t slot, uint8_t& sequence, uint16_t& index, uint16_t& mask, uint8_t* data) const
+{
+	eptr_t record = slotOffset(slot);
+	sequence = backend.readByte(record);
+	index = uint16_t(backend.readByte(eptr_t(record+1)) | backend.readByte(eptr_t(record+2))<<8);
+	mask = uint16_t(backend.readByte(eptr_t(record+3)) | backend.readByte(eptr_t(record+4))<<8);
+	backend.readBlock(data, eptr_t(record+5), PAGE_SIZE);
+	return (sequence&SEQUENCE_MASK)!=(NO_SEQUENCE&SEQUENCE_MASK)
+		&& index<(length()+PAGE_SIZE-1)/PAGE_SIZE
+		&& backend.readByte(eptr_t(record+5+PAGE_SIZE))==checksum(index, mask, data);
+}
+
+void CachedEepromAccess::recover()
+{
+	if (!journalStart)
+		return;
+
+	// the newest record is the valid record that is not followed by its successor
+	uint8_t data[PAGE_SIZE];
+	uint8_t newest = 0, newestSequence = 0;
+	bool found = false;
+	for (uint8_t slot=0; slot<EEPROM_JOURNAL_SLOTS && !found; slot++) {
+		uint8_t sequence, nextSeq;
+		uint16_t index, mask;
+		if (readRecord(slot, sequence, index, mask, data)) {
+			uint8_t next = uint8_t((slot+1)%EEPROM_JOURNAL_SLOTS);
+			if (!readRecord(next, nextSeq, index, mask, data) || (nextSeq&SEQUENCE_MASK)!=nextSequenceAfter(sequence&SEQUENCE_MASK)) {
+				newest = slot;
+				newestSequence = sequence;
+				found = true;
+			}
+		}
+	}
+	if (!found)
+		return;
+
+	// Find the last commit. Records after it belong to a transaction that was interrupted. The next transaction
+	// overwrites them, so that a transaction always follows a commit.
+	uint16_t index, mask;
+	uint8_t slot = newest;
+	uint8_t sequence = newestSequence;
+	for (uint8_t i=0; !(sequence&COMMIT); i++) {
+		uint8_t previous = uint8_t((slot+EEPROM_JOURNAL_SLOTS-1)%EEPROM_JOURNAL_SLOTS);
+		uint8_t previousSequence;
+		if (i+1==EEPROM_JOURNAL_SLOTS || !readRecord(previous, previousSequence, index, mask, data)
+			|| nextSequenceAfter(previousSequence&SEQUENCE_MASK)!=(sequence&SEQUENCE_MASK)) {
+			nextSlot = slot;
+			nextSequence = uint8_t(sequence&SEQUENCE_MASK);
+			return;
+		}
+		slot = previous;
+		sequence = previousSequence;
+	}
+	nextSlot = uint8_t((slot+1)%EEPROM_JOURNAL_SLOTS);
+	nextSequence = nextSequenceAfter(sequence&SEQUENCE_MASK);
+
+	// The committed records are the last commit and the records before it with consecutive sequence numbers.
+	// Older records were overwritten by them, after the pages they held were written home.
+	for (uint8_t i=0; i<EEPROM_JOURNAL_SLOTS; i++) {
+		if (!readRecord(slot, sequence, index, mask, data))
+			break;
+		slots[slot].index = index;
+		slots[slot].mask = mask;
+
+		uint8_t previous = uint8_t((slot+EEPROM_JOURNAL_SLOTS-1)%EEPROM_JOURNAL_SLOTS);
+		uint8_t previousSequence;
+		if (!readRecord(previous, previousSequence, index, mask, data)
+			|| nextSequenceAfter(previousSequence&SEQUENCE_MASK)!=(sequence&SEQUENCE_MASK))
+			break;
+		slot = previous;
+	}
+}
+
+uint8_t CachedEepromAccess::nextSequenceAfter(uint8_t sequence)
+{
+	return uint8_t((sequence+1)%SEQUENCE_MASK);		// SEQUENCE_MASK itself is never used, it is erased eeprom with the COMMIT flag
+}
+
+uint8_t CachedEepromAccess::checksum(uint16_t index, uint16_t mask, const uint8_t* data)
+{
+	// Fletcher style sum, so that swapped bytes are detected
+	uint8_t a = uint8_t(index), b = uint8_t(index>>8);
+	a = uint8_t(a+uint8_t(mask));
+	b = uint8_t(b+a);
+	a = uint8_t(a+uint8_t(mask>>8));
+	b = uint8_t(b+a);
+	for (uint8_t i=0; i<PAGE_SIZE; i++) {
+		if (mask & (1<<i)) {
+			a = uint8_t(a+data[i]);
+			b = uint8_t(b+a);
+		}
+	}
+	return uint8_t(a^b);
+}
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "EepromAccess.h"
+
+#if !CONTROLBOX_STATIC
+
+/**
+ * Size of a cache page and of the data in a journal record. At most 16, one bit per byte in the record mask.
+ */
+#ifndef EEPROM_CACHE_PAGE_SIZE
+#define EEPROM_CACHE_PAGE_SIZE 16
+#endif
+
+/**
+ * Number of pages held in RAM.
+ */
+#ifndef EEPROM_CACHE_PAGES
+#define EEPROM_CACHE_PAGES 4
+#endif
+
+/**
+ * Number of records in the journal. Must be less than 127 and at least EEPROM_CACHE_PAGES.
+ */
+#ifndef EEPROM_JOURNAL_SLOTS
+#define EEPROM_JOURNAL_SLOTS 8
+#endif
+
+/**
+ * An EepromAccess decorator that collects writes in RAM pages and writes them to the backend later, from flush().
+ * Repeated writes to the same bytes, such as a setting that changes on each control update, then cost a single
+ * backend write.
+ *
+ * The backend ends with a journal, which is written as a log: flush() appends a record for each dirty page, with
+ * the bytes of the page that differ from its home location. The newest record of a page holds its content, so a
+ * page that is changed often is only written to the journal, which is written round robin, spreading its wear over
+ * all slots. A page is written home when its newest record is the oldest in the journal and its slot is needed for
+ * a new record.
+ *
+ * The records of a flush form one transaction. The sequence byte of a record is cleared first and written last, so a
+ * record that was interrupted by a reset is never valid. The last record of a transaction is flagged as its commit.
+ * When the decorator is constructed, the records up to the last commit are read back, and records after it are
+ * ignored, so an interrupted flush leaves all its pages unchanged.
+ *
+ * The journal takes EEPROM_JOURNAL_SLOTS*RECORD_SIZE bytes from the end of the backend, so length() is smaller
+ * than the length of the backend. When the backend is too small for a journal, pages are written home directly.
+ *
+ * flush() is intended to be called outside of the control loop, when there is time to spare. When all pages are dirty
+ * and another page is needed, all dirty pages are flushed immediately.
+ */
+class CachedEepromAccess : public EepromAccess
+{
+public:
+	static const uint8_t PAGE_SIZE = EEPROM_CACHE_PAGE_SIZE;
+	static const uint8_t RECORD_SIZE = PAGE_SIZE+6;	// sequence, page (2 bytes), mask (2 bytes), data, checksum
+	static const uint8_t RECORD_DATA = 5;				// offset of the data in a record
+
+	CachedEepromAccess(EepromAccess& backend);
+
+	uint8_t readByte(eptr_t offset) const override;
+	void writeByte(eptr_t offset, uint8_t value) override;
+	void readBlock(void* target, eptr_t offset, uint16_t size) const override;
+	void writeBlock(eptr_t target, const void* source, uint16_t size) override;
+
+	eptr_t length() const override {
+		return journalStart;
+	}
+
+	/**
+	 * Writes dirty pages to the backend, as one transaction.
+	 * @param maxPages	The maximum number of pages to write, to limit the time spent. Writes that span more pages
+	 *   are only atomic when all their pages are flushed together.
+	 * @return true when no dirty pages remain.
+	 */
+	bool flush(uint8_t maxPages=EEPROM_CACHE_PAGES);
+
+	/**
+	 * Drops the cached pages and reads the journal again. Call this when the content of the backend was replaced,
+	 * such as when it is loaded from a file.
+	 */
+	void reload();
+
+	/**
+	 * @return true when there are writes that were not yet written to the backend.
+	 */
+	bool dirty() const;
+
+private:
+	static const uint16_t NO_PAGE = 0xFFFF;
+	static const uint8_t NO_SEQUENCE = 0xFF;	// value of erased eeprom
+	static const uint8_t COMMIT = 0x80;			// flags the last record of a transaction in the sequence byte
+	static const uint8_t SEQUENCE_MASK = 0x7F;
+
+	struct Page {
+		uint16_t index;		// page number, NO_PAGE when unused
+		uint16_t lastUse;
+		bool dirty;
+		uint8_t data[PAGE_SIZE];
+	};
+
+	/**
+	 * A journal slot that holds a committed record.
+	 */
+	struct Slot {
+		uint16_t index;		// page of the record, NO_PAGE when the slot holds no committed record
+		uint16_t mask;
+	};
+
+	const Page* find(uint16_t index) const;
+
+	/**
+	 * Returns the cached page, loading it from the backend when not cached.
+	 */
+	Page& load(uint16_t index);
+
+	/**
+	 * Reads the content of a page from its home location and its newest record.
+	 */
+	void read(uint16_t index, uint8_t* data) const;
+
+	/**
+	 * Finds the newest committed record of a page.
+	 */
+	bool newestRecord(uint16_t index, uint8_t& slot) const;
+
+	/**
+	 * @return A mask with a bit set for each byte of the page that differs from its home location.
+	 */
+	uint16_t changes(const Page& page) const;
+
+	/**
+	 * Frees a slot for a new record. When it holds the newest record of a page, the page is written home first.
+	 */
+	void reclaim(uint8_t slot);
+
+	void writeRecord(const Page& page, uint16_t mask, bool commit);
+
+	void writeHome(uint16_t index, uint16_t mask, const uint8_t* data);
+
+	/**
+	 * Finds the committed records and the next slot to write.
+	 */
+	void recover();
+
+	/**
+	 * Reads a journal record.
+	 * @param sequence	Receives the sequence byte, including the COMMIT flag.
+	 */
+	bool readRecord(uint8_t slot, uint8_t& sequence, uint16_t& index, uint16_t& mask, uint8_t* data) const;
+
+	eptr_t slotOffset(uint8_t slot) const {
+		return eptr_t(journalStart+slot*RECORD_SIZE);
+	}
+
+	static uint8_t checksum(uint16_t index, uint16_t mask, const uint8_t* data);
+
+	static uint8_t nextSequenceAfter(uint8_t sequence);
+
+	/**
+	 * Writes data to the backend, skipping bytes that already have the value.
+	 */
+	void update(eptr_t offset, const uint8_t* data, uint16_t size);
+
+	EepromAccess& backend;
+	eptr_t journalStart;
+	Page pages[EEPROM_CACHE_PAGES];
+	Slot slots[EEPROM_JOURNAL_SLOTS];
+	uint16_t useCount;
+	uint8_t nextSlot;
+	uint8_t nextSequence;
+};
+
+#endif
@@ -37,8 +37,10 @@ bool checkType(uint8_t& typeID, Value* value) {
 	return !typeID || value->typeID()==typeID;
 }
 
-void readValue(Object* root, DataIn& in, DataOut& out) {
-	Object* o = lookupObject(root, in);		// read the object and pipe read data to output
+/**
+ * Reads the type and size from the stream and writes the value of the object.
+ */
+void readObjectValue(Object* o, DataIn& in, DataOut& out) {
 	uint8_t typeID = in.next();
 	uint8_t available = in.next();			// number of bytes expected
 	int8_t code = 0;
@@ -67,6 +69,11 @@ void readValue(Object* root, DataIn& in, DataOut& out) {
 	}
 }
 
+void readValue(Object* root, DataIn& in, DataOut& out) {
+	Object* o = lookupObject(root, in);		// read the object and pipe read data to output
+	readObjectValue(o, in, out);
+}
+
 /**
  * Implements the read value command. Accepts multiple ID chains and outputs each chain plus the
  * data for that object, or a 0-byte block if the object is not known or is not readable.
@@ -82,8 +89,7 @@ void Commands::readSystemValueCommandHandler(DataIn& in, DataOut& out) {
 /**
  * Implements the set value command.
  */
-void setValue(Object* root, DataIn& in, DataIn& mask, DataOut& out) {
-	Object* o = lookupObject(root, in);		// fetch the id and the object
+void setObjectValue(Object* o, DataIn& in, DataIn& mask, DataOut& out) {
 	WritableValue* v = (WritableValue*)o;
 	uint8_t typeID = in.next();
 	uint8_t available = in.next();
@@ -113,6 +119,10 @@ void setValue(Object* root, DataIn& in, DataIn& mask, DataOut& out) {
 	}
 }
 
+void setValue(Object* root, DataIn& in, DataIn& mask, DataOut& out) {
+	Object* o = lookupObject(root, in);		// fetch the id and the object
+	setObjectValue(o, in, mask, out);
+}
 
 void Commands::setValueCommandHandler(DataIn& in, DataOut& out) {
 	DefaultMask defaultMask;
@@ -133,6 +143,44 @@ void Commands::setSystemMaskValueCommandHandler(DataIn& in, DataOut& out) {
 	setValue(systemProfile.systemContainer(), in, in, out);
 }
 
+/**
+ * Reads a 16-bit handle, least significant byte first.
+ */
+object_handle_t Commands::readHandle(DataIn& in) {
+	object_handle_t handle = in.next();
+	return object_handle_t(handle | (in.next()<<8));
+}
+
+/**
+ * Retrieves the handle of an object in the active profile.
+ * Writes the handle, least significant byte first, or an error code when the object has no handle.
+ */
+void Commands::lookupHandleCommandHandler(DataIn& in, DataOut& out) {
+	Container* root = systemProfile.rootContainer();
+	Object* o = root ? lookupObject(root, in) : NULL;
+	object_handle_t handle = handles.find(o);
+	if (handle==HandleTable::INVALID_HANDLE) {
+		out.write(uint8_t(errorCode(invalid_id)));
+	}
+	else {
+		out.write(0);
+		out.write(uint8_t(handle));
+		out.write(uint8_t(handle>>8));
+	}
+}
+
+/**
+ * Implements the read value command for an object addressed by handle, which avoids the lookup in the container hierarchy.
+ */
+void Commands::readHandleValueCommandHandler(DataIn& in, DataOut& out) {
+	readObjectValue(handles.lookup(readHandle(in)), in, out);
+}
+
+void Commands::setHandleValueCommandHandler(DataIn& in, DataOut& out) {
+	DefaultMask defaultMask;
+	setObjectValue(handles.lookup(readHandle(in)), in, defaultMask, out);
+}
+
 /**
  * Consumes the definition data from the stream and returns a {@code NULL} pointer.
  */
@@ -191,12 +239,19 @@ int8_t Commands::rehydrateObject(eptr_t offset, PipeDataIn& in, bool dryRun)
 		OpenContainer* target = (OpenContainer*)container;
 		error = createObject(newObject, in, dryRun);			// read the type and create args
 
+		if (!error && lastID<target->size()) {
+			// the object in the slot is replaced, so its definition is no longer needed
+			eptr_t replaced = handles.release(target->item(lastID));
+			if (replaced)
+				eepromAccess.writeByte(replaced, CMD_DISPOSED_OBJECT);
+		}
 		if (!error && !target->add(lastID,newObject)) {
 			error = errorCode(insufficient_heap);
 		}
 	}
 
 	if (!error) {
+		handles.assign(newObject, container, offset);
         // skip object create command, type and id.
         offset++; // skip creation id
         while (int8_t(eepromAccess.readByte(offset++))<0) {}	// skip contianer
@@ -292,6 +347,12 @@ void Commands::removeEepromCreateCommand(BufferDataOut& id) {
 }
 
 int8_t Commands::deleteObject(DataIn& id) {
+	eptr_t definition;
+	return deleteObject(id, definition);
+}
+
+int8_t Commands::deleteObject(DataIn& id, eptr_t& definition) {
+	definition = INVALID_EPTR;
 	int8_t lastID = 0;
 	OpenContainer* container = nullptr;
 	int8_t error = lookupUserOpenContainer(systemProfile.rootContainer(), id, lastID, container);	// find the container and the ID in the chain to remove
@@ -302,6 +363,7 @@ int8_t Commands::deleteObject(DataIn& id) {
 	if (!error) {
 		Object* target = container->item(lastID);
 		error = target ? int8_t(target->typeID()) : 0;
+		definition = handles.release(target);
 		container->remove(lastID);
 	}
 	return error;
@@ -316,9 +378,15 @@ void Commands::deleteObjectCommandHandler(DataIn& in, DataOut& out)
 	uint8_t buf[MAX_CONTAINER_DEPTH+1];
 	BufferDataOut idCapture(buf, MAX_CONTAINER_DEPTH+1);	// buffer to capture id
 	PipeDataIn idPipe(in, idCapture);						// capture read id
-	int8_t error = deleteObject(idPipe);
-	if (error>=0)
-		removeEepromCreateCommand(idCapture);
+	eptr_t definition;
+	int8_t error = deleteObject(idPipe, definition);
+	if (error>=0) {
+		if (definition!=INVALID_EPTR)
+			eepromAccess.writeByte(definition, CMD_DISPOSED_OBJECT);
+		else
+			removeEepromCreateCommand(idCapture);
+		systemProfile.scheduleCompaction();		// space is reclaimed from the main loop
+	}
 	out.write(uint8_t(error));
 }
 
@@ -408,7 +476,13 @@ bool logValuesCallback(Object* o, void* data, const container_id* id, const cont
 }
 
 void Commands::logValuesImpl(container_id* ids, DataOut& out) {
-	walkRoot(systemProfile.rootContainer(), logValuesCallback, NULL, ids);
+	Container* root = systemProfile.rootContainer();
+	if (root)
+		walkRoot(root, logValuesCallback, &out, ids);
+}
+
+void Commands::logValuesDeltaImpl(container_id* ids, DataOut& out) {
+	deltaLog.logValues(systemProfile.rootContainer(), ids, out);
 }
 
 const uint8_t LOG_FLAGS_IDCHAIN = 1<<0;
@@ -498,7 +572,10 @@ CommandHandler Commands::handlers[] = {
 	&Commands::readSystemValueCommandHandler,	// 0x0F
 	&Commands::setSystemValueCommandHandler,	// 0x10
 	&Commands::setMaskValueCommandHandler,		// 0x11
-	&Commands::setSystemMaskValueCommandHandler // 0x12
+	&Commands::setSystemMaskValueCommandHandler, // 0x12
+	&Commands::lookupHandleCommandHandler,		// 0x13
+	&Commands::readHandleValueCommandHandler,	// 0x14
+	&Commands::setHandleValueCommandHandler		// 0x15
 };
 
 // todo - there are pairs of commands that affect system or user objects
@@ -515,7 +592,7 @@ void Commands::handleCommand(DataIn& dataIn, DataOut& dataOut)
 {
 	PipeDataIn pipeIn = PipeDataIn(dataIn, dataOut);	// ensure command input is also piped to output
 	uint8_t cmd_id = pipeIn.next();						// command type code
-	if (cmd_id>sizeof(handlers)/sizeof(handlers[0]))	// check range
+	if (cmd_id>=sizeof(handlers)/sizeof(handlers[0]))	// check range
 		cmd_id = 0;
 	(
 #if !CONTROLBOX_STATIC
@@ -527,6 +604,8 @@ void Commands::handleCommand(DataIn& dataIn, DataOut& dataOut)
 
 
 #if CONTROLBOX_STATIC
+DeltaLog Commands::deltaLog;
+HandleTable Commands::handles;
 Commands commands;
 #endif
 
@@ -26,6 +26,8 @@
 #include "Values.h"
 #include "SystemProfile.h"
 #include "Integration.h"
+#include "DeltaLog.h"
+#include "HandleTable.h"
 
 typedef char* pchar;
 typedef const char* cpchar;
@@ -148,13 +150,34 @@ class Commands
 	cb_static void setSystemValueCommandHandler(DataIn& in, DataOut& out);
 	cb_static void setMaskValueCommandHandler(DataIn& in, DataOut& out);
 	cb_static void setSystemMaskValueCommandHandler(DataIn& in, DataOut& out);
+	cb_static void lookupHandleCommandHandler(DataIn& in, DataOut& out);
+	cb_static void readHandleValueCommandHandler(DataIn& in, DataOut& out);
+	cb_static void setHandleValueCommandHandler(DataIn& in, DataOut& out);
 
 	cb_static int8_t createObject(Object*& result, DataIn& in, bool dryRun);
 	cb_static void removeEepromCreateCommand(BufferDataOut& id);
 
+	cb_static DeltaLog deltaLog;
+	cb_static HandleTable handles;
+
+	cb_static object_handle_t readHandle(DataIn& in);
+
 public:
 	cb_static void logValuesImpl(container_id* ids, DataOut& out);
 
+	/**
+	 * Logs only the values that changed since the previous call, with periodic keyframes.
+	 * See DeltaLog for the stream format.
+	 */
+	cb_static void logValuesDeltaImpl(container_id* ids, DataOut& out);
+
+	/**
+	 * The handles of the objects in the active profile.
+	 */
+	inline cb_static HandleTable& objectHandles() {
+		return handles;
+	}
+
 #if !CONTROLBOX_STATIC
 private:
 	Comms& comms;
@@ -182,6 +205,7 @@ public:
 	}
 
 	inline cb_static void connectionStarted(StandardConnection& connection, DataOut& out) {
+		deltaLog.requestKeyframe();	// the new listener has no references yet
 		command_callback_fn(connectionStarted(connection, out));
 	}
 
@@ -214,6 +238,12 @@ public:
 	 */
 	cb_static int8_t deleteObject(DataIn& id);
 
+	/**
+	 * Delete an object (but not the definition in eeprom.)
+	 * @param definition	Receives the eeprom offset of the object definition, or INVALID_EPTR when not known.
+	 */
+	cb_static int8_t deleteObject(DataIn& id, eptr_t& definition);
+
 	/**
 	 * Prototype for object factories.
 	 */
@@ -241,11 +271,15 @@ public:
 		CMD_WRITE_SYSTEM_VALUE = 16,// write the value to a system object
 		CMD_WRITE_MASK_VALUE = 17,	// write a value with a mask to preserve some of the existing value
 		CMD_WRITE_SYSTEM_MASK_VALUE = 18,	// write a system value with a mask to preserve some of the existing value
+		CMD_LOOKUP_HANDLE = 19,		// retrieve the handle of the object with the given id chain
+		CMD_READ_HANDLE_VALUE = 20,	// read a value, addressed by handle
+		CMD_WRITE_HANDLE_VALUE = 21,	// write a value, addressed by handle
 		CMD_MAX = 127,				// max command value for user-visible commands
 		CMD_SPECIAL_FLAG = 128,
 		CMD_INVALID = CMD_SPECIAL_FLAG | CMD_NONE,						// special value for invalid command in eeprom. Used as a placeholder for incomplete data
 		CMD_DISPOSED_OBJECT = CMD_CREATE_OBJECT | CMD_SPECIAL_FLAG,	// flag in eeprom for object that is now deleted. Allows space to be reclaimed later.
 		CMD_LOG_VALUES_AUTO = CMD_LOG_VALUES | CMD_SPECIAL_FLAG,
+		CMD_LOG_VALUES_DELTA_AUTO = CMD_NOT_USED | CMD_SPECIAL_FLAG,	// automatic log of changed values only
 	};
 
 };
@@ -261,6 +261,60 @@ TCPClient acceptConnection()
     return accept;
 }
 
+#ifndef CONTROLBOX_BROADCAST_SIZE
+#define CONTROLBOX_BROADCAST_SIZE 2048
+#endif
+
+/**
+ * The unsolicited output for the TCP clients. It is encoded once, and each client is sent it at its own pace.
+ */
+BroadcastDataOut<CONTROLBOX_BROADCAST_SIZE> tcpBroadcast;
+
+/**
+ * Sends broadcast data to a TCPClient. With a zero timeout, the client takes what fits in its send buffer.
+ */
+class TCPClientBroadcastSink : public BroadcastSink
+{
+	TCPClient& client;
+	system_tick_t timeout;
+public:
+	TCPClientBroadcastSink(TCPClient& client_, system_tick_t timeout_) : client(client_), timeout(timeout_) {}
+
+	uint16_t writeAvailable(const uint8_t* data, uint16_t length) override {
+		int sent = int(client.write(data, length, timeout));	// negative on error
+		return sent > 0 ? uint16_t(sent) : 0;
+	}
+};
+
+/**
+ * Sends each TCP client the broadcast output it has not received yet, without waiting for slow clients.
+ * A client that is about to be written to directly, with a command response or an announcement, is sent the rest
+ * of the broadcast first, so the direct output does not end up inside a broadcast frame.
+ */
+void pumpBroadcast()
+{
+	for (auto& connection : connections) {
+		TCPClient& client = connection.getConnection();
+		StandardConnectionDataType& data = connection.getData();
+		TCPClientBroadcastSink sink(client, 0);
+		bool caughtUp = tcpBroadcast.pump(data.broadcast, sink);
+		// a command response or an announcement is written in this receive, otherwise the write need not block
+		bool directOutput = connection.getDataIn().available() || data.announcementDue();
+		if (caughtUp || !directOutput) {
+			continue;
+		}
+		TCPClientBroadcastSink blockingSink(client, SPARK_WIRING_TCPCLIENT_DEFAULT_SEND_TIMEOUT);
+		uint32_t pending = tcpBroadcast.pending(data.broadcast);
+		while (!tcpBroadcast.pump(data.broadcast, blockingSink)) {
+			uint32_t left = tcpBroadcast.pending(data.broadcast);
+			if (left == pending) {
+				break;	// the client does not take data, give up rather than stall the other connections
+			}
+			pending = left;
+		}
+	}
+}
+
 void manageConnection()
 {
     // remove disconnected clients
@@ -269,8 +323,11 @@ void manageConnection()
     TCPClient client = acceptConnection();
     if (client.connected()) {
     		TCPConnection connection(client);
+    		connection.getData().broadcast = tcpBroadcast.attach();
         connections.push_back(connection);
     }
+
+    pumpBroadcast();
 }
 #else
 void manageConnection()
@@ -341,6 +398,30 @@ auto fetch_streams() -> decltype(boost::adaptors::transform(all_connections(), T
     return boost::adaptors::transform(all_connections(), TransformFunctor());
 }
 
+#if defined(SPARK)
+/**
+ * The unsolicited output. Serial is written directly, the TCP clients are sent it from the broadcast buffer.
+ */
+class UnsolicitedOut : public DataOut
+{
+public:
+	bool write(uint8_t data) override {
+		commsOut.write(data);
+		return tcpBroadcast.write(data);
+	}
+
+	bool writeBuffer(const void* data, stream_size_t len) override {
+		commsOut.writeBuffer(data, len);
+		return tcpBroadcast.writeBuffer(data, len);
+	}
+
+	void flush() override {
+		commsOut.flush();
+	}
+};
+
+UnsolicitedOut compositeOut;
+#else
 /**
  * Converts connections to a DataOut reference.
  */
@@ -354,6 +435,7 @@ using CompositeDatOutType = CompositeDataOut<ConnectionTransformIterator<ToDataO
  * A composite
  */
 CompositeDatOutType compositeOut(fetch_streams<ToDataOutFunctor>);
+#endif
 
 #if 0
 void f()
@@ -490,17 +572,16 @@ StandardConnection* handleConnection(
 #endif
 		StandardConnection& connection)
 {
-    static uint16_t connection_count = 0;
     StandardConnectionDataType& data = connection.getData();
-    if (!data.connected || (data.callback_until_first_request && !data.request_received && (++data.next_announcement>100))) {
-    		if (!data.connected) {
-    			data.connected = true;
-			connection_count++;
-    		}
+    if (data.announcementDue()) {
+    		data.connected = true;
 		BinaryToHexTextOut out(connection.getDataOut());
 		cb_nonstatic_decl(comms.)connectionStarted(connection, out);
 		data.next_announcement = 0;
     }
+    else if (data.callback_until_first_request && !data.request_received) {
+    		data.next_announcement++;
+    }
 
     return connection.getDataIn().available() ? &connection : nullptr;
 }
@@ -548,6 +629,15 @@ void processCommand(
     }
 }
 
+void Comms::waitForInput(uint32_t millis)
+{
+#if CONTROLBOX_STATIC
+	(void)millis;	// the connections are polled
+#else
+	connection_.waitForInput(millis);
+#endif
+}
+
 void Comms::receive()
 {
 	if (reset)
@@ -22,6 +22,7 @@
 
 #include "Static.h"
 #include "DataStream.h"
+#include "BroadcastDataOut.h"
 #include <string.h>
 
 #if !CONTROLBOX_STATIC
@@ -49,6 +50,12 @@ struct Connection
     virtual DataIn& getDataIn()=0;
     virtual bool connected()=0;
 
+    /**
+     * Waits up to the given time for input, so that a host can sleep instead of polling the connection.
+     * @return true when input may be available. Connections that cannot wait return true straight away.
+     */
+    virtual bool waitForInput(uint32_t /*millis*/) { return true; }
+
     /**
      * Retrieve the most-recently assigned value to the user data item.
      */
@@ -165,6 +172,8 @@ public:
     virtual DataOut& getDataOut() override { return *out; }
     virtual bool connected() override { return true; }
 
+    connection_type& getConnection() { return *connection; }
+
 };
 
 #include "ControlboxWiring.h"
@@ -233,6 +242,23 @@ struct StandardConnectionDataType
 	 */
 	bool request_received;
 
+	/**
+	 * Position in the broadcast output, for connections that receive the unsolicited output from a BroadcastDataOut.
+	 */
+	BroadcastCursor broadcast;
+
+	/**
+	 * Number of receive calls between announcements, while waiting for the first request.
+	 */
+	static const uint32_t ANNOUNCEMENT_INTERVAL = 100;
+
+	/**
+	 * Returns true when the connection is sent an announcement on the next receive: when it is new, and then
+	 * periodically until the first request when callback_until_first_request is set.
+	 */
+	bool announcementDue() const {
+		return !connected || (callback_until_first_request && !request_received && next_announcement>=ANNOUNCEMENT_INTERVAL);
+	}
 };
 
 /**
@@ -442,6 +468,11 @@ public:
 	 */
 	cb_static void receive();
 
+	/*
+	 * Waits up to the given time for input on the comms link.
+	 */
+	cb_static void waitForInput(uint32_t millis);
+
 	cb_static void resetOnCommandComplete();
 
 	/**
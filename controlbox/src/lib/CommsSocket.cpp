@@ -0,0 +1,282 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CommsSocket.h"
+
+#if !CONTROLBOX_WIRING && defined(__linux__)
+
+#include <chrono>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+SocketConnection::SocketConnection()
+: listener(-1), client(-1), epoll(epoll_create1(EPOLL_CLOEXEC)),
+  inputStart(0), inputEnd(0), outputLength(0), in(*this), out(*this)
+{
+}
+
+SocketConnection::~SocketConnection()
+{
+	disconnect();
+	if (listener >= 0) {
+		close(listener);
+	}
+	if (epoll >= 0) {
+		close(epoll);
+	}
+}
+
+bool SocketConnection::listen(int fd)
+{
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = fd;
+	if (::listen(fd, 4) < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+		int error = errno;
+		close(fd);
+		errno = error;
+		return false;
+	}
+	listener = fd;
+	return true;
+}
+
+bool SocketConnection::listenUnix(const char* path)
+{
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		errno = ENAMETOOLONG;
+		return false;
+	}
+	strcpy(address.sun_path, path);
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return false;
+	}
+	unlink(path);
+	if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+		int error = errno;
+		close(fd);
+		errno = error;
+		return false;
+	}
+	return listen(fd);
+}
+
+bool SocketConnection::listenTcp(uint16_t port)
+{
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return false;
+	}
+	int reuse = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+		int error = errno;
+		close(fd);
+		errno = error;
+		return false;
+	}
+	return listen(fd);
+}
+
+void SocketConnection::accept()
+{
+	int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	// responses are sent per line, so don't hold back small segments (fails harmlessly on Unix sockets)
+	int noDelay = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+	epoll_event event = {};
+	event.events = EPOLLIN | EPOLLRDHUP;
+	event.data.fd = fd;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+	client = fd;
+	getData() = StandardConnectionDataType();
+}
+
+void SocketConnection::disconnect()
+{
+	if (client >= 0) {
+		epoll_ctl(epoll, EPOLL_CTL_DEL, client, nullptr);
+		close(client);
+		client = -1;
+		if (listener >= 0) {
+			// accept the next client
+			epoll_event event = {};
+			event.events = EPOLLIN;
+			event.data.fd = listener;
+			epoll_ctl(epoll, EPOLL_CTL_MOD, listener, &event);
+		}
+	}
+	inputStart = inputEnd = 0;
+	outputLength = 0;
+}
+
+void SocketConnection::receive()
+{
+	if (inputStart == inputEnd) {
+		inputStart = inputEnd = 0;
+	}
+	if (client < 0 || inputEnd == BUFFER_SIZE) {
+		return;
+	}
+	ssize_t count = recv(client, input + inputEnd, BUFFER_SIZE - inputEnd, 0);
+	if (count > 0) {
+		inputEnd += size_t(count);
+	}
+	else if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+		disconnect();
+	}
+}
+
+bool SocketConnection::send()
+{
+	size_t sent = 0;
+	while (sent < outputLength && client >= 0) {
+		ssize_t count = ::send(client, output + sent, outputLength - sent, MSG_NOSIGNAL);
+		if (count > 0) {
+			sent += size_t(count);
+		}
+		else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			// the client is not keeping up: wait for room rather than drop part of a response
+			pollfd writable = { client, POLLOUT, 0 };
+			poll(&writable, 1, -1);
+		}
+		else if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		else {
+			disconnect();
+		}
+	}
+	outputLength = 0;
+	return client >= 0;
+}
+
+void SocketConnection::service(int timeout)
+{
+	epoll_event events[2];
+	int count = epoll_wait(epoll, events, 2, timeout);
+	for (int i = 0; i < count; i++) {
+		if (events[i].data.fd == listener) {
+			if (client < 0) {
+				accept();
+			}
+			else {
+				// one client at a time: the next one waits in the backlog
+				epoll_event event = {};
+				event.events = 0;
+				event.data.fd = listener;
+				epoll_ctl(epoll, EPOLL_CTL_MOD, listener, &event);
+			}
+		}
+		else if (events[i].data.fd == client) {
+			receive();
+		}
+	}
+}
+
+bool SocketConnection::connected()
+{
+	if (client < 0) {
+		service(0);
+	}
+	return client >= 0;
+}
+
+bool SocketConnection::waitForInput(uint32_t millis)
+{
+	// a new client wakes the wait without input, so keep waiting for the rest of the time
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(millis);
+	while (!buffered()) {
+		auto left = std::chrono::duration_cast<std::chrono::milliseconds>(end - std::chrono::steady_clock::now());
+		if (left.count() <= 0) {
+			break;
+		}
+		service(int(left.count()));
+	}
+	return buffered() > 0;
+}
+
+bool SocketConnection::SocketIn::hasNext()
+{
+	return connection.buffered() || connection.connected();
+}
+
+unsigned SocketConnection::SocketIn::available()
+{
+	if (!connection.buffered()) {
+		connection.service(0);
+	}
+	return unsigned(connection.buffered());
+}
+
+uint8_t SocketConnection::SocketIn::peek()
+{
+	while (!connection.buffered() && connection.client >= 0) {
+		connection.service(-1);
+	}
+	return connection.buffered() ? connection.input[connection.inputStart] : 0;
+}
+
+uint8_t SocketConnection::SocketIn::next()
+{
+	uint8_t result = peek();
+	if (connection.buffered()) {
+		connection.inputStart++;
+	}
+	return result;
+}
+
+bool SocketConnection::SocketOut::write(uint8_t data)
+{
+	if (connection.client < 0) {
+		return false;
+	}
+	connection.output[connection.outputLength++] = data;
+	if (data == '\n' || connection.outputLength == BUFFER_SIZE) {
+		return connection.send();
+	}
+	return true;
+}
+
+void SocketConnection::SocketOut::flush()
+{
+	if (connection.outputLength) {
+		connection.send();
+	}
+}
+
+#endif
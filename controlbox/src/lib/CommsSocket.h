@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "ControlboxWiring.h"
+
+#if !CONTROLBOX_WIRING && defined(__linux__)
+
+#include "Comms.h"
+#include <stddef.h>
+
+/**
+ * A host connection that listens on a Unix or TCP socket and serves one client at a time.
+ *
+ * The sockets are non-blocking and watched with epoll, so waitForInput() sleeps until a client connects or sends
+ * data. Input is received in bulk into a buffer that the DataIn reads from. Output is buffered and sent per line,
+ * waiting for the client only when its receive window is full.
+ *
+ * When the client disconnects, the connection data is reset, so the next client gets a new announcement.
+ */
+class SocketConnection : public ConnectionData<StandardConnectionDataType>
+{
+	class SocketIn : public DataIn
+	{
+		SocketConnection& connection;
+	public:
+		SocketIn(SocketConnection& c) : connection(c) {}
+
+		bool hasNext() override;
+		uint8_t next() override;
+		uint8_t peek() override;
+		unsigned available() override;
+	};
+
+	class SocketOut : public DataOut
+	{
+		SocketConnection& connection;
+	public:
+		SocketOut(SocketConnection& c) : connection(c) {}
+
+		bool write(uint8_t data) override;
+		void flush() override;
+	};
+
+	static const size_t BUFFER_SIZE = 4096;
+
+	int listener;
+	int client;
+	int epoll;
+
+	uint8_t input[BUFFER_SIZE];
+	size_t inputStart;
+	size_t inputEnd;
+
+	uint8_t output[BUFFER_SIZE];
+	size_t outputLength;
+
+	SocketIn in;
+	SocketOut out;
+
+	bool listen(int fd);
+	void accept();
+	void disconnect();
+	void receive();
+	bool send();
+
+	/**
+	 * Handles new clients and received data, waiting up to timeout milliseconds (-1 waits indefinitely).
+	 */
+	void service(int timeout);
+
+	size_t buffered() const { return inputEnd - inputStart; }
+
+public:
+	SocketConnection();
+	~SocketConnection();
+
+	SocketConnection(const SocketConnection&) = delete;
+	SocketConnection& operator=(const SocketConnection&) = delete;
+
+	/**
+	 * Listens on a Unix domain socket. An existing socket file at the path is replaced.
+	 * @return false when the socket could not be created, with errno set.
+	 */
+	bool listenUnix(const char* path);
+
+	/**
+	 * Listens on a TCP port on all interfaces.
+	 * @return false when the socket could not be created, with errno set.
+	 */
+	bool listenTcp(uint16_t port);
+
+	DataIn& getDataIn() override { return in; }
+	DataOut& getDataOut() override { return out; }
+	bool connected() override;
+	bool waitForInput(uint32_t millis) override;
+};
+
+#endif
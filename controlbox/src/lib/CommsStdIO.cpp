@@ -2,6 +2,154 @@
 
 #if !CONTROLBOX_WIRING
 
+#include <chrono>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+#if !defined(WIN32)
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+InputStreamPoll::Input::Input(std::istream& in_)
+: in(in_), open(true), stopped(false), event(-1), stopEvent(-1)
+{
+#if defined(__linux__)
+	event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	stopEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+InputStreamPoll::Input::~Input()
+{
+#if defined(__linux__)
+	if (event >= 0) {
+		close(event);
+	}
+	if (stopEvent >= 0) {
+		close(stopEvent);
+	}
+#endif
+}
+
+InputStreamPoll::~InputStreamPoll()
+{
+	input.stop();
+	reader.join();
+}
+
+void InputStreamPoll::Input::stop()
+{
+	stopped.store(true, std::memory_order_release);
+	signal(stopEvent);
+}
+
+/**
+ * Waits until stdin can be read without blocking.
+ * @return false when the thread is stopped.
+ */
+bool InputStreamPoll::Input::waitForStdin()
+{
+#if !defined(WIN32)
+	pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { stopEvent, POLLIN, 0 } };
+	// poll skips a negative fd, so without a stop event check for stop now and then
+	int timeout = stopEvent >= 0 ? -1 : 100;
+	while (!stopped.load(std::memory_order_acquire)) {
+		if (poll(fds, 2, timeout) > 0 && fds[0].revents) {
+			return true;
+		}
+	}
+	return false;
+#else
+	return !stopped.load(std::memory_order_acquire);
+#endif
+}
+
+/**
+ * Reads what the stream has available, waiting only for the first byte.
+ * @return The number of bytes read, 0 at the end of the stream.
+ */
+size_t InputStreamPoll::Input::readChunk(char* target, size_t size)
+{
+#if !defined(WIN32)
+	if (&in == &std::cin) {
+		// std::cin is unbuffered when synchronized with stdio, so read the file directly
+		if (!waitForStdin()) {
+			return 0;
+		}
+		ssize_t count = ::read(STDIN_FILENO, target, size);
+		return count > 0 ? size_t(count) : 0;
+	}
+#endif
+	int c = in.get();
+	if (c == std::char_traits<char>::eof()) {
+		return 0;
+	}
+	target[0] = char(c);
+	return 1 + size_t(in.readsome(target + 1, std::streamsize(size - 1)));
+}
+
+void InputStreamPoll::Input::signal(int fd)
+{
+#if defined(__linux__)
+	if (fd >= 0) {
+		uint64_t one = 1;
+		ssize_t ignored = ::write(fd, &one, sizeof(one));
+		(void)ignored;
+	}
+#endif
+}
+
+void InputStreamPoll::Input::run()
+{
+	char chunk[4096];
+	size_t count;
+	while (!stopped.load(std::memory_order_acquire) && (count = readChunk(chunk, sizeof(chunk))) > 0) {
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(chunk);
+		for (;;) {
+			size_t written = queue.write(data, count);
+			if (written) {
+				signal(event);
+			}
+			if (written == count || stopped.load(std::memory_order_acquire)) {
+				break;
+			}
+			// the queue is full: the consumer will catch up
+			data += written;
+			count -= written;
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	}
+	open.store(false, std::memory_order_release);
+	signal(event);
+}
+
+bool InputStreamPoll::wait(uint32_t millis)
+{
+	auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(millis);
+	while (!available() && input.open.load(std::memory_order_acquire)) {
+		auto now = std::chrono::steady_clock::now();
+		if (now >= end) {
+			break;
+		}
+#if defined(__linux__)
+		if (input.event >= 0) {
+			pollfd fds = { input.event, POLLIN, 0 };
+			int timeout = int(std::chrono::duration_cast<std::chrono::milliseconds>(end - now).count()) + 1;
+			if (poll(&fds, 1, timeout) > 0) {
+				uint64_t count;
+				ssize_t ignored = ::read(input.event, &count, sizeof(count));
+				(void)ignored;
+			}
+			continue;
+		}
+#endif
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return available() > 0;
+}
+
 #if defined(WIN32)
 static int is_pipe = 0;
 static HANDLE input_handle = 0;
@@ -92,7 +240,9 @@ void StdIO::begin(unsigned long)
 
 size_t StdIO::write(uint8_t w) {
     fputc(w, out);
-    fflush(out);
+    if (w == '\n') {
+        fflush(out);    // each line is a complete response or annotation
+    }
     return 1;
 }
 
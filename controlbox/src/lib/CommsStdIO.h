@@ -6,7 +6,8 @@
 #include <iostream>
 #include <string>
 #include <thread>
-#include <queue>
+#include <atomic>
+#include "SpscRingBuffer.h"
 
 class Stream {};
 
@@ -16,47 +17,78 @@ class Stream {};
 
 class InputStreamPoll : public DataIn
 {
-	std::istream& in;
-    std::thread thread;
-	std::queue<uint8_t> queue;
+	/**
+	 * State shared with the reading thread.
+	 * The thread is the only producer of the queue and this object the only consumer.
+	 */
+	struct Input {
+		std::istream& in;
+		SpscRingBuffer<65536> queue;
+		std::atomic<bool> open;
+		std::atomic<bool> stopped;
+		int event;	// signalled when data is added or the stream ends, -1 when not supported
+		int stopEvent;	// signalled to wake the thread when it is stopped, -1 when not supported
+
+		Input(std::istream& in_);
+		~Input();
+
+		void run();
+		bool waitForStdin();
+		size_t readChunk(char* target, size_t size);
+		void stop();
+		static void signal(int fd);
+	};
+
+	Input input;
+	std::thread reader;
 
 public:
-	InputStreamPoll(std::istream& in_) : in(in_), thread(std::bind(&InputStreamPoll::run, this)) {}
-
-	void run()
-	{
-		// make it a daemon thread
-		thread.detach();
-
-		while (!in.eof())
-		{
-			char c;
-			in.get(c);
-			queue.push(uint8_t(c));
-		}
+	/**
+	 * Starts a thread that reads the stream. The stream must outlive this object.
+	 */
+	InputStreamPoll(std::istream& in_) : input(in_), reader(&Input::run, &input) {
 	}
 
+	/**
+	 * Stops the reading thread and waits for it to end. A thread waiting for std::cin is woken up,
+	 * a thread reading another stream stops when that read returns.
+	 */
+	~InputStreamPoll();
+
 	unsigned available()
 	{
-		return queue.size()>0;
+		return unsigned(input.queue.available());
 	}
 
 	bool hasNext()
 	{
-		return !in.eof();
+		return input.open.load(std::memory_order_acquire) || input.queue.available();
 	}
 
 	uint8_t next()
 	{
-		uint8_t front = peek();
-		queue.pop();
-		return front;
+		return input.queue.next();
 	}
 
 	uint8_t peek()
 	{
-		return queue.front();
+		return input.queue.peek();
+	}
+
+	/**
+	 * Reads up to length bytes that have been received.
+	 * @return The number of bytes read.
+	 */
+	size_t read(uint8_t* target, size_t length)
+	{
+		return input.queue.read(target, length);
 	}
+
+	/**
+	 * Waits up to the given time for data or the end of the stream, without using the CPU.
+	 * @return true when data is available.
+	 */
+	bool wait(uint32_t millis);
 };
 
 
@@ -86,6 +118,8 @@ public:
     void flush();
     operator bool() { return in.hasNext(); }
 
+    bool wait(uint32_t millis) { return in.wait(millis); }
+
 private:
     InputStreamPoll in;
     FILE* out;
@@ -110,6 +144,11 @@ public:
 	{
 		return stdio;
 	}
+
+	bool waitForInput(uint32_t millis) override
+	{
+		return stdio.wait(millis);
+	}
 };
 
 #endif
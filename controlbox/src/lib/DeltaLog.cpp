@@ -0,0 +1,131 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DeltaLog.h"
+#include <string.h>
+
+const uint8_t DeltaLog::FULL_FLAG;
+const uint8_t DeltaLog::UNTRACKED;
+const uint8_t DeltaLog::END_OF_LOG;
+const uint8_t DeltaLog::FLAG_KEYFRAME;
+
+void DeltaLog::logValues(Container* root, container_id* ids, DataOut& out)
+{
+	bool keyframe = logsUntilKeyframe==0;
+	if (keyframe) {
+		// forget all references, so every value is sent in full
+		count = 0;
+		shadowUsed = 0;
+		logsUntilKeyframe = keyframeInterval;
+	}
+	else {
+		logsUntilKeyframe--;
+	}
+
+	out.write(uint8_t(keyframe ? FLAG_KEYFRAME : 0));
+	WalkState state = { this, &out, 0 };
+	if (root) {
+		walkRoot(root, logValueCallback, &state, ids);
+	}
+	if (state.position<count) {
+		// values at the end of the hierarchy were removed
+		count = state.position;
+		shadowUsed = count ? entries[count-1].offset+entries[count-1].size : 0;
+	}
+	out.write(END_OF_LOG);
+}
+
+uint64_t DeltaLog::idKey(const container_id* id, const container_id* end)
+{
+	uint64_t key = 0;
+	for (const container_id* p = id; p<end; p++) {
+		key = (key << 7) | uint8_t(*p & 0x7F);
+	}
+	return (key << 3) | uint8_t((end-id-1) & 0x07);
+}
+
+bool DeltaLog::logValueCallback(Object* o, void* data, const container_id* id, const container_id* end, bool enter)
+{
+	WalkState& state = *(WalkState*)data;
+	if (enter && isLoggedValue(o)) {
+		if (state.log->logValue((Value*)o, id, end, state.position, *state.out))
+			state.position++;
+	}
+	return false;
+}
+
+bool DeltaLog::logValue(Value* value, const container_id* id, const container_id* end, uint8_t position, DataOut& out)
+{
+	uint8_t size = value->readStreamSize();
+	obj_type_t type = value->typeID();
+
+	if (size>DELTA_LOG_MAX_VALUE_SIZE) {
+		// too large to buffer. Not tracked and doesn't take a reference, so it doesn't affect other values
+		writeFull(UNTRACKED, id, value, NULL, size, out);
+		return false;
+	}
+
+	uint8_t current[DELTA_LOG_MAX_VALUE_SIZE];
+	BufferDataOut buffer(current, size);
+	value->readTo(buffer);
+
+	uint64_t key = idKey(id, end);
+	if (position<count) {
+		Entry& entry = entries[position];
+		if (entry.key==key && entry.type==type && entry.size==size) {
+			uint8_t* last = shadow+entry.offset;
+			if (memcmp(last, current, size)) {
+				out.write(position);
+				out.writeBuffer(current, size);
+				memcpy(last, current, size);
+			}
+			return true;
+		}
+		// the hierarchy changed from this position on, references after it are reassigned
+		count = position;
+		shadowUsed = count ? entries[count-1].offset+entries[count-1].size : 0;
+	}
+
+	const uint8_t capacity = sizeof(entries)/sizeof(entries[0]);
+	if (position==count && count<capacity && shadowUsed+size<=DELTA_LOG_SHADOW_SIZE) {
+		Entry& entry = entries[count++];
+		entry.key = key;
+		entry.offset = shadowUsed;
+		entry.size = size;
+		entry.type = type;
+		memcpy(shadow+shadowUsed, current, size);
+		shadowUsed += size;
+		writeFull(position, id, value, current, size, out);
+		return true;
+	}
+	writeFull(UNTRACKED, id, value, current, size, out);
+	return false;
+}
+
+void DeltaLog::writeFull(uint8_t ref, const container_id* id, Value* value, const uint8_t* data, uint8_t size, DataOut& out)
+{
+	out.write(uint8_t(ref|FULL_FLAG));
+	writeID(id, out);
+	out.write(value->typeID());
+	out.write(size);
+	if (data)
+		out.writeBuffer(data, size);
+	else
+		value->readTo(out);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Values.h"
+#include "DataStream.h"
+
+/**
+ * Maximum number of logged values that are tracked. Values beyond this are always logged in full.
+ */
+#ifndef DELTA_LOG_MAX_VALUES
+#define DELTA_LOG_MAX_VALUES 32
+#endif
+
+/**
+ * Number of bytes available to store the last logged data of all tracked values.
+ */
+#ifndef DELTA_LOG_SHADOW_SIZE
+#define DELTA_LOG_SHADOW_SIZE 256
+#endif
+
+/**
+ * Values with a larger stream size are not tracked and are always logged in full.
+ */
+#ifndef DELTA_LOG_MAX_VALUE_SIZE
+#define DELTA_LOG_MAX_VALUE_SIZE 32
+#endif
+
+/**
+ * Number of logs between keyframes.
+ */
+#ifndef DELTA_LOG_KEYFRAME_INTERVAL
+#define DELTA_LOG_KEYFRAME_INTERVAL 30
+#endif
+
+/**
+ * Logs values in a container hierarchy, sending only the values that changed since the previous log.
+ *
+ * Each logged value is given a reference, which is its position in the walk of the hierarchy. A value
+ * is sent in full (with reference, id chain, type, size and data) the first time, and after that only
+ * as reference and data when its data changed. The last data sent is kept in a shadow buffer.
+ * A keyframe sends all values in full, so a new listener can build its reference table.
+ *
+ * Stream format, following the flags byte (bit 0 set for a keyframe):
+ *   full entry:   [ref|0x80] [id chain] [type] [size] [data...]
+ *   delta entry:  [ref] [data...]			size is known from the last full entry for ref
+ *   end of log:   0xFF
+ * Values that cannot be tracked are sent in full with reference UNTRACKED and don't take a reference.
+ * When the hierarchy changes, values whose position, id chain, type or size no longer match their reference are
+ * sent in full again, so the listener's table stays consistent without waiting for the next keyframe.
+ * Values are matched by id chain, not by address, because a new object can be allocated where a deleted one was.
+ */
+class DeltaLog
+{
+public:
+	static const uint8_t FULL_FLAG = 0x80;
+	static const uint8_t UNTRACKED = 0x7E;
+	static const uint8_t END_OF_LOG = 0xFF;
+	static const uint8_t FLAG_KEYFRAME = 1<<0;
+
+	DeltaLog(uint8_t keyframeInterval_ = DELTA_LOG_KEYFRAME_INTERVAL)
+		: count(0), shadowUsed(0), keyframeInterval(keyframeInterval_), logsUntilKeyframe(0) {}
+
+	/**
+	 * Writes the flags, changed values and end marker to the stream.
+	 * @param root	The container to log. When NULL, an empty log is written.
+	 * @param ids	Buffer of MAX_CONTAINER_DEPTH ids, used while walking the hierarchy.
+	 */
+	void logValues(Container* root, container_id* ids, DataOut& out);
+
+	/**
+	 * Sends all values in full with the next log.
+	 */
+	void requestKeyframe() {
+		logsUntilKeyframe = 0;
+	}
+
+	/**
+	 * @param interval	Number of logs between keyframes. 0 sends a keyframe every time.
+	 */
+	void setKeyframeInterval(uint8_t interval) {
+		keyframeInterval = interval;
+	}
+
+	/**
+	 * The number of values that currently have a reference.
+	 */
+	uint8_t trackedValues() const {
+		return count;
+	}
+
+private:
+	struct Entry {
+		uint64_t key;		// id chain of the value, see idKey()
+		uint16_t offset;	// start of the last sent data in shadow
+		uint8_t size;
+		obj_type_t type;
+	};
+
+	struct WalkState {
+		DeltaLog* log;
+		DataOut* out;
+		uint8_t position;	// reference of the next logged value
+	};
+
+	/**
+	 * Packs an id chain into a single number: 7 bits for each id and the depth in the lowest 3 bits.
+	 */
+	static uint64_t idKey(const container_id* id, const container_id* end);
+
+	static bool logValueCallback(Object* o, void* data, const container_id* id, const container_id* end, bool enter);
+
+	/**
+	 * Logs a single value and returns true when the value has reference position.
+	 */
+	bool logValue(Value* value, const container_id* id, const container_id* end, uint8_t position, DataOut& out);
+
+	void writeFull(uint8_t ref, const container_id* id, Value* value, const uint8_t* data, uint8_t size, DataOut& out);
+
+	Entry entries[DELTA_LOG_MAX_VALUES < UNTRACKED ? DELTA_LOG_MAX_VALUES : UNTRACKED];
+	uint8_t count;
+	uint8_t shadow[DELTA_LOG_SHADOW_SIZE];
+	uint16_t shadowUsed;
+	uint8_t keyframeInterval;
+	uint8_t logsUntilKeyframe;
+};
@@ -22,6 +22,10 @@
 
 #define DYNAMIC_CONTAINER_BOUNDS_CHECKS 0
 
+#if CONTROLBOX_PROFILING
+ProcessObserver* processObserver = nullptr;
+#endif
+
 container_id DynamicContainer::next() {
 	container_id sz = _size();
 	for (container_id i=0; i<sz;i++)
@@ -23,16 +23,17 @@
 #include <stdlib.h>
 #include "Values.h"
 #include "Memops.h"
+#include "ProcessObserver.h"
 
 typedef void (*ObjectHandler)(Object*, void* data);
 
 inline void do_update(Object* o, void* /*data*/) {
-	o->update();
+	updateObject(o);
 }
 
 inline void do_prepare(Object* o, void* data) {
 	prepare_t* result = (prepare_t*)data;
-        prepare_t p = o->prepare();
+        prepare_t p = prepareObject(o);
         if (p>*result)
                 *result = p;
 }
@@ -141,7 +142,7 @@ template<int SIZE> class StaticTemplateContainer : public OpenContainer
 
 		void prepare(Object* item, prepare_t& time) {
 			if (item)
-				time = std::max(time, item->prepare());
+				time = std::max(time, prepareObject(item));
 		}
 
 	public:
@@ -157,7 +158,7 @@ template<int SIZE> class StaticTemplateContainer : public OpenContainer
 			for (container_id i=0; i<size(); i++ ) {
 				Object* o = item(i);
 				if (o)
-				o->update();
+				updateObject(o);
 			}
 		}
 
@@ -220,7 +221,7 @@ class FixedContainer : public OpenContainer
 
 		void prepare(Object* item, prepare_t& time) {
 			if (item)
-				time = std::max(time, item->prepare());
+				time = std::max(time, prepareObject(item));
 		}
 
 	public:
@@ -252,7 +253,7 @@ class FixedContainer : public OpenContainer
 			for (container_id i=0; i<size(); i++ ) {
 				Object* o = item(i);
 				if (o)
-				o->update();
+				updateObject(o);
 			}
 		}
 
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "HandleTable.h"
+
+const object_handle_t HandleTable::INVALID_HANDLE;
+
+object_handle_t HandleTable::assign(Object* object, Object* container, eptr_t definition)
+{
+	if (!object)
+		return INVALID_HANDLE;
+	for (uint8_t slot=0; slot<HANDLE_TABLE_SIZE; slot++) {
+		if (!objects[slot]) {
+			objects[slot] = object;
+			containers[slot] = container;
+			definitions[slot] = definition;
+			return object_handle_t(sequence[slot]<<8 | slot);
+		}
+	}
+	overflow = true;
+	return INVALID_HANDLE;
+}
+
+eptr_t HandleTable::release(Object* object)
+{
+	eptr_t definition = INVALID_EPTR;
+	if (!object)
+		return definition;
+	for (uint8_t slot=0; slot<HANDLE_TABLE_SIZE; slot++) {
+		if (objects[slot]==object) {
+			definition = definitions[slot];
+			objects[slot] = NULL;
+			containers[slot] = NULL;
+			definitions[slot] = INVALID_EPTR;
+			sequence[slot]++;			// invalidate handles given out for this slot
+		}
+		else if (containers[slot]==object) {
+			release(objects[slot]);		// recursion depth is limited by the container depth
+		}
+	}
+	return definition;
+}
+
+void HandleTable::clear()
+{
+	for (uint8_t slot=0; slot<HANDLE_TABLE_SIZE; slot++) {
+		if (objects[slot])
+			sequence[slot]++;
+		objects[slot] = NULL;
+		containers[slot] = NULL;
+		definitions[slot] = INVALID_EPTR;
+	}
+	overflow = false;
+}
+
+object_handle_t HandleTable::find(Object* object) const
+{
+	for (uint8_t slot=0; slot<HANDLE_TABLE_SIZE; slot++) {
+		if (object && objects[slot]==object)
+			return object_handle_t(sequence[slot]<<8 | slot);
+	}
+	return INVALID_HANDLE;
+}
+
+Object* HandleTable::relocate(eptr_t from, eptr_t to)
+{
+	for (uint8_t slot=0; slot<HANDLE_TABLE_SIZE; slot++) {
+		if (objects[slot] && definitions[slot]==from) {
+			definitions[slot] = to;
+			return objects[slot];
+		}
+	}
+	return NULL;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Values.h"
+#include "EepromAccess.h"
+
+/**
+ * Maximum number of objects that can have a handle. Must be less than 255.
+ */
+#ifndef HANDLE_TABLE_SIZE
+#define HANDLE_TABLE_SIZE 64
+#endif
+
+typedef uint16_t object_handle_t;
+
+/**
+ * Assigns each live user object a 16-bit handle, so that commands can address the object without
+ * decoding an id chain and descending the container hierarchy.
+ *
+ * The low byte of a handle is the slot in the table, the high byte is a sequence number for the slot that
+ * changes each time the slot is released. A handle to a deleted object is therefore not valid for an object that
+ * later reuses the slot.
+ * The container of each object is stored, so that removing a container also releases the handles of all objects in it.
+ * The offset of the object definition in eeprom is stored, so that deleting or moving the definition doesn't require
+ * a walk of the profile.
+ */
+class HandleTable
+{
+public:
+	static const object_handle_t INVALID_HANDLE = 0xFFFF;
+
+	HandleTable() : objects(), containers(), definitions(), sequence(), overflow(false) {}
+
+	/**
+	 * Assigns a handle to an object.
+	 * @param object	The object to assign a handle to.
+	 * @param container	The container that holds the object.
+	 * @param definition	The eeprom offset of the object definition.
+	 * @return The handle, or INVALID_HANDLE when the table is full.
+	 */
+	object_handle_t assign(Object* object, Object* container, eptr_t definition=INVALID_EPTR);
+
+	/**
+	 * Releases the handle of an object and of all objects it contains.
+	 * @return The eeprom offset of the definition of the object, or INVALID_EPTR when not known.
+	 */
+	eptr_t release(Object* object);
+
+	/**
+	 * Releases all handles.
+	 */
+	void clear();
+
+	/**
+	 * @return The object with the given handle, or NULL if the handle is not valid.
+	 */
+	Object* lookup(object_handle_t handle) const {
+		uint8_t slot = uint8_t(handle);
+		if (slot>=HANDLE_TABLE_SIZE || sequence[slot]!=uint8_t(handle>>8))
+			return NULL;
+		return objects[slot];
+	}
+
+	/**
+	 * @return The handle of an object, or INVALID_HANDLE if the object has no handle.
+	 */
+	object_handle_t find(Object* object) const;
+
+	/**
+	 * Updates the stored offset of a definition that was moved.
+	 * @return The object created from the definition, or NULL if it has no handle.
+	 */
+	Object* relocate(eptr_t from, eptr_t to);
+
+	/**
+	 * @return true when every object assigned since the last clear() has a handle.
+	 */
+	bool complete() const {
+		return !overflow;
+	}
+
+private:
+	static_assert(HANDLE_TABLE_SIZE<255, "the slot must fit in the low byte of a handle, 0xFF is reserved");
+
+	Object* objects[HANDLE_TABLE_SIZE];
+	Object* containers[HANDLE_TABLE_SIZE];
+	eptr_t definitions[HANDLE_TABLE_SIZE];
+	uint8_t sequence[HANDLE_TABLE_SIZE];
+	bool overflow;
+};
@@ -3,6 +3,7 @@
 #include "Comms.h"
 #include "Ticks.h"
 #include "ValueTicks.h"
+#include "ProcessObserver.h"
 
 #if CONTROLBOX_STATIC
 
@@ -29,7 +30,7 @@ void controlbox_setup(size_t loadProfileDelay)
 bool prepareCallback(Object* o, void* data, container_id* id, bool enter) {
 	if (enter) {
 		uint32_t& waitUntil = *(uint32_t*)data;
-		prepare_t millisToWait = o->prepare();
+		prepare_t millisToWait = prepareObject(o);
 		if (millisToWait)
 			waitUntil = ticks.millis()+millisToWait;
 	}
@@ -41,18 +42,29 @@ bool prepareCallback(Object* o, void* data, container_id* id, bool enter) {
  */
 bool updateCallback(Object* o, void* data, container_id* id, bool enter) {
 	if (enter)
-		o->update();
+		updateObject(o);
 	return false;
 }
 
+/**
+ * When set, automatic logs only contain the values that changed since the previous log.
+ */
+bool deltaLogging = false;
+
 /**
  * Logs all values in the system.
  */
 void logValues(container_id* ids)
 {
 	DataOut& out = comms.dataOut();
-	out.write(int(Commands::CMD_LOG_VALUES_AUTO));
-	commands.logValuesImpl(ids, out);
+	if (deltaLogging) {
+		out.write(int(Commands::CMD_LOG_VALUES_DELTA_AUTO));
+		commands.logValuesDeltaImpl(ids, out);
+	}
+	else {
+		out.write(int(Commands::CMD_LOG_VALUES_AUTO));
+		commands.logValuesImpl(ids, out);
+	}
 	out.close();
 }
 
@@ -70,7 +82,7 @@ void process()
     prepare_t d = 0;
     Container* root = SystemProfile::rootContainer();
     if (root)
-        d = root->prepare();
+        d = prepareObject(root);
 
     uint32_t end = ticks.millis()+d;
     while (ticks.millis()<end) {
@@ -81,7 +93,7 @@ void process()
         // root may have been changed by commands, so original prepare may not be valid
         // should watch out for newly created objects, since these will then also need preparing
 	if (root==root2 && root) {
-        root->update();
+        updateObject(root);
 
         if (logValuesFlag)
         {
@@ -99,6 +111,7 @@ void controlbox_loop(void)
 {
 	process();
 	Comms::receive();
+	systemProfile.compactStep();
 }
 
 #endif
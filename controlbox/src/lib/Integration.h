@@ -74,6 +74,11 @@ void controlbox_setup(size_t loadProfileDelay);
  */
 void controlbox_loop();
 
+/**
+ * When set, automatic logs only contain the values that changed since the previous log.
+ */
+extern bool deltaLogging;
+
 #endif
 
 #endif	/* INTEGRATION_H */
@@ -46,6 +46,10 @@ public:
 		currentValue = savedValue();
 	}
 
+	void relocated(eptr_t address) {
+		EepromValue::rehydrated(address);		// the saved value moved along, keep the current value
+	}
+
 	void readTo(DataOut& out) {
 		out.write(uint8_t(currentValue>>8));
 		out.write(uint8_t(currentValue&0xFF));
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Values.h"
+
+/**
+ * Set CONTROLBOX_PROFILING to 1 to let the application observe how long each object takes to prepare and update.
+ * When it is 0, objects are called directly and the observer does not exist.
+ */
+#ifndef CONTROLBOX_PROFILING
+#define CONTROLBOX_PROFILING 0
+#endif
+
+#if CONTROLBOX_PROFILING
+
+enum class ProcessPhase : uint8_t {
+	prepare,
+	update
+};
+
+/**
+ * Implemented by the application to collect timing of the control loop.
+ * Containers report their own time too, which includes the time of the objects they contain.
+ */
+class ProcessObserver
+{
+public:
+	/**
+	 * The time source, in microseconds.
+	 */
+	virtual uint32_t micros()=0;
+
+	/**
+	 * Called after an object is prepared or updated.
+	 */
+	virtual void processed(Object* o, ProcessPhase phase, uint32_t micros)=0;
+};
+
+/**
+ * The observer that is notified, or null when there is none.
+ */
+extern ProcessObserver* processObserver;
+
+inline prepare_t prepareObject(Object* o) {
+	ProcessObserver* observer = processObserver;
+	if (!observer)
+		return o->prepare();
+	uint32_t start = observer->micros();
+	prepare_t result = o->prepare();
+	observer->processed(o, ProcessPhase::prepare, observer->micros()-start);
+	return result;
+}
+
+inline void updateObject(Object* o) {
+	ProcessObserver* observer = processObserver;
+	if (!observer) {
+		o->update();
+		return;
+	}
+	uint32_t start = observer->micros();
+	o->update();
+	observer->processed(o, ProcessPhase::update, observer->micros()-start);
+}
+
+#else
+
+inline prepare_t prepareObject(Object* o) {
+	return o->prepare();
+}
+
+inline void updateObject(Object* o) {
+	o->update();
+}
+
+#endif
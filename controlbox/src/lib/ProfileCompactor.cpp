@@ -0,0 +1,169 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProfileCompactor.h"
+#include "Commands.h"
+
+const uint8_t FILLER_HEADER_SIZE = 4;		// command, id, type, len
+const uint16_t MAX_FILLER_SIZE = FILLER_HEADER_SIZE+255;
+
+bool ProfileCompactor::parse(eptr_t at, eptr_t end, Definition& def) const
+{
+	if (eptr_t(at+FILLER_HEADER_SIZE)>end)
+		return false;
+	def.command = eepromAccess.readByte(at);
+	if (def.command!=Commands::CMD_CREATE_OBJECT && def.command!=Commands::CMD_DISPOSED_OBJECT)
+		return false;	// end of definitions, or a definition that was not completed
+	def.ids = 1;
+	while (int8_t(eepromAccess.readByte(eptr_t(at+def.ids)))<0) {
+		if (++def.ids>MAX_CONTAINER_DEPTH)
+			return false;
+	}
+	def.len = eepromAccess.readByte(def.lenOffset(at));
+	def.size = uint16_t(3+def.ids+def.len);
+	return at+def.size<=end;
+}
+
+void ProfileCompactor::write(eptr_t offset, uint8_t value, uint16_t& written)
+{
+	if (eepromAccess.readByte(offset)!=value) {
+		eepromAccess.writeByte(offset, value);
+		written++;
+	}
+}
+
+/**
+ * Removes the last id from the id chain of a disposed definition, keeping the size of the definition.
+ * @return false when the definition cannot be shortened.
+ */
+bool ProfileCompactor::shortenIdChain(eptr_t at, const Definition& def, uint16_t& written)
+{
+	if (def.len==255)
+		return false;
+	// the type byte becomes the length of the shorter chain, then the id before the last id becomes the last
+	write(eptr_t(at+def.ids+1), uint8_t(def.len+1), written);
+	write(eptr_t(at+def.ids-1), uint8_t(eepromAccess.readByte(eptr_t(at+def.ids-1)) & 0x7F), written);
+	return true;
+}
+
+/**
+ * Moves a definition that follows a filler to the start of the filler. The filler then follows the moved definition.
+ * The filler must have a one byte id chain and be at least 4 bytes larger than the definition.
+ */
+void ProfileCompactor::move(eptr_t filler, const Definition& f, eptr_t source, const Definition& def, uint16_t& written, CompactionListener& listener)
+{
+	eptr_t target = filler;
+	uint16_t size = def.size;
+
+	// new filler after the copy, in the payload of the current filler. It ends at the original until the copy is valid.
+	eptr_t next = eptr_t(target+size);
+	write(next, Commands::CMD_DISPOSED_OBJECT, written);
+	write(eptr_t(next+1), 0, written);
+	write(eptr_t(next+2), 0, written);
+	write(eptr_t(next+3), uint8_t(f.len-size), written);
+
+	// copy the definition data, also in the payload of the filler
+	for (uint16_t i=uint16_t(def.ids+3); i<size; i++) {
+		write(eptr_t(target+i), eepromAccess.readByte(eptr_t(source+i)), written);
+	}
+
+	// commit: the filler now has the size of the definition and is followed by the new filler.
+	// The positions of the id and type are not part of the structure yet, so they can be written before.
+	write(eptr_t(target+1), uint8_t(eepromAccess.readByte(eptr_t(source+1)) & 0x7F), written);
+	write(eptr_t(target+2), 0, written);
+	write(eptr_t(target+3), uint8_t(size-FILLER_HEADER_SIZE), written);
+
+	// grow the id chain one id at a time, each time the length moves one position and the size stays the same
+	for (uint8_t j=1; j<def.ids; j++) {
+		uint8_t nextId = eepromAccess.readByte(eptr_t(source+j+1));
+		write(eptr_t(target+j+3), uint8_t(size-3-(j+1)), written);
+		write(eptr_t(target+j+1), j+1<def.ids ? uint8_t(nextId & 0x7F) : nextId, written);
+		write(eptr_t(target+j), eepromAccess.readByte(eptr_t(source+j)), written);	// commit: set the continuation bit
+	}
+	write(eptr_t(target+def.ids+1), eepromAccess.readByte(eptr_t(source+def.ids+1)), written);	// type
+
+	// commit: the copy is valid. The original is still valid too, and replaces the copy when the profile is activated.
+	write(target, Commands::CMD_CREATE_OBJECT, written);
+	// commit: the original is part of the new filler
+	write(eptr_t(next+3), f.len, written);
+	listener.relocated(source, target, eptr_t(target+def.ids+3));
+}
+
+/**
+ * Copies a definition to the end of the profile and disposes of the original.
+ */
+void ProfileCompactor::append(eptr_t source, const Definition& def, eptr_t& end, uint16_t& written, CompactionListener& listener)
+{
+	eptr_t target = end;
+	for (uint16_t i=0; i<def.size; i++) {
+		write(eptr_t(target+i), eepromAccess.readByte(eptr_t(source+i)), written);
+	}
+	end = eptr_t(end+def.size);
+	listener.resized(target, end);
+	write(source, Commands::CMD_DISPOSED_OBJECT, written);		// commit
+	listener.relocated(source, target, eptr_t(target+def.ids+3));
+}
+
+bool ProfileCompactor::step(eptr_t end, eptr_t limit, uint16_t budget, CompactionListener& listener)
+{
+	uint16_t written = 0;
+	Definition def;
+	while (active && written<budget) {
+		if (!parse(position, end, def)) {
+			active = false;		// no disposed definitions until the end
+			break;
+		}
+		if (def.command==Commands::CMD_CREATE_OBJECT) {
+			position = eptr_t(position+def.size);
+			continue;
+		}
+		if (def.ids>1) {
+			if (!shortenIdChain(position, def, written))
+				position = eptr_t(position+def.size);	// cannot be a filler, left in place
+			continue;
+		}
+
+		// position is a filler, look at the definition after it
+		eptr_t nextOffset = eptr_t(position+def.size);
+		Definition next;
+		if (!parse(nextOffset, end, next)) {
+			// nothing valid after the filler, cut it off
+			listener.resized(end, position);
+			active = false;
+			break;
+		}
+		if (next.command==Commands::CMD_DISPOSED_OBJECT) {
+			if (def.size+next.size<=MAX_FILLER_SIZE)
+				write(def.lenOffset(position), uint8_t(def.len+next.size), written);	// commit: merge
+			else
+				position = nextOffset;	// filler is full, continue with the next one
+		}
+		else if (def.size>=next.size+FILLER_HEADER_SIZE) {
+			move(position, def, nextOffset, next, written, listener);
+			position = eptr_t(position+next.size);
+		}
+		else if (limit-end>next.size) {		// keep a byte after the copy to terminate the profile
+			append(nextOffset, next, end, written, listener);
+		}
+		else {
+			position = nextOffset;	// no space to move the definition, the filler is left in place
+		}
+	}
+	return !active;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Static.h"
+#include "EepromAccess.h"
+
+/**
+ * Maximum number of bytes written to eeprom by one compaction step. A step that moves a definition finishes the move,
+ * so a step writes at most this number plus twice the size of one definition.
+ */
+#ifndef PROFILE_COMPACT_STEP_BYTES
+#define PROFILE_COMPACT_STEP_BYTES 32
+#endif
+
+/**
+ * Notified of the changes made by a compaction step.
+ */
+struct CompactionListener
+{
+	/**
+	 * A definition was moved.
+	 * @param from	The previous offset of the definition (the creation command).
+	 * @param to	The new offset of the definition.
+	 * @param data	The new offset of the definition data, as passed to Object::rehydrated().
+	 */
+	virtual void relocated(eptr_t from, eptr_t to, eptr_t data)=0;
+
+	/**
+	 * The end of the profile must be moved. Both the old and the new end give a valid profile.
+	 */
+	virtual void resized(eptr_t from, eptr_t to)=0;
+};
+
+/**
+ * Removes disposed object definitions from a profile in small steps, so that compaction doesn't stall the control loop.
+ *
+ * Disposed definitions are merged into a single filler definition, a disposed definition with a one byte id.
+ * Valid definitions that follow the filler are moved in front of it, so the filler moves to the end of the profile,
+ * where it is cut off. A definition that doesn't fit in the filler is appended to the end of the profile instead,
+ * after which its original location is merged into the filler.
+ *
+ * The profile can be parsed after every single byte that is written: a definition is copied into the payload of the
+ * filler, and each change to the parsed structure is a single byte: the length of a filler, a continuation bit
+ * in an id chain or the command byte that makes the copy valid. These bytes are the commit points, so a reset
+ * during compaction leaves a profile that defines the same objects. Between making the copy valid and disposing
+ * of the original, both are valid. A reset at that point leaves two identical definitions, and the later one
+ * replaces the earlier one when the profile is activated again.
+ */
+class ProfileCompactor
+{
+	cb_nonstatic_decl(EepromAccess& eepromAccess;)
+
+	eptr_t position;	// start of the first definition that may be followed by disposed definitions
+	bool active;
+
+	struct Definition {
+		uint8_t command;
+		uint8_t ids;		// length of the id chain
+		uint8_t len;		// length of the definition data
+		uint16_t size;		// size of the complete definition
+
+		eptr_t lenOffset(eptr_t at) const { return eptr_t(at+2+ids); }
+	};
+
+	bool parse(eptr_t at, eptr_t end, Definition& def) const;
+
+	void write(eptr_t offset, uint8_t value, uint16_t& written);
+
+	bool shortenIdChain(eptr_t at, const Definition& def, uint16_t& written);
+	void move(eptr_t filler, const Definition& f, eptr_t source, const Definition& def, uint16_t& written, CompactionListener& listener);
+	void append(eptr_t source, const Definition& def, eptr_t& end, uint16_t& written, CompactionListener& listener);
+
+public:
+	ProfileCompactor(cb_nonstatic_decl(EepromAccess& ea)) : cb_nonstatic_decl(eepromAccess(ea),) position(0), active(false) {}
+
+	/**
+	 * Starts compacting the definitions from the given offset.
+	 */
+	void start(eptr_t begin) {
+		if (!active || begin<position)
+			position = begin;
+		active = true;
+	}
+
+	void stop() {
+		active = false;
+	}
+
+	bool busy() const {
+		return active;
+	}
+
+	/**
+	 * Performs one compaction step.
+	 * @param end		The end of the profile.
+	 * @param limit		The end of the space available to the profile. Definitions are appended up to this offset.
+	 * @param budget	The maximum number of bytes to write, see PROFILE_COMPACT_STEP_BYTES.
+	 * @param listener	Notified of moved definitions and changes to the end of the profile.
+	 * @return true when compaction is complete.
+	 */
+	bool step(eptr_t end, eptr_t limit, uint16_t budget, CompactionListener& listener);
+};
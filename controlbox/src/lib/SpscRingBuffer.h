@@ -0,0 +1,114 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of Controlbox.
+ *
+ * Controlbox is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Controlbox.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * A bounded byte queue for one producer thread and one consumer thread, without locks.
+ *
+ * The producer only writes head and the consumer only writes tail. Each side publishes its index with release
+ * ordering after copying the data, and reads the other index with acquire ordering, so the data is visible before
+ * the index that covers it. Both sides copy in bulk, at most two memcpy calls per transfer.
+ *
+ * @param Size The capacity in bytes, a power of 2.
+ */
+template <size_t Size>
+class SpscRingBuffer
+{
+	static_assert(Size && !(Size & (Size - 1)), "size must be a power of 2");
+
+	uint8_t buffer[Size];
+	alignas(64) std::atomic<size_t> head;	// total bytes written, owned by the producer
+	alignas(64) std::atomic<size_t> tail;	// total bytes read, owned by the consumer
+
+public:
+	SpscRingBuffer() : head(0), tail(0) {}
+
+	/**
+	 * Producer: the number of bytes that can be written without overwriting unread data.
+	 */
+	size_t space() const {
+		return Size - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+	}
+
+	/**
+	 * Producer: writes as many bytes as fit.
+	 * @return The number of bytes written.
+	 */
+	size_t write(const uint8_t* data, size_t length) {
+		size_t h = head.load(std::memory_order_relaxed);
+		size_t free = Size - (h - tail.load(std::memory_order_acquire));
+		if (length > free) {
+			length = free;
+		}
+		size_t offset = h & (Size - 1);
+		size_t first = length < Size - offset ? length : Size - offset;
+		memcpy(buffer + offset, data, first);
+		memcpy(buffer, data + first, length - first);
+		head.store(h + length, std::memory_order_release);
+		return length;
+	}
+
+	/**
+	 * Consumer: the number of bytes that can be read.
+	 */
+	size_t available() const {
+		return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Consumer: the next byte, without removing it. Only valid when available() is not 0.
+	 */
+	uint8_t peek() const {
+		return buffer[tail.load(std::memory_order_relaxed) & (Size - 1)];
+	}
+
+	/**
+	 * Consumer: removes and returns the next byte. Only valid when available() is not 0.
+	 */
+	uint8_t next() {
+		size_t t = tail.load(std::memory_order_relaxed);
+		uint8_t result = buffer[t & (Size - 1)];
+		tail.store(t + 1, std::memory_order_release);
+		return result;
+	}
+
+	/**
+	 * Consumer: reads up to length bytes.
+	 * @return The number of bytes read.
+	 */
+	size_t read(uint8_t* data, size_t length) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		size_t count = head.load(std::memory_order_acquire) - t;
+		if (length > count) {
+			length = count;
+		}
+		size_t offset = t & (Size - 1);
+		size_t first = length < Size - offset ? length : Size - offset;
+		memcpy(data, buffer + offset, first);
+		memcpy(data + first, buffer, length - first);
+		tail.store(t + length, std::memory_order_release);
+		return length;
+	}
+};
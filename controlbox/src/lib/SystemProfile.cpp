@@ -60,12 +60,13 @@ cb_static_decl(EepromDataOut SystemProfile::writer;)
 cb_static_decl(profile_id_t SystemProfile::current;)
 cb_static_decl(Container* SystemProfile::root = NULL;)
 cb_static_decl(Container& SystemProfile::systemRoot = systemRootContainer();)
+cb_static_decl(ProfileCompactor SystemProfile::compactor;)
 
 
 
 #if !CONTROLBOX_STATIC
 SystemProfile::SystemProfile(EepromAccess& access, Container& systemRootContainer)
-: root(nullptr), systemRoot(systemRootContainer), writer(access), system_id(access,SYSTEM_PROFILE_ID_OFFSET,1), eepromAccess(access) {}
+: root(nullptr), systemRoot(systemRootContainer), compactor(access), writer(access), system_id(access,SYSTEM_PROFILE_ID_OFFSET,1), eepromAccess(access) {}
 
 #endif
 
@@ -187,6 +188,7 @@ bool SystemProfile::activateProfile(profile_id_t profile) {
 			profileReadRegion(profile, eepromReader);			// get region in eeprom for the profile
 			streamObjectDefinitions(eepromReader);
 			profileWriteRegion(writer, true);		// reset to available region (allow open profile)
+			scheduleCompaction();					// remove definitions disposed of before a reset
 		}
 		return activated;
 	}
@@ -279,10 +281,16 @@ bool deleteDynamicallyAllocatedObject(Object* obj, void* data, const container_i
 	return false;										// continue traversal
 }
 
+bool SystemProfile::isOpenProfile(profile_id_t id)
+{
+	return id >= 0 && getProfileEnd(id, true)==eepromAccess.length();
+}
+
 void SystemProfile::closeOpenProfile()
 {
+	compactor.stop();
 	// if this profile is open, be sure to compact eeprom
-	if (current >= 0 && getProfileEnd(current, true)==eepromAccess.length()) {
+	if (isOpenProfile(current)) {
 		eptr_t end = compactObjectDefinitions();
 		setProfileOffset(-1, end);
 	}
@@ -303,6 +311,7 @@ void SystemProfile::deactivateCurrentProfile() {
 	// delete all the objects that were dynamically allocated.
 	container_id id[MAX_CONTAINER_DEPTH];				// buffer for id during traversal
 	walkRoot(rootContainer(), deleteDynamicallyAllocatedObject, NULL, id);
+	invoke_cmd_method(objectHandles().clear());		// also drops objects that were not dynamically allocated
 	current = -1;
 
 	if (isDynamicallyAllocated(root))
@@ -393,6 +402,85 @@ void SystemProfile::listDefinedProfiles(DataIn& in, DataOut& out) {
 #endif
 }
 
+/**
+ * Keeps the definition offsets in the handle table and the eeprom addresses of live objects up to date
+ * when compaction moves a definition, and moves the end of the open profile.
+ */
+struct SystemProfile::CompactionEvents : public CompactionListener
+{
+	cb_nonstatic_decl(SystemProfile& profile;)
+	HandleTable& handles;
+
+	CompactionEvents(cb_nonstatic_decl(SystemProfile& profile_,) HandleTable& handles_)
+		: cb_nonstatic_decl(profile(profile_),) handles(handles_) {}
+
+	void relocated(eptr_t from, eptr_t to, eptr_t data) override {
+		Object* o = handles.relocate(from, to);
+		if (o)
+			o->relocated(data);
+	}
+
+	void resized(eptr_t from, eptr_t to) override {
+#if CONTROLBOX_STATIC
+		SystemProfile::moveOpenProfileEnd(from, to);
+#else
+		profile.moveOpenProfileEnd(from, to);
+#endif
+	}
+};
+
+void SystemProfile::scheduleCompaction()
+{
+#if SYSTEM_PROFILE_ENABLE
+	if (isOpenProfile(current))
+		compactor.start(getProfileOffset(current));
+#endif
+}
+
+void SystemProfile::compactStep(uint16_t budget)
+{
+#if SYSTEM_PROFILE_ENABLE
+	if (!compactor.busy())
+		return;
+
+	HandleTable& handles = invoke_cmd_method(objectHandles());
+	if (!isOpenProfile(current) || !handles.complete()) {
+		// objects without a handle cannot be told that their definition moved.
+		// The profile is compacted when it is closed.
+		compactor.stop();
+		return;
+	}
+
+	CompactionEvents events(cb_nonstatic_decl(*this,) handles);
+	compactor.step(getProfileEnd(current), eepromAccess.length(), budget, events);
+#endif
+}
+
+/**
+ * Moves the end of the open profile. The profile must be valid when it ends at either offset.
+ * The end pointer is two bytes, so the bytes are written in the order that never cuts off the profile before
+ * the lower of the two offsets. A terminating byte after the higher offset covers values beyond it.
+ */
+void SystemProfile::moveOpenProfileEnd(eptr_t from, eptr_t to)
+{
+#if SYSTEM_PROFILE_ENABLE
+	eptr_t guard = from>to ? from : to;
+	if (guard<eepromAccess.length())
+		eepromAccess.writeByte(guard, 0xFF);
+
+	eptr_t address = profileFAT(-1);
+	if (to>from) {
+		eepromAccess.writeByte(address, uint8_t(to>>8));
+		eepromAccess.writeByte(eptr_t(address+1), uint8_t(to));
+	}
+	else {
+		eepromAccess.writeByte(eptr_t(address+1), uint8_t(to));
+		eepromAccess.writeByte(address, uint8_t(to>>8));
+	}
+	profileWriteRegion(writer, true);
+#endif
+}
+
 #if CONTROLBOX_STATIC
 Container* rootContainer() {
 	return systemProfile.rootContainer();
@@ -411,7 +499,7 @@ bool ObjectDefinitionWalker::writeNext(DataOut& out) {
 	uint8_t next = _in->peek();
 	bool valid =  ((next&0x7F)==Commands::CMD_CREATE_OBJECT);
 	if (valid) {
-		PipeDataIn pipe(*_in, next<0 ? blackhole : out);	// next<0 if command not fully completed, so output is discarded
+		PipeDataIn pipe(*_in, int8_t(next)<0 ? blackhole : out);	// next<0 if the object was disposed, so output is discarded
 		pipe.next();										// fetch the next value already peek'ed at so this is written to the output stream
 		/*Object* target = */lookupUserObject(_commands.rootContainer(), pipe);			// find the container where the object will be added
 		// todo - could flag warning if target is NULL
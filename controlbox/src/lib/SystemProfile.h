@@ -27,6 +27,7 @@
 #include "GenericContainer.h"
 #include "ValuesEeprom.h"
 #include "EepromBlock.h"
+#include "ProfileCompactor.h"
 
 #ifndef SYSTEM_PROFILE_ENABLE
 #define SYSTEM_PROFILE_ENABLE 1
@@ -99,6 +100,15 @@ class SystemProfile {
 
 	cb_static void closeOpenProfile();
 	cb_static eptr_t compactObjectDefinitions();
+	cb_static bool isOpenProfile(profile_id_t id);
+
+	/**
+	 * Removes disposed definitions from the open profile in the background, see compactStep().
+	 */
+	cb_static ProfileCompactor compactor;
+
+	struct CompactionEvents;
+	cb_static void moveOpenProfileEnd(eptr_t from, eptr_t to);
 
 
 	cb_static void streamObjectDefinitions(EepromDataIn& eepromReader);
@@ -223,6 +233,17 @@ public:
 
 	cb_static void initializeEeprom();
 
+	/**
+	 * Schedules removal of disposed object definitions from the current profile.
+	 */
+	cb_static void scheduleCompaction();
+
+	/**
+	 * Performs a step of a scheduled compaction, writing a bounded number of bytes.
+	 * Called from the main loop, outside of command handling.
+	 */
+	cb_static void compactStep(uint16_t budget=PROFILE_COMPACT_STEP_BYTES);
+
 	cb_static EepromDataOut& persistence() {
 		return writer;
 	}
@@ -68,6 +68,13 @@ public:
 
 	ticks_seconds_t seconds() { return millis()/1000; }
 
+#if CONTROLBOX_STATIC
+	/**
+	 * Microseconds of the base ticks. These are not scaled, they are used to measure durations.
+	 */
+	ticks_micros_t micros() { return baseticks.micros(); }
+#endif
+
 	void readTo(DataOut& out) {
 		ticks_millis_t time = baseticks.millis();
 		time = millis(time);
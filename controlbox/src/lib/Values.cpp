@@ -46,9 +46,9 @@ bool walkObject(Object* obj, EnumObjectsFn callback, void* data, container_id* i
 		return true;
 
 	if (isContainer(obj)) {
-		*end++ |= 0x80;		// flag as not last element in id chain
+		end[-1] |= 0x80;		// flag as not last element in id chain. end points past the id of obj
 		walkContainer((Container*)obj, callback, data, id, end);
-		*--end &= 0x7F;		// remove last bit
+		end[-1] &= 0x7F;		// remove last bit
 	}
 
 	if (callback(obj, data, id, end, false))
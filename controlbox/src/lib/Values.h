@@ -108,6 +108,12 @@ public:
 	 */
 	virtual void rehydrated(eptr_t /*eeprom_address*/) {}
 
+	/**
+	 * Notifies this object that its definition was moved in eeprom, while the object was live.
+	 * @param eeprom_address	The new offset of the definition data, as for rehydrated().
+	 */
+	virtual void relocated(eptr_t eeprom_address) { rehydrated(eeprom_address); }
+
 	/**
 	 * Prepare this object for subsequent updates.
 	 * The returned value is the number of milliseconds the object needs before updates can be performed.
@@ -513,6 +519,11 @@ inline bool walkRoot(Container* root, EnumObjectsFn callback, void* data, contai
  */
 Object* lookupObject(Object* current, DataIn& data);
 
+/**
+ * Writes an ID chain to the stream.
+ */
+void writeID(const container_id* id, DataOut& out);
+
 /**
  * Read the id chain from the stream and resolve the container and the final index.
  */
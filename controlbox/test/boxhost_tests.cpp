@@ -0,0 +1,155 @@
+#include "catch.hpp"
+#include "BoxHost.h"
+#include "Box.h"
+#include "BoxApi.h"
+#include "ArrayEepromAccess.h"
+#include "GenericContainer.h"
+#include "ValueTicks.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+/**
+ * A connection without a client: no input, and output is discarded.
+ */
+struct IdleConnection : public ConnectionData<StandardConnectionDataType>
+{
+	EmptyDataIn in;
+	BlackholeDataOut out;
+
+	DataIn& getDataIn() override { return in; }
+	DataOut& getDataOut() override { return out; }
+	bool connected() override { return false; }
+};
+
+/**
+ * Simulated time that advances a second per loop.
+ */
+struct SteppedTicks : public Ticks
+{
+	ticks_millis_t now = 0;
+	ticks_millis_t millis() override { return now; }
+};
+
+/**
+ * A virtual controller with its own eeprom, ticks and connection, and a ticks value object in its profile.
+ */
+class VirtualController : public BoxTenant, public CommandCallbacks
+{
+	ArrayEepromAccess<1024> eeprom;
+	SteppedTicks ticks;
+	IdleConnection connection;
+	Object* systemRootItems[2];
+	FixedContainer systemRoot;
+	Box box;
+
+public:
+	std::atomic<bool> busy;
+	std::atomic<unsigned> overlaps;
+	unsigned slowMillis = 0;
+
+	VirtualController()
+		: systemRoot(2, systemRootItems), box(connection, eeprom, ticks, *this, systemRoot), busy(false), overlaps(0)
+	{
+		box.setup();
+		BoxApi api(box);
+		Profile p = api.create_profile();
+		api.activate_profile(p);
+		api.create_object(container_id(0), 1);
+	}
+
+	void loop() override {
+		if (busy.exchange(true)) {
+			overlaps++;
+		}
+		ticks.now += 1000;
+		box.loop();
+		if (slowMillis) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(slowMillis));
+		}
+		busy = false;
+	}
+
+	ticks_millis_t time() const { return ticks.now; }
+
+	int8_t createApplicationObject(Object*& result, ObjectDefinition& def, bool dryRun=false) override {
+		result = (def.type == 1 && !dryRun) ? new ScaledTicksValue(ticks) : nullFactory(def);
+		int8_t error = no_error;
+		if (!result) {
+			error = errorCode(insufficient_heap);
+		}
+		return error;
+	}
+	void handleReset(bool) override {}
+	void connectionStarted(StandardConnection&, DataOut&) override {}
+	Container* createRootContainer() override { return new DynamicContainer(); }
+};
+
+SCENARIO("box host runs many boxes on a thread pool")
+{
+	GIVEN("a host with 4 threads and 32 virtual controllers")
+	{
+		BoxHost host(4);
+		std::vector<VirtualController*> controllers;
+		for (int i = 0; i < 32; i++) {
+			VirtualController* c = new VirtualController();
+			controllers.push_back(c);
+			host.add(std::unique_ptr<BoxTenant>(c));
+		}
+
+		WHEN("it runs 100 rounds")
+		{
+			auto start = std::chrono::steady_clock::now();
+			host.runRounds(100);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			THEN("each box loops 100 times, never on two threads at once")
+			{
+				for (size_t i = 0; i < controllers.size(); i++) {
+					CHECK(host.metrics(i).loops == 100);
+					CHECK(controllers[i]->time() == 100000);
+					CHECK(controllers[i]->overlaps == 0);
+				}
+				BoxHost::Metrics totals = host.totals();
+				CHECK(totals.loops == 3200);
+				CHECK(totals.loopsPerSecond > 0);
+				std::cout << "box host: " << unsigned(3200 / seconds) << " loops/s, "
+					<< double(totals.cpuMicros) / 3200 << " us CPU per loop" << std::endl;
+			}
+		}
+
+		WHEN("the boxes on one worker are slow")
+		{
+			for (size_t i = 0; i < controllers.size(); i += host.threads()) {
+				controllers[i]->slowMillis = 2;
+			}
+			host.runRounds(5);
+
+			THEN("the other workers take over some of their loops")
+			{
+				CHECK(host.totals().loops == 160);
+				uint64_t stolen = 0;
+				for (size_t i = 0; i < controllers.size(); i += host.threads()) {
+					stolen += host.metrics(i).stolen;
+				}
+				CHECK(stolen > 0);
+			}
+		}
+
+		WHEN("it runs in the background")
+		{
+			host.start(1000);
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			host.stop();
+
+			THEN("all boxes loop the same number of times")
+			{
+				uint64_t loops = host.metrics(0).loops;
+				CHECK(loops > 0);
+				for (size_t i = 0; i < controllers.size(); i++) {
+					CHECK(host.metrics(i).loops == loops);
+				}
+			}
+		}
+	}
+}
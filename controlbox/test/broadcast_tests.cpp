@@ -0,0 +1,319 @@
+#include "catch.hpp"
+#include "BroadcastDataOut.h"
+#include "Box.h"
+#include "ArrayEepromAccess.h"
+#include "GenericContainer.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/**
+ * Sink that collects what it is sent, and accepts at most limit bytes until the limit is raised.
+ */
+struct StringSink : public BroadcastSink
+{
+	std::string received;
+	size_t limit = size_t(-1);
+
+	uint16_t writeAvailable(const uint8_t* data, uint16_t length) override {
+		size_t space = limit - received.size();
+		uint16_t sent = uint16_t(length < space ? length : space);
+		received.append(reinterpret_cast<const char*>(data), sent);
+		return sent;
+	}
+};
+
+static void writeString(DataOut& out, const std::string& s)
+{
+	out.writeBuffer(s.data(), stream_size_t(s.size()));
+}
+
+static std::string frame(unsigned i)
+{
+	return "frame " + std::to_string(i) + " 00 11 22 33 44 55 66 77\r\n";
+}
+
+SCENARIO("broadcast output is sent to each reader at its own pace")
+{
+	BroadcastDataOut<256> broadcast;
+
+	GIVEN("a reader that takes everything")
+	{
+		BroadcastCursor cursor = broadcast.attach();
+		StringSink sink;
+		std::string expected;
+		for (unsigned i = 0; i < 20; i++) {
+			writeString(broadcast, frame(i));
+			expected += frame(i);
+			REQUIRE(broadcast.pump(cursor, sink));
+		}
+
+		THEN("it receives the output in order, across the end of the buffer")
+		{
+			CHECK(sink.received == expected);
+			CHECK(cursor.overruns == 0);
+			CHECK(broadcast.pending(cursor) == 0);
+		}
+	}
+
+	GIVEN("a reader that takes part of a frame")
+	{
+		BroadcastCursor cursor = broadcast.attach();
+		StringSink sink;
+		sink.limit = 10;
+		writeString(broadcast, frame(1));
+
+		THEN("the rest is sent when the reader takes more")
+		{
+			CHECK(!broadcast.pump(cursor, sink));
+			CHECK(cursor.midFrame);
+			sink.limit = size_t(-1);
+			CHECK(broadcast.pump(cursor, sink));
+			CHECK(!cursor.midFrame);
+			CHECK(sink.received == frame(1));
+		}
+	}
+
+	GIVEN("a reader that stops taking data mid frame")
+	{
+		BroadcastCursor cursor = broadcast.attach();
+		StringSink sink;
+		sink.limit = 10;
+		writeString(broadcast, frame(0));
+		broadcast.pump(cursor, sink);
+
+		WHEN("the writer overwrites the data the reader has not been sent")
+		{
+			for (unsigned i = 1; i < 30; i++) {
+				writeString(broadcast, frame(i));
+			}
+			sink.limit = size_t(-1);
+			CHECK(broadcast.pump(cursor, sink));
+
+			THEN("the partial frame is ended and the reader continues with whole frames")
+			{
+				CHECK(cursor.overruns == 1);
+				std::string partial = frame(0).substr(0, 10) + "\n";
+				REQUIRE(sink.received.substr(0, partial.size()) == partial);
+				std::string rest = sink.received.substr(partial.size());
+				REQUIRE(!rest.empty());
+				CHECK(rest.size() <= 256);
+				CHECK(rest.compare(0, 6, "frame ") == 0);
+				CHECK(rest.back() == '\n');
+				unsigned first = unsigned(std::stoi(rest.substr(6)));
+				std::string expected;
+				for (unsigned i = first; i < 30; i++) {
+					expected += frame(i);
+				}
+				CHECK(rest == expected);
+			}
+		}
+	}
+
+	GIVEN("a reader that attaches in the middle of a frame")
+	{
+		writeString(broadcast, "partial");
+		BroadcastCursor cursor = broadcast.attach();
+		StringSink sink;
+		writeString(broadcast, " frame\n");
+		writeString(broadcast, frame(1));
+		CHECK(broadcast.pump(cursor, sink));
+
+		THEN("it starts with the next frame")
+		{
+			CHECK(sink.received == frame(1));
+		}
+	}
+
+	GIVEN("two readers")
+	{
+		BroadcastCursor fast = broadcast.attach();
+		BroadcastCursor slow = broadcast.attach();
+		StringSink fastSink, slowSink;
+		slowSink.limit = 0;
+		for (unsigned i = 0; i < 3; i++) {
+			writeString(broadcast, frame(i));
+			broadcast.pump(fast, fastSink);
+			broadcast.pump(slow, slowSink);
+		}
+
+		THEN("the slow reader does not hold back the fast reader")
+		{
+			CHECK(fastSink.received == frame(0) + frame(1) + frame(2));
+			CHECK(slowSink.received.empty());
+			slowSink.limit = size_t(-1);
+			CHECK(broadcast.pump(slow, slowSink));
+			CHECK(slowSink.received == fastSink.received);
+		}
+	}
+}
+
+/**
+ * The local end of a non-blocking socket pair, standing in for a TCP client.
+ */
+struct SocketClient : public BroadcastSink
+{
+	int fds[2];
+	size_t received = 0;
+
+	SocketClient() {
+		socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+		fcntl(fds[0], F_SETFL, O_NONBLOCK);
+		fcntl(fds[1], F_SETFL, O_NONBLOCK);
+	}
+
+	~SocketClient() {
+		close(fds[0]);
+		close(fds[1]);
+	}
+
+	uint16_t writeAvailable(const uint8_t* data, uint16_t length) override {
+		ssize_t sent = send(fds[0], data, length, 0);
+		return sent > 0 ? uint16_t(sent) : 0;
+	}
+
+	void drain() {
+		char buf[4096];
+		ssize_t n;
+		while ((n = read(fds[1], buf, sizeof(buf))) > 0) {
+			received += size_t(n);
+		}
+	}
+};
+
+/**
+ * Writes each byte to every client as it is written, like the CompositeDataOut over the TCP connections.
+ */
+struct PerByteOut : public DataOut
+{
+	std::vector<SocketClient*>& clients;
+	PerByteOut(std::vector<SocketClient*>& clients_) : clients(clients_) {}
+
+	bool write(uint8_t data) override {
+		for (auto c : clients) {
+			c->writeAvailable(&data, 1);
+		}
+		return true;
+	}
+};
+
+SCENARIO("broadcast throughput with socket clients", "[broadcast][throughput]")
+{
+	const unsigned frames = 500;
+	// a logValues frame: 40 bytes of values, hex encoded
+	std::string line;
+	for (unsigned i = 0; i < 40; i++) {
+		line += "A5 ";
+	}
+	line += "\r\n";
+
+	for (unsigned count : {1u, 4u, 16u}) {
+		std::vector<SocketClient> sockets(count);
+		std::vector<SocketClient*> clients;
+		for (auto& s : sockets) {
+			clients.push_back(&s);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		PerByteOut perByte(clients);
+		for (unsigned f = 0; f < frames; f++) {
+			for (char c : line) {
+				perByte.write(uint8_t(c));
+			}
+			for (auto c : clients) {
+				c->drain();
+			}
+		}
+		double perByteSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		BroadcastDataOut<2048> broadcast;
+		std::vector<BroadcastCursor> cursors;
+		for (unsigned i = 0; i < count; i++) {
+			cursors.push_back(broadcast.attach());
+		}
+		for (unsigned f = 0; f < frames; f++) {
+			writeString(broadcast, line);
+			for (unsigned i = 0; i < count; i++) {
+				broadcast.pump(cursors[i], *clients[i]);
+				clients[i]->drain();
+			}
+		}
+		double broadcastSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		for (unsigned i = 0; i < count; i++) {
+			CHECK(clients[i]->received == 2 * frames * line.size());
+			CHECK(cursors[i].overruns == 0);
+		}
+		std::cout << count << " clients: per byte " << unsigned(frames / perByteSeconds)
+			<< " frames/s, broadcast " << unsigned(frames / broadcastSeconds) << " frames/s" << std::endl;
+	}
+}
+
+/**
+ * A box on a connection without input, that counts its announcements.
+ */
+class AnnouncingBox : public CommandCallbacks
+{
+	struct NoTicks : public Ticks
+	{
+		ticks_millis_t millis() override { return 0; }
+	};
+
+	struct SilentConnection : public ConnectionData<StandardConnectionDataType>
+	{
+		EmptyDataIn in;
+		BlackholeDataOut out;
+
+		DataIn& getDataIn() override { return in; }
+		DataOut& getDataOut() override { return out; }
+		bool connected() override { return true; }
+	};
+
+	ArrayEepromAccess<1024> eeprom;
+	NoTicks ticks;
+	Object* systemRootItems[1];
+	FixedContainer systemRoot;
+
+public:
+	SilentConnection connection;
+	Box box;
+	unsigned announcements = 0;
+
+	AnnouncingBox()
+		: systemRoot(1, systemRootItems), box(connection, eeprom, ticks, *this, systemRoot)
+	{
+		connection.getData().callback_until_first_request = true;
+	}
+
+	int8_t createApplicationObject(Object*& result, ObjectDefinition& def, bool dryRun=false) override {
+		result = nullFactory(def);
+		return errorCode(insufficient_heap);
+	}
+	void handleReset(bool) override {}
+	void connectionStarted(StandardConnection&, DataOut&) override { announcements++; }
+	Container* createRootContainer() override { return new DynamicContainer(); }
+};
+
+SCENARIO("a connection knows when it is sent an announcement, so broadcast writes only block before one")
+{
+	AnnouncingBox b;
+	b.box.setup();
+	StandardConnectionDataType& data = b.connection.getData();
+
+	unsigned predicted = 0;
+	for (unsigned i = 0; i < 3*StandardConnectionDataType::ANNOUNCEMENT_INTERVAL; i++) {
+		unsigned before = b.announcements;
+		bool due = data.announcementDue();
+		predicted += due;
+		b.box.loop();
+		CHECK(due == (b.announcements == before+1));
+	}
+	// the first one when connected, then one per interval until a request is received
+	CHECK(predicted == 3);
+	CHECK(b.announcements == 3);
+}
@@ -0,0 +1,276 @@
+#include "catch.hpp"
+#include "CachedEepromAccess.h"
+#include "ArrayEepromAccess.h"
+
+/**
+ * Eeprom that counts writes, and ignores all writes after a limit to simulate a reset while writing.
+ */
+class FaultyEepromAccess : public ArrayEepromAccess<512>
+{
+	using base = ArrayEepromAccess<512>;
+public:
+	unsigned writes = 0;
+	unsigned writesLeft = unsigned(-1);
+
+	void writeByte(eptr_t offset, uint8_t value) override {
+		if (writesLeft) {
+			writesLeft--;
+			writes++;
+			base::writeByte(offset, value);
+		}
+	}
+
+	void writeBlock(eptr_t target, const void* source, uint16_t size) override {
+		const uint8_t* p = (const uint8_t*)source;
+		while (size--)
+			writeByte(target++, *p++);
+	}
+};
+
+SCENARIO("cached eeprom coalesces writes")
+{
+	FaultyEepromAccess backend;
+	CachedEepromAccess cache(backend);
+
+	REQUIRE(cache.length() == 512-EEPROM_JOURNAL_SLOTS*CachedEepromAccess::RECORD_SIZE);
+
+	WHEN("a value is written many times")
+	{
+		for (int i=0; i<100; i++) {
+			cache.writeByte(10, uint8_t(i));
+			cache.writeByte(11, uint8_t(i+1));
+		}
+
+		THEN("the cache returns the last value, without writing to the backend")
+		{
+			CHECK(cache.readByte(10) == 99);
+			CHECK(cache.readByte(11) == 100);
+			CHECK(backend.writes == 0);
+			CHECK(cache.dirty());
+		}
+
+		AND_WHEN("the cache is flushed")
+		{
+			CHECK(cache.flush());
+			THEN("the last value is written once, to the journal")
+			{
+				CHECK(!cache.dirty());
+				// page, mask, 2 data bytes, checksum and sequence
+				CHECK(backend.writes == 2+2+2+1+1);
+				CHECK(backend.readByte(10) == 0xFF);
+				CachedEepromAccess reloaded(backend);
+				CHECK(reloaded.readByte(10) == 99);
+				CHECK(reloaded.readByte(11) == 100);
+			}
+		}
+	}
+
+	WHEN("a value is flushed many times")
+	{
+		const int flushes = 3*EEPROM_JOURNAL_SLOTS;
+		for (int i=0; i<flushes; i++) {
+			cache.writeByte(3, uint8_t(i));
+			cache.flush();
+		}
+		THEN("its home is not written")
+		{
+			CHECK(backend.readByte(3) == 0xFF);
+			CachedEepromAccess reloaded(backend);
+			CHECK(reloaded.readByte(3) == flushes-1);
+		}
+
+		AND_WHEN("other pages are flushed until its record is the oldest")
+		{
+			for (uint8_t i=1; i<EEPROM_JOURNAL_SLOTS; i++) {
+				cache.writeByte(eptr_t(i*CachedEepromAccess::PAGE_SIZE), i);
+				cache.flush();
+			}
+			CHECK(backend.readByte(3) == 0xFF);
+
+			THEN("it is written home when its slot is needed")
+			{
+				cache.writeByte(eptr_t(EEPROM_JOURNAL_SLOTS*CachedEepromAccess::PAGE_SIZE), 0x42);
+				cache.flush();
+				CHECK(backend.readByte(3) == flushes-1);
+
+				CachedEepromAccess reloaded(backend);
+				CHECK(reloaded.readByte(3) == flushes-1);
+				for (uint8_t i=1; i<EEPROM_JOURNAL_SLOTS; i++) {
+					CHECK(reloaded.readByte(eptr_t(i*CachedEepromAccess::PAGE_SIZE)) == i);
+				}
+				CHECK(reloaded.readByte(eptr_t(EEPROM_JOURNAL_SLOTS*CachedEepromAccess::PAGE_SIZE)) == 0x42);
+			}
+		}
+	}
+
+	WHEN("a value is written that is already stored")
+	{
+		cache.writeByte(5, 0xFF);
+		THEN("nothing needs to be written")
+		{
+			CHECK(!cache.dirty());
+		}
+	}
+
+	WHEN("more pages are written than the cache holds")
+	{
+		const eptr_t count = EEPROM_CACHE_PAGES*2*CachedEepromAccess::PAGE_SIZE;
+		for (eptr_t i=0; i<count; i++) {
+			cache.writeByte(i, uint8_t(i));
+		}
+		cache.flush(1);
+		THEN("all data can be read back and is written to the backend after flushing")
+		{
+			uint8_t block[count];
+			cache.readBlock(block, 0, count);
+			for (eptr_t i=0; i<count; i++) {
+				CHECK(block[i] == uint8_t(i));
+			}
+			CHECK(cache.dirty());
+			CHECK(cache.flush());
+			CachedEepromAccess reloaded(backend);
+			for (eptr_t i=0; i<count; i++) {
+				CHECK(reloaded.readByte(i) == uint8_t(i));
+			}
+		}
+	}
+}
+
+static void copy(FaultyEepromAccess& target, const FaultyEepromAccess& source)
+{
+	memcpy((void*)target.eepromData(), source.eepromData(), source.length());
+}
+
+/**
+ * Interrupts a flush that replaces the data at offset after each of the writes it takes, and checks that the data
+ * reads back as either the old or the new data.
+ */
+static void checkInterruptedFlush(FaultyEepromAccess& backend, eptr_t offset, const uint8_t* after, uint8_t size)
+{
+	const uint8_t maxSize = 2*CachedEepromAccess::PAGE_SIZE;
+	const eptr_t other = 6*CachedEepromAccess::PAGE_SIZE;
+	REQUIRE(size <= maxSize);
+	uint8_t before[maxSize];
+	{
+		CachedEepromAccess cache(backend);
+		cache.readBlock(before, offset, size);
+	}
+
+	// count the writes needed for a complete flush
+	FaultyEepromAccess reference;
+	copy(reference, backend);
+	{
+		CachedEepromAccess cache(reference);
+		cache.writeBlock(offset, after, size);
+		reference.writes = 0;
+		cache.flush();
+	}
+	const unsigned total = reference.writes;
+
+	for (unsigned limit=0; limit<=total; limit++) {
+		FaultyEepromAccess target;
+		copy(target, backend);
+		{
+			CachedEepromAccess cache(target);
+			cache.writeBlock(offset, after, size);
+			target.writesLeft = limit;
+			cache.flush();
+		}
+		target.writesLeft = unsigned(-1);
+
+		INFO("reset after " << limit << " of " << total << " writes");
+		uint8_t data[maxSize];
+		CachedEepromAccess recovered(target);
+		recovered.readBlock(data, offset, size);
+		bool updated = !memcmp(data, after, size);
+		CHECK((updated || !memcmp(data, before, size)));
+		// the flush is committed by its last write
+		CHECK(updated == (limit == total));
+
+		// a later transaction on another page doesn't bring back records of the interrupted one
+		recovered.writeByte(other, 0x42);
+		recovered.flush();
+		CachedEepromAccess again(target);
+		uint8_t replayed[maxSize];
+		again.readBlock(replayed, offset, size);
+		CHECK(!memcmp(replayed, data, size));
+		CHECK(again.readByte(other) == 0x42);
+	}
+}
+
+SCENARIO("cached eeprom recovers from a reset during a flush")
+{
+	FaultyEepromAccess backend;
+	const eptr_t offset = 3*CachedEepromAccess::PAGE_SIZE;
+	const uint8_t size = CachedEepromAccess::PAGE_SIZE;
+
+	uint8_t before[size], after[size];
+	for (uint8_t i=0; i<size; i++) {
+		before[i] = i;
+		after[i] = uint8_t(0x80+i);
+	}
+	CachedEepromAccess cache(backend);
+	cache.writeBlock(offset, before, size);
+	cache.flush();
+
+	GIVEN("a journal with free slots")
+	{
+		checkInterruptedFlush(backend, offset, after, size);
+	}
+
+	GIVEN("a full journal, in which the record of the page is the oldest")
+	{
+		for (uint8_t i=1; i<EEPROM_JOURNAL_SLOTS; i++) {
+			cache.writeByte(eptr_t((10+i)*CachedEepromAccess::PAGE_SIZE), i);
+			cache.flush();
+		}
+		// the interrupted flush writes the page home before it reuses the slot of its record
+		checkInterruptedFlush(backend, offset, after, size);
+	}
+}
+
+SCENARIO("cached eeprom writes pages of a flush all or none")
+{
+	FaultyEepromAccess backend;
+	const eptr_t offset = 3*CachedEepromAccess::PAGE_SIZE;
+	const uint8_t size = 2*CachedEepromAccess::PAGE_SIZE;
+
+	uint8_t before[size], after[size];
+	for (uint8_t i=0; i<size; i++) {
+		before[i] = i;
+		after[i] = uint8_t(0x80+i);
+	}
+	{
+		CachedEepromAccess cache(backend);
+		cache.writeBlock(offset, before, size);
+		cache.flush();
+	}
+	checkInterruptedFlush(backend, offset, after, size);
+}
+
+SCENARIO("cached eeprom spreads journal writes over all slots")
+{
+	FaultyEepromAccess backend;
+	CachedEepromAccess cache(backend);
+	const eptr_t journal = cache.length();
+
+	for (int i=0; i<3*EEPROM_JOURNAL_SLOTS; i++) {
+		cache.writeByte(0, uint8_t(i));
+		cache.flush();
+	}
+	for (uint8_t slot=0; slot<EEPROM_JOURNAL_SLOTS; slot++) {
+		CHECK(backend.readByte(eptr_t(journal+slot*CachedEepromAccess::RECORD_SIZE)) != 0xFF);
+	}
+
+	AND_WHEN("the eeprom is used again")
+	{
+		CachedEepromAccess cache(backend);
+		cache.writeByte(0, 0x42);
+		cache.flush();
+		CachedEepromAccess recovered(backend);
+		THEN("the newest record is read")
+		{
+			CHECK(recovered.readByte(0) == 0x42);
+		}
+	}
+}
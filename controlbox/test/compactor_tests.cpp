@@ -0,0 +1,231 @@
+#include "catch.hpp"
+#include "ProfileCompactor.h"
+#include "ArrayEepromAccess.h"
+#include "Commands.h"
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * Eeprom that counts writes, and ignores all writes after a limit to simulate a reset while compacting.
+ */
+class InterruptedEepromAccess : public ArrayEepromAccess<256>
+{
+	using base = ArrayEepromAccess<256>;
+public:
+	unsigned writes = 0;
+	unsigned writesLeft = unsigned(-1);
+
+	void writeByte(eptr_t offset, uint8_t value) override {
+		if (writesLeft) {
+			writesLeft--;
+			writes++;
+			base::writeByte(offset, value);
+		}
+	}
+};
+
+/**
+ * Keeps the end of the profile and follows the moved definitions.
+ */
+struct CompactionTracker : public CompactionListener
+{
+	InterruptedEepromAccess& eeprom;
+	eptr_t end;
+	std::map<eptr_t, eptr_t> moves;		// original offset to current offset
+	unsigned relocations = 0;
+
+	CompactionTracker(InterruptedEepromAccess& eeprom_, eptr_t end_) : eeprom(eeprom_), end(end_) {}
+
+	void relocated(eptr_t from, eptr_t to, eptr_t data) override {
+		CHECK(data > to);
+		for (auto& m : moves) {
+			if (m.second==from)
+				m.second = to;
+		}
+		relocations++;
+	}
+
+	void resized(eptr_t /*from*/, eptr_t to) override {
+		if (eeprom.writesLeft)	// the profile end is stored in eeprom, so it is lost after a reset too
+			end = to;
+	}
+};
+
+using definition = std::vector<uint8_t>;
+
+/**
+ * Parses the definitions like the profile does, and returns the valid definitions without their command byte.
+ */
+std::vector<definition> validDefinitions(EepromAccess& eeprom, eptr_t end, bool* onlyValid = nullptr)
+{
+	std::vector<definition> result;
+	eptr_t at = 0;
+	if (onlyValid)
+		*onlyValid = true;
+	while (at+4<=end) {
+		uint8_t cmd = eeprom.readByte(at);
+		if (cmd!=Commands::CMD_CREATE_OBJECT && cmd!=Commands::CMD_DISPOSED_OBJECT)
+			break;
+		eptr_t p = at+1;
+		while (int8_t(eeprom.readByte(p))<0)
+			p++;
+		p++;	// last id
+		uint8_t len = eeprom.readByte(eptr_t(p+1));
+		eptr_t next = eptr_t(p+2+len);
+		if (next>end)
+			break;
+		if (cmd==Commands::CMD_CREATE_OBJECT) {
+			definition d;
+			for (eptr_t i=at+1; i<next; i++)
+				d.push_back(eeprom.readByte(i));
+			result.push_back(d);
+		}
+		else if (onlyValid)
+			*onlyValid = false;
+		at = next;
+	}
+	return result;
+}
+
+std::set<definition> asSet(const std::vector<definition>& defs)
+{
+	return std::set<definition>(defs.begin(), defs.end());
+}
+
+const uint8_t fragmentedProfile[] = {
+	0x03, 0x01, 0x05, 0x02, 0xAA, 0xBB,			// 0: id 1, type 5
+	0x83, 0x02, 0x05, 0x01, 0xCC,				// 6: disposed
+	0x83, 0x82, 0x03, 0x07, 0x00,				// 11: disposed, nested id 2.3
+	0x03, 0x04, 0x06, 0x01, 0xDD,				// 16: id 4
+	0x03, 0x83, 0x01, 0x09, 0x03, 0x11, 0x22, 0x33,	// 21: nested id 3.1
+	0x83, 0x05, 0x01, 0x00,					// 29: disposed
+	0x03, 0x06, 0x02, 0x00					// 33: id 6
+};
+const eptr_t fragmentedEnd = sizeof(fragmentedProfile);
+
+void loadProfile(EepromAccess& eeprom)
+{
+	eeprom.writeBlock(0, fragmentedProfile, fragmentedEnd);
+}
+
+/**
+ * Runs the compactor to completion, and returns the number of steps.
+ */
+unsigned compact(ProfileCompactor& compactor, CompactionTracker& tracker, eptr_t limit, uint16_t budget)
+{
+	unsigned steps = 0;
+	compactor.start(0);
+	while (!compactor.step(tracker.end, limit, budget, tracker)) {
+		if (++steps>1000)
+			break;
+	}
+	return steps;
+}
+
+SCENARIO("profile compactor removes disposed definitions")
+{
+	InterruptedEepromAccess eeprom;
+	loadProfile(eeprom);
+	std::vector<definition> before = validDefinitions(eeprom, fragmentedEnd);
+	REQUIRE(before.size() == 4);
+
+	ProfileCompactor compactor(eeprom);
+	CompactionTracker tracker(eeprom, fragmentedEnd);
+	for (int offset : { 0, 16, 21, 33 })
+		tracker.moves[eptr_t(offset)] = eptr_t(offset);
+
+	WHEN("the profile is compacted in small steps")
+	{
+		unsigned written = 0;
+		unsigned steps = 0;
+		compactor.start(0);
+		bool done = false;
+		while (!done && steps<1000) {
+			unsigned writesBefore = eeprom.writes;
+			done = compactor.step(tracker.end, eptr_t(eeprom.length()), 4, tracker);
+			// a step finishes the move of a single definition
+			CHECK(eeprom.writes-writesBefore <= 4+2*8);
+			written = eeprom.writes;
+			steps++;
+		}
+
+		THEN("the valid definitions are contiguous and the end of the profile is moved")
+		{
+			REQUIRE(done);
+			CHECK(steps > 1);
+			bool onlyValid;
+			std::vector<definition> after = validDefinitions(eeprom, tracker.end, &onlyValid);
+			CHECK(onlyValid);
+			CHECK(asSet(after) == asSet(before));
+			CHECK(tracker.end == 6+5+8+4);
+			CHECK(written > 0);
+		}
+
+		THEN("the moved definitions are reported")
+		{
+			CHECK(tracker.relocations >= 3);
+			CHECK(tracker.moves[0] == 0);
+			for (auto& m : tracker.moves) {
+				CHECK(eeprom.readByte(m.second) == Commands::CMD_CREATE_OBJECT);
+				for (eptr_t i=1; i<4; i++)
+					CHECK(eeprom.readByte(eptr_t(m.second+i)) == fragmentedProfile[m.first+i]);
+			}
+		}
+
+		AND_WHEN("the compacted profile is compacted again")
+		{
+			unsigned writes = eeprom.writes;
+			compact(compactor, tracker, eptr_t(eeprom.length()), PROFILE_COMPACT_STEP_BYTES);
+			THEN("nothing is written")
+			{
+				CHECK(eeprom.writes == writes);
+			}
+		}
+	}
+
+	WHEN("there is no space to append definitions")
+	{
+		compact(compactor, tracker, fragmentedEnd, PROFILE_COMPACT_STEP_BYTES);
+		THEN("compaction completes and the profile still defines the same objects")
+		{
+			CHECK(!compactor.busy());
+			CHECK(asSet(validDefinitions(eeprom, tracker.end)) == asSet(before));
+			CHECK(tracker.end <= fragmentedEnd);
+		}
+	}
+}
+
+SCENARIO("a reset during compaction leaves a profile that defines the same objects")
+{
+	InterruptedEepromAccess reference;
+	loadProfile(reference);
+	std::set<definition> before = asSet(validDefinitions(reference, fragmentedEnd));
+
+	ProfileCompactor fullCompactor(reference);
+	CompactionTracker fullTracker(reference, fragmentedEnd);
+	compact(fullCompactor, fullTracker, eptr_t(reference.length()), 8);
+	unsigned totalWrites = reference.writes;
+	REQUIRE(totalWrites > 0);
+
+	for (unsigned limit=0; limit<=totalWrites; limit++) {
+		InterruptedEepromAccess eeprom;
+		loadProfile(eeprom);
+		eeprom.writesLeft = limit;
+		ProfileCompactor compactor(eeprom);
+		CompactionTracker tracker(eeprom, fragmentedEnd);
+		compact(compactor, tracker, eptr_t(eeprom.length()), 8);
+
+		INFO("writes before reset: " << limit);
+		CHECK(asSet(validDefinitions(eeprom, tracker.end)) == before);
+
+		// after the reset, compaction resumes from the start of the profile
+		eeprom.writesLeft = unsigned(-1);
+		ProfileCompactor resumed(eeprom);
+		compact(resumed, tracker, eptr_t(eeprom.length()), 8);
+		bool onlyValid;
+		std::vector<definition> after = validDefinitions(eeprom, tracker.end, &onlyValid);
+		CHECK(asSet(after) == before);
+		CHECK(onlyValid);
+	}
+}
@@ -0,0 +1,229 @@
+#include "catch.hpp"
+#include "DeltaLog.h"
+#include "GenericContainer.h"
+#include <vector>
+
+/**
+ * Collects written bytes for inspection.
+ */
+struct VectorDataOut : public DataOut
+{
+	std::vector<uint8_t> data;
+
+	bool write(uint8_t b) override {
+		data.push_back(b);
+		return true;
+	}
+};
+
+/**
+ * A value that streams a variable owned by the test.
+ */
+class VariableValue : public Value
+{
+	void* p;
+	uint8_t size;
+public:
+	VariableValue(void* p_, uint8_t size_) : p(p_), size(size_) {}
+
+	void readTo(DataOut& out) override {
+		out.writeBuffer(p, size);
+	}
+
+	uint8_t readStreamSize() override {
+		return size;
+	}
+};
+
+std::vector<uint8_t> logOnce(DeltaLog& log, Container* root)
+{
+	container_id ids[MAX_CONTAINER_DEPTH];
+	VectorDataOut out;
+	log.logValues(root, ids, out);
+	return out.data;
+}
+
+SCENARIO("delta log only sends changed values")
+{
+	GIVEN("a container with two values and a nested container with one value")
+	{
+		uint16_t a = 0x1234;
+		uint8_t b = 0x56;
+		uint8_t c = 0x78;
+		VariableValue va(&a, sizeof(a));
+		VariableValue vb(&b, sizeof(b));
+		VariableValue vc(&c, sizeof(c));
+		va.setTypeID(1);
+		vb.setTypeID(2);
+		vc.setTypeID(3);
+
+		Object* nestedItems[1] = { &vc };
+		FixedContainer nested(1, nestedItems);
+		Object* rootItems[3] = { &va, &vb, &nested };
+		FixedContainer root(3, rootItems);
+
+		DeltaLog log(3);
+
+		WHEN("the values are logged the first time")
+		{
+			std::vector<uint8_t> result = logOnce(log, &root);
+
+			THEN("all values are sent in full, as a keyframe")
+			{
+				std::vector<uint8_t> expected = {
+					DeltaLog::FLAG_KEYFRAME,
+					0x80, 0x00, 0x01, 0x02, 0x34, 0x12,		// ref 0, id 0, type 1, size 2, data
+					0x81, 0x01, 0x02, 0x01, 0x56,			// ref 1, id 1
+					0x82, 0x82, 0x00, 0x03, 0x01, 0x78,		// ref 2, id chain 2.0
+					0xFF
+				};
+				CHECK(result == expected);
+				CHECK(log.trackedValues() == 3);
+			}
+
+			AND_WHEN("nothing changed")
+			{
+				result = logOnce(log, &root);
+				THEN("only the flags and end of log are sent")
+				{
+					std::vector<uint8_t> expected = { 0x00, 0xFF };
+					CHECK(result == expected);
+				}
+			}
+
+			AND_WHEN("one value changed")
+			{
+				c = 0x79;
+				a = 0x1235;
+				result = logOnce(log, &root);
+				THEN("only the changed values are sent with their reference")
+				{
+					std::vector<uint8_t> expected = { 0x00, 0x00, 0x35, 0x12, 0x02, 0x79, 0xFF };
+					CHECK(result == expected);
+				}
+			}
+
+			AND_WHEN("the keyframe interval has passed")
+			{
+				logOnce(log, &root);
+				logOnce(log, &root);
+				logOnce(log, &root);
+				result = logOnce(log, &root);
+				THEN("a keyframe is sent again")
+				{
+					REQUIRE(result.size() > 2);
+					CHECK(result[0] == DeltaLog::FLAG_KEYFRAME);
+					CHECK(result[1] == 0x80);
+				}
+			}
+
+			AND_WHEN("a keyframe is requested")
+			{
+				log.requestKeyframe();
+				result = logOnce(log, &root);
+				THEN("all values are sent in full")
+				{
+					CHECK(result[0] == DeltaLog::FLAG_KEYFRAME);
+					CHECK(result.size() == 19);
+				}
+			}
+
+			AND_WHEN("a value is replaced by another object")
+			{
+				uint32_t d = 0x9ABCDEF0;
+				VariableValue vd(&d, sizeof(d));
+				vd.setTypeID(4);
+				rootItems[1] = &vd;
+				result = logOnce(log, &root);
+				THEN("the new value and all values after it are sent in full")
+				{
+					std::vector<uint8_t> expected = {
+						0x00,
+						0x81, 0x01, 0x04, 0x04, 0xF0, 0xDE, 0xBC, 0x9A,
+						0x82, 0x82, 0x00, 0x03, 0x01, 0x78,
+						0xFF
+					};
+					CHECK(result == expected);
+				}
+			}
+
+			AND_WHEN("a value moves to another id, like a new object allocated where a deleted one was")
+			{
+				rootItems[1] = nullptr;
+				rootItems[2] = &vb;
+				result = logOnce(log, &root);
+				THEN("it keeps its reference, but is sent in full with its new id")
+				{
+					std::vector<uint8_t> expected = {
+						0x00,
+						0x81, 0x02, 0x02, 0x01, 0x56,
+						0xFF
+					};
+					CHECK(result == expected);
+					CHECK(log.trackedValues() == 2);
+				}
+			}
+
+			AND_WHEN("the last value is removed")
+			{
+				nestedItems[0] = nullptr;
+				logOnce(log, &root);
+				THEN("its reference is dropped")
+				{
+					CHECK(log.trackedValues() == 2);
+				}
+			}
+		}
+	}
+}
+
+SCENARIO("delta log reduces the size of a log with many values")
+{
+	const int count = 30;
+	uint32_t values[count];
+	std::vector<VariableValue> objects;
+	objects.reserve(count);
+	Object* items[count];
+	for (int i=0; i<count; i++) {
+		values[i] = uint32_t(i);
+		objects.emplace_back(&values[i], sizeof(values[i]));
+		items[i] = &objects[i];
+	}
+	FixedContainer root(count, items);
+	DeltaLog log;
+
+	std::vector<uint8_t> keyframe = logOnce(log, &root);
+	values[5]++;
+	std::vector<uint8_t> delta = logOnce(log, &root);
+
+	CHECK(delta.size() == 1 + 1 + 4 + 1);	// flags, ref, data, end of log
+	CHECK(delta.size()*10 < keyframe.size());
+	CHECK(log.trackedValues() == count);
+}
+
+SCENARIO("values that cannot be tracked are always sent in full")
+{
+	const int count = DELTA_LOG_MAX_VALUES+2;
+	uint8_t values[count] = {};
+	std::vector<VariableValue> objects;
+	objects.reserve(count);
+	Object* items[count];
+	for (int i=0; i<count; i++) {
+		objects.emplace_back(&values[i], sizeof(values[i]));
+		items[i] = &objects[i];
+	}
+	FixedContainer root(count, items);
+	DeltaLog log;
+
+	logOnce(log, &root);
+	std::vector<uint8_t> delta = logOnce(log, &root);
+
+	CHECK(log.trackedValues() == DELTA_LOG_MAX_VALUES);
+	std::vector<uint8_t> expected = {
+		0x00,
+		DeltaLog::UNTRACKED|DeltaLog::FULL_FLAG, DELTA_LOG_MAX_VALUES, 0x00, 0x01, 0x00,
+		DeltaLog::UNTRACKED|DeltaLog::FULL_FLAG, DELTA_LOG_MAX_VALUES+1, 0x00, 0x01, 0x00,
+		0xFF
+	};
+	CHECK(delta == expected);
+}
@@ -4,6 +4,8 @@
 #include "BoxApi.h"
 #include "catch_output.h"
 
+#include <fstream>
+#include <iterator>
 #include <regex>
 
 SCENARIO("creating a profile is persisted")
@@ -57,6 +59,23 @@ void configure_ticks_example(ExampleBox& box)
 }
 
 
+SCENARIO("creating a scaled ticks value")
+{
+    ExampleBox box;
+    box.initialize();
+    BoxApi api(box.get_box());
+    Profile p = api.create_profile();
+    api.activate_profile(p);
+
+    THEN("the object is created and logged as a 6 byte value: 4 bytes of time and a scale of 1")
+    {
+        REQUIRE_NOTHROW(api.create_object(container_id(0), ExampleBox::as_int(ExampleBox::object_type::ValueTicksScaled)));
+        std::string result = api.run_command("0a 01 00");
+        INFO("result " << result);
+        CHECK(std::regex_match(result, std::regex("00 01 00 01 06 ([[:xdigit:]]{2} ){4}01 00 00 ")));
+    }
+}
+
 SCENARIO("logging values command")
 {
     GIVEN("a configured box")
@@ -71,7 +90,7 @@ SCENARIO("logging values command")
             THEN("the log should list the created object")
             {
                 INFO("result " << result);
-                REQUIRE(std::regex_match(result, std::regex("00 06 ([[:xdigit:]]{2} ){4}01 00 ")));
+                REQUIRE(std::regex_match(result, std::regex("00 01 00 01 06 ([[:xdigit:]]{2} ){4}01 00 00 ")));
             }
         }
 
@@ -81,7 +100,99 @@ SCENARIO("logging values command")
             THEN("the log should list the created object")
             {
                 INFO("result " << result);
-                REQUIRE(std::regex_match(result, std::regex("00 06 ([[:xdigit:]]{2} ){4}01 00 ")));
+                REQUIRE(std::regex_match(result, std::regex("00 01 00 01 06 ([[:xdigit:]]{2} ){4}01 00 00 ")));
+            }
+        }
+    }
+}
+
+SCENARIO("example boxes can be destroyed right after they are created")
+{
+    // each box reads stdin on a thread, which may not have started yet when the box is destroyed
+    for (int i=0; i<50; i++) {
+        ExampleBox box;
+    }
+}
+
+/**
+ * Exposes the command formatting of BoxApi.
+ */
+class FormattingBoxApi : public BoxApi
+{
+public:
+    FormattingBoxApi(Box& box) : BoxApi(box) {}
+    using BoxApi::format;
+};
+
+SCENARIO("commands are formatted in full, also when longer than the format buffer")
+{
+    ExampleBox box;
+    box.initialize();
+    FormattingBoxApi api(box.get_box());
+
+    CHECK(api.format("03 %02x %02x", 1, 2) == "03 01 02");
+
+    // the initial buffer is twice the size of the format string
+    std::string longArg(100, 'a');
+    CHECK(api.format("%s", longArg.c_str()) == longArg);
+}
+
+/**
+ * Returns true when the eeprom file contains the given bytes.
+ */
+bool eeprom_file_contains(const std::string& filename, const std::string& bytes)
+{
+    std::ifstream in(filename, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return content.find(bytes)!=std::string::npos;
+}
+
+SCENARIO("deleted objects are compacted from the profile in the background")
+{
+    std::string filename = "eeprom_test.bin";
+    remove(filename.c_str());
+
+    GIVEN("a profile with three objects")
+    {
+        ExampleBox box(filename);
+        configure_ticks_example(box);
+        BoxApi api(box.get_box());
+        api.create_object(container_id(1), ExampleBox::as_int(ExampleBox::object_type::ValueTicksScaled));
+        api.create_object(container_id(2), ExampleBox::as_int(ExampleBox::object_type::ValueTicksScaled));
+        std::string created = api.run_command("05 00");
+        // definitions of objects 0 and 2, without the definition of object 1 in between
+        const std::string compacted_definitions("\x03\x00\x01\x00\x03\x02\x01\x00", 8);
+
+        WHEN("the middle object is deleted")
+        {
+            REQUIRE(api.run_command("04 01") == "01 ");   // the type of the deleted object
+            box.shutdown();
+            REQUIRE(!eeprom_file_contains(filename, compacted_definitions));
+
+            AND_WHEN("the box performs background work")
+            {
+                for (int i=0; i<10; i++)
+                    box.get_box().maintain();
+                box.shutdown();
+
+                THEN("the definition is removed from the profile")
+                {
+                    CHECK(eeprom_file_contains(filename, compacted_definitions));
+                    CHECK(api.run_command("05 00") == "00 00 03 00 01 00 03 02 01 00 00 ");
+                }
+
+                AND_WHEN("the box is restarted")
+                {
+                    ExampleBox restarted(filename);
+                    restarted.initialize();
+                    BoxApi restartedApi(restarted.get_box());
+
+                    THEN("the remaining objects are created")
+                    {
+                        CHECK(restartedApi.run_command("05 00") == "00 00 03 00 01 00 03 02 01 00 00 ");
+                        CHECK(restartedApi.run_command("0a 01 00").substr(0, 6) == "00 01 ");
+                    }
+                }
             }
         }
     }
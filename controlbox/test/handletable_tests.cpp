@@ -0,0 +1,125 @@
+#include "catch.hpp"
+#include "HandleTable.h"
+#include "examplebox.h"
+#include "BoxApi.h"
+
+#include <regex>
+
+SCENARIO("handle table")
+{
+	GIVEN("a container with two objects")
+	{
+		Object container, a, b, c;
+		HandleTable handles;
+		object_handle_t hc = handles.assign(&container, nullptr);
+		object_handle_t ha = handles.assign(&a, &container);
+		object_handle_t hb = handles.assign(&b, &container);
+
+		THEN("each object can be found by its handle")
+		{
+			CHECK(handles.lookup(hc) == &container);
+			CHECK(handles.lookup(ha) == &a);
+			CHECK(handles.lookup(hb) == &b);
+			CHECK(handles.find(&b) == hb);
+			CHECK(handles.find(&c) == HandleTable::INVALID_HANDLE);
+			CHECK(handles.lookup(HandleTable::INVALID_HANDLE) == nullptr);
+		}
+
+		WHEN("an object is released and its slot is reused")
+		{
+			handles.release(&a);
+			object_handle_t h = handles.assign(&c, &container);
+			THEN("the old handle is no longer valid")
+			{
+				CHECK(uint8_t(h) == uint8_t(ha));
+				CHECK(h != ha);
+				CHECK(handles.lookup(ha) == nullptr);
+				CHECK(handles.lookup(h) == &c);
+			}
+		}
+
+		WHEN("the container is released")
+		{
+			handles.release(&container);
+			THEN("the objects in it are released too")
+			{
+				CHECK(handles.lookup(hc) == nullptr);
+				CHECK(handles.lookup(ha) == nullptr);
+				CHECK(handles.lookup(hb) == nullptr);
+			}
+		}
+	}
+
+	GIVEN("a full table")
+	{
+		HandleTable handles;
+		Object objects[HANDLE_TABLE_SIZE+1];
+		for (int i=0; i<HANDLE_TABLE_SIZE; i++) {
+			REQUIRE(handles.assign(&objects[i], nullptr) != HandleTable::INVALID_HANDLE);
+		}
+		THEN("no more handles are assigned")
+		{
+			CHECK(handles.assign(&objects[HANDLE_TABLE_SIZE], nullptr) == HandleTable::INVALID_HANDLE);
+		}
+	}
+}
+
+SCENARIO("reading and writing values by handle")
+{
+	GIVEN("a box with an object created in the active profile")
+	{
+		ExampleBox box;
+		box.initialize();
+		BoxApi api(box.get_box());
+		Profile p = api.create_profile();
+		api.activate_profile(p);
+		api.create_object(container_id(0), ExampleBox::as_int(ExampleBox::object_type::ValueTicksScaled));
+
+		WHEN("the handle of the object is looked up")
+		{
+			std::string result = api.run_command("13 00");
+			THEN("the handle is returned")
+			{
+				CHECK(result == "00 00 00 ");
+			}
+
+			AND_WHEN("the object is read by handle")
+			{
+				result = api.run_command("14 00 00 00 00");
+				THEN("the value is returned")
+				{
+					INFO("result " << result);
+					CHECK(std::regex_match(result, std::regex("01 06 ([[:xdigit:]]{2} ){6}")));
+				}
+			}
+
+			AND_WHEN("the object is deleted")
+			{
+				api.run_command("04 00");
+				result = api.run_command("14 00 00 00 00");
+				THEN("the handle is no longer valid")
+				{
+					CHECK(result == "BB ");
+				}
+			}
+		}
+
+		WHEN("a command is sent with the id just past the last command")
+		{
+			std::string result = api.run_command("16 00 00");
+			THEN("it is handled as a no-op")
+			{
+				CHECK(result == "");
+			}
+		}
+
+		WHEN("the handle of an object that doesn't exist is looked up")
+		{
+			std::string result = api.run_command("13 01");
+			THEN("an error is returned")
+			{
+				CHECK(result == "BB ");
+			}
+		}
+	}
+}
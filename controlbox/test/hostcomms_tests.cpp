@@ -0,0 +1,271 @@
+#include "catch.hpp"
+#include "SpscRingBuffer.h"
+#include "CommsStdIO.h"
+#include "CommsSocket.h"
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+SCENARIO("spsc ring buffer")
+{
+	GIVEN("a producer and a consumer thread")
+	{
+		static SpscRingBuffer<65536> queue;
+		const size_t total = 16u << 20;
+
+		auto start = std::chrono::steady_clock::now();
+		std::thread producer([&]() {
+			uint8_t chunk[1000];
+			uint8_t value = 0;
+			size_t sent = 0;
+			while (sent < total) {
+				size_t length = std::min(sizeof(chunk), total - sent);
+				for (size_t i = 0; i < length; i++) {
+					chunk[i] = value++;
+				}
+				size_t done = 0;
+				while (done < length) {
+					size_t written = queue.write(chunk + done, length - done);
+					if (!written) {
+						std::this_thread::yield();
+					}
+					done += written;
+				}
+				sent += length;
+			}
+		});
+
+		size_t received = 0;
+		size_t errors = 0;
+		uint8_t expected = 0;
+		uint8_t chunk[1500];
+		while (received < total) {
+			size_t count = queue.read(chunk, sizeof(chunk));
+			if (!count) {
+				std::this_thread::yield();
+			}
+			for (size_t i = 0; i < count; i++) {
+				errors += chunk[i] != expected++;
+			}
+			received += count;
+		}
+		producer.join();
+		double seconds = secondsSince(start);
+
+		THEN("the consumer receives all data in order")
+		{
+			CHECK(errors == 0);
+			CHECK(queue.available() == 0);
+			std::cout << "spsc ring buffer: " << unsigned(double(total) / seconds / 1e6) << " MB/s" << std::endl;
+		}
+	}
+
+	GIVEN("a full buffer")
+	{
+		SpscRingBuffer<16> queue;
+		uint8_t data[20] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20 };
+		CHECK(queue.write(data, 20) == 16);
+
+		THEN("writing has no effect until data is read")
+		{
+			CHECK(queue.space() == 0);
+			CHECK(queue.write(data, 1) == 0);
+			CHECK(queue.peek() == 1);
+			CHECK(queue.next() == 1);
+			CHECK(queue.write(data + 16, 4) == 1);
+			uint8_t out[20];
+			CHECK(queue.read(out, 20) == 16);
+			CHECK(out[0] == 2);
+			CHECK(out[15] == 17);
+		}
+	}
+}
+
+SCENARIO("input stream poll")
+{
+	GIVEN("a stream with several megabytes of commands")
+	{
+		std::string line = "01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F 10\n";
+		std::string text;
+		while (text.size() < (8u << 20)) {
+			text += line;
+		}
+		std::istringstream stream(text);
+
+		auto start = std::chrono::steady_clock::now();
+		InputStreamPoll poll(stream);
+		std::string received;
+		uint8_t chunk[4096];
+		while (poll.hasNext()) {
+			poll.wait(100);
+			size_t count = poll.read(chunk, sizeof(chunk));
+			received.append(reinterpret_cast<char*>(chunk), count);
+		}
+		double seconds = secondsSince(start);
+
+		THEN("all of it is received, and hasNext() is false after the end")
+		{
+			CHECK(received == text);
+			CHECK(poll.available() == 0);
+			std::cout << "input stream poll: " << unsigned(double(text.size()) / seconds / 1e6) << " MB/s" << std::endl;
+		}
+	}
+
+	GIVEN("streams with more data than the queue holds")
+	{
+		std::string text(100000, 'x');
+
+		THEN("each poll stops its thread, which waits for room in the queue, before its stream is destroyed")
+		{
+			for (int i = 0; i < 200; i++) {
+				std::istringstream stream(text);
+				InputStreamPoll poll(stream);
+				REQUIRE(poll.wait(1000));
+			}
+		}
+	}
+}
+
+/**
+ * Client end of a Unix socket.
+ */
+static int connectUnix(const char* path)
+{
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+SCENARIO("socket connection")
+{
+	std::string path = "/tmp/cbtest_" + std::to_string(getpid()) + ".sock";
+	SocketConnection connection;
+	REQUIRE(connection.listenUnix(path.c_str()));
+
+	GIVEN("no client")
+	{
+		THEN("waiting for input sleeps for the timeout")
+		{
+			std::clock_t cpu = std::clock();
+			auto start = std::chrono::steady_clock::now();
+			CHECK(!connection.waitForInput(50));
+			double seconds = secondsSince(start);
+			double cpuSeconds = double(std::clock() - cpu) / CLOCKS_PER_SEC;
+			CHECK(seconds >= 0.045);
+			CHECK(cpuSeconds < seconds / 2);
+			CHECK(!connection.connected());
+			CHECK(!connection.getDataIn().hasNext());
+		}
+	}
+
+	GIVEN("a client that sends a response line")
+	{
+		int client = connectUnix(path.c_str());
+		REQUIRE(client >= 0);
+		CHECK(write(client, "0A 0B\n", 6) == 6);
+
+		THEN("the connection wakes up and receives the line")
+		{
+			CHECK(connection.waitForInput(1000));
+			CHECK(connection.connected());
+			DataIn& in = connection.getDataIn();
+			std::string line;
+			while (line.size() < 6 && in.hasNext()) {
+				if (in.available()) {
+					line += char(in.next());
+				}
+			}
+			CHECK(line == "0A 0B\n");
+
+			AND_THEN("output is sent per line")
+			{
+				DataOut& out = connection.getDataOut();
+				out.writeBuffer("01 02\r\n", 7);
+				char reply[16] = {};
+				CHECK(read(client, reply, sizeof(reply)) == 7);
+				CHECK(std::string(reply) == "01 02\r\n");
+			}
+
+			AND_WHEN("the client disconnects and another client connects")
+			{
+				connection.getData().request_received = true;
+				close(client);
+				client = -1;
+				connection.waitForInput(100);
+				CHECK(!connection.connected());
+
+				int next = connectUnix(path.c_str());
+				REQUIRE(next >= 0);
+				CHECK(connection.connected());
+				THEN("the connection data is reset for the new client")
+				{
+					CHECK(!connection.getData().request_received);
+				}
+				close(next);
+			}
+		}
+		if (client >= 0) {
+			close(client);
+		}
+	}
+
+	GIVEN("a client that streams several megabytes of commands")
+	{
+		std::string line = "01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F 10\n";
+		std::string text;
+		while (text.size() < (8u << 20)) {
+			text += line;
+		}
+		auto start = std::chrono::steady_clock::now();
+		std::thread sender([&]() {
+			int client = connectUnix(path.c_str());
+			size_t sent = 0;
+			while (client >= 0 && sent < text.size()) {
+				ssize_t count = write(client, text.data() + sent, text.size() - sent);
+				if (count <= 0) {
+					break;
+				}
+				sent += size_t(count);
+			}
+			close(client);
+		});
+
+		std::string received;
+		DataIn& in = connection.getDataIn();
+		connection.waitForInput(1000);
+		while (in.hasNext()) {
+			connection.waitForInput(100);
+			while (in.available()) {
+				received += char(in.next());
+			}
+		}
+		sender.join();
+		double seconds = secondsSince(start);
+
+		THEN("all of it is received")
+		{
+			CHECK(received.size() == text.size());
+			CHECK(received == text);
+			std::cout << "socket connection: " << unsigned(double(text.size()) / seconds / 1e6) << " MB/s" << std::endl;
+		}
+	}
+
+	unlink(path.c_str());
+}
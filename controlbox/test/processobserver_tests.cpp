@@ -0,0 +1,112 @@
+#include "catch.hpp"
+#include "ProcessObserver.h"
+#include "GenericContainer.h"
+#include <vector>
+
+/**
+ * Observer with a clock that advances by one for each reading, and which records every notification.
+ */
+struct RecordingObserver : public ProcessObserver
+{
+	struct Record {
+		Object* object;
+		ProcessPhase phase;
+		uint32_t micros;
+	};
+
+	uint32_t now = 0;
+	std::vector<Record> records;
+
+	uint32_t micros() override {
+		return now++;
+	}
+
+	void processed(Object* o, ProcessPhase phase, uint32_t micros) override {
+		records.push_back({o, phase, micros});
+	}
+};
+
+struct PreparingObject : public Object
+{
+	prepare_t time;
+	unsigned updates = 0;
+
+	PreparingObject(prepare_t time_) : time(time_) {}
+
+	prepare_t prepare() override { return time; }
+	void update() override { updates++; }
+};
+
+SCENARIO("process observer")
+{
+	PreparingObject a(5), b(20), c(10);
+	Object* nestedItems[] = { &c };
+	FixedContainer nested(1, nestedItems);
+	Object* rootItems[] = { &a, nullptr, &b, &nested };
+	FixedContainer root(4, rootItems);
+
+	RecordingObserver observer;
+	processObserver = &observer;
+
+	WHEN("the root is prepared")
+	{
+		prepare_t time = prepareObject(&root);
+
+		THEN("the longest prepare time is returned")
+		{
+			CHECK(time == 20);
+		}
+
+		THEN("each object is reported after it is prepared, containers after their contents")
+		{
+			REQUIRE(observer.records.size() == 5);
+			CHECK(observer.records[0].object == &a);
+			CHECK(observer.records[1].object == &b);
+			CHECK(observer.records[2].object == &c);
+			CHECK(observer.records[3].object == &nested);
+			CHECK(observer.records[4].object == &root);
+			for (auto& r : observer.records) {
+				CHECK(r.phase == ProcessPhase::prepare);
+			}
+		}
+
+		THEN("containers include the time of their contents")
+		{
+			CHECK(observer.records[0].micros == 1);
+			CHECK(observer.records[3].micros == 3);
+			CHECK(observer.records[4].micros == 9);
+		}
+	}
+
+	WHEN("the root is updated")
+	{
+		updateObject(&root);
+
+		THEN("nested objects are updated and reported")
+		{
+			CHECK(a.updates == 1);
+			CHECK(b.updates == 1);
+			CHECK(c.updates == 1);
+			REQUIRE(observer.records.size() == 5);
+			CHECK(observer.records[0].object == &a);
+			CHECK(observer.records[4].object == &root);
+			for (auto& r : observer.records) {
+				CHECK(r.phase == ProcessPhase::update);
+			}
+		}
+	}
+
+	WHEN("there is no observer")
+	{
+		processObserver = nullptr;
+		updateObject(&root);
+
+		THEN("objects are still updated")
+		{
+			CHECK(a.updates == 1);
+			CHECK(observer.records.empty());
+		}
+	}
+
+	processObserver = nullptr;
+}
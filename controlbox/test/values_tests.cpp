@@ -0,0 +1,154 @@
+#include "catch.hpp"
+#include "Values.h"
+#include "GenericContainer.h"
+#include "Box.h"
+#include "BoxApi.h"
+#include "ArrayEepromAccess.h"
+#include "ValueTicks.h"
+#include <vector>
+
+namespace {
+
+/**
+ * Collects written bytes for inspection.
+ */
+struct VectorDataOut : public DataOut
+{
+	std::vector<uint8_t> data;
+
+	bool write(uint8_t b) override {
+		data.push_back(b);
+		return true;
+	}
+};
+
+/**
+ * A value that streams a variable owned by the test.
+ */
+class VariableValue : public Value
+{
+	void* p;
+	uint8_t size;
+public:
+	VariableValue(void* p_, uint8_t size_) : p(p_), size(size_) {}
+
+	void readTo(DataOut& out) override {
+		out.writeBuffer(p, size);
+	}
+
+	uint8_t readStreamSize() override {
+		return size;
+	}
+};
+
+/**
+ * Records the id chain of each value entered during a walk.
+ */
+bool recordIdChain(Object* obj, void* data, const container_id* id, const container_id* end, bool enter)
+{
+	if (enter && obj && !isContainer(obj))
+		static_cast<std::vector<std::vector<uint8_t>>*>(data)->emplace_back(id, end);
+	return false;
+}
+
+/**
+ * A connection without input that records the output of a box.
+ */
+struct RecordingConnection : public ConnectionData<StandardConnectionDataType>
+{
+	EmptyDataIn in;
+	VectorDataOut out;
+
+	DataIn& getDataIn() override { return in; }
+	DataOut& getDataOut() override { return out; }
+	bool connected() override { return false; }
+
+	std::string text() const { return std::string(out.data.begin(), out.data.end()); }
+};
+
+/**
+ * A box with a single scaled ticks value in its profile, running on time that does not advance.
+ */
+class LoggingBox : public CommandCallbacks
+{
+	struct FixedTicks : public Ticks
+	{
+		ticks_millis_t millis() override { return 0; }
+	};
+
+	ArrayEepromAccess<1024> eeprom;
+	FixedTicks ticks;
+	Object* systemRootItems[2];
+	FixedContainer systemRoot;
+
+public:
+	RecordingConnection connection;
+	Box box;
+
+	LoggingBox()
+		: systemRoot(2, systemRootItems), box(connection, eeprom, ticks, *this, systemRoot)
+	{
+		box.setup();
+		BoxApi api(box);
+		Profile p = api.create_profile();
+		api.activate_profile(p);
+		api.create_object(container_id(0), 1);
+		connection.out.data.clear();
+	}
+
+	int8_t createApplicationObject(Object*& result, ObjectDefinition& def, bool dryRun=false) override {
+		result = (def.type == 1 && !dryRun) ? new ScaledTicksValue(ticks) : nullFactory(def);
+		int8_t error = no_error;
+		if (!result) {
+			error = errorCode(insufficient_heap);
+		}
+		return error;
+	}
+	void handleReset(bool) override {}
+	void connectionStarted(StandardConnection&, DataOut&) override {}
+	Container* createRootContainer() override { return new DynamicContainer(); }
+};
+
+}
+
+SCENARIO("walking the hierarchy flags every container id in the chain")
+{
+	uint8_t v = 0;
+	VariableValue value(&v, sizeof(v));
+	Object* innerItems[2] = { nullptr, &value };
+	FixedContainer inner(2, innerItems);
+	Object* middleItems[4] = { nullptr, nullptr, nullptr, &inner };
+	FixedContainer middle(4, middleItems);
+	Object* rootItems[3] = { &value, nullptr, &middle };
+	FixedContainer root(3, rootItems);
+
+	container_id ids[MAX_CONTAINER_DEPTH];
+	std::vector<std::vector<uint8_t>> chains;
+	walkRoot(&root, recordIdChain, &chains, ids);
+
+	// each container id has the 0x80 continuation flag, the last id in the chain does not
+	std::vector<std::vector<uint8_t>> expected = { { 0x00 }, { 0x82, 0x83, 0x01 } };
+	CHECK(chains == expected);
+}
+
+SCENARIO("automatic logs are written to the connection")
+{
+	LoggingBox b;
+	b.box.requestLogValues();
+	b.box.loop();
+
+	// automatic log command, then the read value entry: id 0, type 1, 6 bytes of zero time and a scale of 1
+	std::string log = b.connection.text();
+	INFO("log " << log);
+	CHECK(log == "8A 01 00 01 06 00 00 00 00 01 00 \r\n");
+
+	AND_WHEN("no log is requested")
+	{
+		b.connection.out.data.clear();
+		b.box.loop();
+		THEN("nothing is written")
+		{
+			CHECK(b.connection.text() == "");
+		}
+	}
+}
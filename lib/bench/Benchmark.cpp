@@ -0,0 +1,238 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark runner for the control loop hot paths.
+ *
+ * Usage: bench [--filter <substring>] [--json <file>] [--baseline <file>] [--threshold <percent>]
+ *
+ * Results are printed as a table and written as JSON when --json is given. With --baseline, every benchmark is compared
+ * to the baseline and the runner exits with 1 when it is more than threshold percent slower, when it allocates more,
+ * or when it has no entry in the baseline.
+ */
+
+#include "Benchmark.h"
+#include "Ticks.h"
+#include "Logger.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+// the lib expects the platform to provide these, like the test runner does
+thread_local ExternalTicks ticks;
+NoOpDelay wait;
+BrewPiLogger logger;
+
+void BrewPiLogger::logMessageVaArg(char type, LOG_ID_TYPE errorID, const char * varTypes, ...) {
+    // log messages are not printed, they would disturb the measurements
+}
+
+static std::atomic<uint64_t> allocations(0);
+static std::atomic<uint64_t> heapBytes(0);
+static std::atomic<uint64_t> heapPeakBytes(0);
+
+uint64_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t heapInUse() {
+    return heapBytes.load(std::memory_order_relaxed);
+}
+
+uint64_t heapPeak() {
+    return heapPeakBytes.load(std::memory_order_relaxed);
+}
+
+void resetHeapPeak() {
+    heapPeakBytes.store(heapInUse(), std::memory_order_relaxed);
+}
+
+// heap use is counted in the sizes malloc actually reserved, which can be a bit more than requested
+static std::size_t allocatedSize(void * p) {
+#if defined(__APPLE__)
+    return malloc_size(p);
+#else
+    return malloc_usable_size(p);
+#endif
+}
+
+void * operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void * p = std::malloc(size ? size : 1)) {
+        uint64_t inUse = heapBytes.fetch_add(allocatedSize(p), std::memory_order_relaxed) + allocatedSize(p);
+        uint64_t peak = heapPeakBytes.load(std::memory_order_relaxed);
+        while (inUse > peak && !heapPeakBytes.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {
+        }
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// not inlined, so the compiler does not match the free() against the new in the caller
+__attribute__((noinline)) void operator delete(void * p) noexcept {
+    if (p) {
+        heapBytes.fetch_sub(allocatedSize(p), std::memory_order_relaxed);
+    }
+    std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+std::vector<RegisteredBenchmark> & registeredBenchmarks() {
+    static std::vector<RegisteredBenchmark> benchmarks;
+    return benchmarks;
+}
+
+BenchmarkRegistration::BenchmarkRegistration(const char * name, BenchmarkFunction function) {
+    registeredBenchmarks().push_back({name, function});
+}
+
+static void writeJson(std::ostream & out, const std::vector<BenchmarkResult> & results) {
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult & r = results[i];
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, \"peak_heap_bytes\": %llu, "
+                 "\"iterations\": %llu}%s\n",
+                 r.name.c_str(), r.nsPerOp, r.allocsPerOp, (unsigned long long) r.peakHeapBytes,
+                 (unsigned long long) r.iterations,
+                 i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+}
+
+/**
+ * Reads a result file written by writeJson. Only the fields the comparison needs are parsed.
+ */
+static bool readJson(const char * path, std::map<std::string, BenchmarkResult> & results) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string json = buffer.str();
+
+    size_t pos = 0;
+    while ((pos = json.find("\"name\"", pos)) != std::string::npos) {
+        size_t end = json.find('}', pos);
+        std::string object = json.substr(pos, end - pos);
+        BenchmarkResult r = {};
+        size_t nameStart = object.find('"', object.find(':')) + 1;
+        r.name = object.substr(nameStart, object.find('"', nameStart) - nameStart);
+        size_t ns = object.find("\"ns_per_op\"");
+        size_t allocs = object.find("\"allocs_per_op\"");
+        if (ns == std::string::npos || allocs == std::string::npos) {
+            return false;
+        }
+        r.nsPerOp = std::strtod(object.c_str() + object.find(':', ns) + 1, nullptr);
+        r.allocsPerOp = std::strtod(object.c_str() + object.find(':', allocs) + 1, nullptr);
+        results[r.name] = r;
+        pos = end;
+    }
+    return true;
+}
+
+int main(int argc, char ** argv) {
+    const char * filter = nullptr;
+    const char * jsonPath = nullptr;
+    const char * baselinePath = nullptr;
+    double threshold = 25.0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--filter")) {
+            filter = argv[i + 1];
+        } else if (!strcmp(argv[i], "--json")) {
+            jsonPath = argv[i + 1];
+        } else if (!strcmp(argv[i], "--baseline")) {
+            baselinePath = argv[i + 1];
+        } else if (!strcmp(argv[i], "--threshold")) {
+            threshold = std::atof(argv[i + 1]);
+        } else {
+            std::cerr << "unknown option " << argv[i] << "\n";
+            return 2;
+        }
+    }
+
+    std::map<std::string, BenchmarkResult> baseline;
+    if (baselinePath && !readJson(baselinePath, baseline)) {
+        std::cerr << "cannot read baseline " << baselinePath << "\n";
+        return 2;
+    }
+
+    std::vector<BenchmarkResult> results;
+    int regressions = 0;
+    printf("%-32s %12s %12s %12s %12s\n", "benchmark", "ns/op", "allocs/op", "peak heap", "baseline");
+    for (auto & b : registeredBenchmarks()) {
+        if (filter && !strstr(b.name, filter)) {
+            continue;
+        }
+        Bench bench(std::chrono::milliseconds(20), 10);
+        b.function(bench);
+        results.push_back({b.name, bench.nsPerOp, bench.allocsPerOp, bench.peakHeapBytes, bench.iterations});
+
+        std::string verdict;
+        auto found = baseline.find(b.name);
+        if (found != baseline.end()) {
+            const BenchmarkResult & base = found->second;
+            double change = base.nsPerOp > 0 ? 100.0 * (bench.nsPerOp - base.nsPerOp) / base.nsPerOp : 0;
+            char buf[64];
+            snprintf(buf, sizeof(buf), "%+.1f%%", change);
+            verdict = buf;
+            if (change > threshold) {
+                verdict += " SLOWER";
+                regressions++;
+            }
+            if (bench.allocsPerOp > base.allocsPerOp + 0.001) {
+                verdict += " ALLOCATES";
+                regressions++;
+            }
+        } else if (baselinePath) {
+            // a benchmark that is not in the baseline would never be checked
+            verdict = "MISSING";
+            regressions++;
+        }
+        printf("%-32s %12.2f %12.3f %12llu %12s\n", b.name, bench.nsPerOp, bench.allocsPerOp,
+               (unsigned long long) bench.peakHeapBytes, verdict.c_str());
+    }
+
+    if (jsonPath) {
+        std::ofstream out(jsonPath);
+        writeJson(out, results);
+    }
+    if (regressions) {
+        printf("%d regression(s) exceed or are missing from the baseline, threshold %.0f%%\n", regressions, threshold);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * Number of heap allocations since the start of the program, counted by the replaced global operator new.
+ */
+uint64_t allocationCount();
+
+/**
+ * Bytes allocated with operator new and not yet deleted.
+ */
+uint64_t heapInUse();
+
+/**
+ * Highest value of heapInUse() since the last call to resetHeapPeak().
+ */
+uint64_t heapPeak();
+
+void resetHeapPeak();
+
+/**
+ * Prevents the compiler from optimizing away a value that is computed but not used.
+ */
+template<typename T>
+inline void doNotOptimize(T const & value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchmarkResult {
+    std::string name;
+    double nsPerOp;
+    double allocsPerOp;
+    uint64_t peakHeapBytes;
+    uint64_t iterations;
+};
+
+/**
+ * Handle passed to a benchmark. The benchmark does its setup and then calls measure() with the operation to time.
+ *
+ * measure() doubles the number of iterations until a run takes at least the minimum time, then repeats the run and
+ * keeps the fastest one, which is the least disturbed by the rest of the system. Finally it runs the operation once more
+ * to record how much heap it needs at most, on top of what was in use before.
+ */
+class Bench {
+public:
+    Bench(std::chrono::nanoseconds minTime_, uint8_t repetitions_)
+        : nsPerOp(0), allocsPerOp(0), peakHeapBytes(0), iterations(0), minTime(minTime_), repetitions(repetitions_) {}
+
+    template<typename Op>
+    void measure(Op op) {
+        uint64_t n = 1;
+        while (true) {
+            auto elapsed = run(op, n);
+            if (elapsed >= minTime || n >= (uint64_t(1) << 32)) {
+                break;
+            }
+            n *= 2;
+        }
+        double best = 0;
+        double allocs = 0;
+        for (uint8_t r = 0; r < repetitions; r++) {
+            uint64_t allocsBefore = allocationCount();
+            auto elapsed = run(op, n);
+            uint64_t allocsDuring = allocationCount() - allocsBefore;
+            double ns = double(elapsed.count()) / n;
+            if (r == 0 || ns < best) {
+                best = ns;
+                allocs = double(allocsDuring) / n;
+            }
+        }
+        nsPerOp = best;
+        allocsPerOp = allocs;
+        iterations = n;
+
+        resetHeapPeak();
+        uint64_t heapBefore = heapInUse();
+        op();
+        peakHeapBytes = heapPeak() - heapBefore;
+    }
+
+    double nsPerOp;
+    double allocsPerOp;
+    uint64_t peakHeapBytes;
+    uint64_t iterations;
+
+private:
+    template<typename Op>
+    std::chrono::nanoseconds run(Op & op, uint64_t n) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < n; i++) {
+            op();
+        }
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+    std::chrono::nanoseconds minTime;
+    uint8_t repetitions;
+};
+
+typedef void (*BenchmarkFunction)(Bench & bench);
+
+struct BenchmarkRegistration {
+    BenchmarkRegistration(const char * name, BenchmarkFunction function);
+};
+
+struct RegisteredBenchmark {
+    const char * name;
+    BenchmarkFunction function;
+};
+
+std::vector<RegisteredBenchmark> & registeredBenchmarks();
+
+/**
+ * Defines and registers a benchmark. The body receives a Bench & named bench.
+ */
+#define BENCHMARK(name) \
+    static void benchmark_##name(Bench & bench); \
+    static BenchmarkRegistration benchmark_registration_##name(#name, benchmark_##name); \
+    static void benchmark_##name(Bench & bench)
@@ -0,0 +1,292 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Benchmark.h"
+
+#include "Pid.h"
+#include "SetPoint.h"
+#include "TempSensorMock.h"
+#include "SensorSetPointPair.h"
+#include "ActuatorMocks.h"
+#include "ActuatorPwm.h"
+#include "ActuatorMutexDriver.h"
+#include "ActuatorMutexGroup.h"
+#include "FilterCascaded.h"
+#include "OneWire.h"
+#include "OneWireEmulator.h"
+#include "DallasTemperature.h"
+#include "DS2408.h"
+#include "RefTo.h"
+#include "temperatureFormats.h"
+#include "Ticks.h"
+#include <memory>
+#include <vector>
+
+BENCHMARK(pid_update) {
+    TempSensorMock sensor(20.0);
+    ActuatorBool vAct;
+    ActuatorPwm act(vAct, 4);
+    SetPointSimple sp(21.0);
+    SensorSetPointPair input(sensor, sp);
+    Pid pid(input, act);
+    pid.setConstants(10.0, 600, 60);
+    temp_t step = 0.0625;
+    bench.measure([&] {
+        sensor.add(step);
+        step = -step;
+        pid.update();
+    });
+}
+
+BENCHMARK(filter_cascaded_add) {
+    FilterCascaded filter;
+    filter.setFiltering(2);
+    filter.init(temp_precise_t(20.0));
+    temp_t value = 20.0;
+    temp_t step = 0.0625;
+    bench.measure([&] {
+        value += step;
+        step = -step;
+        doNotOptimize(filter.add(value));
+    });
+}
+
+BENCHMARK(actuator_pwm_fast_update) {
+    ActuatorBool target;
+    ActuatorPwm act(target, 4);
+    act.set(37.0);
+    bench.measure([&] {
+        ticks.incMillis(1);
+        act.fastUpdate();
+    });
+}
+
+BENCHMARK(actuator_pwm_value) {
+    ActuatorBool target;
+    ActuatorPwm act(target, 4);
+    act.set(37.0);
+    for (int i = 0; i < 20000; i++) {
+        ticks.incMillis(1);
+        act.fastUpdate();
+    }
+    bench.measure([&] {
+        doNotOptimize(act.value());
+    });
+}
+
+BENCHMARK(actuator_pwm_value_pid_and_update) {
+    // in one control loop, the PID reads the achieved value for anti-windup and the PWM reads it at a new period
+    ActuatorBool target;
+    ActuatorPwm act(target, 4);
+    act.set(37.0);
+    bench.measure([&] {
+        ticks.incMillis(1);
+        doNotOptimize(act.value());
+        doNotOptimize(act.value());
+        act.fastUpdate();
+    });
+}
+
+BENCHMARK(actuator_pwm_bank_fast_update_8) {
+    std::vector<std::unique_ptr<ActuatorBool>> targets;
+    std::vector<std::unique_ptr<ActuatorPwm>> channels;
+    for (int i = 0; i < 8; i++) {
+        targets.emplace_back(new ActuatorBool());
+        channels.emplace_back(new ActuatorPwm(*targets.back(), 4));
+        channels.back()->set(temp_t(10.0 * i + 5.0));
+    }
+    bench.measure([&] {
+        ticks.incMillis(1);
+        ticks_millis_t now = ticks.millis();
+        for (auto & channel : channels) {
+            channel->fastUpdate(now);
+        }
+    });
+}
+
+BENCHMARK(actuator_mutex_group_request) {
+    ActuatorBool act1;
+    ActuatorBool act2;
+    ActuatorMutexGroup mutex;
+    ActuatorMutexDriver actm1(act1);
+    ActuatorMutexDriver actm2(act2);
+    actm1.setMutex(&mutex);
+    actm2.setMutex(&mutex);
+    actm1.setState(ActuatorDigital::State::Active, 5);
+    bench.measure([&] {
+        // a lower priority request that is denied while the other actuator is active
+        doNotOptimize(mutex.request(&actm2, ActuatorDigital::State::Active, 3));
+    });
+}
+
+/*
+ * One actuator in a group of count holds the mutex, the others take turns requesting to go active with different
+ * priorities, as PWM actuators waiting for their turn do on each fast update.
+ */
+static void mutexGroupWaitingRequests(Bench & bench, size_t count) {
+    ActuatorMutexGroup mutex;
+    std::vector<std::unique_ptr<ActuatorBool>> targets;
+    std::vector<std::unique_ptr<ActuatorMutexDriver>> drivers;
+    for (size_t i = 0; i < count; i++) {
+        targets.emplace_back(new ActuatorBool());
+        drivers.emplace_back(new ActuatorMutexDriver(*targets.back(), &mutex));
+    }
+    drivers[0]->setState(ActuatorDigital::State::Active, 50);
+    size_t next = 1;
+    bench.measure([&] {
+        doNotOptimize(mutex.request(drivers[next].get(), ActuatorDigital::State::Active, int8_t(next * 3)));
+        next = (next + 1 < count) ? next + 1 : 1;
+    });
+}
+
+BENCHMARK(actuator_mutex_group_request_4) {
+    mutexGroupWaitingRequests(bench, 4);
+}
+
+BENCHMARK(actuator_mutex_group_request_8) {
+    mutexGroupWaitingRequests(bench, 8);
+}
+
+/*
+ * The OneWire benchmarks run the drivers against the bus emulator, so they measure the CPU time of the driver and the
+ * emulation of each time slot. The bus time the same transactions take on hardware is checked in OneWireEmulatorTest.
+ */
+BENCHMARK(onewire_search_8) {
+    OneWireBusEmulator bus(30);
+    std::vector<std::unique_ptr<DS18B20Model>> sensors;
+    for (uint64_t i = 0; i < 8; i++) {
+        sensors.emplace_back(new DS18B20Model(0x100000 + i * 0x1357));
+        bus.add(*sensors.back());
+    }
+    OneWire oneWire(30);
+    DeviceAddress address;
+    bench.measure([&] {
+        oneWire.reset_search();
+        while (oneWire.search(address)) {
+            doNotOptimize(address);
+        }
+    });
+}
+
+BENCHMARK(onewire_read_scratchpad) {
+    OneWireBusEmulator bus(30);
+    DS18B20Model sensor(0x123456);
+    bus.add(sensor);
+    OneWire oneWire(30);
+    DallasTemperature dallas(&oneWire);
+    DeviceAddress address;
+    memcpy(address, sensor.getRom(), 8);
+    uint8_t scratchPad[9];
+    bench.measure([&] {
+        doNotOptimize(dallas.readScratchPadCRC(address, scratchPad));
+    });
+}
+
+BENCHMARK(onewire_ds2408_write) {
+    OneWireBusEmulator bus(30);
+    DS2408Model model(0x2408);
+    bus.add(model);
+    OneWire oneWire(30);
+    DeviceAddress address;
+    memcpy(address, model.getRom(), 8);
+    DS2408 device(&oneWire, address);
+    uint8_t latches = 0;
+    bench.measure([&] {
+        doNotOptimize(device.writeLatches(latches++));
+    });
+}
+
+BENCHMARK(ref_to_get_cached) {
+    ActuatorBool act;
+    RefTo<ActuatorDigital> ref([&act]() -> Interface * { return &act; });
+    bench.measure([&] {
+        doNotOptimize(ref.get());
+    });
+}
+
+BENCHMARK(ref_to_get_after_invalidate) {
+    ActuatorBool act;
+    RefTo<ActuatorDigital> ref([&act]() -> Interface * { return &act; });
+    bench.measure([&] {
+        RefToGeneric::invalidateAll();
+        doNotOptimize(ref.get());
+    });
+}
+
+BENCHMARK(to_string_impl) {
+    temp_t value = 21.5625;
+    char buf[12];
+    bench.measure([&] {
+        doNotOptimize(toStringImpl(value.getRaw(), temp_t::fractional_bit_count, buf, 3, sizeof(buf), 'C', true));
+    });
+}
+
+BENCHMARK(to_string_impl_fahrenheit) {
+    temp_t value = 21.5625;
+    char buf[12];
+    bench.measure([&] {
+        doNotOptimize(toStringImpl(value.getRaw(), temp_t::fractional_bit_count, buf, 2, sizeof(buf), 'F', true));
+    });
+}
+
+// the temperatures of a 't' response
+BENCHMARK(to_temp_strings_7) {
+    temp_t values[] = { 19.875, 20.0, 4.5625, 5.0, temp_t::invalid(), -1.25, 65.5 };
+    char buf[7 * 8 + 1];
+    bench.measure([&] {
+        doNotOptimize(temp_t::toTempStrings(values, 7, buf, sizeof(buf), 2, '\0', 'C', true));
+    });
+}
+
+BENCHMARK(from_string_impl) {
+    int32_t raw = 0;
+    bench.measure([&] {
+        doNotOptimize(fromStringImpl(&raw, temp_t::fractional_bit_count, "21.563", 'C', true,
+                                     temp_t::min().getRaw(), temp_t::max().getRaw()));
+        doNotOptimize(raw);
+    });
+}
+
+BENCHMARK(fixed_point_multiply) {
+    temp_long_t a = 1.5;
+    temp_long_t b = 1.0001;
+    bench.measure([&] {
+        a = a * b;
+        doNotOptimize(a);
+    });
+}
+
+BENCHMARK(fixed_point_divide) {
+    temp_long_t a = 1000.0;
+    temp_long_t b = 1.0001;
+    bench.measure([&] {
+        a = a / b;
+        doNotOptimize(a);
+    });
+}
+
+BENCHMARK(fixed_point_add_saturating) {
+    temp_t a = 20.0;
+    temp_t b = 0.0625;
+    bench.measure([&] {
+        a += b;
+        b = -b;
+        doNotOptimize(a);
+    });
+}
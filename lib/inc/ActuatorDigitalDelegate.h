@@ -23,6 +23,7 @@
 #include "ControllerMixins.h"
 #include "Interface.h"
 #include "RefTo.h"
+#include "Delegate.h"
 
 
 class ActuatorDigitalDelegate :
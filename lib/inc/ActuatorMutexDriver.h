@@ -63,6 +63,10 @@ public:
         return mutexGroup;
     }
 
+    ActuatorDigital & getTarget() const {
+        return target;
+    }
+
     // To activate actuator, permission is asked from mutexGroup, false is always allowed
     // when priority not specified, default to highest priority
     virtual void setState(State state, int8_t priority = 127) override final;
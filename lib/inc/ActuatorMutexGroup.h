@@ -28,10 +28,11 @@
 
 class ActuatorPriority {
 public:
-	ActuatorPriority(ActuatorMutexDriver * act, int8_t p) : actuator(act), priority(p){};
+	ActuatorPriority(ActuatorMutexDriver * act) : actuator(act), key(0), heapIndex(-1){};
 	~ActuatorPriority() = default;
     ActuatorMutexDriver * actuator;
-    int8_t priority; // valid priorities are 0-127. -1 is used for actuators that are not trying to get the mutex
+    int32_t key; // priority, offset by the number of decays at the time of the request
+    int8_t heapIndex; // position in the waiting heap, -1 for actuators that are not trying to get the mutex
 };
 
 class ActuatorMutexGroup final :
@@ -42,7 +43,8 @@ public:
     ActuatorMutexGroup() :
         deadTime(0),
         lastActiveTime(0),
-        lastActiveActuator(nullptr)
+        lastActiveActuator(nullptr),
+        decays(0)
 	{
     }
 
@@ -55,7 +57,15 @@ public:
     void registerActuator(ActuatorMutexDriver * act);
     void unRegisterActuator(ActuatorMutexDriver * act);
 
-
+    /**
+     * Requests permission to change the state of an actuator.
+     * Waiting requests are kept in a heap, ordered by priority (valid priorities are 0-127). Only the waiting request
+     * with the highest priority is honored, and only when no other actuator is active and the dead time has passed.
+     * @param requester: actuator that wants to change state
+     * @param newState: requested state, Inactive is always allowed
+     * @param newPriority: priority of the request
+     * @return true when the actuator may change to the new state
+     */
     bool request(ActuatorMutexDriver * requester, ActuatorDigital::State newState, int8_t newPriority);
 
     /**
@@ -71,8 +81,18 @@ public:
     }
     void setDeadTime(ticks_millis_t);
 
-    ticks_millis_t getWaitTime();
+    /**
+     * Returns the time until the dead time has passed and another actuator can go active.
+     * @return time in milliseconds, 0 when the dead time has passed
+     */
+    ticks_millis_t getWaitTime() const;
+
+    /**
+     * Returns the waiting actuator with the highest priority, or nullptr when no actuator is waiting.
+     */
+    ActuatorMutexDriver * getNextActuator() const;
 
+    // update decreases all priorities by 1, so that old requests lose their priority automatically
     void update() final;
 
     void fastUpdate() final {} // not needed
@@ -81,7 +101,20 @@ private:
     ticks_millis_t deadTime; // minimum time between switching from one actuator to the other
     ticks_millis_t lastActiveTime;
     ActuatorMutexDriver * lastActiveActuator;
+    uint32_t decays; // number of times priorities were decreased by update()
     std::vector<ActuatorPriority> actuatorPriorities;
+    std::vector<ActuatorPriority *> waiting; // binary max-heap on key
+
+    int32_t effectivePriority(const ActuatorPriority & ap) const {
+        return ap.key - int32_t(decays);
+    }
+    ActuatorPriority * find(ActuatorMutexDriver * act);
+    void rebuildWaiting();
+    void heapSet(size_t index, ActuatorPriority * ap);
+    void heapUp(size_t index);
+    void heapDown(size_t index);
+    void enqueue(ActuatorPriority & ap, int32_t key);
+    void dequeue(ActuatorPriority & ap);
 
 friend class ActuatorMutexGroupMixin;
 };
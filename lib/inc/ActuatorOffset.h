@@ -101,6 +101,14 @@ public:
         maximum = max;
     }
 
+    ProcessValue & getTarget() const {
+        return target;
+    }
+
+    ProcessValue & getReference() const {
+        return reference;
+    }
+
     void setReferenceSettingOrValue(bool useSetting) {
         useReferenceValue = useSetting;
     }
@@ -49,6 +49,10 @@ private:
     int32_t        period_ms;
     temp_t         minVal;
     temp_t         maxVal;
+    // value() only changes with time between edges, so it is computed at most once per millisecond
+    mutable temp_t         cachedValue;
+    mutable ticks_millis_t cachedValueTime;
+    mutable bool           cachedValueValid;
 
 public:
     /** Constructor.
@@ -86,7 +90,17 @@ public:
      *
      * @return achieved duty cycle in fixed point.
      */
-    temp_t value() const override final;
+    temp_t value() const override final {
+        return value(ticks.millis());
+    }
+
+    /** Returns the achieved value at the given time, which should be the current time.
+     *  The result is cached until the time changes or the output toggles, so calling this more than once per
+     *  millisecond is cheap.
+     * @param now current time in milliseconds
+     * @return achieved duty cycle in fixed point.
+     */
+    temp_t value(ticks_millis_t now) const;
 
     /** Returns the set duty cycle
      * @return duty cycle setting in fixed point
@@ -108,7 +122,15 @@ public:
      * If needed, it can even skip going high or low. This will happen, for example, when the target is
      * a time limited actuator with a minimum on and/or off time.
      */
-    void fastUpdate() override final;
+    void fastUpdate() override final {
+        fastUpdate(ticks.millis());
+    }
+
+    /** Same as fastUpdate(), with the current time passed in.
+     *  This allows updating many PWM channels with a single read of the time.
+     * @param now current time in milliseconds
+     */
+    void fastUpdate(ticks_millis_t now);
 
     /**
      * Periodic update (every second). Same as fast update, but calls periodic update on target too.
@@ -118,6 +140,12 @@ public:
         fastUpdate();
     };
 
+    /** returns the digital actuator that is toggled
+     */
+    ActuatorDigital & getTarget() const {
+        return target;
+    }
+
     /** returns the PWM period
      * @return PWM period in seconds
      */
@@ -131,8 +159,15 @@ public:
      */
     void setPeriod(uint16_t sec){
         period_ms = int32_t(sec) * 1000;
+        cachedValueValid = false;
     }
 
+    /** Returns the time until fastUpdate() next needs to toggle the target or start a new period.
+     * Calling fastUpdate() before then does not change the output, so a simulation can skip ahead.
+     * @return time in milliseconds, 0 when a toggle is due now (or is being blocked by the target)
+     */
+    ticks_millis_t getWaitTime() const;
+
 
 
 private:
@@ -147,7 +182,13 @@ private:
      * @param expectedPeriod estimate of the duration of the period in ms
      * @return duration of the high period in ms
      */
-    int32_t calculateDutyTime(int32_t expectedPeriod);
+    int32_t calculateDutyTime(int32_t expectedPeriod) const;
+
+    /** Calculates the achieved value from the last high and low transitions
+     * @param now current time in milliseconds
+     * @return achieved duty cycle in fixed point.
+     */
+    temp_t calculateValue(ticks_millis_t now) const;
 
     friend class ActuatorPwmMixin;
 };
@@ -76,6 +76,17 @@ public:
     }
     ticks_seconds_t timeSinceToggle(void) const;
 
+    /**
+     * Returns the time until the next time limit expires: the minimum on or off time for the current state,
+     * or the maximum on time, after which update() forces the target off.
+     * @return time in milliseconds, 0 when no limit is pending
+     */
+    ticks_millis_t getWaitTime(void) const;
+
+    ActuatorDigital & getTarget() const {
+        return target;
+    }
+
 private:
     ActuatorDigital & target;
     ticks_seconds_t        minOnTime;
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "Interface.h"
+#include "LoopProfiler.h"
+
+/**
+ * ControlGraph compiles a list of control objects into flat dispatch tables for update() and fastUpdate().
+ *
+ * The data dependencies between objects (sensor -> PID -> PWM -> mutex -> pin) are derived with a visitor and the
+ * objects are sorted so that each object is updated after the objects it reads from. Objects that do not depend on
+ * each other keep the order in which they were passed in, so the order is deterministic.
+ * Objects with an empty update() or fastUpdate() are left out of the corresponding table.
+ * Delegates are resolved to their current target, so the tables have to be rebuilt when devices change.
+ * The graph compares the RefTo topology generation and the list of objects it was compiled for to detect this.
+ */
+class ControlGraph {
+public:
+    ControlGraph() : compiledGeneration(0) {}
+    ~ControlGraph() = default;
+
+    /**
+     * Builds the dispatch tables for the given objects.
+     * @param objects objects to update. Objects they refer to, but which are not in this list, are not updated,
+     * but are used to determine the order.
+     */
+    void compile(const std::vector<Interface *> & objects);
+
+    /**
+     * Returns true when the dispatch tables have to be rebuilt for these objects: the topology generation changed, or
+     * the list differs from the one the tables were compiled for, also when an object was replaced by another one.
+     */
+    bool isStale(const std::vector<Interface *> & objects) const;
+
+    void update(){
+        for(auto obj : updateTable){
+            PROFILE_OBJECT(obj, ProfilePhase::Update);
+            obj->update();
+        }
+    }
+
+    void fastUpdate(){
+        for(auto obj : fastUpdateTable){
+            PROFILE_OBJECT(obj, ProfilePhase::FastUpdate);
+            obj->fastUpdate();
+        }
+    }
+
+    const std::vector<Interface *> & getUpdateTable() const {
+        return updateTable;
+    }
+
+    const std::vector<Interface *> & getFastUpdateTable() const {
+        return fastUpdateTable;
+    }
+
+private:
+    std::vector<Interface *> updateTable;
+    std::vector<Interface *> fastUpdateTable;
+    uint32_t compiledGeneration;
+    std::vector<Interface *> compiledObjects;
+};
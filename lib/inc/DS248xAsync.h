@@ -0,0 +1,97 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "DS248xRegisters.h"
+#include "OneWireTransaction.h"
+
+/**
+ * Number of polls that find the bus master busy before the operation is considered failed.
+ * A 1-Wire reset, the longest operation, takes about 1.2 ms.
+ */
+#ifndef DS248X_ASYNC_MAX_BUSY_POLLS
+#define DS248X_ASYNC_MAX_BUSY_POLLS 1000
+#endif
+
+/**
+ * I2C access to a DS248x. Each call is a single I2C transfer, none of them wait for the 1-Wire bus.
+ */
+class DS248xI2C {
+public:
+    virtual ~DS248xI2C() = default;
+
+    virtual void writeCommand(uint8_t command) = 0;
+    virtual void writeCommand(uint8_t command, uint8_t parameter) = 0;
+
+    /**
+     * Reads the register selected by the read pointer.
+     */
+    virtual uint8_t readRegister() = 0;
+};
+
+/**
+ * Executes queued 1-Wire transactions on a DS248x without blocking.
+ *
+ * The blocking DS248x driver polls the busy flag of the bus master until each operation completes, which blocks the
+ * main loop for the complete transaction. This driver starts an operation and returns. Each call to poll() reads the
+ * status once, and when the master is no longer busy, finishes the operation and starts the next one. A poll costs a
+ * few short I2C transfers, so it can be called from a fast loop without delaying it.
+ */
+class DS248xAsync {
+public:
+    DS248xAsync(DS248xI2C & i2c_)
+        : i2c(i2c_), head(nullptr), tail(nullptr), busyPolls(0), inProgress(false), statusPointer(false) {}
+
+    /**
+     * Queues a transaction. It is executed after the transactions queued before it.
+     */
+    void submit(OneWireTransaction & transaction);
+
+    /**
+     * Advances the current transaction by at most one 1-Wire operation.
+     * @return true while transactions are queued.
+     */
+    bool poll();
+
+    bool idle() const {
+        return head == nullptr;
+    }
+
+private:
+    uint8_t readStatus();
+    uint8_t readData();
+
+    /**
+     * Processes the result of the operation that completed.
+     * @return false when the transaction completed.
+     */
+    bool finish(OneWireTransaction & t, uint8_t status);
+    void start(OneWireTransaction & t);
+    bool searchStep(OneWireTransaction & t, uint8_t status);
+    void complete(OneWireTransaction::Status status);
+
+    DS248xI2C & i2c;
+    OneWireTransaction * head;
+    OneWireTransaction * tail;
+    uint16_t busyPolls;
+    bool inProgress;        // an operation of the head transaction was started on the master
+    bool statusPointer;     // the read pointer selects the status register
+};
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Register and command definitions of the DS2482/DS2484 I2C to 1-Wire bridge,
+// shared by the blocking and the asynchronous driver.
+
+#define DS248X_CONFIG_APU (0x1<<0)
+#define DS248X_CONFIG_PPM (0x1<<1)
+#define DS248X_CONFIG_SPU (0x1<<2)
+#define DS2484_CONFIG_WS  (0x1<<3)
+
+#define DS248X_STATUS_BUSY 	(0x1<<0)
+#define DS248X_STATUS_PPD 	(0x1<<1)
+#define DS248X_STATUS_SD	(0x1<<2)
+#define DS248X_STATUS_LL	(0x1<<3)
+#define DS248X_STATUS_RST	(0x1<<4)
+#define DS248X_STATUS_SBR	(0x1<<5)
+#define DS248X_STATUS_TSB	(0x1<<6)
+#define DS248X_STATUS_DIR	(0x1<<7)
+
+// I2C commands
+#define DS248X_DRST	0xf0 // Device Reset
+#define DS248X_WCFG	0xd2 // Write Configuration
+#define DS248X_CHSL	0xc3 // Channel Select (DS248X-800 only)
+#define DS248X_SRP	0xe1 // Set Read Pointer
+#define DS248X_1WRS	0xb4 // 1-Wire Reset
+#define DS248X_1WWB	0xa5 // 1-Wire Write Byte
+#define DS248X_1WRB	0x96 // 1-Wire Read Byte
+#define DS248X_1WSB	0x87 // 1-Wire Single Bit
+#define DS248X_1WT	0x78 // 1-Wire Triplet
+#define DS248X_ADJP	0xc3 // Adjust OneWire port config (DS2484 only))
+
+// Read pointer codes for the Set Read Pointer command
+#define DS248X_PTR_STATUS 0xf0
+#define DS248X_PTR_READ 0xe1
+#define DS248X_PTR_CONFIG 0xc3
+#define DS248X_PTR_PORTCONFIG 0xb4 //DS2484 only
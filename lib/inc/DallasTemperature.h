@@ -202,10 +202,8 @@ class DallasTemperature
   
 #endif
   
-#if REQUIRESWHOLEBUSOPS
-  // sends command for all devices on the bus to perform a temperature conversion 
+  // sends command for all devices on the bus to perform a temperature conversion
   void requestTemperatures(void);
-#endif  
    
   // sends command for one device to perform a temperature conversion by address
   void requestTemperaturesByAddress(const uint8_t*);
@@ -220,6 +218,10 @@ class DallasTemperature
   int16_t getTemp(const uint8_t* address) { return getTempRaw(address); }
   
   int16_t getTempRaw(const uint8_t* deviceAddress);  // changed return type from uint32 to int16 (Elco, BrewPi)
+
+  // returns temperature raw value and updates resolution from the same scratchpad read.
+  // resolution is left unchanged when the scratchpad cannot be read
+  int16_t getTempRaw(const uint8_t* deviceAddress, uint8_t& resolution);
   
 #if REQUIRESTEMPCONVERSION
   // returns temperature in degrees C
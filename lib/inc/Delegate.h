@@ -45,6 +45,13 @@ public:
         return delegate.getLookup();
     }
 
+    /**
+     * Returns the object that calls are currently forwarded to
+     */
+    T * getDelegate() const {
+        return delegate.get();
+    }
+
 protected:
     RefTo<T> delegate;
 };
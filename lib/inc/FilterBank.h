@@ -0,0 +1,99 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "temperatureFormats.h"
+#include "FilterCascaded.h"
+
+/*
+ * FilterBank filters multiple channels with the same cascaded filter as FilterCascaded, with NUM_SECTIONS sections.
+ *
+ * The filter state is stored as a structure of arrays: for each section and each tap, the values of all channels are
+ * stored next to each other. All channels are advanced at once with add(), which processes multiple channels per
+ * instruction when SIMD is available (SSE2/AVX2 on the host). On targets without SIMD, the same kernel runs one
+ * channel at a time, using the saturating DSP instructions when the core has them.
+ *
+ * Results are bit-exact with FilterCascaded, including saturation of temp_precise_t on overflow.
+ * All channels share the same filtering setting. To sweep filter settings, use one bank per setting.
+ */
+class FilterBank
+{
+public:
+    FilterBank(uint8_t nrOfChannels, uint8_t bValue = 2);
+    ~FilterBank() = default;
+
+    // initializes all sections of all channels to val
+    void init(temp_precise_t val = temp_precise_t(0.0));
+
+    // initializes all sections of a single channel to val
+    void init(uint8_t channel, temp_precise_t val);
+
+    // b is limited to 13, so the largest shift (a = 2b + 4) still fits in 32 bits
+    void setFiltering(uint8_t bValue);
+
+    uint8_t getFiltering() const {
+        return b;
+    }
+
+    uint8_t size() const {
+        return channels;
+    }
+
+    // adds one value for each channel and advances all channels. values should hold size() elements
+    void add(const temp_precise_t * values);
+
+    // adds one value for each channel and advances all channels. values should hold size() elements
+    void add(const temp_t * values);
+
+    temp_precise_t readInput(uint8_t channel) const; // returns the most recent filter input of channel
+
+    temp_precise_t readOutput(uint8_t channel) const; // returns the output of the last section of channel
+
+    temp_precise_t readPrevOutput(uint8_t channel) const; // returns the previous output of the last section of channel
+
+private:
+    enum {
+        X = 0, // index of filter input taps
+        Y = 1, // index of filter output taps
+        TAPS = 3
+    };
+
+    // runs all sections for the values in input
+    void advance();
+
+    // pointer to the values of all channels, for a tap delayed by 'delay' samples
+    int32_t * tap(uint8_t section, uint8_t xy, uint8_t delay){
+        return &state[((section * 2 + xy) * TAPS + (head + delay) % TAPS) * stride];
+    }
+
+    const int32_t * tap(uint8_t section, uint8_t xy, uint8_t delay) const {
+        return &state[((section * 2 + xy) * TAPS + (head + delay) % TAPS) * stride];
+    }
+
+    uint8_t channels;
+    uint16_t stride; // number of channels, rounded up to a multiple of the SIMD width
+    uint8_t a;
+    uint8_t b;
+    uint8_t head; // slot of the most recent sample. Taps rotate instead of being copied on each add
+    std::vector<int32_t> state;
+    std::vector<int32_t> input; // padded copy of the input values
+};
@@ -0,0 +1,183 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "Platform.h"
+
+/**
+ * Set BREWPI_PROFILING to 1 in Platform.h to measure where the control loop spends its time.
+ * When it is 0, the profiler and all hooks compile to nothing.
+ */
+#ifndef BREWPI_PROFILING
+#define BREWPI_PROFILING 0
+#endif
+
+#if BREWPI_PROFILING
+
+#include <stdint.h>
+#include "Ticks.h"
+
+#ifndef PROFILER_MAX_OBJECTS
+#define PROFILER_MAX_OBJECTS 32
+#endif
+
+/**
+ * Histogram with power of 2 buckets. Bucket 0 counts zero, bucket i counts values in [2^(i-1), 2^i).
+ * The last bucket also counts everything larger. Counts saturate instead of wrapping.
+ */
+class TimingHistogram {
+public:
+    static const uint8_t BUCKETS = 16;
+
+    TimingHistogram() {
+        clear();
+    }
+
+    void add(uint32_t value);
+
+    void clear();
+
+    uint16_t bucket(uint8_t i) const {
+        return buckets[i];
+    }
+
+    uint32_t count() const {
+        return count_;
+    }
+
+    uint32_t max() const {
+        return max_;
+    }
+
+    static uint8_t bucketFor(uint32_t value);
+
+private:
+    uint16_t buckets[BUCKETS];
+    uint32_t count_;
+    uint32_t max_;
+};
+
+enum class ProfilePhase : uint8_t {
+    Prepare,
+    Update,
+    FastUpdate
+};
+
+/**
+ * Collects the time spent in each object's update functions, the period of the main loop and how late PWM edges are.
+ *
+ * Objects are identified by address. The first PROFILER_MAX_OBJECTS object/phase pairs get an entry, time spent in
+ * other objects is counted in the overflow histogram.
+ */
+class LoopProfiler {
+public:
+    struct Entry {
+        const void * object;
+        ProfilePhase phase;
+        TimingHistogram micros;
+    };
+
+    LoopProfiler() {
+        clear();
+    }
+
+    /**
+     * Called at the start of each iteration of the main loop. Records the time since the previous call.
+     */
+    void loopStarted();
+
+    void record(const void * object, ProfilePhase phase, uint32_t micros);
+
+    /**
+     * Records how many milliseconds a PWM edge was later than scheduled. Early edges are counted as 0.
+     */
+    void recordPwmLateness(int32_t millis);
+
+    void clear();
+
+    uint8_t entryCount() const {
+        return used;
+    }
+
+    const Entry & entry(uint8_t i) const {
+        return entries[i];
+    }
+
+    const TimingHistogram & overflow() const {
+        return overflow_;
+    }
+
+    const TimingHistogram & loopPeriods() const {
+        return loopPeriods_;
+    }
+
+    const TimingHistogram & pwmLateness() const {
+        return pwmLateness_;
+    }
+
+private:
+    Entry entries[PROFILER_MAX_OBJECTS];
+    uint8_t used;
+    TimingHistogram overflow_;
+    TimingHistogram loopPeriods_;
+    TimingHistogram pwmLateness_;
+    ticks_micros_t lastLoopStart;
+    bool looping;
+};
+
+/**
+ * Platforms that run controllers on several threads, like the simulations on the test platform, define
+ * PROFILER_THREAD_LOCAL as thread_local, so that each thread profiles its own controller, like it has its own ticks.
+ */
+#ifndef PROFILER_THREAD_LOCAL
+#define PROFILER_THREAD_LOCAL
+#endif
+
+extern PROFILER_THREAD_LOCAL LoopProfiler profiler;
+
+/**
+ * Records the time from construction to destruction for an object and phase.
+ */
+class ProfileScope {
+public:
+    ProfileScope(const void * object_, ProfilePhase phase_)
+        : object(object_), phase(phase_), start(ticks.micros()) {}
+
+    ~ProfileScope() {
+        profiler.record(object, phase, ticks.micros() - start);
+    }
+
+private:
+    const void * object;
+    ProfilePhase phase;
+    ticks_micros_t start;
+};
+
+#define PROFILE_OBJECT(object, phase) ProfileScope profileScope_(object, phase)
+#define PROFILE_LOOP_STARTED() profiler.loopStarted()
+#define PROFILE_PWM_LATENESS(millis) profiler.recordPwmLateness(millis)
+
+#else
+
+#define PROFILE_OBJECT(object, phase)
+#define PROFILE_LOOP_STARTED()
+#define PROFILE_PWM_LATENESS(millis)
+
+#endif
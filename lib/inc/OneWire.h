@@ -49,18 +49,31 @@
 #include <inttypes.h>
 #include "OneWireImpl.h"
 
+class OneWireConversionScheduler;
+
 class OneWire {
 public:
     // Argument is PinNr for OneWirePin device, address for bus master IC
 
-    OneWire(uint8_t pa) : driver(pa){
+    OneWire(uint8_t pa) : scheduler(nullptr), driver(pa){
         // base class OneWireLowLevelInterface configures pin or bus master IC
 #if ONEWIRE_SEARCH
         reset_search();
 #endif
     }
 
+    ~OneWire();
+
+    OneWire(const OneWire&) = delete;
+    OneWire& operator=(const OneWire&) = delete;
+
+    // Returns the scheduler for temperature conversions on this bus. It is created on first use and
+    // destroyed with the bus, so the sensors using it must be destroyed first.
+    OneWireConversionScheduler & conversionScheduler();
+
 private:
+    OneWireConversionScheduler * scheduler;
+
 #if ONEWIRE_SEARCH
     // global search state
     uint8_t ROM_NO[8];
@@ -121,6 +134,10 @@ public:
     // get garbage.  The order is deterministic. You will always get
     // the same devices in the same order.
     uint8_t search(uint8_t *newAddr);
+
+    // Check if the device with the given address responds. Takes a reset and a single search pass along its address,
+    // without changing the state of search().
+    bool verify(const uint8_t rom[8]);
 #endif
 
 #if ONEWIRE_CRC
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "DallasTemperature.h"
+#include "Ticks.h"
+
+class OneWire;
+
+/**
+ * Schedules the temperature conversions of all temperature sensors on a OneWire bus.
+ *
+ * Instead of addressing every sensor with its own Convert T command, a single Skip ROM Convert T starts the conversion
+ * on all sensors at once. The conversion time follows from the resolution of each sensor, so the bus is ready when
+ * the slowest sensor is. The scratchpads of all sensors are then read back in one pass, after which each sensor
+ * picks up its own value.
+ */
+class OneWireConversionScheduler {
+public:
+    /**
+     * A sensor registered with the scheduler of its bus.
+     */
+    class Client {
+    public:
+        Client(const uint8_t* address_)
+            : next(nullptr), address(address_), raw(DEVICE_DISCONNECTED_RAW), resolution(12) {}
+
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+
+        uint8_t getResolution() const {
+            return resolution;
+        }
+
+    private:
+        Client* next;
+        const uint8_t* address;
+        int16_t raw;            // temperature read back after the last conversion
+        uint8_t resolution;     // resolution found in the last scratchpad that was read
+
+        friend class OneWireConversionScheduler;
+    };
+
+    /**
+     * Returns the scheduler for the given bus. It is owned by the bus, see OneWire::conversionScheduler().
+     */
+    static OneWireConversionScheduler & forBus(OneWire* bus);
+
+    void add(Client & client);
+    void remove(Client & client);
+
+    /**
+     * Starts a conversion on all sensors on the bus, unless a conversion is in progress.
+     * The results of a completed conversion that were not read yet are read back first.
+     * @return the number of milliseconds until the conversion of all sensors is complete.
+     */
+    uint16_t requestConversion();
+
+    /**
+     * Returns the raw temperature of a sensor, or DEVICE_DISCONNECTED_RAW when it could not be read.
+     * When a conversion completed since the last read, the scratchpads of all sensors are read first.
+     * While a conversion is in progress, the result of the previous conversion is returned.
+     */
+    int16_t read(Client & client);
+
+    /**
+     * Stores a reading of a sensor that was taken outside of a scheduled conversion, such as when the sensor is
+     * initialized. read() returns it until the next conversion completes.
+     */
+    void store(Client & client, int16_t raw);
+
+    /**
+     * @return true while a conversion is in progress.
+     */
+    bool busy();
+
+    /**
+     * The number of Convert T commands sent on the bus.
+     */
+    uint32_t conversionsRequested() const {
+        return conversions;
+    }
+
+    /**
+     * The conversion time of a DS18B20 at the given resolution (9-12 bits).
+     */
+    static uint16_t conversionMillis(uint8_t resolution);
+
+private:
+    OneWireConversionScheduler(OneWire* bus_);
+    friend class OneWire;
+
+    void readAll();
+
+    OneWire* bus;
+    DallasTemperature sensors;
+    Client* clients;
+    ticks_millis_t started;
+    uint32_t conversions;
+    uint16_t duration;      // conversion time of the slowest sensor
+    bool converting;
+};
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "OneWireLowLevelInterface.h"
+
+/**
+ * Model of a single 1-Wire slave at bit level.
+ *
+ * The base class implements the ROM layer: reset/presence, read ROM, match ROM, skip ROM and search ROM.
+ * Once a device is selected, the first byte written is passed to functionCommand(). Bytes written after that go to
+ * functionWrite() and each byte read by the master is taken from functionRead(). Bits are sent LSB first.
+ */
+class OneWireDeviceModel {
+public:
+    /**
+     * @param family family code, the first byte of the ROM
+     * @param serial 48 bit serial number, the CRC byte is calculated
+     */
+    OneWireDeviceModel(uint8_t family, uint64_t serial);
+    virtual ~OneWireDeviceModel() = default;
+
+    const uint8_t * getRom() const {
+        return rom;
+    }
+
+    /**
+     * A disconnected device does not respond to anything on the bus and loses its volatile state when it is connected
+     * again, like a device that is unplugged and plugged back in.
+     */
+    void setConnected(bool connected);
+    bool isConnected() const {
+        return connected;
+    }
+
+    /**
+     * Restores the state the device has after power up, as after a brown out.
+     */
+    virtual void powerOnReset();
+
+    // bus side, called by OneWireBusEmulator
+    bool resetPulse(); // returns true when the device answers with a presence pulse
+    void writeSlot(bool bit);
+    bool readSlot(); // returns false when the device pulls the bus low
+
+protected:
+    virtual void functionCommand(uint8_t command) = 0;
+    virtual void functionWrite(uint8_t data) {}
+    virtual uint8_t functionRead() {
+        return 0xFF;
+    }
+
+    /**
+     * Stops responding until the next reset.
+     */
+    void idle();
+
+private:
+    enum class State : uint8_t {
+        Idle,
+        RomCommand,
+        MatchRom,
+        ReadRom,
+        SearchRom,
+        Function,
+        FunctionData
+    };
+
+    uint8_t rom[8];
+    bool connected;
+    State state;
+    uint8_t bitIndex; // position within the current byte or the ROM
+    uint8_t searchPhase; // 0: send bit, 1: send complement, 2: receive direction
+    bool matching;
+    uint8_t writeShift;
+    uint8_t writeBits;
+    uint8_t readShift;
+    uint8_t readBits;
+
+    bool romBit(uint8_t index) const {
+        return (rom[index / 8] >> (index % 8)) & 1;
+    }
+    void romCommand(uint8_t command);
+};
+
+/**
+ * DS18B20 temperature sensor. Conversions complete immediately.
+ * Supports convert T, read/write/copy scratchpad, recall EEPROM and read power supply.
+ */
+class DS18B20Model final : public OneWireDeviceModel {
+public:
+    DS18B20Model(uint64_t serial);
+
+    /**
+     * Sets the temperature that the next conversion will measure.
+     * @param temperature in 1/16 degree Celsius
+     */
+    void setTemperatureRaw(int16_t temperature){
+        measured = temperature;
+    }
+
+    void powerOnReset() override;
+
+    uint32_t getConversions() const {
+        return conversions;
+    }
+
+    const uint8_t * getScratchpad() const {
+        return scratchpad;
+    }
+
+protected:
+    void functionCommand(uint8_t command) override;
+    void functionWrite(uint8_t data) override;
+    uint8_t functionRead() override;
+
+private:
+    uint8_t scratchpad[9];
+    uint8_t eeprom[3]; // TH, TL, configuration
+    int16_t measured;
+    uint32_t conversions;
+    uint8_t command;
+    uint8_t index;
+
+    void updateCrc();
+};
+
+/**
+ * DS2413 dual channel addressable switch.
+ * Supports PIO access read and PIO access write.
+ */
+class DS2413Model final : public OneWireDeviceModel {
+public:
+    DS2413Model(uint64_t serial);
+
+    /**
+     * Output latches, bit 0 for PIOA and bit 1 for PIOB. 0 means the output transistor is on.
+     */
+    uint8_t getLatches() const {
+        return latches;
+    }
+
+    /**
+     * Sets the level that external circuits drive the pins to when the output transistor is off.
+     */
+    void setInputs(uint8_t levels){
+        inputs = levels & 0x03;
+    }
+
+    void powerOnReset() override;
+
+protected:
+    void functionCommand(uint8_t command) override;
+    void functionWrite(uint8_t data) override;
+    uint8_t functionRead() override;
+
+private:
+    uint8_t latches;
+    uint8_t inputs;
+    uint8_t command;
+    uint8_t index;
+    uint8_t written;
+    bool acknowledged;
+
+    uint8_t status() const;
+};
+
+/**
+ * DS2408 8 channel addressable switch.
+ * Supports read PIO registers, channel access read, channel access write and reset activity latches.
+ */
+class DS2408Model final : public OneWireDeviceModel {
+public:
+    DS2408Model(uint64_t serial);
+
+    uint8_t getLatches() const {
+        return registers[LATCH];
+    }
+
+    /**
+     * Sets the level that external circuits drive the pins to when the output transistor is off.
+     */
+    void setInputs(uint8_t levels);
+
+    void powerOnReset() override;
+
+protected:
+    void functionCommand(uint8_t command) override;
+    void functionWrite(uint8_t data) override;
+    uint8_t functionRead() override;
+
+private:
+    // registers at address 0x88 to 0x8F
+    static const uint8_t PIO = 0;
+    static const uint8_t LATCH = 1;
+    static const uint8_t ACTIVITY = 2;
+    static const uint8_t STATUS = 5;
+    uint8_t registers[8];
+    uint8_t inputs;
+
+    uint8_t command;
+    uint8_t index;
+    uint8_t address;
+    uint8_t written;
+    uint16_t crc;
+    uint8_t crcBytes[2];
+    bool acknowledged;
+
+    void updatePio();
+    uint8_t withCrc(uint8_t data);
+};
+
+/**
+ * A 1-Wire bus with device models, for running the OneWire drivers on Linux without hardware.
+ *
+ * The bus keeps count of reset pulses and time slots and of the bus time they take at standard speed, so the time a
+ * transaction takes on real hardware is known. Faults can be injected: read errors, devices that disconnect and
+ * devices that reset.
+ *
+ * A bus is attached to a pin number. OneWireEmulator drivers created for that pin talk to this bus.
+ */
+class OneWireBusEmulator {
+public:
+    // standard speed timing, recommended values from Maxim application note 126
+    static const uint32_t RESET_MICROS = 960; // 480 us reset pulse, 480 us presence detect and recovery
+    static const uint32_t SLOT_MICROS = 70; // 60 us slot, 10 us recovery
+
+    struct Statistics {
+        uint32_t resets;
+        uint32_t writeSlots;
+        uint32_t readSlots;
+        uint64_t micros; // bus time used
+    };
+
+    OneWireBusEmulator(uint8_t pin);
+    ~OneWireBusEmulator();
+
+    OneWireBusEmulator(const OneWireBusEmulator &) = delete;
+    OneWireBusEmulator & operator=(const OneWireBusEmulator &) = delete;
+
+    /**
+     * Connects a device to the bus. The device is not owned by the bus.
+     */
+    void add(OneWireDeviceModel & device);
+    void remove(OneWireDeviceModel & device);
+
+    /**
+     * Resets all devices to their power up state.
+     */
+    void powerCycle();
+
+    /**
+     * Inverts the value of a read slot, to cause a CRC error.
+     * @param slot number of read slots to let pass first, 0 corrupts the next read slot
+     */
+    void injectReadError(uint32_t slot);
+
+    const Statistics & getStatistics() const {
+        return statistics;
+    }
+    void resetStatistics();
+
+    // master side
+    bool reset();
+    void writeSlot(bool bit);
+    bool readSlot();
+
+    /**
+     * Returns the bus attached to a pin, or nullptr.
+     */
+    static OneWireBusEmulator * onPin(uint8_t pin);
+
+private:
+    uint8_t pin;
+    std::vector<OneWireDeviceModel *> devices;
+    std::vector<uint32_t> readErrors; // read slot numbers to invert
+    Statistics statistics;
+};
+
+/**
+ * OneWire driver for Linux that talks to the OneWireBusEmulator attached to its pin.
+ * Without an emulated bus on the pin, it behaves like OneWireNull: no presence pulse and all reads return 0.
+ */
+class OneWireEmulator final : public OneWireLowLevelInterface {
+public:
+    OneWireEmulator(uint8_t pin_) : pin(pin_) {}
+
+    bool init() override {
+        return true;
+    }
+
+    uint8_t pinNr() override {
+        return pin;
+    }
+
+    bool reset() override;
+    void write(uint8_t v, uint8_t power = 0) override;
+    uint8_t read() override;
+    void write_bit(uint8_t v) override;
+    uint8_t read_bit() override;
+
+    /**
+     * Reads a bit and its complement and writes the search direction, as in a step of the search ROM algorithm.
+     * When the two bits read differ, all remaining devices agree and the direction is the first bit read.
+     */
+    void search_triplet(uint8_t * search_direction, uint8_t * id_bit, uint8_t * cmp_id_bit);
+
+private:
+    uint8_t pin;
+};
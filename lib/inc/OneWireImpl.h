@@ -14,6 +14,12 @@ typedef DS248x OneWireDriver;
 
 typedef OneWirePin OneWireDriver;
 
+#elif defined(ONEWIRE_EMULATED)
+
+#include "OneWireEmulator.h"
+
+typedef OneWireEmulator OneWireDriver;
+
 #elif defined(ONEWIRE_NULL)
 
 #include "OneWireNull.h"
@@ -23,6 +23,7 @@
 #include "TempSensor.h"
 #include "OneWireAddress.h"
 #include "DallasTemperature.h"
+#include "OneWireConversionScheduler.h"
 #include "Ticks.h"
 
 class DallasTemperature;
@@ -40,25 +41,29 @@ public:
 	 * /param calibration	A temperature value that is added to all readings. This can be used to calibrate the sensor.	 
 	 */
 	OneWireTempSensor(OneWire* bus, DeviceAddress address, temp_t calibrationOffset)
-	: sensor(bus)
+	: sensor(bus), scheduler(OneWireConversionScheduler::forBus(bus)), conversion(settings.sensorAddress)
     {
         memcpy(settings.sensorAddress, address, sizeof(DeviceAddress));
         settings.calibrationOffset = calibrationOffset;
         state.connected = true; // assume connected upon creation, because address will be set just after this construction
         state.cachedValue = TEMP_SENSOR_DISCONNECTED;
+        scheduler.add(conversion);
         init();
     };
 	
 	OneWireTempSensor(OneWire* bus)
-    : sensor(bus) {
+    : sensor(bus), scheduler(OneWireConversionScheduler::forBus(bus)), conversion(settings.sensorAddress) {
         memset(settings.sensorAddress, 0, sizeof(DeviceAddress));
         settings.calibrationOffset = temp_t(0.0);
         state.connected = true; // assume connected upon creation, because address will be set just after this construction
         state.cachedValue = TEMP_SENSOR_DISCONNECTED;
+        scheduler.add(conversion);
         init();
     };
 
-	~OneWireTempSensor() = default;
+	~OneWireTempSensor() {
+        scheduler.remove(conversion);
+    }
 
     /**
      * Accept function for visitor pattern
@@ -75,11 +80,16 @@ public:
 	bool init() override final ;
 	temp_t read() const override final ; // return cached value
 	void update() override final ; // read from hardware sensor
+
+	/**
+	 * Starts a conversion on all sensors on the bus of this sensor, unless one is already in progress.
+	 * @return the number of milliseconds until the conversion is complete, after which update() reads the new value.
+	 */
+	uint16_t requestConversion();
 	
 	private:
 
 	void setConnected(bool connected);
-	void requestConversion();
 	void waitForConversion()
 	{
 		wait.millis(750);
@@ -91,13 +101,21 @@ public:
 	 */
 	temp_t readAndConstrainTemp();
 
+	/**
+	 * Converts a raw DS18B20 reading in 1/16 degree to temp_t and applies the calibration offset.
+	 */
+	temp_t fromRaw(int16_t tempRaw) const;
+
 	DallasTemperature sensor;
+	OneWireConversionScheduler & scheduler;
 
 	struct Settings {
         DeviceAddress sensorAddress;
         temp_t calibrationOffset;
 	} settings;
 
+	OneWireConversionScheduler::Client conversion;
+
 	struct State {
         temp_t cachedValue;
         bool connected;
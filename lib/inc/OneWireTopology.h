@@ -0,0 +1,130 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include "Ticks.h"
+
+class OneWire;
+
+/**
+ * Keeps track of the devices on a OneWire bus without searching the whole bus each time the devices are listed.
+ *
+ * Each call to update() does at most one bus transaction, at most once per step interval:
+ * - a presence check of a known device that has not been seen for the check interval, with OneWire::verify()
+ * - otherwise, one step of a background search. A full search pass starts every search interval.
+ *
+ * A device is added when the search finds it and removed when it misses several presence checks in a row.
+ * The listener is called for each addition and removal.
+ */
+class OneWireTopology {
+public:
+    static const uint8_t MAX_DEVICES = 16;
+    static const uint8_t MISSES_TO_REMOVE = 3;
+
+    enum class Change : uint8_t {
+        Added,
+        Removed
+    };
+
+    typedef std::function<void(const OneWireTopology & topology, const uint8_t * address, Change change)> Listener;
+
+    struct Statistics {
+        uint32_t presenceChecks;
+        uint32_t searchSteps;
+    };
+
+    /**
+     * @param bus the bus to track, its search state is used by the background search
+     * @param stepInterval minimum time between two bus transactions started by update()
+     * @param checkInterval time after which a known device that was not seen is checked
+     * @param searchInterval time between the starts of two background search passes
+     */
+    OneWireTopology(OneWire & bus,
+                    ticks_millis_t stepInterval = 250,
+                    ticks_millis_t checkInterval = 5000,
+                    ticks_millis_t searchInterval = 60000);
+
+    void setListener(Listener listener_){
+        listener = listener_;
+    }
+
+    /**
+     * Does the next scheduled bus transaction if one is due. Call it from the main loop.
+     */
+    void update(ticks_millis_t now);
+
+    /**
+     * Searches the whole bus now and removes known devices that are not found and fail a presence check.
+     * Use before listing devices to a user, who expects a device that was just plugged in to be there.
+     */
+    void refresh(ticks_millis_t now);
+
+    uint8_t count() const {
+        return numDevices;
+    }
+
+    /**
+     * Copies the address of a device.
+     * @return false when index is not below count()
+     */
+    bool address(uint8_t index, uint8_t * address) const;
+
+    /**
+     * @return the time the device was last found or checked, 0 if the device is not known
+     */
+    ticks_millis_t lastSeen(const uint8_t * address) const;
+
+    const Statistics & getStatistics() const {
+        return statistics;
+    }
+
+private:
+    struct Device {
+        uint8_t address[8];
+        ticks_millis_t lastSeen;
+        uint8_t misses; // consecutive failed presence checks
+        bool found; // found in the current search pass
+    };
+
+    OneWire & bus;
+    ticks_millis_t stepInterval;
+    ticks_millis_t checkInterval;
+    ticks_millis_t searchInterval;
+
+    Device devices[MAX_DEVICES];
+    uint8_t numDevices;
+    uint8_t nextCheck; // round robin start for presence checks
+    bool searching; // a search pass is in progress
+    bool searched; // at least one search pass was started
+    ticks_millis_t lastStep;
+    ticks_millis_t lastSearchStart;
+    Listener listener;
+    Statistics statistics;
+
+    int8_t find(const uint8_t * address) const;
+    void seen(const uint8_t * address, ticks_millis_t now);
+    void remove(uint8_t index);
+    bool checkPresence(uint8_t index, ticks_millis_t now);
+    bool searchStep(ticks_millis_t now);
+    void startSearch(ticks_millis_t now);
+    void notify(const uint8_t * address, Change change);
+};
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Maximum number of bytes a transaction writes to the bus: a match ROM command, the ROM and a few bytes for the device.
+ */
+#ifndef ONEWIRE_TRANSACTION_MAX_WRITE
+#define ONEWIRE_TRANSACTION_MAX_WRITE 13
+#endif
+
+/**
+ * State of a 1-Wire search that is kept between search transactions, like the search state in OneWire.
+ */
+struct OneWireSearch {
+    OneWireSearch() {
+        restart();
+    }
+
+    /**
+     * Starts the next search from the first device.
+     */
+    void restart() {
+        for (uint8_t i = 0; i < 8; i++) {
+            rom[i] = 0;
+        }
+        lastDiscrepancy = 0;
+        lastZero = 0;
+        lastDevice = false;
+        found = false;
+    }
+
+    uint8_t rom[8];         // address found by the last search transaction
+    uint8_t lastDiscrepancy;
+    uint8_t lastZero;       // last discrepancy where 0 was chosen in the search in progress
+    bool lastDevice;
+    bool found;             // true when the last search transaction found a device
+};
+
+/**
+ * A sequence of 1-Wire operations that is executed without blocking by an asynchronous bus master.
+ *
+ * A transaction optionally starts with a reset, then writes bytes, and then either reads bytes or searches for the next
+ * device. The transaction and its read buffer must stay alive until it completes. On completion, the callback is
+ * invoked. The transaction is no longer queued at that point, so the callback can submit it again.
+ */
+class OneWireTransaction {
+public:
+    enum class Status : uint8_t {
+        Idle,       // not submitted
+        Pending,    // queued or in progress
+        Done,
+        NoPresence, // no device responded to the reset
+        Timeout,    // the bus master stayed busy
+        Invalid     // too many bytes were written to the transaction
+    };
+
+    typedef void (*Callback)(OneWireTransaction & transaction, void * context);
+
+    OneWireTransaction(Callback callback_ = nullptr, void * context_ = nullptr)
+        : next(nullptr), callback(callback_), context(context_) {
+        clear();
+    }
+
+    /**
+     * Removes all operations, so the transaction can be reused.
+     */
+    void clear() {
+        writeCount = 0;
+        readData = nullptr;
+        readCount = 0;
+        searchState = nullptr;
+        doReset = false;
+        overflow = false;
+        position = 0;
+        status_ = Status::Idle;
+    }
+
+    OneWireTransaction & reset() {
+        doReset = true;
+        return *this;
+    }
+
+    OneWireTransaction & write(uint8_t b) {
+        if (writeCount < ONEWIRE_TRANSACTION_MAX_WRITE) {
+            writeData[writeCount++] = b;
+        } else {
+            overflow = true;
+        }
+        return *this;
+    }
+
+    OneWireTransaction & select(const uint8_t * rom) {
+        write(0x55);
+        for (uint8_t i = 0; i < 8; i++) {
+            write(rom[i]);
+        }
+        return *this;
+    }
+
+    OneWireTransaction & skip() {
+        return write(0xCC);
+    }
+
+    OneWireTransaction & read(uint8_t * buffer, uint8_t count) {
+        readData = buffer;
+        readCount = count;
+        return *this;
+    }
+
+    /**
+     * Finds the next device on the bus. The result is stored in the search state.
+     */
+    OneWireTransaction & search(OneWireSearch & state) {
+        searchState = &state;
+        return reset().write(0xF0);
+    }
+
+    Status status() const {
+        return status_;
+    }
+
+    bool completed() const {
+        return status_ != Status::Pending;
+    }
+
+    void onComplete(Callback callback_, void * context_) {
+        callback = callback_;
+        context = context_;
+    }
+
+private:
+    friend class DS248xAsync;
+
+    enum class Operation : uint8_t {
+        Reset, Write, Read, Triplet, None
+    };
+
+    uint8_t operationCount() const {
+        return uint8_t((doReset ? 1 : 0) + writeCount + (searchState ? 64 : readCount));
+    }
+
+    /**
+     * The kind of the operation at the current position.
+     */
+    Operation operation() const {
+        uint8_t p = position;
+        if (doReset) {
+            if (p == 0) {
+                return Operation::Reset;
+            }
+            p--;
+        }
+        if (p < writeCount) {
+            return Operation::Write;
+        }
+        p = uint8_t(p - writeCount);
+        if (searchState) {
+            return p < 64 ? Operation::Triplet : Operation::None;
+        }
+        return p < readCount ? Operation::Read : Operation::None;
+    }
+
+    /**
+     * Index of the current operation within its kind.
+     */
+    uint8_t index() const {
+        uint8_t p = doReset ? uint8_t(position - 1) : position;
+        return operation() == Operation::Write ? p : uint8_t(p - writeCount);
+    }
+
+    OneWireTransaction * next;
+    Callback callback;
+    void * context;
+    uint8_t writeData[ONEWIRE_TRANSACTION_MAX_WRITE];
+    uint8_t writeCount;
+    uint8_t * readData;
+    uint8_t readCount;
+    OneWireSearch * searchState;
+    bool doReset;
+    bool overflow;
+    uint8_t position;   // index of the next operation
+    Status status_;
+};
@@ -63,6 +63,14 @@ class Pid final : public ControllerInterface, public PidMixin
 
         void setDerivativeFilter(uint8_t b);
 
+        ProcessValue & getInput() const {
+            return input;
+        }
+
+        ProcessValue & getOutput() const {
+            return output;
+        }
+
         void setActuatorIsNegative(bool setting){
             actuatorIsNegative = setting;
         }
@@ -42,13 +42,20 @@ extern template TempSensor* asInterface<TempSensor>(Interface*);
 extern template SetPoint* asInterface<SetPoint>(Interface*);
 
 
+/**
+ * RefToGeneric holds a lookup function to find its target.
+ * RefTo<T> caches the resolved target, because a lookup and the cast to the interface are relatively expensive and
+ * are done several times per update. The cache is valid for one topology generation only.
+ * Code that changes which object a lookup returns, like installing or removing a device, must call invalidateAll().
+ */
 class RefToGeneric {
 public:
-    RefToGeneric(){};
-    RefToGeneric(std::function<Interface* ()> lookup) : lookup(std::move(lookup)){};
+    RefToGeneric() : cachedGeneration(0) {};
+    RefToGeneric(std::function<Interface* ()> lookup) : lookup(std::move(lookup)), cachedGeneration(0) {};
     ~RefToGeneric() = default;
     void setLookup(std::function<Interface* ()> newLookup){
         lookup = newLookup;
+        cachedGeneration = 0; // force new lookup on next access
     }
     std::function<Interface* ()>  getLookup(){
         return lookup;
@@ -60,21 +67,53 @@ public:
         return *get();
     }
 
+    /**
+     * Invalidates the cached targets of all references, by starting a new topology generation.
+     */
+    static void invalidateAll(){
+        generation++;
+        if(generation == 0){
+            generation = 1; // 0 is reserved for 'not cached'
+        }
+    }
+
+    static uint32_t getGeneration(){
+        return generation;
+    }
+
 protected:
     // callable loopup object, must implement () operator
     // and hold information required for lookup
     std::function<Interface* ()> lookup;
+
+    // generation in which the cached target was resolved, 0 if not resolved yet
+    mutable uint32_t cachedGeneration;
+
+    static uint32_t generation;
 };
 
 template<class T>
 class RefTo : public RefToGeneric {
 public:
-    RefTo(){};
-    RefTo(std::function<Interface* ()> lookup) : RefToGeneric(lookup){};
+    RefTo() : cachedTarget(nullptr) {};
+    RefTo(std::function<Interface* ()> lookup) : RefToGeneric(lookup), cachedTarget(nullptr) {};
     ~RefTo() = default;
 
 
     T* get() const {
+        if(cachedGeneration != generation){
+            cachedTarget = resolve();
+            cachedGeneration = generation;
+        }
+        return cachedTarget;
+    }
+
+    T& operator()() const {
+        return *get();
+    }
+
+private:
+    T* resolve() const {
         T* specializedTarget = nullptr;
         if(lookup){
             Interface* target = lookup();
@@ -85,9 +124,7 @@ public:
         return (specializedTarget) ? specializedTarget : defaultTarget<T>();
     }
 
-    T& operator()() const {
-        return *get();
-    }
+    mutable T* cachedTarget;
 };
 
 // simple lookup class that just keeps a pointer to its target
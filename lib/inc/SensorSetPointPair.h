@@ -49,6 +49,14 @@ public:
         v.visit(*this);
     }
 
+    TempSensor & getSensor() const {
+        return sensor;
+    }
+
+    SetPoint & getSetPoint() const {
+        return setPoint;
+    }
+
     void update() final {};
     void fastUpdate() final {};
 
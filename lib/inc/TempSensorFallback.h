@@ -55,6 +55,14 @@ public:
         return onBackupSensor ? backup : main;
     }
 
+    TempSensor & getMain() const {
+        return main;
+    }
+
+    TempSensor & getBackup() const {
+        return backup;
+    }
+
     /**
      * Check if sensor is connected
      * @return bool: true if active sensor is connected
@@ -46,6 +46,8 @@
 #include <boost/operators.hpp>
 #include <boost/concept_check.hpp>
 #include <limits>
+#include <type_traits>
+#include <stdint.h>
 #ifndef _USE_MATH_DEFINES
 #define _USE_MATH_DEFINES
 #define __FPML_DEFINED_USE_MATH_DEFINES__
@@ -53,6 +55,14 @@
 #include <math.h>
 #include <errno.h>
 
+// Saturating add and subtract use the compiler's overflow builtins when they are available. These compile to an
+// add and a branch on the overflow flag, instead of comparing both operands against the limits first.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+#define FPML_OVERFLOW_BUILTINS 1
+#else
+#define FPML_OVERFLOW_BUILTINS 0
+#endif
+
 namespace fpml {
 
 
@@ -189,7 +199,7 @@ class fixed_point_base: boost::ordered_field_operators<
     //!
     //! This constructor takes a value of type B and initializes the internal
     //! representation of fixed_point<B, I, F> with it.
-    fixed_point_base(
+    constexpr fixed_point_base(
     /// The internal representation to use for initialization.
             B value,
             /// This value is not important, it's just here to differentiate from
@@ -228,18 +238,18 @@ public:
     //!
     //! This constructor takes a numeric value of type T and converts it to
     //! this fixed_point type.
-    fixed_point_base(
+    constexpr fixed_point_base(
     /// The value to convert.
             T value) :
             value_((B) value << F) {
-        BOOST_CONCEPT_ASSERT((boost::Integer<T>));
+        static_assert(std::numeric_limits<T>::is_integer, "fixed_point can only be constructed from integer types");
     }
 
     /// Converting constructor.
     //!
     //! This constructor takes a numeric value of type bool and converts it to
     //! this fixed_point type.
-    fixed_point_base(
+    constexpr fixed_point_base(
     /// The value to convert.
             bool value) :
             value_((B) (value * power2<F>::value)) {
@@ -252,7 +262,7 @@ public:
     //!
     //! The conversion is done by multiplication with 2^F and rounding to the
     //! next integer.
-    fixed_point_base(
+    constexpr fixed_point_base(
     /// The value to convert.
             float value) :
             value_((B) (value * power2<F>::value + (value >= 0 ? .5 : -.5))) {
@@ -262,7 +272,10 @@ public:
     //!
     //! This constructor takes a numeric value of type double and converts it to
     //! this fixed_point type.
-    fixed_point_base(
+    //!
+    //! The constructor is constexpr, so a constant like temp_t(0.2) can be
+    //! converted at compile time, without floating point code at runtime.
+    constexpr fixed_point_base(
     /// The value to convert.
             double value) :
             value_((B) (value * power2<F>::value + (value >= 0 ? .5 : -.5))) {
@@ -272,14 +285,14 @@ public:
     //!
     //! This constructor takes a numeric value of type long double and converts
     //! it to this fixed_point type.
-    fixed_point_base(
+    constexpr fixed_point_base(
     /// The value to convert.
             long double value) :
             value_((B) (value * power2<F>::value + (value >= 0 ? .5 : -.5))) {
     }
 
     /// Copy constructor.
-    fixed_point_base(
+    constexpr fixed_point_base(
     /// The right hand side.
             fixed_point_base<Derived, B, I, F> const& rhs) :
             value_(rhs.value_) {
@@ -395,7 +408,20 @@ public:
     fpml::fixed_point_base<Derived, B, I, F> & operator +=(
     /// Summand for addition.
             fpml::fixed_point_base<Derived, B, I, F> const& summand) {
-
+#if FPML_OVERFLOW_BUILTINS
+        // the derived type can reserve values at the ends of the range, so the result can be within range of B but
+        // outside the range of Derived. Values that already are outside the range of Derived, like temp_t::invalid(),
+        // are only constrained when they move further out.
+        B result;
+        if (__builtin_add_overflow(value_, summand.value_, &result)) {
+            result = (summand.value_ < 0) ? Derived::min_val : Derived::max_val;
+        } else if ((summand.value_ > 0) && (result > Derived::max_val)) {
+            result = Derived::max_val;
+        } else if ((summand.value_ < 0) && (result < Derived::min_val)) {
+            result = Derived::min_val;
+        }
+        value_ = result;
+#else
         if ((summand.value_ > 0) &&
                 (value_ > Derived::max_val - summand.value_)){ // would overflow
             value_ = Derived::max_val; // constrain instead of overflow
@@ -407,6 +433,7 @@ public:
         else{
             value_ += summand.value_;
         }
+#endif
         return *this;
     }
 
@@ -419,7 +446,17 @@ public:
     fpml::fixed_point_base<Derived, B, I, F> & operator -=(
     /// Diminuend for subtraction.
             fpml::fixed_point_base<Derived, B, I, F> const& diminuend) {
-
+#if FPML_OVERFLOW_BUILTINS
+        B result;
+        if (__builtin_sub_overflow(value_, diminuend.value_, &result)) {
+            result = (diminuend.value_ > 0) ? Derived::min_val : Derived::max_val;
+        } else if ((diminuend.value_ < 0) && (result > Derived::max_val)) {
+            result = Derived::max_val;
+        } else if ((diminuend.value_ > 0) && (result < Derived::min_val)) {
+            result = Derived::min_val;
+        }
+        value_ = result;
+#else
         if ((diminuend.value_ < 0) &&
                 (value_ > Derived::max_val + diminuend.value_)){ // would overflow
             value_ = Derived::max_val; // constrain instead of overflow
@@ -431,10 +468,14 @@ public:
         else{
             value_ -= diminuend.value_;
         }
+#endif
         return *this;
     }
 
 protected:
+    /// Values with a smaller magnitude can be shifted left by F within 32 bits.
+    static constexpr int64_t narrow_division_limit = int64_t(1) << (F < 31 ? 31 - F : 0);
+
     struct Error_promote_type_not_specialized_for_this_type {
     };
 
@@ -555,6 +596,15 @@ public:
     fpml::fixed_point_base<Derived, B, I, F> & operator /=(
     /// Divisor for division.
             fpml::fixed_point_base<Derived, B, I, F> const& divisor) {
+        typedef typename fpml::fixed_point_base<Derived, B, I, F>::template promote_type<B>::type promoted;
+        // A 64 bit division is a library call on 32 bit targets. When the shifted dividend fits in 32 bits, the
+        // 32 bit division gives the same result. The lower limit is exclusive to keep INT32_MIN / -1 out of it.
+        if (sizeof(promoted) > sizeof(int32_t) && std::is_signed<B>::value
+                && int64_t(value_) > -narrow_division_limit && int64_t(value_) < narrow_division_limit) {
+            int32_t dividend = int32_t(uint32_t(int32_t(value_)) << F);
+            value_ = B(dividend / int32_t(divisor.value_));
+            return *this;
+        }
         value_ =
                 (static_cast<typename fpml::fixed_point_base<Derived, B, I, F>::template
                 promote_type<B>::type>(value_) << F) / divisor.value_;
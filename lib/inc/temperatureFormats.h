@@ -72,10 +72,10 @@ public:
         value_ = rhs.value_;
     }
 
-    temp_t(base::base_type value) : base(value){}
+    constexpr temp_t(base::base_type value) : base(value){}
 
     // constructor from base class, needed for inherited operators to work
-    temp_t(fpml::fixed_point_base<temp_t, TEMP_TYPE, TEMP_INTBITS> const & rhs) :
+    constexpr temp_t(fpml::fixed_point_base<temp_t, TEMP_TYPE, TEMP_INTBITS> const & rhs) :
         fpml::fixed_point_base<temp_t, TEMP_TYPE, TEMP_INTBITS>(rhs){
     }
 
@@ -86,7 +86,7 @@ public:
     temp_t(temp_long_t const & rhs);
 
     // construction from double, use base class constructor
-    temp_t(double d) : fpml::fixed_point_base<temp_t, TEMP_TYPE, TEMP_INTBITS>(d){}
+    constexpr temp_t(double d) : fpml::fixed_point_base<temp_t, TEMP_TYPE, TEMP_INTBITS>(d){}
 
     // reserve lowest 5 values for special cases (invalid/disabled)
     static const fpml::fixed_point_base<temp_t, TEMP_TYPE, TEMP_INTBITS>::base_type min_val =
@@ -193,6 +193,15 @@ public:
         }
         return toStringImpl(value_, fractional_bit_count, buf, numDecimals, len, format, absolute);
     }
+    /*
+     * Formats several temperatures into buf in one pass, each without leading spaces and followed by separator.
+     * Invalid values are written as null. With separator '\0', buf holds consecutive strings.
+     * Stops at the first value that does not fit in size, including the terminating \0.
+     * @return the number of characters written, not counting the terminating \0
+     */
+    static uint16_t toTempStrings(temp_t const values[], uint8_t count, char buf[], uint16_t size,
+            uint8_t numDecimals, char separator, char format, bool absolute);
+
     std::string toCstring() const{
         char temporary[10]; // max 3 integer digits, 4 decimals + period + minus sign + \0
         char * noLeadingSpace = temporary;
@@ -242,10 +251,10 @@ public:
         value_ = rhs.value_;
     }
 
-    temp_precise_t(base::base_type value) : base(value) {}
+    constexpr temp_precise_t(base::base_type value) : base(value) {}
 
     // constructor from base class, needed for inherited operators to work
-    temp_precise_t(fpml::fixed_point_base<temp_precise_t, TEMP_PRECISE_TYPE, TEMP_PRECISE_INTBITS> const & rhs) :
+    constexpr temp_precise_t(fpml::fixed_point_base<temp_precise_t, TEMP_PRECISE_TYPE, TEMP_PRECISE_INTBITS> const & rhs) :
         fpml::fixed_point_base<temp_precise_t, TEMP_PRECISE_TYPE, TEMP_PRECISE_INTBITS>(rhs){
     }
 
@@ -256,7 +265,7 @@ public:
     temp_precise_t(temp_long_t const & rhs);
 
     // construction from double, use base class constructor
-    temp_precise_t(double d) : fpml::fixed_point_base<temp_precise_t, TEMP_PRECISE_TYPE, TEMP_PRECISE_INTBITS>(d){}
+    constexpr temp_precise_t(double d) : fpml::fixed_point_base<temp_precise_t, TEMP_PRECISE_TYPE, TEMP_PRECISE_INTBITS>(d){}
 
     void setRaw(TEMP_PRECISE_TYPE val){
         value_= val;
@@ -352,10 +361,10 @@ public:
         value_ = rhs.value_;
     }
 
-    temp_long_t(base::base_type value) : base(value) {}
+    constexpr temp_long_t(base::base_type value) : base(value) {}
 
     // constructor from base class, needed for inherited operators to work
-    temp_long_t(fpml::fixed_point_base<temp_long_t, TEMP_LONG_TYPE, TEMP_LONG_INTBITS> const & rhs) :
+    constexpr temp_long_t(fpml::fixed_point_base<temp_long_t, TEMP_LONG_TYPE, TEMP_LONG_INTBITS> const & rhs) :
         fpml::fixed_point_base<temp_long_t, TEMP_LONG_TYPE, TEMP_LONG_INTBITS>(rhs){
     }
 
@@ -366,7 +375,7 @@ public:
     temp_long_t(temp_precise_t const & rhs);
 
     // construction from double, use base class constructor
-    temp_long_t(double d) : fpml::fixed_point_base<temp_long_t, TEMP_LONG_TYPE, TEMP_LONG_INTBITS>(d){}
+    constexpr temp_long_t(double d) : fpml::fixed_point_base<temp_long_t, TEMP_LONG_TYPE, TEMP_LONG_INTBITS>(d){}
 
     void setRaw(TEMP_LONG_TYPE val){
         value_= val;
@@ -386,6 +395,12 @@ public:
         return toStringImpl(value_, fractional_bit_count, buf, numDecimals, len, 'C', false);
     }
 
+    /*
+     * Formats several values into buf in one pass, like temp_t::toTempStrings
+     */
+    static uint16_t toStrings(temp_long_t const values[], uint8_t count, char buf[], uint16_t size,
+            uint8_t numDecimals, char separator);
+
     bool fromString(char const * const s, int32_t minimum = min_val, int32_t maximum =
             max_val) {
         return fromStringImpl(&value_, fractional_bit_count, s,
@@ -29,7 +29,8 @@ ActuatorMutexGroup::~ActuatorMutexGroup(){
 }
 
 void ActuatorMutexGroup::registerActuator(ActuatorMutexDriver * act){
-    actuatorPriorities.push_back(ActuatorPriority(act, -1));
+    actuatorPriorities.push_back(ActuatorPriority(act));
+    rebuildWaiting(); // entries could have moved
 }
 
 void ActuatorMutexGroup::unRegisterActuator(ActuatorMutexDriver * act){
@@ -38,51 +39,143 @@ void ActuatorMutexGroup::unRegisterActuator(ActuatorMutexDriver * act){
 	for(;it < end; it++){
 		if(it->actuator == act){
 			actuatorPriorities.erase(it);
+			if(lastActiveActuator == act){
+			    lastActiveActuator = nullptr;
+			}
+			rebuildWaiting();
 			return;
 		}
 	}
 }
 
-bool ActuatorMutexGroup::request(ActuatorMutexDriver * requester, ActuatorDigital::State newState, int8_t newPriority){
-    // loop over all actuators to see if my request has highest priority
-    // and if no other actuators are active
+ActuatorPriority * ActuatorMutexGroup::find(ActuatorMutexDriver * act){
+    for(auto & ap : actuatorPriorities){
+        if(ap.actuator == act){
+            return &ap;
+        }
+    }
+    return nullptr;
+}
 
-    bool requestHonored = true;
-    bool otherActuatorActive = false;
-    int8_t highestPriority = -1;
+void ActuatorMutexGroup::rebuildWaiting(){
+    waiting.clear();
+    for(auto & ap : actuatorPriorities){
+        if(ap.heapIndex >= 0){
+            waiting.push_back(&ap);
+            heapUp(waiting.size() - 1);
+        }
+    }
+}
 
-    if(newState != ActuatorDigital::State::Active){
-        newPriority = -1; // set requester priority to -1, because its not waiting to go active anymore
+void ActuatorMutexGroup::heapSet(size_t index, ActuatorPriority * ap){
+    waiting[index] = ap;
+    ap->heapIndex = int8_t(index);
+}
+
+void ActuatorMutexGroup::heapUp(size_t index){
+    ActuatorPriority * ap = waiting[index];
+    while(index > 0){
+        size_t parent = (index - 1) / 2;
+        if(waiting[parent]->key >= ap->key){
+            break;
+        }
+        heapSet(index, waiting[parent]);
+        index = parent;
     }
+    heapSet(index, ap);
+}
 
-    for(auto & ap : actuatorPriorities ){
-    	ActuatorDigital::State actuatorState = ap.actuator->getState();
-        if(ap.actuator == requester){
-        	ap.priority = newPriority; // update requester's priority
+void ActuatorMutexGroup::heapDown(size_t index){
+    ActuatorPriority * ap = waiting[index];
+    size_t size = waiting.size();
+    while(true){
+        size_t child = 2 * index + 1;
+        if(child >= size){
+            break;
         }
-        if(ap.priority > highestPriority){
-        	highestPriority = ap.priority;
+        if(child + 1 < size && waiting[child + 1]->key > waiting[child]->key){
+            child++;
         }
-        if(actuatorState == ActuatorDigital::State::Active){
-            lastActiveTime = ticks.millis();
-            lastActiveActuator = ap.actuator;
-            if(ap.actuator != requester){
-            	otherActuatorActive = true;
-            }
+        if(ap->key >= waiting[child]->key){
+            break;
+        }
+        heapSet(index, waiting[child]);
+        index = child;
+    }
+    heapSet(index, ap);
+}
+
+void ActuatorMutexGroup::enqueue(ActuatorPriority & ap, int32_t key){
+    if(ap.heapIndex < 0){
+        waiting.push_back(&ap);
+        ap.key = key;
+        heapUp(waiting.size() - 1);
+        return;
+    }
+    int32_t oldKey = ap.key;
+    ap.key = key;
+    if(key > oldKey){
+        heapUp(size_t(ap.heapIndex));
+    }
+    else{
+        heapDown(size_t(ap.heapIndex));
+    }
+}
+
+void ActuatorMutexGroup::dequeue(ActuatorPriority & ap){
+    if(ap.heapIndex < 0){
+        return;
+    }
+    size_t index = size_t(ap.heapIndex);
+    ap.heapIndex = -1;
+    ActuatorPriority * last = waiting.back();
+    waiting.pop_back();
+    if(last != &ap){
+        heapSet(index, last);
+        heapUp(index);
+        heapDown(size_t(last->heapIndex));
+    }
+}
+
+bool ActuatorMutexGroup::request(ActuatorMutexDriver * requester, ActuatorDigital::State newState, int8_t newPriority){
+    ticks_millis_t now = ticks.millis();
+
+    // Only the actuator that was active last can still be active: all others had to pass here to go active.
+    // Time limited actuators can stay active after their request to go inactive, so its state is checked.
+    bool otherActuatorActive = false;
+    if(lastActiveActuator != nullptr && lastActiveActuator->getState() == ActuatorDigital::State::Active){
+        lastActiveTime = now;
+        otherActuatorActive = lastActiveActuator != requester;
+    }
+
+    ActuatorPriority * ap = find(requester);
+
+    if(newState != ActuatorDigital::State::Active){
+        if(ap != nullptr){
+            dequeue(*ap); // not waiting to go active anymore
         }
+        return true; // always allow setting to Inactive
+    }
+
+    if(ap != nullptr){
+        enqueue(*ap, int32_t(newPriority) + int32_t(decays));
     }
 
     // Check that no other actuator in the group is active
-	requestHonored &= !otherActuatorActive;
+    bool requestHonored = !otherActuatorActive;
 
 	// Check that no other waiting actuator has higher priority
-	requestHonored &= newPriority >= highestPriority;
+    requestHonored &= waiting.empty() || newPriority >= effectivePriority(*waiting.front());
 
 	// Guard the minimum dead time for switching between actuators
 	requestHonored &= !(getWaitTime() > 0) || lastActiveActuator == requester;
 
-	// always allow setting to Inactive
-    requestHonored = requestHonored || newState == ActuatorDigital::State::Inactive;
+	if(requestHonored){
+	    if(ap != nullptr){
+	        dequeue(*ap);
+	    }
+	    lastActiveActuator = requester;
+	}
 
     return requestHonored;
 }
@@ -91,6 +184,10 @@ void ActuatorMutexGroup::cancelRequest(ActuatorMutexDriver * requester){
     request(requester, ActuatorDigital::State::Inactive, -1);
 }
 
+ActuatorMutexDriver * ActuatorMutexGroup::getNextActuator() const {
+    return waiting.empty() ? nullptr : waiting.front()->actuator;
+}
+
 void ActuatorMutexGroup::setDeadTime(ticks_millis_t time){
     deadTime = time;
     if(lastActiveTime == 0){
@@ -99,7 +196,7 @@ void ActuatorMutexGroup::setDeadTime(ticks_millis_t time){
     }
 }
 
-ticks_millis_t ActuatorMutexGroup::getWaitTime(){
+ticks_millis_t ActuatorMutexGroup::getWaitTime() const {
     ticks_millis_t elapsed = ticks.millis() - lastActiveTime;
     if(elapsed >= deadTime){
         return 0;
@@ -109,12 +206,17 @@ ticks_millis_t ActuatorMutexGroup::getWaitTime(){
     }
 }
 
-// update decreases all priorities by 1, so that old requests lose their priority automatically
+// Decreasing the offset lowers all waiting priorities by 1 without touching the heap, because their order stays the same.
+// Requests that drop below 0 are no longer waiting. When the top of the heap has dropped below 0, all have.
 void ActuatorMutexGroup::update(){
-	for(auto & ap : actuatorPriorities ){
-        if(ap.priority > -1){
-            ap.priority--;
+    decays++;
+    if(!waiting.empty() && effectivePriority(*waiting.front()) < 0){
+        for(auto ap : waiting){
+            ap->heapIndex = -1;
         }
+        waiting.clear();
+    }
+	for(auto & ap : actuatorPriorities ){
         if(ap.actuator->getState() == ActuatorDigital::State::Active){
             lastActiveTime = ticks.millis();
             lastActiveActuator = ap.actuator;
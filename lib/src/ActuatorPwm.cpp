@@ -5,6 +5,7 @@
 #include "ActuatorPwm.h"
 #include "Ticks.h"
 #include "ActuatorMutexDriver.h"
+#include "LoopProfiler.h"
 
 ActuatorPwm::ActuatorPwm(ActuatorDigital & _target, uint16_t _period) :
     target(_target),
@@ -12,7 +13,10 @@ ActuatorPwm::ActuatorPwm(ActuatorDigital & _target, uint16_t _period) :
     dutyLate(0),
     periodLate(0),
     minVal(0.0),
-    maxVal(100.0)
+    maxVal(100.0),
+    cachedValue(0.0),
+    cachedValueTime(0),
+    cachedValueValid(false)
 {
     target.setState(ActuatorDigital::State::Inactive);
     setPeriod(_period); // sets period_ms
@@ -24,7 +28,7 @@ ActuatorPwm::ActuatorPwm(ActuatorDigital & _target, uint16_t _period) :
     dutyTime = calculateDutyTime(period_ms);
 }
 
-int32_t ActuatorPwm::calculateDutyTime(int32_t expectedPeriod) {
+int32_t ActuatorPwm::calculateDutyTime(int32_t expectedPeriod) const {
     // shift by 6 makes calculation work for period up to 11 hours
     int32_t duty = int32_t(temp_long_t(dutySetting) << uint8_t(6)) * ((expectedPeriod + 50) / 100) >> 6;
     return duty;
@@ -42,15 +46,25 @@ void ActuatorPwm::set(temp_t const& val) {
     if (dutySetting != val_) {
         dutySetting = val_;
         dutyTime = calculateDutyTime(period_ms + periodLate);
+        cachedValueValid = false;
     }
 }
 
 // returns the actual achieved PWM value, not the set value
-temp_t ActuatorPwm::value() const {
+temp_t ActuatorPwm::value(ticks_millis_t now) const {
+    if(!cachedValueValid || now != cachedValueTime){
+        cachedValue = calculateValue(now);
+        cachedValueTime = now;
+        cachedValueValid = true;
+    }
+    return cachedValue;
+}
+
+temp_t ActuatorPwm::calculateValue(ticks_millis_t now) const {
     ticks_millis_t windowDuration = cycleTime; // previous time between two pulses
     ticks_millis_t totalHigh = 0;
-    ticks_millis_t sinceLowToHigh = timeSinceMillis(ticks.millis(), lowToHighTime);
-    ticks_millis_t sinceHighToLow = timeSinceMillis(ticks.millis(), highToLowTime);
+    ticks_millis_t sinceLowToHigh = timeSinceMillis(now, lowToHighTime);
+    ticks_millis_t sinceHighToLow = timeSinceMillis(now, highToLowTime);
     if(sinceLowToHigh > sinceHighToLow){
         // pulse is finished, and we are in the low period:   ___|--|__
         totalHigh = sinceLowToHigh - sinceHighToLow;
@@ -87,10 +101,10 @@ temp_t ActuatorPwm::value() const {
     return pastValue;
 }
 
-void ActuatorPwm::fastUpdate() {
+void ActuatorPwm::fastUpdate(ticks_millis_t now) {
     target.fastUpdate();
     int32_t adjDutyTime = dutyTime - dutyLate;
-    int32_t currentTime = ticks.millis();
+    int32_t currentTime = now;
     int32_t elapsedTime = currentTime - periodStartTime;
 
     int32_t sinceLowToHigh = timeSinceMillis(currentTime, lowToHighTime);
@@ -109,6 +123,7 @@ void ActuatorPwm::fastUpdate() {
                 periodStartTime = currentTime;
                 cycleTime = period_ms;
                 highToLowTime = 0; // set to zero to indicate we are stringing high periods together
+                cachedValueValid = false;
             }
             else{
                 target.setState(ActuatorDigital::State::Inactive);
@@ -118,10 +133,12 @@ void ActuatorPwm::fastUpdate() {
                 }
                 int32_t thisDutyLate = elapsedTime - dutyTime;
                 dutyLate += thisDutyLate;
+                PROFILE_PWM_LATENESS(thisDutyLate);
                 if(highToLowTime != 0){
                     cycleTime = timeSinceMillis(currentTime, highToLowTime);
                 }
                 highToLowTime =currentTime;
+                cachedValueValid = false;
             }
         }
     }
@@ -164,10 +181,13 @@ void ActuatorPwm::fastUpdate() {
                     cycleTime = timeSinceMillis(currentTime, lowToHighTime);
                 }
                 lowToHighTime = currentTime;
+                cachedValueValid = false;
             }
         }
         if(newPeriod){
-            if(value() < maxVal * temp_t(0.2)){
+            PROFILE_PWM_LATENESS(elapsedTime - period_ms);
+            constexpr temp_t lowFraction(0.2); // converted at compile time
+            if(value(now) < maxVal * lowFraction){
                 // If target actuator was kept low externally, periodLate should not be used.
                 // This could be due to the mutex group blocking going active, for example.
                 // If the read value is under 20% of maximum, this is not likely to be normal behavior
@@ -186,6 +206,7 @@ void ActuatorPwm::fastUpdate() {
             // low period was longer, increase high period (duty cycle) with same ratio
             dutyTime = calculateDutyTime(period_ms + periodLate);
             periodStartTime = currentTime;
+            cachedValueValid = false;
         }
     }
     else {
@@ -193,6 +214,31 @@ void ActuatorPwm::fastUpdate() {
     }
 }
 
+ticks_millis_t ActuatorPwm::getWaitTime() const {
+    int32_t currentTime = ticks.millis();
+    int32_t elapsedTime = currentTime - periodStartTime;
+    int32_t wait;
+    if (target.getState() == ActuatorDigital::State::Active) {
+        wait = (dutyTime - dutyLate) - elapsedTime; // end of duty cycle
+    }
+    else {
+        wait = period_ms - elapsedTime; // end of PWM cycle
+        // fastUpdate also goes high early when the achieved duty in this cycle falls behind.
+        // The duty time grows linearly with the time since going high, find when it passes the last high time.
+        int32_t sinceLowToHigh = timeSinceMillis(currentTime, lowToHighTime);
+        int32_t lastHighDuration = sinceLowToHigh - timeSinceMillis(currentTime, highToLowTime);
+        int32_t fullDuty = calculateDutyTime(period_ms);
+        if (lastHighDuration > 0 && fullDuty > 0) {
+            int32_t needed = lastHighDuration + dutyLate;
+            int32_t goHighAt = (needed > 0) ? int32_t(int64_t(needed) * period_ms / fullDuty) + 1 : 0;
+            if (goHighAt - sinceLowToHigh < wait) {
+                wait = goHighAt - sinceLowToHigh;
+            }
+        }
+    }
+    return (wait > 0) ? wait : 0;
+}
+
 int8_t ActuatorPwm::priority(){
     int32_t adjDutyTime = dutyTime - dutyLate;
     int32_t priority = (adjDutyTime*100)/period_ms;
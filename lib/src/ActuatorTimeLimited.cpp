@@ -62,3 +62,21 @@ ticks_seconds_t ActuatorTimeLimited::timeSinceToggle() const
 {
     return ticks.timeSinceSeconds(toggleTime);
 }
+
+ticks_millis_t ActuatorTimeLimited::getWaitTime() const
+{
+    ticks_seconds_t since = timeSinceToggle();
+    ticks_seconds_t limit = (state == State::Active) ? minOnTime : minOffTime;
+    ticks_seconds_t wait = 0;
+    if (since <= limit){
+        wait = limit + 1 - since; // setState uses <=, so the state can change one second after the limit
+    }
+    if (state == State::Active && since < maxOnTime && (wait == 0 || maxOnTime - since < wait)){
+        wait = maxOnTime - since;
+    }
+    if (wait == 0){
+        return 0;
+    }
+    // seconds are truncated milliseconds, the next second starts at the next multiple of 1000
+    return ticks_millis_t(wait) * 1000 - ticks.millis() % 1000;
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ControlGraph.h"
+
+#include <algorithm>
+#include "Platform.h"
+#include "RefTo.h"
+#include "ActuatorMocks.h"
+#include "ActuatorInterfaces.h"
+#include "ActuatorMutexDriver.h"
+#include "ActuatorMutexGroup.h"
+#include "ActuatorPwm.h"
+#include "SetPoint.h"
+#include "TempSensorDisconnected.h"
+#include "TempSensorExternal.h"
+#include "TempSensorFallback.h"
+#include "TempSensorMock.h"
+#include "Pid.h"
+#include "ActuatorTimeLimited.h"
+#include "ActuatorOffset.h"
+#include "OneWireTempSensor.h"
+#include "TempSensorDelegate.h"
+#include "ActuatorDigitalDelegate.h"
+#include "SetPointDelegate.h"
+#include "SensorSetPointPair.h"
+#include "ProcessValueDelegate.h"
+
+#if WIRING
+#include "ActuatorPin.h"
+#endif
+
+#if BREWPI_DS2408
+#include "ValveController.h"
+#endif
+
+#if BREWPI_DS2413
+#include "ActuatorOneWire.h"
+#endif
+
+// limits following chains of delegates and drivers, in case objects are configured in a loop
+#define MAX_FORWARD_DEPTH 16
+
+/*
+ * Position of a single object in the control graph
+ */
+struct ControlGraphNode {
+    ControlGraphNode() : forward(nullptr), isAlias(false), hasUpdate(false), hasFastUpdate(false) {}
+
+    Interface * forward; // update() and fastUpdate() are passed on to this object
+    bool isAlias; // object only forwards to another object and takes its place in the graph (delegates)
+    bool hasUpdate; // object does work in update() itself
+    bool hasFastUpdate; // object does work in fastUpdate() itself
+    std::vector<Interface *> inputs; // objects that should be updated before this object
+    std::vector<Interface *> outputs; // objects that should be updated after this object
+};
+
+/*
+ * Fills in a ControlGraphNode for the visited object
+ */
+class VisitorControlGraph : public VisitorBase {
+public:
+    VisitorControlGraph(ControlGraphNode & n) : node(n) {}
+    ~VisitorControlGraph() = default;
+
+    void visit(ActuatorBool& thisRef) final {}
+    void visit(ActuatorInvalid& thisRef) final {}
+    void visit(ActuatorMutexDriver& thisRef) final {
+        if(thisRef.getMutex() != nullptr){
+            node.inputs.push_back(thisRef.getMutex());
+        }
+        node.outputs.push_back(&thisRef.getTarget());
+        node.forward = &thisRef.getTarget();
+    }
+    void visit(ActuatorMutexGroup& thisRef) final {
+        node.hasUpdate = true;
+    }
+    void visit(ActuatorNop& thisRef) final {}
+#if BREWPI_DS2413
+    void visit(ActuatorOneWire& thisRef) final {
+        node.hasUpdate = true;
+    }
+#endif
+    void visit(ActuatorPwm& thisRef) final {
+        node.outputs.push_back(&thisRef.getTarget());
+        node.hasUpdate = true;
+        node.hasFastUpdate = true;
+    }
+    void visit(ActuatorOffset& thisRef) final {
+        node.inputs.push_back(&thisRef.getReference());
+        node.outputs.push_back(&thisRef.getTarget());
+    }
+    void visit(ActuatorTimeLimited& thisRef) final {
+        node.outputs.push_back(&thisRef.getTarget());
+        node.hasUpdate = true;
+    }
+    void visit(ActuatorValue& thisRef) final {}
+    void visit(Pid& thisRef) final {
+        node.inputs.push_back(&thisRef.getInput());
+        node.outputs.push_back(&thisRef.getOutput());
+        node.hasUpdate = true;
+    }
+    void visit(SetPointConstant& thisRef) final {}
+    void visit(SetPointMinMax& thisRef) final {}
+    void visit(SetPointSimple& thisRef) final {}
+    void visit(TempSensorDisconnected& thisRef) final {}
+    void visit(TempSensorExternal& thisRef) final {}
+    void visit(TempSensorFallback& thisRef) final {
+        node.inputs.push_back(&thisRef.getMain());
+        node.inputs.push_back(&thisRef.getBackup());
+        node.hasUpdate = true;
+    }
+    void visit(TempSensorMock& thisRef) final {}
+    void visit(OneWireTempSensor& thisRef) final {
+        node.hasUpdate = true;
+    }
+#if BREWPI_DS2408
+    void visit(ValveController& thisRef) final {
+        node.hasUpdate = true;
+    }
+#endif
+    void visit(TempSensorDelegate& thisRef) final {
+        alias(thisRef.getDelegate());
+    }
+    void visit(ActuatorDigitalDelegate& thisRef) final {
+        alias(thisRef.getDelegate());
+    }
+    void visit(SetPointDelegate& thisRef) final {
+        alias(thisRef.getDelegate());
+    }
+    void visit(ProcessValueDelegate& thisRef) final {
+        alias(thisRef.getDelegate());
+    }
+    void visit(SensorSetPointPair& thisRef) final {
+        node.inputs.push_back(&thisRef.getSensor());
+        node.inputs.push_back(&thisRef.getSetPoint());
+    }
+#if WIRING
+    void visit(ActuatorPin& thisRef) final {}
+#endif
+
+private:
+    void alias(Interface * target){
+        node.forward = target;
+        node.isAlias = true;
+    }
+
+    ControlGraphNode & node;
+};
+
+static ControlGraphNode describe(Interface * obj){
+    ControlGraphNode node;
+    VisitorControlGraph v(node);
+    obj->accept(v);
+    return node;
+}
+
+// returns the object that takes the place of obj in the graph, by skipping delegates
+static Interface * canonical(Interface * obj){
+    for(uint8_t depth = 0; obj != nullptr && depth < MAX_FORWARD_DEPTH; depth++){
+        ControlGraphNode node = describe(obj);
+        if(!node.isAlias || node.forward == nullptr){
+            break;
+        }
+        obj = node.forward;
+    }
+    return obj;
+}
+
+// returns true if calling update() (fast == false) or fastUpdate() (fast == true) on obj has any effect
+static bool hasWork(Interface * obj, bool fast){
+    for(uint8_t depth = 0; obj != nullptr && depth < MAX_FORWARD_DEPTH; depth++){
+        ControlGraphNode node = describe(obj);
+        if(fast ? node.hasFastUpdate : node.hasUpdate){
+            return true;
+        }
+        obj = node.forward;
+    }
+    return false;
+}
+
+static size_t findNode(const std::vector<Interface *> & nodes, Interface * obj){
+    return std::find(nodes.begin(), nodes.end(), obj) - nodes.begin();
+}
+
+void ControlGraph::compile(const std::vector<Interface *> & objects){
+    // discover all objects reachable from the given objects, in a deterministic order
+    std::vector<Interface *> nodes;
+    std::vector<Interface *> pending(objects.rbegin(), objects.rend()); // reversed, because it is used as a stack
+    std::vector<std::vector<size_t>> successors;
+
+    while(!pending.empty()){
+        Interface * obj = canonical(pending.back());
+        pending.pop_back();
+        if(obj == nullptr || findNode(nodes, obj) < nodes.size()){
+            continue;
+        }
+        nodes.push_back(obj);
+        ControlGraphNode node = describe(obj);
+        pending.insert(pending.end(), node.outputs.rbegin(), node.outputs.rend());
+        pending.insert(pending.end(), node.inputs.rbegin(), node.inputs.rend());
+    }
+
+    // add edges from each object to the objects that should be updated after it
+    successors.resize(nodes.size());
+    std::vector<size_t> inDegree(nodes.size(), 0);
+    for(size_t i = 0; i < nodes.size(); i++){
+        ControlGraphNode node = describe(nodes[i]);
+        for(auto input : node.inputs){
+            size_t from = findNode(nodes, canonical(input));
+            if(from < nodes.size() && from != i){
+                successors[from].push_back(i);
+                inDegree[i]++;
+            }
+        }
+        for(auto output : node.outputs){
+            size_t to = findNode(nodes, canonical(output));
+            if(to < nodes.size() && to != i){
+                successors[i].push_back(to);
+                inDegree[to]++;
+            }
+        }
+    }
+
+    // topological sort. Of all objects that are ready, the first discovered goes first, which keeps the order stable.
+    std::vector<size_t> rank(nodes.size(), nodes.size());
+    for(size_t position = 0; position < nodes.size(); position++){
+        size_t next = nodes.size();
+        for(size_t i = 0; i < nodes.size(); i++){
+            if(rank[i] == nodes.size() && inDegree[i] == 0){
+                next = i;
+                break;
+            }
+        }
+        if(next == nodes.size()){
+            // dependency loop, break it at the first object that is not placed yet
+            for(next = 0; rank[next] != nodes.size(); next++){}
+        }
+        rank[next] = position;
+        for(auto s : successors[next]){
+            if(inDegree[s] > 0){
+                inDegree[s]--;
+            }
+        }
+    }
+
+    std::vector<Interface *> sorted(objects);
+    std::stable_sort(sorted.begin(), sorted.end(), [&nodes, &rank](Interface * a, Interface * b){
+        return rank[findNode(nodes, canonical(a))] < rank[findNode(nodes, canonical(b))];
+    });
+
+    updateTable.clear();
+    fastUpdateTable.clear();
+    for(auto obj : sorted){
+        if(hasWork(obj, false)){
+            updateTable.push_back(obj);
+        }
+        if(hasWork(obj, true)){
+            fastUpdateTable.push_back(obj);
+        }
+    }
+    compiledGeneration = RefToGeneric::getGeneration();
+    compiledObjects = objects;
+}
+
+bool ControlGraph::isStale(const std::vector<Interface *> & objects) const {
+    return compiledGeneration != RefToGeneric::getGeneration() || compiledObjects != objects;
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DS248xAsync.h"
+
+void DS248xAsync::submit(OneWireTransaction & t) {
+    t.next = nullptr;
+    t.position = 0;
+    if (t.overflow) {
+        t.status_ = OneWireTransaction::Status::Invalid;
+        if (t.callback) {
+            t.callback(t, t.context);
+        }
+        return;
+    }
+    t.status_ = OneWireTransaction::Status::Pending;
+    if (tail) {
+        tail->next = &t;
+    } else {
+        head = &t;
+    }
+    tail = &t;
+}
+
+bool DS248xAsync::poll() {
+    if (head == nullptr) {
+        return false;
+    }
+    OneWireTransaction & t = *head;
+
+    if (!inProgress && t.position == 0 && t.searchState && t.searchState->lastDevice) {
+        // the previous search found the last device, like OneWire::search() this search finds nothing
+        t.searchState->restart();
+        complete(OneWireTransaction::Status::Done);
+        return head != nullptr;
+    }
+
+    // never start an operation or read a result while the master is busy
+    uint8_t status = readStatus();
+    if (status & DS248X_STATUS_BUSY) {
+        if (++busyPolls >= DS248X_ASYNC_MAX_BUSY_POLLS) {
+            complete(OneWireTransaction::Status::Timeout);
+        }
+        return true;
+    }
+    busyPolls = 0;
+
+    if (inProgress) {
+        inProgress = false;
+        if (!finish(t, status)) {
+            return head != nullptr;
+        }
+    }
+
+    if (t.operation() == OneWireTransaction::Operation::None) {
+        complete(OneWireTransaction::Status::Done);
+    } else {
+        start(t);
+    }
+    return head != nullptr;
+}
+
+uint8_t DS248xAsync::readStatus() {
+    if (!statusPointer) {
+        i2c.writeCommand(DS248X_SRP, DS248X_PTR_STATUS);
+        statusPointer = true;
+    }
+    return i2c.readRegister();
+}
+
+uint8_t DS248xAsync::readData() {
+    i2c.writeCommand(DS248X_SRP, DS248X_PTR_READ);
+    statusPointer = false;
+    return i2c.readRegister();
+}
+
+void DS248xAsync::start(OneWireTransaction & t) {
+    switch (t.operation()) {
+        case OneWireTransaction::Operation::Reset:
+            i2c.writeCommand(DS248X_1WRS);
+            break;
+        case OneWireTransaction::Operation::Write:
+            i2c.writeCommand(DS248X_1WWB, t.writeData[t.index()]);
+            break;
+        case OneWireTransaction::Operation::Read:
+            i2c.writeCommand(DS248X_1WRB);
+            break;
+        case OneWireTransaction::Operation::Triplet: {
+            OneWireSearch & s = *t.searchState;
+            uint8_t bitNumber = uint8_t(t.index() + 1);
+            if (bitNumber == 1) {
+                s.lastZero = 0;
+            }
+            // before the last discrepancy, take the same path as the previous search. At it, take the other path.
+            bool direction;
+            if (bitNumber < s.lastDiscrepancy) {
+                direction = s.rom[t.index() / 8] & (1 << (t.index() % 8));
+            } else {
+                direction = bitNumber == s.lastDiscrepancy;
+            }
+            i2c.writeCommand(DS248X_1WT, direction ? 0x80 : 0x00);
+            break;
+        }
+        case OneWireTransaction::Operation::None:
+            return;
+    }
+    statusPointer = true; // 1-Wire commands set the read pointer to the status register
+    inProgress = true;
+}
+
+bool DS248xAsync::finish(OneWireTransaction & t, uint8_t status) {
+    switch (t.operation()) {
+        case OneWireTransaction::Operation::Reset:
+            if (!(status & DS248X_STATUS_PPD)) {
+                if (t.searchState) {
+                    t.searchState->restart();
+                }
+                complete(OneWireTransaction::Status::NoPresence);
+                return false;
+            }
+            break;
+        case OneWireTransaction::Operation::Read:
+            t.readData[t.index()] = readData();
+            break;
+        case OneWireTransaction::Operation::Triplet:
+            if (!searchStep(t, status)) {
+                return false;
+            }
+            break;
+        default:
+            break;
+    }
+    t.position++;
+    return true;
+}
+
+bool DS248xAsync::searchStep(OneWireTransaction & t, uint8_t status) {
+    OneWireSearch & s = *t.searchState;
+    bool idBit = status & DS248X_STATUS_SBR;
+    bool cmpIdBit = status & DS248X_STATUS_TSB;
+    bool direction = status & DS248X_STATUS_DIR;
+
+    if (idBit && cmpIdBit) {
+        // no devices participate in the search
+        s.restart();
+        complete(OneWireTransaction::Status::Done);
+        return false;
+    }
+
+    uint8_t bit = t.index();
+    if (!idBit && !cmpIdBit && !direction) {
+        s.lastZero = uint8_t(bit + 1);
+    }
+    uint8_t mask = uint8_t(1 << (bit % 8));
+    if (direction) {
+        s.rom[bit / 8] |= mask;
+    } else {
+        s.rom[bit / 8] &= uint8_t(~mask);
+    }
+
+    if (bit == 63) {
+        s.lastDiscrepancy = s.lastZero;
+        s.lastDevice = s.lastDiscrepancy == 0;
+        s.found = s.rom[0] != 0;
+        if (!s.found) {
+            s.restart();
+        }
+    }
+    return true;
+}
+
+void DS248xAsync::complete(OneWireTransaction::Status status) {
+    OneWireTransaction & t = *head;
+    head = t.next;
+    if (head == nullptr) {
+        tail = nullptr;
+    }
+    t.next = nullptr;
+    t.status_ = status;
+    inProgress = false;
+    busyPolls = 0;
+    // the transaction is no longer queued, so the callback can submit it again
+    if (t.callback) {
+        t.callback(t, t.context);
+    }
+}
@@ -419,7 +419,6 @@ bool DallasTemperature::isConversionAvailable(const uint8_t* deviceAddress) {
 }
 #endif
 
-#if REQUIRESWHOLEBUSOPS
 // sends command for all devices on the bus to perform a temperature conversion
 
 void DallasTemperature::requestTemperatures() {
@@ -427,14 +426,13 @@ void DallasTemperature::requestTemperatures() {
     _wire->skip();
     _wire->write(STARTCONVO, isParasitePowerMode());
 
-#if REQUIRESWAITFORCONVERSION
+#if REQUIRESWAITFORCONVERSION && REQUIRESWHOLEBUSOPS
     // ASYNC mode?
     if (!waitForConversion) return;
     blockTillConversionComplete(getResolution(), NULL);
 #endif
 
 }
-#endif // REQUIRESWHOLEBUSOPS
 
 // sends command for one device to perform a temperature by address
 
@@ -553,10 +551,18 @@ int16_t DallasTemperature::calculateTemperature(const uint8_t* deviceAddress, ui
 // operating range of the device
 
 int16_t DallasTemperature::getTempRaw(const uint8_t* deviceAddress) {
+    uint8_t resolution;
+    return getTempRaw(deviceAddress, resolution);
+}
+
+int16_t DallasTemperature::getTempRaw(const uint8_t* deviceAddress, uint8_t& resolution) {
     ScratchPad scratchPad;
     if (!readScratchPadCRC(deviceAddress, scratchPad)) {
         return DEVICE_DISCONNECTED_RAW;
     }
+    // DS18S20 has a fixed 9-bit resolution, but needs the 12-bit conversion time
+    // the other models store the resolution in bits 5 and 6 of the configuration register
+    resolution = isDS18S20Model(deviceAddress) ? 12 : uint8_t(9 + ((scratchPad[CONFIGURATION] >> 5) & 0x03));
     // return DEVICE_DISCONNECTED when a reset has been detected to force it to be reconfigured
     if (detectedReset(scratchPad)) {
         return DEVICE_DISCONNECTED_RAW;
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FilterBank.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FILTER_BANK_LANES 8
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FILTER_BANK_LANES 4
+#else
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#endif
+#define FILTER_BANK_LANES 1
+#endif
+
+/*
+ * Saturating 32 bit addition and subtraction, identical to fixed_point_base::operator+= and operator-=
+ * for temp_precise_t, which constrains the result to the range of int32_t.
+ */
+static inline int32_t satAdd(int32_t x, int32_t y){
+#if defined(__ARM_FEATURE_DSP)
+    return __qadd(x, y);
+#else
+    int32_t sum = int32_t(uint32_t(x) + uint32_t(y));
+    if(((x ^ sum) & (y ^ sum)) < 0){ // sign of result differs from the sign of both operands
+        return (x < 0) ? INT32_MIN : INT32_MAX;
+    }
+    return sum;
+#endif
+}
+
+static inline int32_t satSub(int32_t x, int32_t y){
+#if defined(__ARM_FEATURE_DSP)
+    return __qsub(x, y);
+#else
+    int32_t diff = int32_t(uint32_t(x) - uint32_t(y));
+    if(((x ^ y) & (x ^ diff)) < 0){ // operands have different signs and the result has the sign of y
+        return (x < 0) ? INT32_MIN : INT32_MAX;
+    }
+    return diff;
+#endif
+}
+
+#if defined(__AVX2__)
+typedef __m256i lanes_t;
+typedef __m128i shift_t;
+static inline lanes_t load(const int32_t * p){ return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+static inline void store(int32_t * p, lanes_t v){ _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+static inline shift_t shiftCount(uint8_t s){ return _mm_cvtsi32_si128(s); }
+static inline lanes_t sra(lanes_t v, shift_t s){ return _mm256_sra_epi32(v, s); }
+static inline lanes_t add(lanes_t x, lanes_t y){ return _mm256_add_epi32(x, y); }
+static inline lanes_t sub(lanes_t x, lanes_t y){ return _mm256_sub_epi32(x, y); }
+static inline lanes_t bitXor(lanes_t x, lanes_t y){ return _mm256_xor_si256(x, y); }
+static inline lanes_t bitAnd(lanes_t x, lanes_t y){ return _mm256_and_si256(x, y); }
+static inline lanes_t allOnesIfNegative(lanes_t v){ return _mm256_srai_epi32(v, 31); }
+static inline lanes_t select(lanes_t mask, lanes_t ifSet, lanes_t ifClear){ return _mm256_blendv_epi8(ifClear, ifSet, mask); }
+static inline lanes_t broadcast(int32_t v){ return _mm256_set1_epi32(v); }
+#elif defined(__SSE2__)
+typedef __m128i lanes_t;
+typedef __m128i shift_t;
+static inline lanes_t load(const int32_t * p){ return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+static inline void store(int32_t * p, lanes_t v){ _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+static inline shift_t shiftCount(uint8_t s){ return _mm_cvtsi32_si128(s); }
+static inline lanes_t sra(lanes_t v, shift_t s){ return _mm_sra_epi32(v, s); }
+static inline lanes_t add(lanes_t x, lanes_t y){ return _mm_add_epi32(x, y); }
+static inline lanes_t sub(lanes_t x, lanes_t y){ return _mm_sub_epi32(x, y); }
+static inline lanes_t bitXor(lanes_t x, lanes_t y){ return _mm_xor_si128(x, y); }
+static inline lanes_t bitAnd(lanes_t x, lanes_t y){ return _mm_and_si128(x, y); }
+static inline lanes_t allOnesIfNegative(lanes_t v){ return _mm_srai_epi32(v, 31); }
+static inline lanes_t select(lanes_t mask, lanes_t ifSet, lanes_t ifClear){
+    return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifClear));
+}
+static inline lanes_t broadcast(int32_t v){ return _mm_set1_epi32(v); }
+#endif
+
+#if FILTER_BANK_LANES > 1
+// Vector versions of satAdd and satSub: wrap around, then replace the lanes that overflowed
+static inline lanes_t satAdd(lanes_t x, lanes_t y){
+    lanes_t sum = add(x, y);
+    lanes_t overflow = allOnesIfNegative(bitAnd(bitXor(x, sum), bitXor(y, sum)));
+    lanes_t limit = bitXor(allOnesIfNegative(x), broadcast(INT32_MAX)); // INT32_MIN for negative x, INT32_MAX otherwise
+    return select(overflow, limit, sum);
+}
+
+static inline lanes_t satSub(lanes_t x, lanes_t y){
+    lanes_t diff = sub(x, y);
+    lanes_t overflow = allOnesIfNegative(bitAnd(bitXor(x, y), bitXor(x, diff)));
+    lanes_t limit = bitXor(allOnesIfNegative(x), broadcast(INT32_MAX));
+    return select(overflow, limit, diff);
+}
+#endif
+
+FilterBank::FilterBank(uint8_t nrOfChannels, uint8_t bValue) :
+    channels(nrOfChannels),
+    stride(uint16_t((nrOfChannels + FILTER_BANK_LANES - 1) / FILTER_BANK_LANES * FILTER_BANK_LANES)),
+    head(0),
+    state(NUM_SECTIONS * 2 * TAPS * stride, 0),
+    input(stride, 0)
+{
+    setFiltering(bValue);
+}
+
+void FilterBank::setFiltering(uint8_t bValue){
+    if(bValue > 13){
+        bValue = 13;
+    }
+    b = bValue;
+    a = uint8_t(bValue * 2 + 4);
+}
+
+void FilterBank::init(temp_precise_t val){
+    for(uint8_t ch = 0; ch < channels; ch++){
+        init(ch, val);
+    }
+}
+
+void FilterBank::init(uint8_t channel, temp_precise_t val){
+    if(channel >= channels){
+        return;
+    }
+    int32_t raw = val.getRaw();
+    for(uint8_t s = 0; s < NUM_SECTIONS; s++){
+        for(uint8_t t = 0; t < TAPS; t++){
+            tap(s, X, t)[channel] = raw;
+            tap(s, Y, t)[channel] = raw;
+        }
+    }
+}
+
+void FilterBank::add(const temp_t * values){
+    for(uint8_t ch = 0; ch < channels; ch++){
+        temp_precise_t v = values[ch];
+        input[ch] = v.getRaw();
+    }
+    advance();
+}
+
+void FilterBank::add(const temp_precise_t * values){
+    for(uint8_t ch = 0; ch < channels; ch++){
+        temp_precise_t v = values[ch];
+        input[ch] = v.getRaw();
+    }
+    advance();
+}
+
+void FilterBank::advance(){
+    // rotate taps: the oldest slot (delay 2) becomes the newest (delay 0)
+    head = uint8_t((head + TAPS - 1) % TAPS);
+
+    // Same order of operations as FixedFilter::add, to keep saturation behavior identical.
+    // Each section reads the output of the previous section, which was just written.
+    const int32_t * in = input.data();
+    for(uint8_t s = 0; s < NUM_SECTIONS; s++){
+        int32_t * x0 = tap(s, X, 0);
+        const int32_t * x1 = tap(s, X, 1);
+        const int32_t * x2 = tap(s, X, 2);
+        int32_t * y0 = tap(s, Y, 0);
+        const int32_t * y1 = tap(s, Y, 1);
+        const int32_t * y2 = tap(s, Y, 2);
+
+#if FILTER_BANK_LANES > 1
+        const shift_t sa = shiftCount(a);
+        const shift_t sa1 = shiftCount(uint8_t(a - 1));
+        const shift_t sa2 = shiftCount(uint8_t(a - 2));
+        const shift_t sb = shiftCount(b);
+        for(uint16_t ch = 0; ch < stride; ch += FILTER_BANK_LANES){
+            lanes_t vx0 = load(in + ch);
+            lanes_t vx1 = load(x1 + ch);
+            lanes_t vx2 = load(x2 + ch);
+            lanes_t vy1 = load(y1 + ch);
+            lanes_t vy2 = load(y2 + ch);
+
+            lanes_t vy0 = satAdd(satSub(vy1, vy2), vy1);
+            vy0 = satSub(vy0, sra(vy1, sb));
+            vy0 = satAdd(vy0, sra(vy2, sb));
+            lanes_t temporary = satAdd(satAdd(sra(vx0, sa), sra(vx1, sa1)), sra(vx2, sa));
+            temporary = satSub(temporary, sra(vy2, sa2));
+            vy0 = satAdd(vy0, temporary);
+
+            store(x0 + ch, vx0);
+            store(y0 + ch, vy0);
+        }
+#else
+        for(uint16_t ch = 0; ch < stride; ch++){
+            int32_t vy0 = satAdd(satSub(y1[ch], y2[ch]), y1[ch]);
+            vy0 = satSub(vy0, y1[ch] >> b);
+            vy0 = satAdd(vy0, y2[ch] >> b);
+            int32_t temporary = satAdd(satAdd(in[ch] >> a, x1[ch] >> uint8_t(a - 1)), x2[ch] >> a);
+            temporary = satSub(temporary, y2[ch] >> uint8_t(a - 2));
+            vy0 = satAdd(vy0, temporary);
+
+            x0[ch] = in[ch];
+            y0[ch] = vy0;
+        }
+#endif
+        in = y0;
+    }
+}
+
+temp_precise_t FilterBank::readInput(uint8_t channel) const {
+    temp_precise_t result;
+    result.setRaw(tap(0, X, 0)[channel]);
+    return result;
+}
+
+temp_precise_t FilterBank::readOutput(uint8_t channel) const {
+    temp_precise_t result;
+    result.setRaw(tap(NUM_SECTIONS - 1, Y, 0)[channel]);
+    return result;
+}
+
+temp_precise_t FilterBank::readPrevOutput(uint8_t channel) const {
+    temp_precise_t result;
+    result.setRaw(tap(NUM_SECTIONS - 1, Y, 1)[channel]);
+    return result;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LoopProfiler.h"
+
+#if BREWPI_PROFILING
+
+PROFILER_THREAD_LOCAL LoopProfiler profiler;
+
+uint8_t TimingHistogram::bucketFor(uint32_t value) {
+    uint8_t b = 0;
+    while (value != 0 && b < BUCKETS - 1) {
+        value >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void TimingHistogram::add(uint32_t value) {
+    uint16_t & b = buckets[bucketFor(value)];
+    if (b != UINT16_MAX) {
+        b++;
+    }
+    if (count_ != UINT32_MAX) {
+        count_++;
+    }
+    if (value > max_) {
+        max_ = value;
+    }
+}
+
+void TimingHistogram::clear() {
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+        buckets[i] = 0;
+    }
+    count_ = 0;
+    max_ = 0;
+}
+
+void LoopProfiler::loopStarted() {
+    ticks_micros_t now = ticks.micros();
+    if (looping) {
+        loopPeriods_.add(now - lastLoopStart);
+    }
+    lastLoopStart = now;
+    looping = true;
+}
+
+void LoopProfiler::record(const void * object, ProfilePhase phase, uint32_t micros) {
+    for (uint8_t i = 0; i < used; i++) {
+        if (entries[i].object == object && entries[i].phase == phase) {
+            entries[i].micros.add(micros);
+            return;
+        }
+    }
+    if (used < PROFILER_MAX_OBJECTS) {
+        Entry & e = entries[used++];
+        e.object = object;
+        e.phase = phase;
+        e.micros.clear();
+        e.micros.add(micros);
+        return;
+    }
+    overflow_.add(micros);
+}
+
+void LoopProfiler::recordPwmLateness(int32_t millis) {
+    pwmLateness_.add(millis > 0 ? uint32_t(millis) : 0);
+}
+
+void LoopProfiler::clear() {
+    used = 0;
+    overflow_.clear();
+    loopPeriods_.clear();
+    pwmLateness_.clear();
+    lastLoopStart = 0;
+    looping = false;
+}
+
+#endif
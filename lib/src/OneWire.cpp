@@ -115,9 +115,21 @@ sample code bearing this copyright.
  */
 
 #include "OneWire.h"
+#include "OneWireConversionScheduler.h"
 #include "Platform.h"
 // #include "Ticks.h"
 
+OneWire::~OneWire() {
+    delete scheduler;
+}
+
+OneWireConversionScheduler & OneWire::conversionScheduler() {
+    if (scheduler == nullptr) {
+        scheduler = new OneWireConversionScheduler(this);
+    }
+    return *scheduler;
+}
+
 void OneWire::write_bytes(const uint8_t *buf, uint16_t count) {
     for (uint16_t i = 0; i < count; i++)
         driver.write(buf[i]);
@@ -310,6 +322,32 @@ uint8_t OneWire::search(uint8_t *newAddr) {
     return search_result;
 }
 
+//
+// Check whether the device with the given ROM is on the bus, by walking its path through the search tree.
+// Unlike select() followed by a read, this gives a different result when the device is absent.
+// The search state is not changed.
+//
+
+bool OneWire::verify(const uint8_t rom[8]) {
+    uint8_t id_bit, cmp_id_bit, search_direction;
+
+    if (!driver.reset()) {
+        return false;
+    }
+    driver.write(0xF0);
+    for (uint8_t i = 0; i < 64; i++) {
+        uint8_t rom_bit = (rom[i / 8] >> (i % 8)) & 1;
+        search_direction = rom_bit;
+        id_bit = cmp_id_bit = 1; // as if no device answered, for drivers that do not set them
+        driver.search_triplet(&search_direction, &id_bit, &cmp_id_bit);
+        // no devices left, or all remaining devices have the other bit value
+        if ((id_bit && cmp_id_bit) || search_direction != rom_bit) {
+            return false;
+        }
+    }
+    return true;
+}
+
 #endif
 
 #if ONEWIRE_CRC
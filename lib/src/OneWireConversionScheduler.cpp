@@ -0,0 +1,107 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OneWireConversionScheduler.h"
+#include "OneWire.h"
+
+OneWireConversionScheduler::OneWireConversionScheduler(OneWire* bus_)
+    : bus(bus_), sensors(bus_), clients(nullptr),
+      started(0), conversions(0), duration(0), converting(false)
+{
+}
+
+OneWireConversionScheduler & OneWireConversionScheduler::forBus(OneWire* bus) {
+    return bus->conversionScheduler();
+}
+
+void OneWireConversionScheduler::add(Client & client) {
+    client.next = clients;
+    clients = &client;
+}
+
+void OneWireConversionScheduler::remove(Client & client) {
+    for (Client** p = &clients; *p != nullptr; p = &(*p)->next) {
+        if (*p == &client) {
+            *p = client.next;
+            client.next = nullptr;
+            return;
+        }
+    }
+}
+
+uint16_t OneWireConversionScheduler::conversionMillis(uint8_t resolution) {
+    switch (resolution) {
+        case 9:
+            return 94;
+        case 10:
+            return 188;
+        case 11:
+            return 375;
+        default:
+            return 750;
+    }
+}
+
+bool OneWireConversionScheduler::busy() {
+    if (converting && timeSinceMillis(ticks.millis(), started) >= duration) {
+        converting = false;
+        readAll();
+    }
+    return converting;
+}
+
+uint16_t OneWireConversionScheduler::requestConversion() {
+    if (busy()) {
+        return uint16_t(duration - timeSinceMillis(ticks.millis(), started));
+    }
+    if (clients == nullptr) {
+        return 0;
+    }
+
+    duration = 0;
+    for (Client* c = clients; c != nullptr; c = c->next) {
+        uint16_t millis = conversionMillis(c->resolution);
+        if (millis > duration) {
+            duration = millis;
+        }
+    }
+
+    sensors.requestTemperatures(); // Skip ROM, Convert T: all sensors convert at the same time
+    started = ticks.millis();
+    converting = true;
+    conversions++;
+    return duration;
+}
+
+int16_t OneWireConversionScheduler::read(Client & client) {
+    busy(); // reads back all sensors when a conversion just completed
+    return client.raw;
+}
+
+void OneWireConversionScheduler::store(Client & client, int16_t raw) {
+    client.raw = raw;
+}
+
+void OneWireConversionScheduler::readAll() {
+    for (Client* c = clients; c != nullptr; c = c->next) {
+        uint8_t resolution = c->resolution;
+        c->raw = sensors.getTempRaw(c->address, resolution);
+        c->resolution = resolution;
+    }
+}
@@ -0,0 +1,595 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Platform.h"
+
+#if defined(ONEWIRE_EMULATED)
+
+#include "OneWireEmulator.h"
+#include "OneWire.h"
+#include <algorithm>
+
+OneWireDeviceModel::OneWireDeviceModel(uint8_t family, uint64_t serial) :
+    connected(true),
+    state(State::Idle),
+    bitIndex(0),
+    searchPhase(0),
+    matching(false),
+    writeShift(0),
+    writeBits(0),
+    readShift(0),
+    readBits(0)
+{
+    rom[0] = family;
+    for(uint8_t i = 1; i < 7; i++){
+        rom[i] = uint8_t(serial >> (8 * (i - 1)));
+    }
+    rom[7] = OneWire::crc8(rom, 7);
+}
+
+void OneWireDeviceModel::setConnected(bool connect){
+    if(connect && !connected){
+        powerOnReset(); // the device lost power while it was unplugged
+    }
+    connected = connect;
+    state = State::Idle;
+}
+
+void OneWireDeviceModel::powerOnReset(){
+    state = State::Idle;
+}
+
+void OneWireDeviceModel::idle(){
+    state = State::Idle;
+}
+
+bool OneWireDeviceModel::resetPulse(){
+    if(!connected){
+        return false;
+    }
+    state = State::RomCommand;
+    writeBits = 0;
+    readBits = 0;
+    return true;
+}
+
+void OneWireDeviceModel::romCommand(uint8_t command){
+    bitIndex = 0;
+    switch(command){
+    case 0x33: // read ROM
+        state = State::ReadRom;
+        break;
+    case 0x55: // match ROM
+        matching = true;
+        state = State::MatchRom;
+        break;
+    case 0xCC: // skip ROM
+        state = State::Function;
+        break;
+    case 0xF0: // search ROM
+        searchPhase = 0;
+        state = State::SearchRom;
+        break;
+    default: // alarm search (the models have no alarm condition) and overdrive commands are not supported
+        state = State::Idle;
+        break;
+    }
+}
+
+void OneWireDeviceModel::writeSlot(bool bit){
+    if(!connected){
+        return;
+    }
+    switch(state){
+    case State::RomCommand:
+    case State::Function:
+    case State::FunctionData:
+        writeShift = uint8_t((writeShift >> 1) | (bit ? 0x80 : 0));
+        if(++writeBits == 8){
+            writeBits = 0;
+            if(state == State::RomCommand){
+                romCommand(writeShift);
+            }
+            else if(state == State::Function){
+                state = State::FunctionData;
+                readBits = 0;
+                functionCommand(writeShift);
+            }
+            else{
+                functionWrite(writeShift);
+            }
+        }
+        break;
+    case State::MatchRom:
+        matching = matching && bit == romBit(bitIndex);
+        if(++bitIndex == 64){
+            state = matching ? State::Function : State::Idle;
+        }
+        break;
+    case State::SearchRom:
+        if(searchPhase != 2 || bit != romBit(bitIndex)){
+            state = State::Idle; // not on the path the master chose
+            break;
+        }
+        searchPhase = 0;
+        if(++bitIndex == 64){
+            state = State::Function;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+bool OneWireDeviceModel::readSlot(){
+    if(!connected){
+        return true;
+    }
+    switch(state){
+    case State::ReadRom:
+    {
+        bool bit = romBit(bitIndex);
+        if(++bitIndex == 64){
+            state = State::Function;
+        }
+        return bit;
+    }
+    case State::SearchRom:
+        if(searchPhase == 0){
+            searchPhase = 1;
+            return romBit(bitIndex);
+        }
+        if(searchPhase == 1){
+            searchPhase = 2;
+            return !romBit(bitIndex);
+        }
+        return true;
+    case State::FunctionData:
+    {
+        if(readBits == 0){
+            readShift = functionRead();
+        }
+        bool bit = readShift & 1;
+        readShift >>= 1;
+        readBits = (readBits + 1) % 8;
+        return bit;
+    }
+    default:
+        return true;
+    }
+}
+
+DS18B20Model::DS18B20Model(uint64_t serial) :
+    OneWireDeviceModel(0x28, serial),
+    eeprom{0x4B, 0x46, 0x7F}, // factory settings: TH 75 C, TL 70 C, 12 bits
+    measured(25 * 16),
+    conversions(0),
+    command(0),
+    index(0)
+{
+    powerOnReset();
+}
+
+void DS18B20Model::powerOnReset(){
+    OneWireDeviceModel::powerOnReset();
+    scratchpad[0] = 0x50; // power on value is 85 C
+    scratchpad[1] = 0x05;
+    scratchpad[2] = eeprom[0];
+    scratchpad[3] = eeprom[1];
+    scratchpad[4] = eeprom[2];
+    scratchpad[5] = 0xFF;
+    scratchpad[6] = 0x0C;
+    scratchpad[7] = 0x10;
+    updateCrc();
+    command = 0;
+}
+
+void DS18B20Model::updateCrc(){
+    scratchpad[8] = OneWire::crc8(scratchpad, 8);
+}
+
+void DS18B20Model::functionCommand(uint8_t c){
+    command = c;
+    index = 0;
+    switch(command){
+    case 0x44: // convert T
+    {
+        conversions++;
+        uint8_t unusedBits = uint8_t(3 - ((scratchpad[4] >> 5) & 0x03)); // 0 at 12 bits, 3 at 9 bits
+        int16_t value = int16_t(measured & ~((1 << unusedBits) - 1));
+        scratchpad[0] = uint8_t(value);
+        scratchpad[1] = uint8_t(uint16_t(value) >> 8);
+        updateCrc();
+        break;
+    }
+    case 0x48: // copy scratchpad
+        std::copy(scratchpad + 2, scratchpad + 5, eeprom);
+        break;
+    case 0xB8: // recall EEPROM
+        std::copy(eeprom, eeprom + 3, scratchpad + 2);
+        updateCrc();
+        break;
+    case 0xBE: // read scratchpad
+    case 0x4E: // write scratchpad
+    case 0xB4: // read power supply, reads as 1 for external power
+        break;
+    default:
+        idle();
+        break;
+    }
+}
+
+void DS18B20Model::functionWrite(uint8_t data){
+    if(command == 0x4E && index < 3){
+        // the configuration register only has the resolution bits
+        scratchpad[2 + index] = (index == 2) ? uint8_t((data & 0x60) | 0x1F) : data;
+        index++;
+        updateCrc();
+    }
+}
+
+uint8_t DS18B20Model::functionRead(){
+    if(command == 0xBE && index < 9){
+        return scratchpad[index++];
+    }
+    return 0xFF; // conversions are complete, power supply is external
+}
+
+DS2413Model::DS2413Model(uint64_t serial) :
+    OneWireDeviceModel(0x3A, serial),
+    latches(0x03),
+    inputs(0x03),
+    command(0),
+    index(0),
+    written(0),
+    acknowledged(false)
+{
+}
+
+void DS2413Model::powerOnReset(){
+    OneWireDeviceModel::powerOnReset();
+    latches = 0x03;
+    command = 0;
+}
+
+uint8_t DS2413Model::status() const {
+    uint8_t pins = latches & inputs;
+    uint8_t lower = uint8_t((pins & 0x01) | ((latches & 0x01) << 1) | ((pins & 0x02) << 1) | ((latches & 0x02) << 2));
+    return uint8_t(lower | ((~lower & 0x0F) << 4));
+}
+
+void DS2413Model::functionCommand(uint8_t c){
+    command = c;
+    index = 0;
+    if(command != 0xF5 && command != 0x5A){ // PIO access read and write
+        idle();
+    }
+}
+
+void DS2413Model::functionWrite(uint8_t data){
+    if(command != 0x5A){
+        return;
+    }
+    if(index == 0){
+        written = data;
+        index = 1;
+    }
+    else if(index == 1){
+        // the data is sent a second time inverted, to guard against transmission errors
+        acknowledged = data == uint8_t(~written);
+        if(acknowledged){
+            latches = written & 0x03;
+        }
+        index = 2;
+    }
+}
+
+uint8_t DS2413Model::functionRead(){
+    if(command == 0xF5){
+        return status();
+    }
+    if(command == 0x5A){
+        if(index == 2){
+            index = 3;
+            return acknowledged ? 0xAA : 0xFF;
+        }
+        if(index == 3){
+            index = 0; // ready for the next write
+            return status();
+        }
+    }
+    return 0xFF;
+}
+
+DS2408Model::DS2408Model(uint64_t serial) :
+    OneWireDeviceModel(0x29, serial),
+    inputs(0xFF),
+    command(0),
+    index(0),
+    address(0),
+    written(0),
+    crc(0),
+    crcBytes{0, 0},
+    acknowledged(false)
+{
+    powerOnReset();
+}
+
+void DS2408Model::powerOnReset(){
+    OneWireDeviceModel::powerOnReset();
+    registers[PIO] = 0;
+    registers[LATCH] = 0xFF;
+    registers[ACTIVITY] = 0;
+    registers[3] = 0;
+    registers[4] = 0;
+    registers[STATUS] = 0x88; // VCC powered, power on reset latch set
+    registers[6] = 0xFF;
+    registers[7] = 0xFF;
+    updatePio();
+    registers[ACTIVITY] = 0;
+    command = 0;
+}
+
+void DS2408Model::setInputs(uint8_t levels){
+    inputs = levels;
+    updatePio();
+}
+
+void DS2408Model::updatePio(){
+    uint8_t pio = registers[LATCH] & inputs;
+    registers[ACTIVITY] |= uint8_t(pio ^ registers[PIO]);
+    registers[PIO] = pio;
+}
+
+void DS2408Model::functionCommand(uint8_t c){
+    command = c;
+    index = 0;
+    crc = OneWire::crc16(&c, 1);
+    switch(command){
+    case 0xF0: // read PIO registers
+    case 0xF5: // channel access read
+    case 0x5A: // channel access write
+        break;
+    case 0xC3: // reset activity latches
+        registers[ACTIVITY] = 0;
+        break;
+    default:
+        idle();
+        break;
+    }
+}
+
+void DS2408Model::functionWrite(uint8_t data){
+    if(command == 0xF0 && index < 2){
+        // target address, the upper byte is 0 for all registers
+        if(index == 0){
+            address = data;
+        }
+        crc = OneWire::crc16(&data, 1, crc);
+        index++;
+    }
+    else if(command == 0x5A){
+        if(index == 0){
+            written = data;
+            index = 1;
+        }
+        else if(index == 1){
+            acknowledged = data == uint8_t(~written);
+            if(acknowledged){
+                registers[LATCH] = written;
+                updatePio();
+            }
+            index = 2;
+        }
+    }
+}
+
+// appends the inverted CRC16 after every 32 bytes of channel access read data
+uint8_t DS2408Model::withCrc(uint8_t data){
+    if(index == 32){
+        crcBytes[0] = uint8_t(~crc);
+        crcBytes[1] = uint8_t(~crc >> 8);
+        index = 33;
+        return crcBytes[0];
+    }
+    if(index == 33){
+        index = 0;
+        crc = 0;
+        return crcBytes[1];
+    }
+    crc = OneWire::crc16(&data, 1, crc);
+    index++;
+    return data;
+}
+
+uint8_t DS2408Model::functionRead(){
+    switch(command){
+    case 0xF0:
+        if(index < 2){
+            return 0xFF;
+        }
+        if(address >= 0x88 && address <= 0x8F){
+            uint8_t data = registers[address - 0x88];
+            address++;
+            crc = OneWire::crc16(&data, 1, crc);
+            return data;
+        }
+        // the inverted CRC16 follows the last register
+        if(index == 2){
+            crcBytes[0] = uint8_t(~crc);
+            crcBytes[1] = uint8_t(~crc >> 8);
+        }
+        if(index < 4){
+            return crcBytes[index++ - 2];
+        }
+        return 0xFF;
+    case 0xF5:
+        return withCrc(registers[PIO]);
+    case 0x5A:
+        if(index == 2){
+            index = 3;
+            return acknowledged ? 0xAA : 0xFF;
+        }
+        if(index == 3){
+            index = 0;
+            return registers[PIO];
+        }
+        return 0xFF;
+    case 0xC3:
+        return 0xAA;
+    default:
+        return 0xFF;
+    }
+}
+
+static OneWireBusEmulator ** busRegistry(){
+    static OneWireBusEmulator * buses[256] = {};
+    return buses;
+}
+
+OneWireBusEmulator::OneWireBusEmulator(uint8_t pin_) : pin(pin_), statistics{0, 0, 0, 0} {
+    busRegistry()[pin] = this;
+}
+
+OneWireBusEmulator::~OneWireBusEmulator(){
+    if(busRegistry()[pin] == this){
+        busRegistry()[pin] = nullptr;
+    }
+}
+
+OneWireBusEmulator * OneWireBusEmulator::onPin(uint8_t pin){
+    return busRegistry()[pin];
+}
+
+void OneWireBusEmulator::add(OneWireDeviceModel & device){
+    devices.push_back(&device);
+}
+
+void OneWireBusEmulator::remove(OneWireDeviceModel & device){
+    devices.erase(std::remove(devices.begin(), devices.end(), &device), devices.end());
+}
+
+void OneWireBusEmulator::powerCycle(){
+    for(auto d : devices){
+        d->powerOnReset();
+    }
+}
+
+void OneWireBusEmulator::injectReadError(uint32_t slot){
+    readErrors.push_back(statistics.readSlots + slot);
+}
+
+void OneWireBusEmulator::resetStatistics(){
+    readErrors.clear();
+    statistics = Statistics{0, 0, 0, 0};
+}
+
+bool OneWireBusEmulator::reset(){
+    statistics.resets++;
+    statistics.micros += RESET_MICROS;
+    bool presence = false;
+    for(auto d : devices){
+        presence = d->resetPulse() || presence;
+    }
+    return presence;
+}
+
+void OneWireBusEmulator::writeSlot(bool bit){
+    statistics.writeSlots++;
+    statistics.micros += SLOT_MICROS;
+    for(auto d : devices){
+        d->writeSlot(bit);
+    }
+}
+
+bool OneWireBusEmulator::readSlot(){
+    uint32_t slot = statistics.readSlots++;
+    statistics.micros += SLOT_MICROS;
+    // open drain: any device can pull the bus low
+    bool level = true;
+    for(auto d : devices){
+        level = d->readSlot() && level;
+    }
+    auto error = std::find(readErrors.begin(), readErrors.end(), slot);
+    if(error != readErrors.end()){
+        readErrors.erase(error);
+        level = !level;
+    }
+    return level;
+}
+
+bool OneWireEmulator::reset(){
+    OneWireBusEmulator * bus = OneWireBusEmulator::onPin(pin);
+    return bus != nullptr && bus->reset();
+}
+
+void OneWireEmulator::write(uint8_t v, uint8_t power){
+    OneWireBusEmulator * bus = OneWireBusEmulator::onPin(pin);
+    if(bus == nullptr){
+        return;
+    }
+    for(uint8_t i = 0; i < 8; i++){
+        bus->writeSlot(v & 0x01);
+        v >>= 1;
+    }
+}
+
+uint8_t OneWireEmulator::read(){
+    OneWireBusEmulator * bus = OneWireBusEmulator::onPin(pin);
+    if(bus == nullptr){
+        return 0;
+    }
+    uint8_t v = 0;
+    for(uint8_t i = 0; i < 8; i++){
+        v |= uint8_t(bus->readSlot() ? 1 << i : 0);
+    }
+    return v;
+}
+
+void OneWireEmulator::write_bit(uint8_t v){
+    OneWireBusEmulator * bus = OneWireBusEmulator::onPin(pin);
+    if(bus != nullptr){
+        bus->writeSlot(v & 0x01);
+    }
+}
+
+uint8_t OneWireEmulator::read_bit(){
+    OneWireBusEmulator * bus = OneWireBusEmulator::onPin(pin);
+    return (bus != nullptr && bus->readSlot()) ? 1 : 0;
+}
+
+void OneWireEmulator::search_triplet(uint8_t * search_direction, uint8_t * id_bit, uint8_t * cmp_id_bit){
+    OneWireBusEmulator * bus = OneWireBusEmulator::onPin(pin);
+    if(bus == nullptr){
+        *id_bit = 1; // no devices
+        *cmp_id_bit = 1;
+        return;
+    }
+    *id_bit = bus->readSlot();
+    *cmp_id_bit = bus->readSlot();
+    if(*id_bit != *cmp_id_bit){
+        *search_direction = *id_bit;
+    }
+    else if(*id_bit){
+        *search_direction = 1; // no devices responded
+    }
+    bus->writeSlot(*search_direction);
+}
+
+#endif
@@ -49,7 +49,7 @@ bool OneWireTempSensor::init() {
     if(temp == DEVICE_DISCONNECTED_RAW){
         // Device was just powered on and should be initialized
         if(sensor.initConnection(settings.sensorAddress)){
-            requestConversion();
+            sensor.requestTemperaturesByAddress(settings.sensorAddress);
             waitForConversion();
             temp = sensor.getTempRaw(settings.sensorAddress);
         }
@@ -57,7 +57,8 @@ bool OneWireTempSensor::init() {
     DEBUG_ONLY(logInfoIntStringTemp(INFO_TEMP_SENSOR_INITIALIZED, addressString, temp));
     success = temp != DEVICE_DISCONNECTED_RAW;
     if(success){
-            state.cachedValue = temp;
+        state.cachedValue = fromRaw(temp);
+        scheduler.store(conversion, temp); // read() returns this until the next conversion completes
         requestConversion(); // piggyback request for a new conversion
     }
 
@@ -66,8 +67,8 @@ bool OneWireTempSensor::init() {
     return success;
 }
 
-void OneWireTempSensor::requestConversion() {
-    sensor.requestTemperaturesByAddress(settings.sensorAddress);
+uint16_t OneWireTempSensor::requestConversion() {
+    return scheduler.requestConversion();
 }
 
 void OneWireTempSensor::setConnected(bool connected) {
@@ -101,7 +102,7 @@ temp_t OneWireTempSensor::readAndConstrainTemp() {
     int16_t tempRaw;
     bool success;
 
-    tempRaw = sensor.getTempRaw(settings.sensorAddress);
+    tempRaw = scheduler.read(conversion);
     success = tempRaw != DEVICE_DISCONNECTED_RAW;
 
     if (!success){
@@ -118,6 +119,10 @@ temp_t OneWireTempSensor::readAndConstrainTemp() {
         return temp_t::invalid();
     }
 
+    return fromRaw(tempRaw);
+}
+
+temp_t OneWireTempSensor::fromRaw(int16_t tempRaw) const {
     const uint8_t shift = temp_t::fractional_bit_count - ONEWIRE_TEMP_SENSOR_PRECISION; // difference in precision between DS18B20 format and temperature adt
     temp_t temp;
     temp.setRaw(tempRaw << shift);
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OneWireTopology.h"
+#include "OneWire.h"
+#include <string.h>
+
+#if ONEWIRE_SEARCH
+
+OneWireTopology::OneWireTopology(OneWire & bus_,
+                                 ticks_millis_t stepInterval_,
+                                 ticks_millis_t checkInterval_,
+                                 ticks_millis_t searchInterval_) :
+    bus(bus_),
+    stepInterval(stepInterval_),
+    checkInterval(checkInterval_),
+    searchInterval(searchInterval_),
+    numDevices(0),
+    nextCheck(0),
+    searching(false),
+    searched(false),
+    lastStep(0),
+    lastSearchStart(0),
+    statistics{0, 0}
+{
+}
+
+bool OneWireTopology::address(uint8_t index, uint8_t * address) const {
+    if(index >= numDevices){
+        return false;
+    }
+    memcpy(address, devices[index].address, 8);
+    return true;
+}
+
+ticks_millis_t OneWireTopology::lastSeen(const uint8_t * address) const {
+    int8_t index = find(address);
+    return index >= 0 ? devices[index].lastSeen : 0;
+}
+
+int8_t OneWireTopology::find(const uint8_t * address) const {
+    for(uint8_t i = 0; i < numDevices; i++){
+        if(memcmp(devices[i].address, address, 8) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+void OneWireTopology::notify(const uint8_t * address, Change change){
+    if(listener){
+        listener(*this, address, change);
+    }
+}
+
+void OneWireTopology::seen(const uint8_t * address, ticks_millis_t now){
+    int8_t index = find(address);
+    if(index < 0){
+        if(numDevices == MAX_DEVICES){
+            return; // no room, the device will be added when another one is removed
+        }
+        index = numDevices++;
+        memcpy(devices[index].address, address, 8);
+        notify(address, Change::Added);
+    }
+    Device & d = devices[index];
+    d.lastSeen = now;
+    d.misses = 0;
+    d.found = true;
+}
+
+void OneWireTopology::remove(uint8_t index){
+    uint8_t address[8];
+    memcpy(address, devices[index].address, 8);
+    numDevices--;
+    for(uint8_t i = index; i < numDevices; i++){
+        devices[i] = devices[i + 1];
+    }
+    if(nextCheck > index){
+        nextCheck--;
+    }
+    notify(address, Change::Removed);
+}
+
+/*
+ * Returns true when the device is present. A device that misses MISSES_TO_REMOVE checks in a row is removed.
+ */
+bool OneWireTopology::checkPresence(uint8_t index, ticks_millis_t now){
+    statistics.presenceChecks++;
+    Device & d = devices[index];
+    if(bus.verify(d.address)){
+        d.lastSeen = now;
+        d.misses = 0;
+        return true;
+    }
+    if(++d.misses >= MISSES_TO_REMOVE){
+        remove(index);
+    }
+    return false;
+}
+
+void OneWireTopology::startSearch(ticks_millis_t now){
+    bus.reset_search();
+    for(uint8_t i = 0; i < numDevices; i++){
+        devices[i].found = false;
+    }
+    searching = true;
+    searched = true;
+    lastSearchStart = now;
+}
+
+/*
+ * Finds the next device of the current search pass. Returns false when the pass is complete.
+ */
+bool OneWireTopology::searchStep(ticks_millis_t now){
+    statistics.searchSteps++;
+    uint8_t address[8];
+    if(bus.search(address)){
+        if(OneWire::crc8(address, 7) == address[7]){
+            seen(address, now);
+        }
+        return true;
+    }
+    searching = false;
+    return false;
+}
+
+void OneWireTopology::update(ticks_millis_t now){
+    if(searched && now - lastStep < stepInterval){
+        return;
+    }
+    lastStep = now;
+
+    // presence checks go first, so a removed device is noticed even while a long search pass is running
+    for(uint8_t n = 0; n < numDevices; n++){
+        uint8_t i = (nextCheck + n) % numDevices;
+        if(now - devices[i].lastSeen >= checkInterval){
+            nextCheck = i + 1;
+            checkPresence(i, now);
+            return;
+        }
+    }
+
+    if(!searching && (!searched || now - lastSearchStart >= searchInterval)){
+        startSearch(now);
+    }
+    if(searching){
+        searchStep(now);
+    }
+}
+
+void OneWireTopology::refresh(ticks_millis_t now){
+    startSearch(now);
+    while(searchStep(now)){
+    }
+    // the search can miss a device because of a transmission error, only remove devices that fail a check too
+    for(uint8_t i = numDevices; i-- > 0;){
+        if(!devices[i].found && !bus.verify(devices[i].address)){
+            remove(i);
+        }
+    }
+    lastStep = now;
+}
+
+#endif
@@ -54,6 +54,7 @@ void Pid::setConstants(temp_long_t kp,
 
 void Pid::update()
 {
+    constexpr temp_long_t zero(0.0); // converted at compile time
     temp_t currentSetPoint = input.setting();
     temp_t inputVal = input.value();
     bool validSensor = !inputVal.isDisabledOrInvalid();
@@ -124,7 +125,7 @@ void Pid::update()
     else{
         // calculate PID parts.
         p = Kp * -inputError;
-        i = (Ti != 0) ? (integral/Ti) : temp_long_t(0.0);
+        i = (Ti != 0) ? (integral/Ti) : zero;
         d = -Kp * (derivative * Td);
     }
 
@@ -161,8 +162,8 @@ void Pid::update()
             antiWindup = pidResult - achievedSetting;
             antiWindup *= 3; // Anti windup gain is 3
             // make sure anti-windup is at least p when clipping to prevent further windup
-            antiWindup = (p > temp_long_t(0.0) && antiWindup < p) ? p : antiWindup;
-            antiWindup = (p < temp_long_t(0.0) && antiWindup > p) ? p : antiWindup;
+            antiWindup = (p > zero && antiWindup < p) ? p : antiWindup;
+            antiWindup = (p < zero && antiWindup > p) ? p : antiWindup;
         }
         else {
             temp_t achievedOutput = output.value();
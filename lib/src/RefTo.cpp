@@ -26,6 +26,8 @@
 #include "SensorSetPointPair.h"
 #include "VisitorCast.h"
 
+uint32_t RefToGeneric::generation = 1;
+
 template<>
 ActuatorDigital * defaultTarget<ActuatorDigital>(){
     static ActuatorNop s;
@@ -18,6 +18,7 @@
  */
 
 #include "temperatureFormats.h"
+#include <cstring>
 
 // Converting constructors, which shift and constrain the value.
 
@@ -356,6 +357,115 @@ temp_long_t temp_long_t::operator/(uint16_t const rhs) {
     return result;
 }
 
+// 5^n for n decimals, multiplying by 5^n and shifting n bits less than the fixed point scale is * 10^n / 2^F
+static const uint32_t powersOf5[] = { 1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125 };
+
+static const uint32_t powersOf10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+        1000000000 };
+
+// two ASCII digits for each value 0-99, so digits can be written in pairs
+static const char digitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+// writes the decimal digits of v backwards, ending before end. Returns a pointer to the first digit.
+// Dividing by 100 with a reciprocal multiply is exact for all 32 bit values.
+static char * putDigits(char * end, uint32_t v)
+{
+    char * p = end;
+    while (v >= 100) {
+        uint32_t q = uint32_t((uint64_t(v) * 0x51EB851Fu) >> 37);
+        uint32_t pair = v - q * 100;
+        p -= 2;
+        p[0] = digitPairs[2 * pair];
+        p[1] = digitPairs[2 * pair + 1];
+        v = q;
+    }
+    if (v >= 10) {
+        p -= 2;
+        p[0] = digitPairs[2 * v];
+        p[1] = digitPairs[2 * v + 1];
+    } else {
+        *--p = char('0' + v);
+    }
+    return p;
+}
+
+// enough for all digits of a 64 bit value, the decimal point and a minus sign
+static const uint8_t MAX_FORMATTED_LENGTH = 22;
+
+// formats a fixed point value without padding, writing backwards and ending before end.
+// Returns a pointer to the first character.
+static char * formatFixedPoint(char * end,
+        int32_t const raw,
+        unsigned char const F,
+        uint8_t const numDecimals,
+        char format,
+        bool absolute)
+{
+    int64_t shifter = raw;
+
+    if (format == 'F') {
+        if (raw > -(INT32_C(1) << 24) && raw < (INT32_C(1) << 24)) {
+            // fits in 32 bits, which avoids a 64 bit division
+            int32_t rounder = (raw < 0) ? -25 : 25;
+            shifter = (raw * 90 + rounder) / 50;
+        } else {
+            int8_t rounder = (shifter < 0) ? -25 : 25;
+            shifter = (shifter * 90 + rounder) / 50;
+        }
+        if (absolute) {
+            shifter += int64_t(32) << F;
+        }
+    }
+
+    bool negative = shifter < 0;
+    uint64_t magnitude = negative ? uint64_t(-shifter) : uint64_t(shifter);
+
+    // * 10^numDecimals / 2^F, rounded
+    unsigned char shift = F - numDecimals;
+    magnitude = (magnitude * powersOf5[numDecimals] + (uint64_t(1) << (shift - 1))) >> shift;
+
+    char * p;
+    if (magnitude >> 32) {
+        // only for the widest formats with many decimals, split off the lower 8 digits with a single division
+        uint32_t high = uint32_t(magnitude / powersOf10[8]);
+        uint32_t low = uint32_t(magnitude - uint64_t(high) * powersOf10[8]);
+        p = putDigits(end, low);
+        while (p > end - 8) {
+            *--p = '0';
+        }
+        p = putDigits(p, high);
+    } else {
+        p = putDigits(end, uint32_t(magnitude));
+    }
+
+    // at least one digit before the decimal point
+    while (p > end - numDecimals - 1) {
+        *--p = '0';
+    }
+    // move the integer part one place to the front to make room for the decimal point
+    char * point = end - numDecimals - 1;
+    for (char * c = p; c < point + 1; c++) {
+        c[-1] = c[0];
+    }
+    p--;
+    *point = '.';
+
+    if (negative) {
+        *--p = '-';
+    }
+    return p;
+}
+
 // converts fixed point value to string, without using double/float
 // resulting string is always length len (including \0). Spaces are prepended to achieve that
 char * toStringImpl(const int32_t raw, // raw value of fixed point
@@ -366,61 +476,87 @@ char * toStringImpl(const int32_t raw, // raw value of fixed point
         char format, // C or F
         bool absolute) // is this an absolute temperature? need to subtract 32 for F
         {
-
-    char const digit[] = "0123456789";
-    char* p;
-    bool negative = false;
-
-    // Use larger type to prevent overflow.
-    int64_t shifter = raw;
-
-    if(format =='F'){
-        int8_t rounder = (shifter < 0) ? -25 : 25;
-        shifter = (shifter * 90 + rounder) / 50;
-        if(absolute){
-            shifter += 32 << F;
-        }
+    char formatted[MAX_FORMATTED_LENGTH];
+    char * end = &formatted[MAX_FORMATTED_LENGTH];
+    char * start = formatFixedPoint(end, raw, F, numDecimals, format, absolute);
+
+    // when the value does not fit, the characters at the front are left out
+    uint8_t length = uint8_t(end - start);
+    if (length > len - 1) {
+        start = end - (len - 1);
+        length = len - 1;
     }
+    char * pWithoutSpaces = &buf[len - 1 - length];
+    memset(buf, ' ', len - 1 - length); // prepend digits with spaces
+    memcpy(pWithoutSpaces, start, length);
+    buf[len - 1] = '\0';
+    // return pointer to string skipping spaces
+    // programmer can choose to use original buf pointer with spaces or return value without spaces
+    return pWithoutSpaces;
+}
 
-    if (shifter < 0) {
-        shifter = -shifter;
-        negative = true;
-    }
-    // code below looks a bit cryptic, but what it does is * 10^numDecimals / 2^F
-    for (uint8_t i = 0; i < numDecimals; i++) {
-        shifter = shifter * 5; // *5 instead of 10, combined with reduced shift below. Less chance of overflow
+// appends a formatted value and separator to buf, returns the number of characters added or 0 if they don't fit
+static uint16_t appendFixedPoint(char buf[],
+        uint16_t space, // characters available, not counting the \0
+        int32_t raw,
+        unsigned char F,
+        uint8_t numDecimals,
+        char separator,
+        char format,
+        bool absolute)
+{
+    char formatted[MAX_FORMATTED_LENGTH];
+    char * end = &formatted[MAX_FORMATTED_LENGTH];
+    char * start = formatFixedPoint(end, raw, F, numDecimals, format, absolute);
+    uint16_t length = uint16_t(end - start);
+    if (length + 1u > space) {
+        return 0;
     }
-    shifter = (shifter + (1 << (F - numDecimals - 1))) >> (F - numDecimals); // divide rounded by fixed point scale
-
-    p = &buf[len - 1]; // start at the end of buffer
-    *p = '\0';
-    lldiv_t dv { };
-    dv.quot = shifter;
-    do { //Move back, inserting digits as u go
-        if (p == &buf[len - 1 - numDecimals]) {
-            *--p = '.'; // insert decimal point at right moment
-        } else {
-            dv = lldiv(dv.quot, 10);
-            if ((dv.quot || dv.rem)) { // check if end of digits
-                *--p = digit[std::abs(dv.rem)];
-            } else if ((p - buf) > (len - numDecimals - 3)) { // still need to print some leading zeros
-                *--p = '0';
-            } else if (negative) {
-                // print minus sign if needed as last digit to print
-                *--p = '-';
-                break;
-            } else {
-                break;
+    memcpy(buf, start, length);
+    buf[length] = separator;
+    return length + 1;
+}
+
+uint16_t temp_t::toTempStrings(temp_t const values[], uint8_t count, char buf[], uint16_t size,
+        uint8_t numDecimals, char separator, char format, bool absolute)
+{
+    uint16_t written = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t space = size - 1 - written;
+        uint16_t added;
+        if (values[i].isDisabledOrInvalid()) {
+            added = (space >= 5) ? 5 : 0;
+            if (added) {
+                memcpy(&buf[written], "null", 4);
+                buf[written + 4] = separator;
             }
+        } else {
+            added = appendFixedPoint(&buf[written], space, values[i].value_, fractional_bit_count, numDecimals,
+                    separator, format, absolute);
         }
-    } while (p > buf);
-    char * pWithoutSpaces = p;
-    while (p > buf) {
-        *(--p) = ' '; // prepend digits with spaces
+        if (added == 0) {
+            break;
+        }
+        written += added;
     }
-    // return pointer to string skipping spaces
-    // programmer can choose to use original buf pointer with spaces or return value without spaces
-    return pWithoutSpaces;
+    buf[written] = '\0';
+    return written;
+}
+
+uint16_t temp_long_t::toStrings(temp_long_t const values[], uint8_t count, char buf[], uint16_t size,
+        uint8_t numDecimals, char separator)
+{
+    uint16_t written = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t added = appendFixedPoint(&buf[written], size - 1 - written, values[i].value_,
+                fractional_bit_count, numDecimals, separator, 'C', false);
+        if (added == 0) {
+            break;
+        }
+        written += added;
+    }
+    buf[written] = '\0';
+    return written;
 }
 
 // Converts string into fixed point and returns bool on success.
@@ -461,8 +597,16 @@ bool fromStringImpl(int32_t * raw, // result is put in this variable upon succes
 
         decimalValue = decimalValue << F;
         uint8_t charsAfterPoint = end - decimalPtr; // actually used # digits after point
-        while (charsAfterPoint-- > 0) {
+        while (charsAfterPoint > 9) {
             decimalValue = (decimalValue + 5) / 10;
+            charsAfterPoint--;
+        }
+        // a single rounded division instead of rounding after each digit, in 32 bits when the value fits
+        uint32_t divisor = powersOf10[charsAfterPoint];
+        if (decimalValue >= 0 && decimalValue < (INT64_C(1) << 31)) {
+            decimalValue = (uint32_t(decimalValue) + (divisor >> 1)) / divisor;
+        } else {
+            decimalValue = (decimalValue + (divisor >> 1)) / divisor;
         }
     }
     newValue = positive ? newValue + decimalValue : newValue - decimalValue;
@@ -31,6 +31,10 @@
 #include "Ticks.h"
 #include "ActuatorMutexGroup.h"
 #include "ActuatorMutexDriver.h"
+#include "ActuatorPwm.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE(ActuatorMutexTest)
 
@@ -208,5 +212,118 @@ BOOST_AUTO_TEST_CASE(test_destructors1) {
 }
 
 
-BOOST_AUTO_TEST_SUITE_END()
+/*
+ * Runs PWM actuators with a 60 second period that share a mutex group, with a fast update every 100 ms and a mutex
+ * update every second. Returns for each actuator the achieved duty as a percentage of its setting.
+ */
+std::vector<double> achievedDutyInMutexGroup(const std::vector<double> & duties, ticks_millis_t deadTime, ticks_millis_t duration){
+    ActuatorMutexGroup mutex;
+    mutex.setDeadTime(deadTime);
+    std::vector<std::unique_ptr<ActuatorBool>> pins;
+    std::vector<std::unique_ptr<ActuatorMutexDriver>> drivers;
+    std::vector<std::unique_ptr<ActuatorPwm>> pwms;
+    for(double duty : duties){
+        pins.emplace_back(new ActuatorBool());
+        drivers.emplace_back(new ActuatorMutexDriver(*pins.back(), &mutex));
+        pwms.emplace_back(new ActuatorPwm(*drivers.back(), 60));
+        pwms.back()->set(duty);
+    }
+
+    std::vector<ticks_millis_t> highTimes(duties.size(), 0);
+    ticks_millis_t start = ticks.millis();
+    for(ticks_millis_t t = 0; t < duration; t += 100){
+        for(auto & pwm : pwms){
+            pwm->fastUpdate();
+        }
+        if(t % 1000 == 0){
+            mutex.update();
+        }
+        unsigned active = 0;
+        for(size_t i = 0; i < pins.size(); i++){
+            if(pins[i]->getState() == ActuatorDigital::State::Active){
+                highTimes[i] += 100;
+                active++;
+            }
+        }
+        BOOST_REQUIRE(active <= 1);
+        delay(100);
+    }
+    ticks_millis_t elapsed = ticks.millis() - start;
+
+    std::vector<double> achieved;
+    double totalHigh = 0;
+    double totalDuty = 0;
+    for(size_t i = 0; i < duties.size(); i++){
+        achieved.push_back(100.0 * (100.0 * highTimes[i] / elapsed) / duties[i]);
+        totalHigh += 100.0 * highTimes[i] / elapsed;
+        totalDuty += duties[i];
+    }
+    BOOST_TEST_MESSAGE("group of " << duties.size() << ": " << 100.0 * totalHigh / totalDuty << "% of total duty achieved, "
+                       << "lowest " << *std::min_element(achieved.begin(), achieved.end()) << "%");
+    return achieved;
+}
+
+BOOST_AUTO_TEST_CASE(mutex_group_of_4_achieves_most_of_the_total_duty) {
+    std::vector<double> duties = {10, 15, 20, 25};
+    auto achieved = achievedDutyInMutexGroup(duties, 10000, 4 * 3600000);
+    double totalHigh = 0;
+    double totalDuty = 0;
+    for(size_t i = 0; i < duties.size(); i++){
+        totalHigh += achieved[i] * duties[i];
+        totalDuty += duties[i];
+    }
+    // the highest priority is served first, the 10 second dead time for each switch is the only loss
+    BOOST_CHECK_GT(totalHigh / totalDuty, 75);
+}
+
+BOOST_AUTO_TEST_CASE(waiting_request_with_highest_priority_goes_first) {
+    auto act1 = ActuatorBool();
+    auto act2 = ActuatorBool();
+    auto act3 = ActuatorBool();
+    auto mutex = ActuatorMutexGroup();
+    auto actm1 = ActuatorMutexDriver(act1, &mutex);
+    auto actm2 = ActuatorMutexDriver(act2, &mutex);
+    auto actm3 = ActuatorMutexDriver(act3, &mutex);
+
+    actm1.setState(ActuatorDigital::State::Active, 50);
+    BOOST_CHECK(act1.getState() == ActuatorDigital::State::Active);
 
+    // act2 keeps asking with a low priority while act1 is active
+    for(int i = 0; i < 30; i++){
+        actm2.setState(ActuatorDigital::State::Active, 5);
+        delay(1000);
+    }
+    BOOST_CHECK(act2.getState() == ActuatorDigital::State::Inactive);
+    actm1.setState(ActuatorDigital::State::Inactive);
+
+    // waiting longer does not raise the priority, a new request with a higher priority gets ahead
+    actm3.setState(ActuatorDigital::State::Active, 20);
+    BOOST_CHECK(act3.getState() == ActuatorDigital::State::Active);
+    BOOST_CHECK(mutex.getNextActuator() == &actm2);
+}
+
+BOOST_AUTO_TEST_CASE(waiting_requests_expire_when_not_repeated) {
+    auto act1 = ActuatorBool();
+    auto act2 = ActuatorBool();
+    auto act3 = ActuatorBool();
+    auto mutex = ActuatorMutexGroup();
+    auto actm1 = ActuatorMutexDriver(act1, &mutex);
+    auto actm2 = ActuatorMutexDriver(act2, &mutex);
+    auto actm3 = ActuatorMutexDriver(act3, &mutex);
+
+    actm1.setState(ActuatorDigital::State::Active, 5);
+    actm2.setState(ActuatorDigital::State::Active, 3);
+    actm3.setState(ActuatorDigital::State::Active, 10);
+    actm1.setState(ActuatorDigital::State::Inactive);
+    BOOST_CHECK(mutex.getNextActuator() == &actm3);
+
+    for(int i = 0; i < 10; i++){
+        mutex.update();
+    }
+    BOOST_CHECK(mutex.getNextActuator() == &actm3); // priority of act3 has decreased to 0
+
+    mutex.update();
+    BOOST_CHECK(mutex.getNextActuator() == nullptr); // all requests have expired
+}
+
+BOOST_AUTO_TEST_SUITE_END()
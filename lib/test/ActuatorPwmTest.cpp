@@ -615,6 +615,38 @@ BOOST_AUTO_TEST_CASE(actual_value_returned_by_ActuatorPwm_readValue_is_correct){
 }
 
 
+BOOST_AUTO_TEST_CASE(cached_value_follows_toggles_within_the_same_millisecond){
+    // pwm1 is read before and after each update, so a stale cached value would show after a toggle.
+    // pwm2 is read only after its update, with the time passed in once for both calls.
+    auto boolAct1 = ActuatorBool();
+    auto pwmAct1 = ActuatorPwm(boolAct1, 4);
+    auto boolAct2 = ActuatorBool();
+    auto pwmAct2 = ActuatorPwm(boolAct2, 4);
+
+    pwmAct1.set(30.0);
+    pwmAct2.set(30.0);
+    int toggles = 0;
+    for(int i = 0; i < 20000; i++){
+        if(i == 10000){
+            pwmAct1.set(60.0);
+            pwmAct2.set(60.0);
+        }
+        ActuatorDigital::State before = boolAct1.getState();
+        temp_t valueBefore = pwmAct1.value();
+        pwmAct1.fastUpdate();
+        ticks_millis_t now = ticks.millis();
+        pwmAct2.fastUpdate(now);
+        if(boolAct1.getState() != before){
+            toggles++;
+        }
+        BOOST_REQUIRE(boolAct1.getState() == boolAct2.getState());
+        BOOST_REQUIRE_EQUAL(pwmAct1.value(), pwmAct2.value(now));
+        BOOST_REQUIRE(pwmAct1.value() == valueBefore || boolAct1.getState() != before || i == 10000);
+        delay(7);
+    }
+    BOOST_CHECK_GT(toggles, 50);
+}
+
 BOOST_AUTO_TEST_CASE(actual_value_returned_by_ActuatorPwm_readValue_is_correct_with_time_limited_actuator){
     auto boolAct = ActuatorBool();
     auto timeLimitedAct = ActuatorTimeLimited(boolAct, 2, 5);
@@ -782,4 +814,62 @@ BOOST_AUTO_TEST_CASE(decreasing_pwm_value_after_long_high_time_and_mutex_wait){
     }
 }
 
+BOOST_AUTO_TEST_CASE(pwm_does_not_toggle_before_wait_time_has_passed){
+    auto boolAct = ActuatorBool();
+    auto pwmAct = ActuatorPwm(boolAct, 10);
+
+    ticks_millis_t start = ticks.millis();
+    ticks_millis_t deadline = start;
+    uint32_t toggles = 0;
+    uint32_t onTime = 0;
+    ActuatorDigital::State previous = boolAct.getState();
+    while(ticks.millis() - start < 200000){ // 20 periods, with 1 ms resolution
+        ticks_millis_t elapsed = ticks.millis() - start;
+        // change the duty cycle in the middle of periods. A new setting invalidates the wait time.
+        temp_t duty = elapsed < 50000 ? 30.0 : (elapsed < 123456 ? 75.0 : 10.0);
+        if(duty != pwmAct.setting()){
+            pwmAct.set(duty);
+            deadline = ticks.millis();
+        }
+        pwmAct.fastUpdate();
+        if(boolAct.getState() != previous){
+            BOOST_REQUIRE_MESSAGE(ticks.millis() >= deadline, "toggled at " << ticks.millis() << " before " << deadline);
+            previous = boolAct.getState();
+            toggles++;
+        }
+        ticks_millis_t wait = pwmAct.getWaitTime();
+        if(wait > 0){
+            deadline = ticks.millis() + wait;
+        }
+        if(boolAct.getState() == ActuatorDigital::State::Active){
+            onTime++;
+        }
+        delay(1);
+    }
+    BOOST_CHECK(toggles >= 38);
+    BOOST_CHECK_CLOSE(onTime / 2000.0, (5*30.0 + 7.3456*75.0 + 7.6544*10.0)/20, 5);
+}
+
+BOOST_AUTO_TEST_CASE(pwm_skipping_ahead_by_wait_time_gives_same_duty_cycle){
+    auto boolAct = ActuatorBool();
+    auto pwmAct = ActuatorPwm(boolAct, 10);
+    pwmAct.set(35.0);
+
+    ticks_millis_t start = ticks.millis();
+    ticks_millis_t onTime = 0;
+    uint32_t updates = 0;
+    while(ticks.millis() - start < 1000000){ // 100 periods
+        pwmAct.fastUpdate();
+        ticks_millis_t wait = pwmAct.getWaitTime();
+        BOOST_REQUIRE(wait > 0);
+        if(boolAct.getState() == ActuatorDigital::State::Active){
+            onTime += wait;
+        }
+        delay(wait);
+        updates++;
+    }
+    BOOST_CHECK_CLOSE(onTime / 10000.0, 35.0, 1);
+    BOOST_CHECK(updates <= 201); // only the toggles
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -135,4 +135,46 @@ BOOST_AUTO_TEST_CASE(correct_state_is_returned_with_actuatorNop) {
 	delete act;
 }
 
+BOOST_AUTO_TEST_CASE(wait_time_is_time_until_state_can_change) {
+    ticks.reset();
+    ActuatorBool v;
+    const uint16_t minOn = 100;
+    const uint16_t maxOn = 200;
+    const uint16_t minOff = 300;
+    ActuatorTimeLimited act(v, minOn, minOff, maxOn);
+
+    delay(minOff*2000 + 250);
+    BOOST_CHECK_EQUAL(act.getWaitTime(), 0u);
+    act.setState(ActuatorDigital::State::Active);
+    BOOST_REQUIRE(act.getState() == ActuatorDigital::State::Active);
+
+    ticks_millis_t wait = act.getWaitTime();
+    BOOST_CHECK_EQUAL(wait, (minOn + 1) * 1000u - 250);
+    delay(wait - 1);
+    act.setState(ActuatorDigital::State::Inactive);
+    BOOST_CHECK(act.getState() == ActuatorDigital::State::Active); // one millisecond too early
+    delay(1);
+    // minimum on time has passed, next limit is the maximum on time
+    BOOST_CHECK_EQUAL(act.getWaitTime(), (maxOn - minOn - 1) * 1000u);
+    act.setState(ActuatorDigital::State::Inactive);
+    BOOST_CHECK(act.getState() == ActuatorDigital::State::Inactive);
+
+    wait = act.getWaitTime();
+    BOOST_CHECK_EQUAL(wait, (minOff + 1) * 1000u);
+    delay(wait - 1);
+    act.setState(ActuatorDigital::State::Active);
+    BOOST_CHECK(act.getState() == ActuatorDigital::State::Inactive);
+    delay(1);
+    act.setState(ActuatorDigital::State::Active);
+    BOOST_CHECK(act.getState() == ActuatorDigital::State::Active);
+
+    BOOST_CHECK_EQUAL(act.getWaitTime(), (minOn + 1) * 1000u);
+    delay(maxOn * 1000 - 1);
+    act.update();
+    BOOST_CHECK(act.getState() == ActuatorDigital::State::Active);
+    delay(1);
+    act.update();
+    BOOST_CHECK(act.getState() == ActuatorDigital::State::Inactive); // forced off at maximum on time
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include "ControlGraph.h"
+#include "RefTo.h"
+#include "ActuatorMocks.h"
+#include "ActuatorMutexDriver.h"
+#include "ActuatorMutexGroup.h"
+#include "ActuatorPwm.h"
+#include "ActuatorOffset.h"
+#include "ActuatorDigitalDelegate.h"
+#include "TempSensorMock.h"
+#include "SetPoint.h"
+#include "SensorSetPointPair.h"
+#include "Pid.h"
+
+/*
+ * Beer temperature controls the fridge setpoint, fridge temperature controls a heater, like Control
+ */
+struct ControlGraphFixture {
+    ControlGraphFixture() :
+        beerSensor(20.0),
+        beerSet(20.0),
+        beer(beerSensor, beerSet),
+        fridgeSensor(20.0),
+        fridgeSet(20.0),
+        fridge(fridgeSensor, fridgeSet),
+        heaterPin(),
+        heaterToggle([this]() -> Interface * { return &heaterPin; }),
+        mutex(),
+        heaterMutex(heaterToggle, &mutex),
+        heaterPwm(heaterMutex, 4),
+        heaterPid(fridge, heaterPwm),
+        fridgeOffset(fridge, beer),
+        beerToFridgePid(beer, fridgeOffset)
+    {
+        // registered in reverse data flow order on purpose
+        objects = {&heaterPwm, &heaterPid, &mutex, &beerToFridgePid, &fridgeSensor, &beerSensor};
+    }
+
+    static size_t position(const std::vector<Interface *> & table, Interface * obj){
+        return std::find(table.begin(), table.end(), obj) - table.begin();
+    }
+
+    TempSensorMock beerSensor;
+    SetPointSimple beerSet;
+    SensorSetPointPair beer;
+    TempSensorMock fridgeSensor;
+    SetPointSimple fridgeSet;
+    SensorSetPointPair fridge;
+    ActuatorBool heaterPin;
+    ActuatorDigitalDelegate heaterToggle;
+    ActuatorMutexGroup mutex;
+    ActuatorMutexDriver heaterMutex;
+    ActuatorPwm heaterPwm;
+    Pid heaterPid;
+    ActuatorOffset fridgeOffset;
+    Pid beerToFridgePid;
+    std::vector<Interface *> objects;
+    ControlGraph graph;
+};
+
+BOOST_FIXTURE_TEST_SUITE(ControlGraphTest, ControlGraphFixture)
+
+BOOST_AUTO_TEST_CASE(update_table_is_sorted_by_data_flow){
+    graph.compile(objects);
+    auto & table = graph.getUpdateTable();
+
+    // sensors have an empty update() and are left out
+    BOOST_CHECK_EQUAL(table.size(), 4u);
+    BOOST_CHECK_EQUAL(position(table, &fridgeSensor), table.size());
+    BOOST_CHECK_EQUAL(position(table, &beerSensor), table.size());
+
+    // beer pid sets the fridge setpoint, which is the input of the heater pid, which drives the PWM
+    BOOST_CHECK_LT(position(table, &beerToFridgePid), position(table, &heaterPid));
+    BOOST_CHECK_LT(position(table, &heaterPid), position(table, &heaterPwm));
+    // the mutex group grants requests of the mutex driver that the PWM toggles
+    BOOST_CHECK_LT(position(table, &mutex), position(table, &heaterPwm));
+}
+
+BOOST_AUTO_TEST_CASE(fast_update_table_only_contains_objects_with_fast_update){
+    graph.compile(objects);
+    auto & table = graph.getFastUpdateTable();
+
+    BOOST_REQUIRE_EQUAL(table.size(), 1u);
+    BOOST_CHECK_EQUAL(table[0], &heaterPwm);
+}
+
+BOOST_AUTO_TEST_CASE(graph_is_stale_after_topology_change){
+    BOOST_CHECK(graph.isStale(objects));
+    graph.compile(objects);
+    BOOST_CHECK(!graph.isStale(objects));
+
+    RefToGeneric::invalidateAll();
+    BOOST_CHECK(graph.isStale(objects));
+    graph.compile(objects);
+    BOOST_CHECK(!graph.isStale(objects));
+
+    objects.push_back(&fridgeSet);
+    BOOST_CHECK(graph.isStale(objects));
+}
+
+BOOST_AUTO_TEST_CASE(graph_is_stale_when_an_object_is_replaced){
+    graph.compile(objects);
+    BOOST_CHECK(!graph.isStale(objects));
+
+    BOOST_CHECK_LT(position(graph.getUpdateTable(), &heaterPwm), graph.getUpdateTable().size());
+
+    // same number of objects, but the PWM is replaced, so it should no longer be updated
+    objects[0] = &fridgeSet;
+    BOOST_CHECK(graph.isStale(objects));
+    graph.compile(objects);
+    BOOST_CHECK(!graph.isStale(objects));
+    BOOST_CHECK_EQUAL(position(graph.getUpdateTable(), &heaterPwm), graph.getUpdateTable().size());
+}
+
+BOOST_AUTO_TEST_CASE(graph_update_drives_actuator_like_object_loop){
+    fridgeSensor.setTemp(temp_t(18.0));
+    heaterPid.setConstants(temp_long_t(10.0), 0, 0);
+    heaterPid.setInputFilter(0);
+    heaterPid.setDerivativeFilter(0);
+    beerToFridgePid.setConstants(temp_long_t(0.0), 0, 0);
+    mutex.setDeadTime(0);
+
+    graph.compile(objects);
+    for(int i = 0; i < 10; i++){
+        graph.update();
+        graph.fastUpdate();
+        ticks.incMillis(1000);
+    }
+    BOOST_CHECK_GT(heaterPwm.setting(), temp_t(0.0));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include "DS248xAsync.h"
+#include "DS248xModel.h"
+#include <set>
+#include <algorithm>
+
+struct DS248xAsyncFixture {
+    DS248xAsyncFixture() : driver(model) {
+        model.devices.push_back({{0x28, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07}, {0x50, 0x05, 1, 0, 0x7F, 0xFF, 0x0C, 0x10, 0x1C}});
+        model.devices.push_back({{0x28, 0x81, 0x02, 0x03, 0x04, 0x05, 0x06, 0x08}, {0x60, 0x01, 1, 0, 0x7F, 0xFF, 0x0C, 0x10, 0x2D}});
+        model.devices.push_back({{0x3A, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77}, {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09}});
+    }
+
+    /**
+     * Polls until the transaction completes, with the given time between polls.
+     * @return the longest time spent in a single poll.
+     */
+    uint32_t run(OneWireTransaction & t, uint32_t loopMicros) {
+        uint32_t worst = 0;
+        for (int i = 0; i < 100000 && !t.completed(); i++) {
+            uint32_t start = model.now;
+            driver.poll();
+            worst = std::max(worst, model.now - start);
+            model.advance(loopMicros);
+        }
+        return worst;
+    }
+
+    /**
+     * Polls until the transaction completes without doing anything else, like the blocking driver does.
+     * @return the total time until completion.
+     */
+    uint32_t runBlocking(OneWireTransaction & t) {
+        uint32_t start = model.now;
+        run(t, 20); // the blocking driver waits 20 us between status reads
+        return model.now - start;
+    }
+
+    DS248xModel model;
+    DS248xAsync driver;
+};
+
+BOOST_FIXTURE_TEST_SUITE(DS248xAsyncTest, DS248xAsyncFixture)
+
+static void countCompletion(OneWireTransaction & t, void * context) {
+    (*static_cast<int *>(context))++;
+}
+
+BOOST_AUTO_TEST_CASE(read_scratchpad_of_selected_device) {
+    int completions = 0;
+    uint8_t scratchpad[9] = {};
+    OneWireTransaction t(countCompletion, &completions);
+    t.reset().select(model.devices[1].rom.data()).write(0xBE).read(scratchpad, 9);
+    driver.submit(t);
+
+    BOOST_CHECK(!driver.idle());
+    BOOST_CHECK(t.status() == OneWireTransaction::Status::Pending);
+    run(t, 100);
+
+    BOOST_CHECK(t.status() == OneWireTransaction::Status::Done);
+    BOOST_CHECK_EQUAL(completions, 1);
+    BOOST_CHECK(driver.idle());
+    BOOST_CHECK(std::equal(scratchpad, scratchpad + 9, model.devices[1].scratchpad.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(convert_all_devices) {
+    OneWireTransaction t;
+    t.reset().skip().write(0x44);
+    driver.submit(t);
+    run(t, 100);
+    BOOST_CHECK(t.status() == OneWireTransaction::Status::Done);
+    BOOST_CHECK_EQUAL(model.conversions, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(search_finds_all_devices) {
+    OneWireSearch search;
+    OneWireTransaction t;
+    std::set<std::vector<uint8_t>> found;
+    for (int i = 0; i < 10; i++) {
+        t.clear();
+        t.search(search);
+        driver.submit(t);
+        run(t, 100);
+        BOOST_REQUIRE(t.status() == OneWireTransaction::Status::Done);
+        if (!search.found) {
+            break;
+        }
+        found.insert(std::vector<uint8_t>(search.rom, search.rom + 8));
+    }
+
+    std::set<std::vector<uint8_t>> expected;
+    for (auto & d : model.devices) {
+        expected.insert(std::vector<uint8_t>(d.rom.begin(), d.rom.end()));
+    }
+    BOOST_CHECK(found == expected);
+}
+
+BOOST_AUTO_TEST_CASE(no_presence_without_devices) {
+    model.devices.clear();
+    OneWireTransaction t;
+    t.reset().skip().write(0x44);
+    driver.submit(t);
+    run(t, 100);
+    BOOST_CHECK(t.status() == OneWireTransaction::Status::NoPresence);
+}
+
+BOOST_AUTO_TEST_CASE(timeout_when_master_stays_busy) {
+    model.stuck = true;
+    OneWireTransaction t;
+    t.reset();
+    driver.submit(t);
+    run(t, 100);
+    BOOST_CHECK(t.status() == OneWireTransaction::Status::Timeout);
+    BOOST_CHECK(driver.idle());
+}
+
+BOOST_AUTO_TEST_CASE(too_many_bytes_is_invalid) {
+    int completions = 0;
+    OneWireTransaction t(countCompletion, &completions);
+    for (int i = 0; i <= ONEWIRE_TRANSACTION_MAX_WRITE; i++) {
+        t.write(0);
+    }
+    driver.submit(t);
+    BOOST_CHECK(t.status() == OneWireTransaction::Status::Invalid);
+    BOOST_CHECK_EQUAL(completions, 1);
+    BOOST_CHECK(driver.idle());
+}
+
+struct Resubmit {
+    DS248xAsync * driver;
+    int remaining;
+    std::vector<int> order;
+    int id;
+};
+
+static void resubmit(OneWireTransaction & t, void * context) {
+    Resubmit & r = *static_cast<Resubmit *>(context);
+    r.order.push_back(r.id);
+    if (--r.remaining > 0) {
+        r.driver->submit(t);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(transactions_complete_in_order_and_can_be_resubmitted) {
+    Resubmit r1 = {&driver, 2, {}, 1};
+    OneWireTransaction t1(resubmit, &r1);
+    t1.reset().skip().write(0x44);
+    Resubmit r2 = {&driver, 1, {}, 2};
+    OneWireTransaction t2(resubmit, &r2);
+    t2.reset().skip().write(0x44);
+
+    driver.submit(t1);
+    driver.submit(t2);
+    for (int i = 0; i < 1000 && driver.poll(); i++) {
+        model.advance(100);
+    }
+    BOOST_CHECK_EQUAL(r1.order.size(), 2u);
+    BOOST_CHECK_EQUAL(r2.order.size(), 1u);
+    BOOST_CHECK_EQUAL(model.conversions, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(poll_latency_is_a_fraction_of_a_blocking_transaction) {
+    uint8_t scratchpad[9];
+    OneWireTransaction t;
+    t.reset().select(model.devices[0].rom.data()).write(0xBE).read(scratchpad, 9);
+
+    driver.submit(t);
+    uint32_t blocking = runBlocking(t);
+
+    driver.submit(t);
+    uint32_t worstPoll = run(t, 100);
+
+    OneWireSearch search;
+    OneWireTransaction s;
+    s.search(search);
+    driver.submit(s);
+    uint32_t blockingSearch = runBlocking(s);
+    search.restart();
+    driver.submit(s);
+    uint32_t worstSearchPoll = run(s, 100);
+
+    *output << "DS248x scratchpad read: blocking " << blocking << " us, worst poll " << worstPoll << " us\n";
+    *output << "DS248x search: blocking " << blockingSearch << " us, worst poll " << worstSearchPoll << " us\n";
+
+    BOOST_CHECK(worstPoll * 20 < blocking);
+    BOOST_CHECK(worstSearchPoll * 20 < blockingSearch);
+    BOOST_CHECK(worstPoll <= 5 * 3 * DS248xModel::I2C_BYTE_MICROS);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
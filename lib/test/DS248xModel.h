@@ -0,0 +1,242 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "DS248xAsync.h"
+#include <vector>
+#include <deque>
+#include <array>
+#include <cstring>
+
+/**
+ * Register model of a DS248x with simulated 1-Wire devices, for testing drivers on Linux.
+ *
+ * The model keeps a clock in microseconds. Every I2C transfer advances it by the transfer time at 400 kHz, and every
+ * 1-Wire operation keeps the master busy for the time given in the DS2484 datasheet at standard speed.
+ * Devices support match ROM, skip ROM, search ROM, read scratchpad and convert T.
+ */
+class DS248xModel : public DS248xI2C {
+public:
+    struct Device {
+        std::array<uint8_t, 8> rom;
+        std::array<uint8_t, 9> scratchpad;
+    };
+
+    static const uint32_t I2C_BYTE_MICROS = 25;     // 9 bits at 400 kHz, with start/stop overhead
+    static const uint32_t RESET_MICROS = 1148;
+    static const uint32_t BIT_MICROS = 70;
+
+    std::vector<Device> devices;
+    uint32_t now = 0;
+    uint32_t transfers = 0;
+    uint32_t conversions = 0;
+    bool stuck = false;     // keeps the master busy forever
+
+    void advance(uint32_t micros) {
+        now += micros;
+    }
+
+    void writeCommand(uint8_t command) override {
+        transfer(2);
+        execute(command, 0);
+    }
+
+    void writeCommand(uint8_t command, uint8_t parameter) override {
+        transfer(3);
+        execute(command, parameter);
+    }
+
+    uint8_t readRegister() override {
+        transfer(2);
+        switch (pointer) {
+            case DS248X_PTR_STATUS:
+                return status();
+            case DS248X_PTR_READ:
+                return data;
+            case DS248X_PTR_CONFIG:
+                return config;
+            default:
+                return 0xFF;
+        }
+    }
+
+private:
+    enum class RomState {
+        Idle, RomCommand, Match, Search, Function, ReadScratchpad
+    };
+
+    uint8_t pointer = DS248X_PTR_STATUS;
+    uint8_t statusFlags = 0;
+    uint8_t data = 0xFF;
+    uint8_t config = 0;
+    uint32_t busyUntil = 0;
+
+    RomState romState = RomState::Idle;
+    std::vector<bool> selected;
+    std::vector<uint8_t> matchRom;
+    uint8_t searchBit = 0;
+    uint8_t readIndex = 0;
+
+    void transfer(uint8_t bytes) {
+        now += bytes * I2C_BYTE_MICROS;
+        transfers++;
+    }
+
+    uint8_t status() const {
+        uint8_t s = statusFlags;
+        if (stuck || now < busyUntil) {
+            s |= DS248X_STATUS_BUSY;
+        }
+        return s;
+    }
+
+    void busyFor(uint32_t micros) {
+        busyUntil = now + micros;
+        pointer = DS248X_PTR_STATUS;
+    }
+
+    void execute(uint8_t command, uint8_t parameter) {
+        if (status() & DS248X_STATUS_BUSY && command != DS248X_SRP && command != DS248X_DRST) {
+            return; // the DS248x does not acknowledge commands while busy
+        }
+        switch (command) {
+            case DS248X_SRP:
+                pointer = parameter;
+                break;
+            case DS248X_DRST:
+                statusFlags = DS248X_STATUS_RST;
+                busyUntil = now;
+                pointer = DS248X_PTR_STATUS;
+                break;
+            case DS248X_WCFG:
+                config = parameter & 0x0F;
+                pointer = DS248X_PTR_CONFIG;
+                break;
+            case DS248X_1WRS:
+                oneWireReset();
+                busyFor(RESET_MICROS);
+                break;
+            case DS248X_1WWB:
+                oneWireWrite(parameter);
+                busyFor(8 * BIT_MICROS);
+                break;
+            case DS248X_1WRB:
+                data = oneWireRead();
+                busyFor(8 * BIT_MICROS);
+                break;
+            case DS248X_1WT:
+                triplet(parameter & 0x80);
+                busyFor(3 * BIT_MICROS);
+                break;
+        }
+    }
+
+    void oneWireReset() {
+        statusFlags = devices.empty() ? 0 : DS248X_STATUS_PPD;
+        selected.assign(devices.size(), false);
+        romState = RomState::RomCommand;
+    }
+
+    void oneWireWrite(uint8_t b) {
+        switch (romState) {
+            case RomState::RomCommand:
+                if (b == 0xCC) {
+                    selected.assign(devices.size(), true);
+                    romState = RomState::Function;
+                } else if (b == 0x55) {
+                    matchRom.clear();
+                    romState = RomState::Match;
+                } else if (b == 0xF0) {
+                    selected.assign(devices.size(), true);
+                    searchBit = 0;
+                    romState = RomState::Search;
+                } else {
+                    romState = RomState::Idle;
+                }
+                break;
+            case RomState::Match:
+                matchRom.push_back(b);
+                if (matchRom.size() == 8) {
+                    for (size_t i = 0; i < devices.size(); i++) {
+                        selected[i] = std::memcmp(devices[i].rom.data(), matchRom.data(), 8) == 0;
+                    }
+                    romState = RomState::Function;
+                }
+                break;
+            case RomState::Function:
+                if (b == 0xBE) {
+                    readIndex = 0;
+                    romState = RomState::ReadScratchpad;
+                } else if (b == 0x44) {
+                    conversions++;
+                    romState = RomState::Idle;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    uint8_t oneWireRead() {
+        if (romState != RomState::ReadScratchpad) {
+            return 0xFF;
+        }
+        // open drain: the result is the AND of all selected devices
+        uint8_t result = 0xFF;
+        for (size_t i = 0; i < devices.size(); i++) {
+            if (selected[i] && readIndex < 9) {
+                result &= devices[i].scratchpad[readIndex];
+            }
+        }
+        readIndex++;
+        return result;
+    }
+
+    void triplet(bool requestedDirection) {
+        bool idBit = true;
+        bool cmpIdBit = true;
+        for (size_t i = 0; i < devices.size(); i++) {
+            if (selected[i]) {
+                bool bit = devices[i].rom[searchBit / 8] & (1 << (searchBit % 8));
+                idBit = idBit && bit;
+                cmpIdBit = cmpIdBit && !bit;
+            }
+        }
+        bool direction;
+        if (idBit != cmpIdBit) {
+            direction = idBit;
+        } else if (!idBit) {
+            direction = requestedDirection; // discrepancy
+        } else {
+            direction = true; // no devices
+        }
+        for (size_t i = 0; i < devices.size(); i++) {
+            bool bit = devices[i].rom[searchBit / 8] & (1 << (searchBit % 8));
+            if (bit != direction) {
+                selected[i] = false;
+            }
+        }
+        searchBit++;
+        statusFlags = uint8_t((statusFlags & DS248X_STATUS_PPD)
+                | (idBit ? DS248X_STATUS_SBR : 0)
+                | (cmpIdBit ? DS248X_STATUS_TSB : 0)
+                | (direction ? DS248X_STATUS_DIR : 0));
+    }
+};
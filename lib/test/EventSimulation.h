@@ -0,0 +1,138 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include "Ticks.h"
+
+/**
+ * Discrete event simulation on top of the test platform ticks.
+ *
+ * Instead of advancing the clock in fixed steps, the simulation jumps to the next moment something can change:
+ * the next control update, or the next event an actuator reports through getWaitTime(), like a PWM edge, the end of
+ * a minimum on or off time, or the end of a mutex dead time. Between those moments the outputs are constant, so the
+ * plant can be integrated over the whole interval in one go.
+ *
+ * Derived classes implement the control update, which runs every control period, the fast update, which runs at
+ * every event, and the plant model.
+ */
+class EventSimulation {
+public:
+    /**
+     * Returns the milliseconds until the next event of one actuator, 0 when it has none pending.
+     */
+    using EventSource = std::function<ticks_millis_t()>;
+
+    /**
+     * @param controlPeriod milliseconds between control updates. The Pid filters expect 1 second.
+     */
+    EventSimulation(ticks_millis_t controlPeriod = 1000) :
+        period(controlPeriod),
+        nextControlTime(ticks.millis()),
+        steps(0),
+        controlUpdates(0)
+    {}
+
+    virtual ~EventSimulation() = default;
+
+    void addEventSource(EventSource source){
+        sources.push_back(source);
+    }
+
+    /**
+     * Adds an actuator that reports its next event with getWaitTime(), like ActuatorPwm, ActuatorTimeLimited and
+     * ActuatorMutexGroup.
+     */
+    template<class T>
+    void watch(const T & actuator){
+        addEventSource([&actuator]{
+            return actuator.getWaitTime();
+        });
+    }
+
+    /**
+     * Simulates the given number of milliseconds.
+     */
+    void run(ticks_millis_t duration){
+        ticks_millis_t end = ticks.millis() + duration;
+        while(ticks.millis() < end){
+            ticks_millis_t now = ticks.millis();
+            if(now >= nextControlTime){
+                controlUpdate();
+                nextControlTime += period;
+                controlUpdates++;
+            }
+            fastUpdate();
+
+            // an event source that returns 0 is either idle, or blocked by another source that has a later event
+            ticks_millis_t next = (nextControlTime < end) ? nextControlTime : end;
+            for(auto & source : sources){
+                ticks_millis_t wait = source();
+                if(wait > 0 && now + wait < next){
+                    next = now + wait;
+                }
+            }
+
+            advance(next - now);
+            ticks.setMillis(next);
+            steps++;
+        }
+    }
+
+    ticks_millis_t controlPeriod() const {
+        return period;
+    }
+
+    /**
+     * Number of intervals the plant was advanced, including the control updates.
+     */
+    uint64_t stepCount() const {
+        return steps;
+    }
+
+    uint64_t controlUpdateCount() const {
+        return controlUpdates;
+    }
+
+protected:
+    /**
+     * Reads the plant into the sensors and updates the control objects, every control period.
+     */
+    virtual void controlUpdate() = 0;
+
+    /**
+     * Called at every event, after the control update when both are due. Should call fastUpdate() on actuators.
+     */
+    virtual void fastUpdate() {}
+
+    /**
+     * Integrates the plant over the given time, with the outputs set by the last update.
+     */
+    virtual void advance(ticks_millis_t millis) = 0;
+
+private:
+    ticks_millis_t period;
+    ticks_millis_t nextControlTime;
+    uint64_t steps;
+    uint64_t controlUpdates;
+    std::vector<EventSource> sources;
+};
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include "EventSimulation.h"
+#include "Simulation.h"
+#include "Pid.h"
+#include "SetPoint.h"
+#include "TempSensorExternal.h"
+#include "ActuatorMocks.h"
+#include "ActuatorPwm.h"
+#include "ActuatorTimeLimited.h"
+#include "ActuatorMutexDriver.h"
+#include "ActuatorMutexGroup.h"
+#include "SensorSetPointPair.h"
+#include <chrono>
+#include <math.h>
+
+/*
+ * A heater and a cooler acting on beer temperature, like SimBeerHeaterCooler in SimulationTest.
+ * The cooler is time limited and both share a mutex group, so all three kinds of actuator events occur.
+ * The heater PWM period is only 30 seconds, because edges no longer need to line up with 1 second steps.
+ *
+ * The Pid assumes one update per second. For a longer control period, the integral and derivative times are
+ * scaled to the same number of updates. The filters are not scaled, so this is only a good approximation when
+ * the control period is short compared to the beer temperature changes.
+ */
+struct EventChamber : public EventSimulation {
+    EventChamber(ticks_millis_t controlPeriod = 1000, ticks_millis_t fastUpdateInterval = 0) :
+        EventSimulation(controlPeriod),
+        fridgeSensor(true),
+        fridgeSet(20.0),
+        fridge(fridgeSensor, fridgeSet),
+        beerSensor(true),
+        beerSet(20.0),
+        beer(beerSensor, beerSet),
+        heaterMutex(heaterPin),
+        coolerMutex(coolerPin),
+        coolerTimeLimited(coolerMutex, 120, 180),
+        heater(heaterMutex, 30),
+        cooler(coolerTimeLimited, 1200),
+        heaterPid(beer, heater),
+        coolerPid(beer, cooler),
+        heaterOnTime(0),
+        coolerOnTime(0)
+    {
+        heaterPid.setInputFilter(1);
+        heaterPid.setDerivativeFilter(4);
+        uint16_t seconds = controlPeriod / 1000;
+        heaterPid.setConstants(60.0, 7200 / seconds, 500 / seconds);
+        coolerPid.setInputFilter(1);
+        coolerPid.setDerivativeFilter(4);
+        coolerPid.setConstants(40.0, 7200 / seconds, 1200 / seconds);
+        coolerPid.setActuatorIsNegative(true);
+
+        coolerMutex.setMutex(&mutex);
+        heaterMutex.setMutex(&mutex);
+        mutex.setDeadTime(1800000); // 30 minutes
+
+        if(fastUpdateInterval){
+            // fixed steps, for comparison
+            addEventSource([fastUpdateInterval]{
+                return fastUpdateInterval - ticks.millis() % fastUpdateInterval;
+            });
+        }
+        else {
+            watch(heater);
+            watch(cooler);
+            watch(coolerTimeLimited);
+            watch(mutex);
+        }
+    }
+
+    void controlUpdate() override {
+        beerSensor.setValue(temp_t(sim.beerTemp));
+        fridgeSensor.setValue(temp_t(sim.airTemp));
+        heaterPid.update();
+        coolerPid.update();
+        cooler.update();
+        heater.update();
+        mutex.update();
+    }
+
+    void fastUpdate() override {
+        heater.fastUpdate();
+        cooler.fastUpdate();
+    }
+
+    void advance(ticks_millis_t millis) override {
+        bool heating = heaterPin.getState() == ActuatorDigital::State::Active;
+        bool cooling = coolerPin.getState() == ActuatorDigital::State::Active;
+        heaterOnTime += heating ? millis : 0;
+        coolerOnTime += cooling ? millis : 0;
+        sim.advance(millis, heating, cooling);
+    }
+
+    Simulation sim;
+    TempSensorExternal fridgeSensor;
+    SetPointSimple fridgeSet;
+    SensorSetPointPair fridge;
+    TempSensorExternal beerSensor;
+    SetPointSimple beerSet;
+    SensorSetPointPair beer;
+    ActuatorBool heaterPin;
+    ActuatorBool coolerPin;
+    ActuatorMutexGroup mutex;
+    ActuatorMutexDriver heaterMutex;
+    ActuatorMutexDriver coolerMutex;
+    ActuatorTimeLimited coolerTimeLimited;
+    ActuatorPwm heater;
+    ActuatorPwm cooler;
+    Pid heaterPid;
+    Pid coolerPid;
+    uint64_t heaterOnTime;
+    uint64_t coolerOnTime;
+};
+
+BOOST_AUTO_TEST_SUITE(event_simulation)
+
+BOOST_AUTO_TEST_CASE(plant_advance_does_not_depend_on_step_size) {
+    Simulation once;
+    Simulation steps;
+    once.envTemp = steps.envTemp = 10.0;
+
+    once.advance(3600000, true, false);
+    for(int i = 0; i < 3600; i++){
+        steps.advance(1000, true, false);
+    }
+    BOOST_CHECK_CLOSE(once.beerTemp, steps.beerTemp, 1e-6);
+    BOOST_CHECK_CLOSE(once.airTemp, steps.airTemp, 1e-6);
+    BOOST_CHECK_CLOSE(once.wallTemp, steps.wallTemp, 1e-6);
+    BOOST_CHECK_CLOSE(once.heaterTemp, steps.heaterTemp, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(plant_advance_reaches_analytic_steady_state) {
+    Simulation sim;
+    sim.envTemp = 10.0;
+
+    sim.advance(30u * 24 * 3600 * 1000, false, false); // 30 days without heating or cooling
+    BOOST_CHECK_CLOSE(sim.beerTemp, 10.0, 0.01);
+    BOOST_CHECK_CLOSE(sim.wallTemp, 10.0, 0.01);
+
+    // with the heater on, all heater power leaks through the walls: heaterPower = envWallTransfer * (wall - env)
+    sim.advance(30u * 24 * 3600 * 1000, true, false);
+    BOOST_CHECK_CLOSE(sim.wallTemp, 10.0 + sim.heaterPower / sim.envWallTransfer, 0.01);
+    BOOST_CHECK_CLOSE(sim.airTemp, sim.wallTemp + sim.heaterPower / sim.wallAirTransfer, 0.01);
+    BOOST_CHECK_CLOSE(sim.beerTemp, sim.airTemp, 0.01);
+}
+
+BOOST_AUTO_TEST_CASE(events_give_same_result_as_fixed_small_steps) {
+    ticks.reset();
+    EventChamber events;
+    events.beerSet.write(18.0);
+    events.run(6 * 3600 * 1000);
+
+    ticks.reset();
+    EventChamber fixed(1000, 10);
+    fixed.beerSet.write(18.0);
+    fixed.run(6 * 3600 * 1000);
+
+    // When the beer is at the setpoint, the heater and cooler compete for the mutex. Which one wins depends on
+    // millisecond timing differences, so only the temperature and the cooling work are compared.
+    BOOST_CHECK_CLOSE(events.sim.beerTemp, fixed.sim.beerTemp, 0.5);
+    BOOST_CHECK_CLOSE(double(events.coolerOnTime), double(fixed.coolerOnTime), 5);
+    // without the fixed steps, only the control updates and actuator events are simulated
+    BOOST_CHECK(events.stepCount() < fixed.stepCount() / 50);
+    BOOST_TEST_MESSAGE("event steps: " << events.stepCount() << ", fixed steps: " << fixed.stepCount());
+}
+
+BOOST_AUTO_TEST_CASE(four_week_fermentation) {
+    ticks.reset();
+    EventChamber chamber(30000); // a control update every 30 seconds
+
+    const ticks_millis_t day = 24 * 3600 * 1000;
+
+    struct Phase {
+        ticks_millis_t duration;
+        double setPoint;
+        double envTemp;
+        bool ramp; // change the setpoint by 0.1 degree per hour, instead of a step
+    };
+    const Phase profile[] = {
+        {7 * day, 19.0, 22.0, false},  // primary fermentation
+        {3 * day, 21.0, 22.0, true},   // diacetyl rest
+        {11 * day, 21.0, 16.0, false}, // conditioning in a colder room
+        {7 * day, 4.0, 16.0, false},   // cold crash
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    chamber.sim.envTemp = 22.0;
+    chamber.sim.beerTemp = chamber.sim.airTemp = chamber.sim.wallTemp = chamber.sim.heaterTemp = 22.0;
+    double setPoint = 19.0;
+    for(auto & phase : profile){
+        chamber.sim.envTemp = phase.envTemp;
+        for(ticks_millis_t t = 0; t < phase.duration; t += 3600000){
+            if(phase.ramp){
+                setPoint = (setPoint + 0.1 < phase.setPoint) ? setPoint + 0.1 : phase.setPoint;
+            }
+            else {
+                setPoint = phase.setPoint;
+            }
+            chamber.beerSet.write(setPoint);
+            chamber.run(3600000);
+        }
+        BOOST_CHECK_SMALL(chamber.sim.beerTemp - phase.setPoint, 0.5);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    BOOST_CHECK_EQUAL(ticks.millis(), 28 * day);
+    BOOST_CHECK_EQUAL(chamber.controlUpdateCount(), 28u * 24 * 120);
+    BOOST_TEST_MESSAGE("four weeks simulated in " << elapsed << " s with " << chamber.stepCount() << " steps, "
+                       << chamber.controlUpdateCount() << " control updates");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include <vector>
+#include <chrono>
+#include <stdlib.h>
+#include "FilterBank.h"
+#include "FilterCascaded.h"
+
+BOOST_AUTO_TEST_SUITE(FilterBankTest)
+
+// Compares every output of a bank with separate FilterCascaded objects, for random input
+static void checkBitExact(uint8_t nrOfChannels, uint8_t b, temp_precise_t amplitude, int samples){
+    FilterBank bank(nrOfChannels, b);
+    std::vector<FilterCascaded> reference(nrOfChannels);
+    for(auto & f : reference){
+        f.setFiltering(b);
+    }
+
+    srand(b + nrOfChannels);
+    std::vector<temp_precise_t> values(nrOfChannels);
+    int mismatches = 0;
+    for(int i = 0; i < samples; i++){
+        for(uint8_t ch = 0; ch < nrOfChannels; ch++){
+            // square wave with random amplitude per channel, steps far enough to make the filters overshoot
+            temp_precise_t v;
+            v.setRaw((((i / 50) + ch) % 2) ? amplitude.getRaw() : -amplitude.getRaw());
+            v = v * temp_precise_t(double(rand() % 1000) / 1000.0);
+            values[ch] = v;
+        }
+        bank.add(values.data());
+        for(uint8_t ch = 0; ch < nrOfChannels; ch++){
+            temp_precise_t expected = reference[ch].add(values[ch]);
+            if(bank.readOutput(ch) != expected
+                    || bank.readPrevOutput(ch) != reference[ch].readPrevOutput()
+                    || bank.readInput(ch) != reference[ch].readInput()){
+                mismatches++;
+            }
+        }
+    }
+    BOOST_CHECK_MESSAGE(mismatches == 0, "b=" << int(b) << ", channels=" << int(nrOfChannels) << ": " << mismatches << " mismatches");
+}
+
+BOOST_AUTO_TEST_CASE(bank_is_bit_exact_with_cascaded_filters){
+    for(uint8_t b = 0; b <= 6; b++){
+        checkBitExact(11, b, temp_precise_t(20.0), 1000);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(bank_is_bit_exact_for_full_range_input){
+    // start at the maximum value and jump between the limits of temp_precise_t
+    const uint8_t nrOfChannels = 5;
+    for(uint8_t b = 0; b <= 6; b++){
+        FilterBank bank(nrOfChannels, b);
+        std::vector<FilterCascaded> reference(nrOfChannels);
+        temp_precise_t start;
+        start.setRaw(INT32_MAX);
+        bank.init(start);
+        for(auto & f : reference){
+            f.setFiltering(b);
+            f.init(start);
+        }
+
+        srand(b);
+        std::vector<temp_precise_t> values(nrOfChannels);
+        int mismatches = 0;
+        for(int i = 0; i < 500; i++){
+            for(auto & v : values){
+                v.setRaw((rand() % 2) ? INT32_MAX : INT32_MIN);
+            }
+            bank.add(values.data());
+            for(uint8_t ch = 0; ch < nrOfChannels; ch++){
+                if(bank.readOutput(ch) != reference[ch].add(values[ch])){
+                    mismatches++;
+                }
+            }
+        }
+        BOOST_CHECK_MESSAGE(mismatches == 0, "b=" << int(b) << ": " << mismatches << " mismatches");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(init_sets_single_channel){
+    FilterBank bank(3);
+    bank.init(temp_precise_t(10.0));
+    bank.init(1, temp_precise_t(20.0));
+    BOOST_CHECK_EQUAL(bank.readOutput(0), temp_precise_t(10.0));
+    BOOST_CHECK_EQUAL(bank.readOutput(1), temp_precise_t(20.0));
+    BOOST_CHECK_EQUAL(bank.readPrevOutput(1), temp_precise_t(20.0));
+    BOOST_CHECK_EQUAL(bank.readOutput(2), temp_precise_t(10.0));
+
+    temp_t values[3] = {temp_t(10.0), temp_t(20.0), temp_t(10.0)};
+    bank.add(values);
+    BOOST_CHECK_EQUAL(bank.readOutput(1), temp_precise_t(20.0)); // steady state
+}
+
+BOOST_AUTO_TEST_CASE(bank_is_faster_than_separate_filters){
+    const uint8_t nrOfChannels = 12;
+    const int samples = 20000;
+    FilterBank bank(nrOfChannels, 4);
+    std::vector<FilterCascaded> reference(nrOfChannels);
+    std::vector<temp_precise_t> values(nrOfChannels);
+    for(uint8_t ch = 0; ch < nrOfChannels; ch++){
+        reference[ch].setFiltering(4);
+        values[ch] = temp_precise_t(double(ch));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < samples; i++){
+        for(uint8_t ch = 0; ch < nrOfChannels; ch++){
+            reference[ch].add(values[ch]);
+        }
+    }
+    auto separateTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < samples; i++){
+        bank.add(values.data());
+    }
+    auto bankTime = std::chrono::steady_clock::now() - start;
+
+    BOOST_CHECK_EQUAL(bank.readOutput(nrOfChannels - 1), reference[nrOfChannels - 1].readOutput());
+    BOOST_TEST_MESSAGE("filtering " << int(nrOfChannels) << " channels, " << samples << " samples. Separate filters: "
+        << std::chrono::duration_cast<std::chrono::microseconds>(separateTime).count() << " us, bank: "
+        << std::chrono::duration_cast<std::chrono::microseconds>(bankTime).count() << " us");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include "LoopProfiler.h"
+#include "ControlGraph.h"
+#include "ActuatorMocks.h"
+#include "ActuatorPwm.h"
+
+#if BREWPI_PROFILING
+
+struct LoopProfilerFixture {
+    LoopProfilerFixture() {
+        profiler.clear();
+        ticks.setMillis(0);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(LoopProfilerTest, LoopProfilerFixture)
+
+BOOST_AUTO_TEST_CASE(histogram_buckets_are_powers_of_two) {
+    BOOST_CHECK_EQUAL(TimingHistogram::bucketFor(0), 0);
+    BOOST_CHECK_EQUAL(TimingHistogram::bucketFor(1), 1);
+    BOOST_CHECK_EQUAL(TimingHistogram::bucketFor(2), 2);
+    BOOST_CHECK_EQUAL(TimingHistogram::bucketFor(3), 2);
+    BOOST_CHECK_EQUAL(TimingHistogram::bucketFor(4), 3);
+    BOOST_CHECK_EQUAL(TimingHistogram::bucketFor(1000), 10);
+    BOOST_CHECK_EQUAL(TimingHistogram::bucketFor(UINT32_MAX), TimingHistogram::BUCKETS - 1);
+
+    TimingHistogram h;
+    h.add(5);
+    h.add(6);
+    h.add(100);
+    BOOST_CHECK_EQUAL(h.bucket(3), 2);
+    BOOST_CHECK_EQUAL(h.bucket(7), 1);
+    BOOST_CHECK_EQUAL(h.count(), 3u);
+    BOOST_CHECK_EQUAL(h.max(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_counts_saturate) {
+    TimingHistogram h;
+    for (uint32_t i = 0; i < 70000; i++) {
+        h.add(1);
+    }
+    BOOST_CHECK_EQUAL(h.bucket(1), UINT16_MAX);
+    BOOST_CHECK_EQUAL(h.count(), 70000u);
+}
+
+BOOST_AUTO_TEST_CASE(loop_period_is_time_between_loop_starts) {
+    PROFILE_LOOP_STARTED();
+    delay(10);
+    PROFILE_LOOP_STARTED();
+    delay(30);
+    PROFILE_LOOP_STARTED();
+
+    BOOST_CHECK_EQUAL(profiler.loopPeriods().count(), 2u);
+    BOOST_CHECK_EQUAL(profiler.loopPeriods().max(), 30000u); // micros
+}
+
+BOOST_AUTO_TEST_CASE(control_graph_records_each_object_and_phase) {
+    ActuatorBool pin;
+    ActuatorPwm pwm(pin, 4);
+    ControlGraph graph;
+    graph.compile({&pwm});
+
+    graph.update();
+    graph.fastUpdate();
+    graph.fastUpdate();
+
+    BOOST_REQUIRE_EQUAL(profiler.entryCount(), 2);
+    bool foundUpdate = false;
+    bool foundFastUpdate = false;
+    for (uint8_t i = 0; i < profiler.entryCount(); i++) {
+        const LoopProfiler::Entry & e = profiler.entry(i);
+        BOOST_CHECK(e.object == &pwm);
+        if (e.phase == ProfilePhase::Update) {
+            foundUpdate = true;
+            BOOST_CHECK_EQUAL(e.micros.count(), 1u);
+        }
+        if (e.phase == ProfilePhase::FastUpdate) {
+            foundFastUpdate = true;
+            BOOST_CHECK_EQUAL(e.micros.count(), 2u);
+        }
+    }
+    BOOST_CHECK(foundUpdate);
+    BOOST_CHECK(foundFastUpdate);
+}
+
+BOOST_AUTO_TEST_CASE(objects_beyond_capacity_are_counted_as_overflow) {
+    int objects[PROFILER_MAX_OBJECTS + 2];
+    for (auto & o : objects) {
+        profiler.record(&o, ProfilePhase::Update, 1);
+    }
+    BOOST_CHECK_EQUAL(profiler.entryCount(), PROFILER_MAX_OBJECTS);
+    BOOST_CHECK_EQUAL(profiler.overflow().count(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(pwm_edges_are_later_when_updates_are_infrequent) {
+    ActuatorBool pin;
+    ActuatorPwm pwm(pin, 4);
+    pwm.set(50.0);
+
+    for (int i = 0; i < 4000; i++) {
+        delay(1);
+        pwm.fastUpdate();
+    }
+    uint32_t lateWhenFrequent = profiler.pwmLateness().max();
+    BOOST_CHECK(profiler.pwmLateness().count() > 0);
+
+    profiler.clear();
+    for (int i = 0; i < 400; i++) {
+        delay(97);
+        pwm.fastUpdate();
+    }
+    BOOST_CHECK(profiler.pwmLateness().count() > 0);
+    BOOST_CHECK(profiler.pwmLateness().max() > lateWhenFrequent);
+    BOOST_CHECK(profiler.pwmLateness().max() < 97);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
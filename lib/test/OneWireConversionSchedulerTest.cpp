@@ -0,0 +1,132 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include "OneWire.h"
+#include "OneWireConversionScheduler.h"
+#include "OneWireTempSensor.h"
+#include <memory>
+
+BOOST_AUTO_TEST_SUITE(OneWireConversionSchedulerTest)
+
+BOOST_AUTO_TEST_CASE(scheduler_is_shared_per_bus) {
+    OneWire bus1(0);
+    OneWire bus2(1);
+    BOOST_CHECK(&OneWireConversionScheduler::forBus(&bus1) == &OneWireConversionScheduler::forBus(&bus1));
+    BOOST_CHECK(&OneWireConversionScheduler::forBus(&bus1) != &OneWireConversionScheduler::forBus(&bus2));
+}
+
+BOOST_AUTO_TEST_CASE(scheduler_is_destroyed_with_its_bus) {
+    DeviceAddress address = {DS18B20MODEL, 1};
+    OneWireConversionScheduler::Client client(address);
+    std::unique_ptr<OneWire> bus(new OneWire(0));
+    OneWireConversionScheduler::forBus(bus.get()).add(client);
+    BOOST_CHECK_GT(OneWireConversionScheduler::forBus(bus.get()).requestConversion(), 0);
+
+    // a new bus, possibly at the same address, starts without the clients and conversions of the old one
+    bus.reset();
+    bus.reset(new OneWire(0));
+    OneWireConversionScheduler & scheduler = OneWireConversionScheduler::forBus(bus.get());
+    BOOST_CHECK_EQUAL(scheduler.conversionsRequested(), 0u);
+    BOOST_CHECK_EQUAL(scheduler.requestConversion(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(no_conversion_without_sensors) {
+    OneWire bus(0);
+    OneWireConversionScheduler & scheduler = OneWireConversionScheduler::forBus(&bus);
+    BOOST_CHECK_EQUAL(scheduler.requestConversion(), 0);
+    BOOST_CHECK_EQUAL(scheduler.conversionsRequested(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(one_conversion_for_all_sensors_on_the_bus) {
+    OneWire bus(0);
+    OneWireConversionScheduler & scheduler = OneWireConversionScheduler::forBus(&bus);
+    uint32_t conversionsBefore = scheduler.conversionsRequested();
+
+    DeviceAddress addresses[10] = {};
+    std::vector<std::unique_ptr<OneWireConversionScheduler::Client>> clients;
+    for (uint8_t i = 0; i < 10; i++) {
+        addresses[i][0] = DS18B20MODEL;
+        addresses[i][1] = i;
+        clients.emplace_back(new OneWireConversionScheduler::Client(addresses[i]));
+        scheduler.add(*clients.back());
+    }
+
+    ticks.setMillis(1000);
+    BOOST_CHECK_EQUAL(scheduler.requestConversion(), 750); // all sensors start at 12 bits
+
+    // the other sensors on the bus wait for the same conversion
+    ticks.setMillis(1100);
+    for (uint8_t i = 1; i < 10; i++) {
+        BOOST_CHECK_EQUAL(scheduler.requestConversion(), 650);
+    }
+    BOOST_CHECK(scheduler.busy());
+    BOOST_CHECK_EQUAL(scheduler.conversionsRequested() - conversionsBefore, 1u);
+
+    // after the conversion, all scratchpads are read back in one pass
+    ticks.setMillis(1750);
+    BOOST_CHECK(!scheduler.busy());
+    for (auto & c : clients) {
+        // the null bus returns an empty scratchpad, which has a valid CRC, but no reset detection flag
+        BOOST_CHECK_EQUAL(scheduler.read(*c), DEVICE_DISCONNECTED_RAW);
+        // the configuration register is 0, which is 9 bits
+        BOOST_CHECK_EQUAL(c->getResolution(), 9);
+    }
+
+    // the next conversion only waits for the resolution that was read back
+    BOOST_CHECK_EQUAL(scheduler.requestConversion(), 94);
+    BOOST_CHECK_EQUAL(scheduler.conversionsRequested() - conversionsBefore, 2u);
+
+    for (auto & c : clients) {
+        scheduler.remove(*c);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(temp_sensors_share_the_conversion_of_their_bus) {
+    OneWire bus(0);
+    OneWireConversionScheduler & scheduler = OneWireConversionScheduler::forBus(&bus);
+    ticks.setMillis(5000);
+    uint32_t conversionsBefore = scheduler.conversionsRequested();
+
+    DeviceAddress address1 = {DS18B20MODEL, 1};
+    DeviceAddress address2 = {DS18B20MODEL, 2};
+    {
+        OneWireTempSensor sensor1(&bus, address1, temp_t(0.0));
+        OneWireTempSensor sensor2(&bus, address2, temp_t(0.0));
+
+        ticks.setMillis(10000);
+        uint16_t wait = sensor1.requestConversion();
+        BOOST_CHECK(wait > 0);
+        BOOST_CHECK_EQUAL(sensor2.requestConversion(), wait);
+        BOOST_CHECK_EQUAL(scheduler.conversionsRequested() - conversionsBefore, 1u);
+
+        ticks.setMillis(10000 + wait);
+        sensor1.update();
+        sensor2.update();
+        // both updates request the next conversion, but only one is sent
+        BOOST_CHECK_EQUAL(scheduler.conversionsRequested() - conversionsBefore, 2u);
+    }
+    // destroyed sensors are removed from the scheduler
+    ticks.setMillis(20000);
+    BOOST_CHECK_EQUAL(scheduler.requestConversion(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
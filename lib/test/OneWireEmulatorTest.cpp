@@ -0,0 +1,235 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include "OneWire.h"
+#include "OneWireEmulator.h"
+#include "DallasTemperature.h"
+#include "OneWireTempSensor.h"
+#include "DS2413.h"
+#include "DS2408.h"
+#include "ValveController.h"
+#include <cstring>
+#include <memory>
+#include <set>
+
+struct OneWireEmulatorFixture {
+    // a pin that is not used by the other tests, which expect no devices
+    static const uint8_t PIN = 20;
+
+    OneWireEmulatorFixture() :
+        bus(PIN),
+        oneWire(PIN),
+        sensor1(0x010203040506),
+        sensor2(0x0A0B0C0D0E0F),
+        sensor3(0x112233445566),
+        ds2413(0x2413),
+        ds2408(0x2408)
+    {
+        bus.add(sensor1);
+        bus.add(sensor2);
+        bus.add(sensor3);
+        bus.add(ds2413);
+        bus.add(ds2408);
+        memcpy(address1, sensor1.getRom(), 8);
+    }
+
+    OneWireBusEmulator bus;
+    OneWire oneWire;
+    DS18B20Model sensor1;
+    DS18B20Model sensor2;
+    DS18B20Model sensor3;
+    DS2413Model ds2413;
+    DS2408Model ds2408;
+    DeviceAddress address1;
+};
+
+BOOST_FIXTURE_TEST_SUITE(OneWireEmulatorTest, OneWireEmulatorFixture)
+
+BOOST_AUTO_TEST_CASE(search_finds_all_devices_on_the_bus) {
+    std::set<uint64_t> found;
+    DeviceAddress address;
+    oneWire.reset_search();
+    bus.resetStatistics();
+    while(oneWire.search(address)){
+        BOOST_CHECK_EQUAL(OneWire::crc8(address, 7), address[7]);
+        uint64_t id = 0;
+        memcpy(&id, address, 8);
+        found.insert(id);
+    }
+    BOOST_CHECK_EQUAL(found.size(), 5u);
+    for(const OneWireDeviceModel * device : {
+        (OneWireDeviceModel*) &sensor1, (OneWireDeviceModel*) &sensor2, (OneWireDeviceModel*) &sensor3,
+        (OneWireDeviceModel*) &ds2413, (OneWireDeviceModel*) &ds2408}){
+        uint64_t id = 0;
+        memcpy(&id, device->getRom(), 8);
+        BOOST_CHECK(found.count(id) == 1);
+    }
+    BOOST_TEST_MESSAGE("Searching 5 devices takes " << bus.getStatistics().micros << " us of bus time");
+}
+
+BOOST_AUTO_TEST_CASE(unconnected_pin_has_no_devices) {
+    OneWire empty(PIN + 1);
+    DeviceAddress address;
+    BOOST_CHECK(!empty.reset());
+    empty.reset_search();
+    BOOST_CHECK(!empty.search(address));
+}
+
+BOOST_AUTO_TEST_CASE(temp_sensor_reads_the_emulated_temperature) {
+    sensor1.setTemperatureRaw(int16_t(21.5 * 16));
+    OneWireTempSensor sensor(&oneWire, address1, temp_t(0.0));
+    BOOST_CHECK(sensor.isConnected());
+    BOOST_CHECK_EQUAL(sensor.read(), temp_t(21.5));
+
+    // init already requested the next conversion, which measured the old temperature
+    sensor1.setTemperatureRaw(int16_t(-2.25 * 16));
+    ticks.setMillis(ticks.millis() + 1000);
+    sensor.update();
+    BOOST_CHECK_EQUAL(sensor.read(), temp_t(21.5));
+    ticks.setMillis(ticks.millis() + 1000);
+    sensor.update();
+    BOOST_CHECK_EQUAL(sensor.read(), temp_t(-2.25));
+}
+
+BOOST_AUTO_TEST_CASE(temp_sensor_uses_its_initial_reading_until_the_first_conversion_completes) {
+    sensor1.setTemperatureRaw(int16_t(21.5 * 16));
+    OneWireTempSensor sensor(&oneWire, address1, temp_t(0.0));
+
+    // the conversion requested by init is still in progress, so the bus is not used
+    bus.resetStatistics();
+    sensor.update();
+    BOOST_CHECK(sensor.isConnected());
+    BOOST_CHECK_EQUAL(sensor.read(), temp_t(21.5));
+    BOOST_CHECK_EQUAL(bus.getStatistics().resets, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(temp_sensor_caches_the_converted_and_calibrated_reading_on_init) {
+    // init used to cache the raw reading in 1/16 degrees, which read() returned as 344 degrees
+    sensor1.setTemperatureRaw(int16_t(21.5 * 16));
+    OneWireTempSensor sensor(&oneWire, address1, temp_t(0.5));
+    BOOST_CHECK(sensor.isConnected());
+    BOOST_CHECK_EQUAL(sensor.read(), temp_t(22.0));
+}
+
+BOOST_AUTO_TEST_CASE(reading_the_scratchpad_takes_a_known_bus_time) {
+    DallasTemperature dallas(&oneWire);
+    uint8_t scratchPad[9];
+    bus.resetStatistics();
+    dallas.readScratchPad(address1, scratchPad);
+
+    const OneWireBusEmulator::Statistics & s = bus.getStatistics();
+    BOOST_CHECK_EQUAL(s.resets, 2u); // the bus is reset again after reading
+    BOOST_CHECK_EQUAL(s.writeSlots, 80u); // match ROM command, address and read scratchpad command
+    BOOST_CHECK_EQUAL(s.readSlots, 72u); // 9 bytes
+    BOOST_CHECK_EQUAL(s.micros, 2 * 960u + 152 * 70);
+    BOOST_CHECK(memcmp(scratchPad, sensor1.getScratchpad(), 9) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(scratchpad_crc_error_is_retried) {
+    DallasTemperature dallas(&oneWire);
+    BOOST_REQUIRE(dallas.initConnection(address1));
+    sensor1.setTemperatureRaw(int16_t(20 * 16));
+    dallas.requestTemperaturesByAddress(address1);
+
+    bus.injectReadError(3);
+    BOOST_CHECK_EQUAL(dallas.getTempRaw(address1), 20 * 16);
+
+    // the retry fails too
+    bus.injectReadError(3);
+    bus.injectReadError(72 + 3);
+    BOOST_CHECK_EQUAL(dallas.getTempRaw(address1), DEVICE_DISCONNECTED_RAW);
+}
+
+BOOST_AUTO_TEST_CASE(disconnected_sensor_reads_as_disconnected) {
+    DallasTemperature dallas(&oneWire);
+    BOOST_REQUIRE(dallas.initConnection(address1));
+    dallas.requestTemperaturesByAddress(address1);
+    BOOST_CHECK(dallas.getTempRaw(address1) != DEVICE_DISCONNECTED_RAW);
+
+    sensor1.setConnected(false);
+    BOOST_CHECK_EQUAL(dallas.getTempRaw(address1), DEVICE_DISCONNECTED_RAW);
+
+    // reconnecting powers the sensor up again, which needs a new init
+    sensor1.setConnected(true);
+    BOOST_CHECK_EQUAL(dallas.getTempRaw(address1), DEVICE_DISCONNECTED_RAW);
+    BOOST_REQUIRE(dallas.initConnection(address1));
+    dallas.requestTemperaturesByAddress(address1);
+    BOOST_CHECK(dallas.getTempRaw(address1) != DEVICE_DISCONNECTED_RAW);
+}
+
+BOOST_AUTO_TEST_CASE(power_on_reset_of_sensor_is_detected) {
+    DallasTemperature dallas(&oneWire);
+    BOOST_REQUIRE(dallas.initConnection(address1));
+    dallas.requestTemperaturesByAddress(address1);
+    BOOST_CHECK(dallas.getTempRaw(address1) != DEVICE_DISCONNECTED_RAW);
+    // initConnection stored 0 in the high alarm EEPROM byte, so a reset is visible in the scratchpad
+    BOOST_CHECK_EQUAL(sensor1.getScratchpad()[HIGH_ALARM_TEMP], 1);
+
+    bus.powerCycle();
+    BOOST_CHECK_EQUAL(sensor1.getScratchpad()[HIGH_ALARM_TEMP], 0);
+    BOOST_CHECK_EQUAL(dallas.getTempRaw(address1), DEVICE_DISCONNECTED_RAW);
+}
+
+BOOST_AUTO_TEST_CASE(ds2413_latches_can_be_written_and_read) {
+    DeviceAddress address;
+    memcpy(address, ds2413.getRom(), 8);
+    DS2413 device(&oneWire, address);
+
+    BOOST_CHECK(device.writeLatchBit(0, true, false));
+    BOOST_CHECK_EQUAL(ds2413.getLatches(), 0x02);
+    bool latch = false;
+    BOOST_CHECK(device.readLatchBit(0, latch, false));
+    BOOST_CHECK(latch);
+    BOOST_CHECK(device.readLatchBit(1, latch, false));
+    BOOST_CHECK(!latch);
+
+    BOOST_CHECK(device.writeLatchBit(0, false, false));
+    BOOST_CHECK_EQUAL(ds2413.getLatches(), 0x03);
+}
+
+BOOST_AUTO_TEST_CASE(valve_controller_drives_ds2408) {
+    DeviceAddress address;
+    memcpy(address, ds2408.getRom(), 8);
+    auto device = std::make_shared<DS2408>(&oneWire, address);
+    BOOST_CHECK(device->isConnected());
+    ValveController valve(device, 0);
+
+    ds2408.setInputs(0xFF); // neither feedback switch is closed
+    valve.open();
+    valve.update();
+    BOOST_CHECK(valve.getAction() == ValveController::VALVE_OPENING);
+    BOOST_CHECK(ds2408.getLatches() >> 6 == ValveController::VALVE_OPENING);
+    BOOST_CHECK(valve.getPosition() == ValveController::VALVE_HALFWAY);
+
+    // the open feedback switch pulls pin 5 low
+    ds2408.setInputs(0b11011111);
+    valve.update();
+    BOOST_CHECK(valve.getPosition() == ValveController::VALVE_OPENED);
+    BOOST_CHECK(ds2408.getLatches() >> 6 == ValveController::VALVE_IDLE);
+
+    ds2408.setConnected(false);
+    device->update();
+    BOOST_CHECK(!device->isConnected());
+    BOOST_CHECK(valve.getPosition() == ValveController::VALVE_ERROR);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
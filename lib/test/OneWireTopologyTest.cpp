@@ -0,0 +1,231 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include "OneWire.h"
+#include "OneWireEmulator.h"
+#include "OneWireTopology.h"
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+struct OneWireTopologyFixture {
+    static const uint8_t PIN = 20;
+
+    OneWireTopologyFixture() :
+        bus(PIN),
+        oneWire(PIN),
+        topology(oneWire, 250, 5000, 60000),
+        sensor1(0x010203040506),
+        sensor2(0x0A0B0C0D0E0F),
+        sensor3(0x112233445566)
+    {
+        bus.add(sensor1);
+        bus.add(sensor2);
+        topology.setListener([this](const OneWireTopology &, const uint8_t * address, OneWireTopology::Change change){
+            Event e;
+            memcpy(e.address, address, 8);
+            e.change = change;
+            events.push_back(e);
+        });
+    }
+
+    struct Event {
+        uint8_t address[8];
+        OneWireTopology::Change change;
+    };
+
+    bool known(const OneWireDeviceModel & device){
+        uint8_t address[8];
+        for(uint8_t i = 0; topology.address(i, address); i++){
+            if(memcmp(address, device.getRom(), 8) == 0){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // calls update each step interval until the given time
+    void run(ticks_millis_t from, ticks_millis_t to){
+        for(ticks_millis_t t = from; t <= to; t += 250){
+            topology.update(t);
+        }
+    }
+
+    OneWireBusEmulator bus;
+    OneWire oneWire;
+    OneWireTopology topology;
+    DS18B20Model sensor1;
+    DS18B20Model sensor2;
+    DS18B20Model sensor3;
+    std::vector<Event> events;
+};
+
+BOOST_FIXTURE_TEST_SUITE(OneWireTopologyTest, OneWireTopologyFixture)
+
+BOOST_AUTO_TEST_CASE(verify_only_succeeds_for_devices_on_the_bus) {
+    BOOST_CHECK(oneWire.verify(sensor1.getRom()));
+    BOOST_CHECK(oneWire.verify(sensor2.getRom()));
+    BOOST_CHECK(!oneWire.verify(sensor3.getRom()));
+    sensor2.setConnected(false);
+    BOOST_CHECK(!oneWire.verify(sensor2.getRom()));
+
+    OneWire empty(PIN + 1);
+    BOOST_CHECK(!empty.verify(sensor1.getRom()));
+}
+
+BOOST_AUTO_TEST_CASE(verify_takes_one_reset_and_one_search_pass) {
+    bus.resetStatistics();
+    oneWire.verify(sensor1.getRom());
+    const OneWireBusEmulator::Statistics & s = bus.getStatistics();
+    BOOST_CHECK_EQUAL(s.resets, 1u);
+    BOOST_CHECK_EQUAL(s.writeSlots, 8u + 64u);
+    BOOST_CHECK_EQUAL(s.readSlots, 2 * 64u);
+}
+
+BOOST_AUTO_TEST_CASE(verify_does_not_disturb_a_search_in_progress) {
+    uint8_t first[8], second[8], address[8];
+    oneWire.reset_search();
+    BOOST_REQUIRE(oneWire.search(first));
+    BOOST_REQUIRE(oneWire.search(second));
+
+    oneWire.reset_search();
+    BOOST_REQUIRE(oneWire.search(address));
+    oneWire.verify(sensor3.getRom());
+    BOOST_REQUIRE(oneWire.search(address));
+    BOOST_CHECK(memcmp(address, second, 8) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(refresh_finds_all_devices) {
+    topology.refresh(1000);
+    BOOST_CHECK_EQUAL(topology.count(), 2);
+    BOOST_CHECK(known(sensor1));
+    BOOST_CHECK(known(sensor2));
+    BOOST_CHECK_EQUAL(topology.lastSeen(sensor1.getRom()), 1000u);
+    BOOST_CHECK_EQUAL(topology.lastSeen(sensor3.getRom()), 0u);
+    BOOST_REQUIRE_EQUAL(events.size(), 2u);
+    BOOST_CHECK(events[0].change == OneWireTopology::Change::Added);
+    BOOST_CHECK(events[1].change == OneWireTopology::Change::Added);
+
+    // nothing changed, so refreshing again gives no events
+    topology.refresh(2000);
+    BOOST_CHECK_EQUAL(events.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(refresh_removes_unplugged_devices) {
+    topology.refresh(1000);
+    bus.remove(sensor1);
+    topology.refresh(2000);
+    BOOST_CHECK_EQUAL(topology.count(), 1);
+    BOOST_CHECK(!known(sensor1));
+    BOOST_REQUIRE_EQUAL(events.size(), 3u);
+    BOOST_CHECK(events[2].change == OneWireTopology::Change::Removed);
+    BOOST_CHECK(memcmp(events[2].address, sensor1.getRom(), 8) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(update_searches_in_steps) {
+    // one device found per step
+    topology.update(0);
+    BOOST_CHECK_EQUAL(topology.count(), 1);
+    topology.update(100); // too soon
+    BOOST_CHECK_EQUAL(topology.getStatistics().searchSteps, 1u);
+    topology.update(250);
+    BOOST_CHECK_EQUAL(topology.count(), 2);
+    topology.update(500); // ends the search pass
+    BOOST_CHECK_EQUAL(topology.getStatistics().searchSteps, 3u);
+
+    // no bus transactions until a device needs a check
+    bus.resetStatistics();
+    run(750, 4750);
+    BOOST_CHECK_EQUAL(bus.getStatistics().resets, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(known_devices_are_checked_without_searching) {
+    topology.refresh(0);
+    bus.resetStatistics();
+    run(250, 5250);
+    // both sensors are checked once, the next search pass is not due yet
+    BOOST_CHECK_EQUAL(topology.getStatistics().presenceChecks, 2u);
+    BOOST_CHECK_EQUAL(topology.getStatistics().searchSteps, 3u);
+    BOOST_CHECK_EQUAL(bus.getStatistics().resets, 2u);
+    BOOST_CHECK_EQUAL(topology.lastSeen(sensor1.getRom()), 5000u);
+}
+
+BOOST_AUTO_TEST_CASE(disconnected_device_is_removed_after_missed_checks) {
+    topology.refresh(0);
+    sensor2.setConnected(false);
+    run(250, 15000);
+    // the checks at 5250, 5500 and 5750 failed
+    BOOST_CHECK(!known(sensor2));
+    BOOST_REQUIRE_EQUAL(events.size(), 3u);
+    BOOST_CHECK(events[2].change == OneWireTopology::Change::Removed);
+    BOOST_CHECK(known(sensor1));
+    BOOST_CHECK_EQUAL(topology.count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(device_that_misses_a_check_is_kept) {
+    topology.refresh(0);
+    sensor2.setConnected(false);
+    topology.update(5000);
+    topology.update(5250);
+    sensor2.setConnected(true);
+    run(5500, 10000);
+    BOOST_CHECK(known(sensor2));
+    BOOST_CHECK_EQUAL(events.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(hot_plugged_device_is_found_by_background_search) {
+    topology.refresh(0);
+    bus.add(sensor3);
+    run(250, 59750);
+    BOOST_CHECK(!known(sensor3));
+    run(60000, 62000);
+    BOOST_CHECK(known(sensor3));
+    BOOST_REQUIRE_EQUAL(events.size(), 3u);
+    BOOST_CHECK(events[2].change == OneWireTopology::Change::Added);
+    BOOST_CHECK(memcmp(events[2].address, sensor3.getRom(), 8) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(update_takes_at_most_one_bus_transaction) {
+    bus.add(sensor3);
+    topology.refresh(0);
+
+    // a full search, which listing the devices used to do each time
+    bus.resetStatistics();
+    uint8_t address[8];
+    oneWire.reset_search();
+    while(oneWire.search(address)){
+    }
+    uint64_t search = bus.getStatistics().micros;
+
+    uint64_t longest = 0;
+    for(ticks_millis_t t = 250; t <= 120000; t += 250){
+        bus.resetStatistics();
+        topology.update(t);
+        longest = std::max(longest, bus.getStatistics().micros);
+        BOOST_CHECK_LE(bus.getStatistics().resets, 1u);
+    }
+    BOOST_TEST_MESSAGE("Longest update: " << longest << " us, full search: " << search << " us");
+    BOOST_CHECK_LT(2 * longest, search); // a presence check costs about as much as finding one device
+    BOOST_CHECK_EQUAL(topology.count(), 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -138,7 +138,42 @@ BOOST_AUTO_TEST_CASE(RefTo_SetPointActuator) {
     delete spa;
 }
 
+BOOST_AUTO_TEST_CASE(RefTo_caches_target_until_generation_changes) {
+    auto lookup = VectorIndexLookup(1, devices);
+    RefTo<ActuatorDigital> ref(lookup);
+    BOOST_CHECK_EQUAL(ref.get(), act2);
+
+    devices[1] = act1; // change target without notifying references
+    BOOST_CHECK_EQUAL(ref.get(), act2); // still cached
+
+    RefToGeneric::invalidateAll();
+    BOOST_CHECK_EQUAL(ref.get(), act1); // looked up again
+
+    devices[1] = temp;
+    RefToGeneric::invalidateAll();
+    BOOST_CHECK_EQUAL(ref.get(), defaultTarget<ActuatorDigital>()); // wrong type is also re-evaluated
+}
 
+// the speed of the cached path is measured by the ref_to_get benchmarks in lib/bench
+BOOST_AUTO_TEST_CASE(RefTo_cached_get_does_not_call_lookup_again) {
+    auto lookup = VectorIndexLookup(1, devices);
+    int lookups = 0;
+    RefTo<ActuatorDigital> ref([&]() -> Interface * {
+        lookups++;
+        return lookup();
+    });
+
+    for(int i = 0; i < 100; i++){
+        BOOST_CHECK_EQUAL(ref.get(), act2);
+    }
+    BOOST_CHECK_EQUAL(lookups, 1);
+
+    RefToGeneric::invalidateAll();
+    for(int i = 0; i < 100; i++){
+        BOOST_CHECK_EQUAL(ref.get(), act2);
+    }
+    BOOST_CHECK_EQUAL(lookups, 2);
+}
 
 BOOST_AUTO_TEST_SUITE_END()
 
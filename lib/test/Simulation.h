@@ -0,0 +1,243 @@
+/*
+ * Copyright 2015 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <string.h>
+#include "Ticks.h"
+
+/* This class simulates a fridge is a simple way:
+ * There are 3 heat capacities: the beer itself, the air in the fridge and the fridge walls.
+ * The heater heats the air in the fridge directly.
+ * The cooler cools the fridge walls, which in turn cool the fridge air.
+ * This causes an extra delay when cooling and a potential source of overshoot
+ */
+
+
+struct Simulation{
+    Simulation(){
+        beerTemp = 20.0;
+        airTemp = 20.0;
+        wallTemp = 20.0;
+        envTemp = 20.0;
+        heaterTemp = 20.0;
+
+        beerCapacity = 4.2 * 1.0 * 20; // heat capacity water * density of water * 20L volume (in kJ per kelvin).
+        airCapacity = 1.005 * 1.225 * 0.200; // heat capacity of dry air * density of air * 200L volume (in kJ per kelvin).
+        // Moist air has only slightly higher heat capacity, 1.02 when saturated at 20C.
+        wallCapacity = 5.0; // just a guess
+        heaterCapacity = 1.0; // also a guess, to simulate that heater first heats itself, then starts heating the air
+
+        heaterPower = 0.1; // 100W, in kW.
+        coolerPower = 0.1; // 100W, in kW. Assuming 200W at 50% efficiency
+
+        airBeerTransfer= 1.0/300;
+        wallAirTransfer= 1.0/300;
+        heaterAirTransfer= 1.0/30;
+        envWallTransfer = 0.001; // losses to environment
+
+        heaterToBeer = 0.0; // ratio of heater transfered directly to beer instead of fridge air
+        heaterToAir = 1.0 - heaterToBeer;
+
+    }
+    virtual ~Simulation(){}
+
+    void update(bool heaterActive, bool coolerActive){
+        double beerTempNew = beerTemp;
+        double airTempNew = airTemp;
+        double wallTempNew = wallTemp;
+        double heaterTempNew = heaterTemp;
+
+        beerTempNew += (airTemp - beerTemp) * airBeerTransfer / beerCapacity;
+
+        if(heaterActive){
+            heaterTempNew += heaterPower / heaterCapacity;
+        }
+        if(coolerActive){
+            wallTempNew -= coolerPower / wallCapacity;
+        }
+
+        airTempNew += (heaterTemp - airTemp) * heaterAirTransfer / airCapacity;
+        airTempNew += (wallTemp - airTemp) * wallAirTransfer / airCapacity;
+        airTempNew += (beerTemp - airTemp) * airBeerTransfer / airCapacity;
+
+
+        beerTempNew += (airTemp - beerTemp) * airBeerTransfer / beerCapacity;
+
+        heaterTempNew += (airTemp - heaterTemp) * heaterAirTransfer / heaterCapacity;
+
+        wallTempNew += (envTemp - wallTemp) * envWallTransfer / wallCapacity;
+        wallTempNew += (airTemp - wallTemp) * wallAirTransfer/ wallCapacity;
+
+        airTemp = airTempNew;
+        beerTemp = beerTempNew;
+        wallTemp = wallTempNew;
+        heaterTemp = heaterTempNew;
+    }
+
+    /* Advances the model by a time step with the heater and cooler held in the same state.
+     * update() takes explicit steps of 1 second. This integrates the same heat flows exactly, by solving the linear
+     * differential equation with a matrix exponential, so the step can have any length.
+     * Unlike update(), the exchange between beer and air is counted once for the beer.
+     */
+    void advance(ticks_millis_t millis, bool heaterActive, bool coolerActive){
+        updatePropagators();
+        double z[N] = {beerTemp, airTemp, wallTemp, heaterTemp,
+                       envTemp, heaterActive ? 1.0 : 0.0, coolerActive ? 1.0 : 0.0};
+        // exp(M (a + b)) = exp(M a) exp(M b), so apply the propagator of each set bit in the step
+        for(uint8_t bit = 0; millis != 0; bit++, millis >>= 1){
+            if(millis & 1){
+                const Matrix & p = propagators[bit];
+                double next[STATES];
+                for(int i = 0; i < STATES; i++){
+                    next[i] = 0;
+                    for(int j = 0; j < N; j++){
+                        next[i] += p[i][j] * z[j];
+                    }
+                }
+                memcpy(z, next, sizeof(next)); // inputs do not change
+            }
+        }
+        beerTemp = z[0];
+        airTemp = z[1];
+        wallTemp = z[2];
+        heaterTemp = z[3];
+    }
+
+    double beerTemp;
+    double airTemp;
+    double wallTemp;
+    double envTemp;
+    double heaterTemp;
+
+    double beerCapacity;
+    double airCapacity;
+    double wallCapacity;
+    double heaterCapacity;
+
+    double heaterPower;
+    double coolerPower;
+
+    double airBeerTransfer;
+    double wallAirTransfer;
+    double envWallTransfer;
+    double heaterAirTransfer;
+
+    double heaterToBeer;
+    double heaterToAir;
+
+private:
+    static const int STATES = 4; // beer, air, wall, heater
+    static const int INPUTS = 3; // environment temperature, heater on, cooler on
+    static const int N = STATES + INPUTS;
+    typedef double Matrix[N][N];
+
+    /* The state and the inputs form one vector z = [x; u], with dz/dt = M z and M = [A B; 0 0].
+     * The propagator over time t is exp(M t). The propagators for 2^k milliseconds are computed once.
+     * The model parameters are public and tests change them, so they are recomputed when the parameters change.
+     */
+    void updatePropagators(){
+        const double parameters[] = {beerCapacity, airCapacity, wallCapacity, heaterCapacity, heaterPower,
+                                     coolerPower, airBeerTransfer, wallAirTransfer, envWallTransfer, heaterAirTransfer};
+        static_assert(sizeof(parameters) == sizeof(cachedParameters), "cached parameters do not match");
+        if(memcmp(parameters, cachedParameters, sizeof(parameters)) == 0){
+            return;
+        }
+        memcpy(cachedParameters, parameters, sizeof(parameters));
+        for(uint8_t bit = 0; bit < 32; bit++){
+            exponential(ldexp(0.001, bit), propagators[bit]);
+        }
+    }
+
+    /* Computes exp(M h) with scaling and squaring of a taylor series */
+    void exponential(double h, Matrix & result) const {
+        Matrix m = {};
+        // beer
+        m[0][0] = -airBeerTransfer / beerCapacity;
+        m[0][1] = airBeerTransfer / beerCapacity;
+        // air
+        m[1][0] = airBeerTransfer / airCapacity;
+        m[1][1] = -(airBeerTransfer + wallAirTransfer + heaterAirTransfer) / airCapacity;
+        m[1][2] = wallAirTransfer / airCapacity;
+        m[1][3] = heaterAirTransfer / airCapacity;
+        // wall
+        m[2][1] = wallAirTransfer / wallCapacity;
+        m[2][2] = -(wallAirTransfer + envWallTransfer) / wallCapacity;
+        m[2][STATES + 0] = envWallTransfer / wallCapacity;
+        m[2][STATES + 2] = -coolerPower / wallCapacity;
+        // heater
+        m[3][1] = heaterAirTransfer / heaterCapacity;
+        m[3][3] = -heaterAirTransfer / heaterCapacity;
+        m[3][STATES + 1] = heaterPower / heaterCapacity;
+
+        // scale so the norm is below 0.5
+        double norm = 0;
+        for(int i = 0; i < N; i++){
+            double rowSum = 0;
+            for(int j = 0; j < N; j++){
+                m[i][j] *= h;
+                rowSum += fabs(m[i][j]);
+            }
+            norm = (rowSum > norm) ? rowSum : norm;
+        }
+        int squarings = 0;
+        while(norm > 0.5){
+            norm /= 2;
+            squarings++;
+        }
+        double scale = ldexp(1.0, -squarings);
+        Matrix term;
+        for(int i = 0; i < N; i++){
+            for(int j = 0; j < N; j++){
+                m[i][j] *= scale;
+                term[i][j] = (i == j) ? 1.0 : 0.0;
+                result[i][j] = term[i][j];
+            }
+        }
+        for(int k = 1; k <= 12; k++){
+            multiply(term, m, term);
+            for(int i = 0; i < N; i++){
+                for(int j = 0; j < N; j++){
+                    term[i][j] /= k;
+                    result[i][j] += term[i][j];
+                }
+            }
+        }
+        for(int s = 0; s < squarings; s++){
+            multiply(result, result, result);
+        }
+    }
+
+    static void multiply(const Matrix & a, const Matrix & b, Matrix & out){
+        Matrix product;
+        for(int i = 0; i < N; i++){
+            for(int j = 0; j < N; j++){
+                product[i][j] = 0;
+                for(int k = 0; k < N; k++){
+                    product[i][j] += a[i][k] * b[k][j];
+                }
+            }
+        }
+        memcpy(out, product, sizeof(product));
+    }
+
+    Matrix propagators[32];
+    double cachedParameters[10] = {};
+};
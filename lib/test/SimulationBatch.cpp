@@ -0,0 +1,203 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SimulationBatch.h"
+#include "Simulation.h"
+#include "Pid.h"
+#include "SetPoint.h"
+#include "TempSensorExternal.h"
+#include "ActuatorMocks.h"
+#include "ActuatorPwm.h"
+#include "ActuatorTimeLimited.h"
+#include "ActuatorMutexDriver.h"
+#include "ActuatorMutexGroup.h"
+#include "SensorSetPointPair.h"
+#include <math.h>
+
+/*
+ * Heater and cooler acting on beer or fridge air, like SimBeerHeaterCooler and SimFridgeHeaterCooler in SimulationTest.
+ * The sensors are external sensors without noise, so a run is fully deterministic.
+ */
+struct BatchChamber {
+    BatchChamber(const SimulationParams & params) :
+        fridgeSensor(true),
+        fridgeSet(params.setPoint),
+        fridge(fridgeSensor, fridgeSet),
+        beerSensor(true),
+        beerSet(params.setPoint),
+        beer(beerSensor, beerSet),
+        heaterPin(),
+        coolerPin(),
+        mutex(),
+        heaterMutex(heaterPin),
+        coolerMutex(coolerPin),
+        coolerTimeLimited(coolerMutex, params.coolerMinOnTime, params.coolerMinOffTime),
+        heater(heaterMutex, params.heaterPeriod),
+        cooler(coolerTimeLimited, params.coolerPeriod),
+        heaterPid(params.actOnBeer ? beer : fridge, heater),
+        coolerPid(params.actOnBeer ? beer : fridge, cooler)
+    {
+        sim.beerTemp = params.startTemp;
+        sim.airTemp = params.startTemp;
+        sim.wallTemp = params.startTemp;
+        sim.heaterTemp = params.startTemp;
+        sim.envTemp = params.envTemp;
+
+        configure(heaterPid, params.heater);
+        configure(coolerPid, params.cooler);
+        coolerPid.setActuatorIsNegative(true);
+
+        coolerMutex.setMutex(&mutex);
+        heaterMutex.setMutex(&mutex);
+        mutex.setDeadTime(params.deadTime);
+    }
+
+    static void configure(Pid & pid, const PidSettings & settings){
+        pid.setInputFilter(settings.inputFilter);
+        pid.setDerivativeFilter(settings.derivativeFilter);
+        pid.setConstants(settings.kp, settings.ti, settings.td);
+    }
+
+    // limit precision to mimic DS18B20 sensor, like TempSensorMock, but without noise
+    static temp_t quantize(double value){
+        const uint8_t shift = temp_t::fractional_bit_count - 4;
+        temp_t rounder;
+        rounder.setRaw(1 << (shift-1));
+        return ((temp_t(value) + rounder) >> shift) << shift;
+    }
+
+    void update(){
+        beerSensor.setValue(quantize(sim.beerTemp));
+        fridgeSensor.setValue(quantize(sim.airTemp));
+        heaterPid.update();
+        coolerPid.update();
+        cooler.update();
+        heater.update();
+        mutex.update();
+
+        sim.update(heaterPin.getState() == ActuatorDigital::State::Active,
+                   coolerPin.getState() == ActuatorDigital::State::Active);
+        ticks.incMillis(1000);
+    }
+
+    Simulation sim;
+    TempSensorExternal fridgeSensor;
+    SetPointSimple fridgeSet;
+    SensorSetPointPair fridge;
+    TempSensorExternal beerSensor;
+    SetPointSimple beerSet;
+    SensorSetPointPair beer;
+    ActuatorBool heaterPin;
+    ActuatorBool coolerPin;
+    ActuatorMutexGroup mutex;
+    ActuatorMutexDriver heaterMutex;
+    ActuatorMutexDriver coolerMutex;
+    ActuatorTimeLimited coolerTimeLimited;
+    ActuatorPwm heater;
+    ActuatorPwm cooler;
+    Pid heaterPid;
+    Pid coolerPid;
+};
+
+SimulationSummary SimulationBatch::runSingle(const SimulationParams & params){
+    // each run starts at time zero, ticks are thread local. Restore the time afterwards for the calling thread.
+    ticks_millis_t callerTime = ticks.millis();
+    ticks.reset();
+
+    SimulationSummary summary = simulate(params);
+
+    ticks.setMillis(callerTime);
+    return summary;
+}
+
+SimulationSummary SimulationBatch::simulate(const SimulationParams & params){
+    BatchChamber chamber(params);
+    const double & controlled = params.actOnBeer ? chamber.sim.beerTemp : chamber.sim.airTemp;
+    const bool stepUp = params.setPoint >= params.startTemp;
+
+    SimulationSummary summary = {0, false, 0.0, 0.0, 0.0};
+    uint32_t heaterOnTime = 0;
+    uint32_t coolerOnTime = 0;
+
+    for(uint32_t t = 0; t < params.duration; t++){
+        chamber.update();
+
+        double error = controlled - params.setPoint;
+        double pastSetPoint = stepUp ? error : -error;
+        if(pastSetPoint > summary.overshoot){
+            summary.overshoot = pastSetPoint;
+        }
+        if(fabs(error) > params.settledBand){
+            summary.settlingTime = t + 1;
+        }
+        if(chamber.heaterPin.getState() == ActuatorDigital::State::Active){
+            heaterOnTime++;
+        }
+        if(chamber.coolerPin.getState() == ActuatorDigital::State::Active){
+            coolerOnTime++;
+        }
+    }
+
+    summary.settled = summary.settlingTime < params.duration;
+    if(params.duration > 0){
+        summary.heaterDuty = 100.0 * heaterOnTime / params.duration;
+        summary.coolerDuty = 100.0 * coolerOnTime / params.duration;
+    }
+    return summary;
+}
+
+std::vector<SimulationSummary> SimulationBatch::run(const std::vector<SimulationParams> & params){
+    std::vector<SimulationSummary> results(params.size());
+    for(size_t i = 0; i < params.size(); i++){
+        // every task writes to its own element, results does not resize while tasks are running
+        pool.submit([&params, &results, i]{
+            results[i] = runSingle(params[i]);
+        });
+    }
+    pool.wait();
+    return results;
+}
+
+std::vector<SimulationParams> SimulationBatch::pidGrid(const SimulationParams & base,
+                                                       bool heater,
+                                                       const std::vector<temp_long_t> & kps,
+                                                       const std::vector<uint16_t> & tis,
+                                                       const std::vector<uint16_t> & tds,
+                                                       const std::vector<uint8_t> & filters,
+                                                       uint8_t derivativeFilterOffset){
+    std::vector<SimulationParams> grid;
+    grid.reserve(kps.size() * tis.size() * tds.size() * filters.size());
+    for(auto kp : kps){
+        for(auto ti : tis){
+            for(auto td : tds){
+                for(auto filter : filters){
+                    SimulationParams p = base;
+                    PidSettings & settings = heater ? p.heater : p.cooler;
+                    settings.kp = kp;
+                    settings.ti = ti;
+                    settings.td = td;
+                    settings.inputFilter = filter;
+                    settings.derivativeFilter = uint8_t((filter + derivativeFilterOffset < 6) ? filter + derivativeFilterOffset : 6);
+                    grid.push_back(p);
+                }
+            }
+        }
+    }
+    return grid;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "temperatureFormats.h"
+#include "Ticks.h"
+#include "WorkStealingPool.h"
+
+/**
+ * Settings for a single Pid in a batch simulation.
+ * A Kp of zero leaves the actuator of the Pid off.
+ */
+struct PidSettings {
+    temp_long_t kp;
+    uint16_t ti;
+    uint16_t td;
+    uint8_t inputFilter;
+    uint8_t derivativeFilter;
+};
+
+/**
+ * Parameter set for one batch simulation run.
+ * The fridge model from Simulation.h is started at startTemp and a heater and a cooler Pid, sharing a mutex group,
+ * control it to setPoint. This is the same step response as the SimulationTest cases, without writing a CSV file.
+ */
+struct SimulationParams {
+    SimulationParams() :
+        heater({temp_long_t(10.0), 600, 60, 1, 4}),
+        cooler({temp_long_t(10.0), 1800, 200, 1, 4}),
+        actOnBeer(false),
+        startTemp(20.0),
+        setPoint(20.0),
+        envTemp(20.0),
+        heaterPeriod(20),
+        coolerPeriod(1200),
+        coolerMinOnTime(120),
+        coolerMinOffTime(180),
+        deadTime(3600000),
+        duration(20000),
+        settledBand(0.25)
+    {}
+
+    PidSettings heater;
+    PidSettings cooler;
+    bool actOnBeer; // when true, the Pids act on beer temperature. When false, on fridge air temperature
+    double startTemp; // initial temperature of beer, air, walls and heater
+    double setPoint;
+    double envTemp;
+    uint16_t heaterPeriod; // PWM period in seconds
+    uint16_t coolerPeriod; // PWM period in seconds
+    ticks_seconds_t coolerMinOnTime;
+    ticks_seconds_t coolerMinOffTime;
+    ticks_millis_t deadTime; // mutex group dead time between heater and cooler
+    uint32_t duration; // simulated time in seconds, one update per second
+    double settledBand; // temperature is settled when it stays within this band around the setpoint
+};
+
+/**
+ * Summary of a batch simulation run, instead of the full time series.
+ */
+struct SimulationSummary {
+    uint32_t settlingTime; // seconds until the controlled temperature stays within the settled band
+    bool settled; // false when the temperature was outside the band at the end of the simulation
+    double overshoot; // maximum excursion past the setpoint, in the direction of the step
+    double heaterDuty; // percentage of time the heater pin was active
+    double coolerDuty; // percentage of time the cooler pin was active
+};
+
+/**
+ * Runs many independent plant + controller simulations in parallel.
+ * Each run creates its own objects inside a worker thread. The test platform ticks are thread local, so every run
+ * has its own clock starting at zero and results do not depend on scheduling or the number of threads.
+ */
+class SimulationBatch {
+public:
+    /**
+     * @param nrOfThreads number of worker threads, 0 to use all cores
+     */
+    SimulationBatch(unsigned nrOfThreads = 0) : pool(nrOfThreads) {}
+    ~SimulationBatch() = default;
+
+    /**
+     * Simulates all parameter sets and returns a summary for each, in the same order as the input.
+     */
+    std::vector<SimulationSummary> run(const std::vector<SimulationParams> & params);
+
+    /**
+     * Simulates a single parameter set in the calling thread.
+     */
+    static SimulationSummary runSingle(const SimulationParams & params);
+
+    /**
+     * Creates the cartesian product of the given Pid constants and filter settings, applied to either the heater or
+     * the cooler Pid of a base parameter set. Filter values are used for both the input and the derivative filter,
+     * the derivative filter offset by derivativeFilterOffset (limited to 6).
+     */
+    static std::vector<SimulationParams> pidGrid(const SimulationParams & base,
+                                                 bool heater,
+                                                 const std::vector<temp_long_t> & kps,
+                                                 const std::vector<uint16_t> & tis,
+                                                 const std::vector<uint16_t> & tds,
+                                                 const std::vector<uint8_t> & filters,
+                                                 uint8_t derivativeFilterOffset = 3);
+
+    unsigned threads() const {
+        return pool.size();
+    }
+
+private:
+    static SimulationSummary simulate(const SimulationParams & params);
+
+    WorkStealingPool pool;
+};
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "runner.h"
+#include "SimulationBatch.h"
+#include <atomic>
+#include <chrono>
+
+BOOST_AUTO_TEST_SUITE(SimulationBatchTest)
+
+BOOST_AUTO_TEST_CASE(work_stealing_pool_runs_all_tasks){
+    WorkStealingPool pool(4);
+    std::atomic<int> count(0);
+    for(int i = 0; i < 1000; i++){
+        pool.submit([&count]{ count++; });
+    }
+    pool.wait();
+    BOOST_CHECK_EQUAL(count, 1000);
+
+    // pool can be reused after waiting
+    for(int i = 0; i < 10; i++){
+        pool.submit([&count]{ count++; });
+    }
+    pool.wait();
+    BOOST_CHECK_EQUAL(count, 1010);
+}
+
+BOOST_AUTO_TEST_CASE(pid_grid_is_cartesian_product){
+    SimulationParams base;
+    auto grid = SimulationBatch::pidGrid(base, true, {5.0, 10.0}, {600, 1200, 1800}, {0, 60}, {1, 4});
+    BOOST_REQUIRE_EQUAL(grid.size(), 2u * 3u * 2u * 2u);
+    BOOST_CHECK_EQUAL(grid[0].heater.kp, temp_long_t(5.0));
+    BOOST_CHECK_EQUAL(grid[0].heater.ti, 600);
+    BOOST_CHECK_EQUAL(grid[0].heater.td, 0);
+    BOOST_CHECK_EQUAL(grid[0].heater.inputFilter, 1);
+    BOOST_CHECK_EQUAL(grid[0].heater.derivativeFilter, 4);
+    BOOST_CHECK_EQUAL(grid[1].heater.inputFilter, 4);
+    BOOST_CHECK_EQUAL(grid[1].heater.derivativeFilter, 6); // limited to 6
+    BOOST_CHECK_EQUAL(grid.back().heater.kp, temp_long_t(10.0));
+    BOOST_CHECK_EQUAL(grid.back().heater.ti, 1800);
+    BOOST_CHECK_EQUAL(grid.back().heater.td, 60);
+    BOOST_CHECK_EQUAL(grid.back().cooler.kp, base.cooler.kp); // cooler is untouched
+}
+
+BOOST_AUTO_TEST_CASE(heating_step_settles_without_cooler){
+    SimulationParams params;
+    params.startTemp = 19.0;
+    params.setPoint = 24.0;
+    params.envTemp = 16.0;
+    params.heater = {temp_long_t(10.0), 600, 60, 1, 4};
+    params.duration = 20000;
+
+    SimulationSummary result = SimulationBatch::runSingle(params);
+
+    BOOST_CHECK(result.settled);
+    BOOST_CHECK_LT(result.settlingTime, 10000u);
+    BOOST_CHECK_LT(result.overshoot, 1.0);
+    BOOST_CHECK_GT(result.heaterDuty, 0.0);
+    BOOST_CHECK_EQUAL(result.coolerDuty, 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_results_are_identical_to_sequential_results){
+    SimulationParams base;
+    base.startTemp = 19.0;
+    base.setPoint = 24.0;
+    base.envTemp = 16.0;
+    base.duration = 10000;
+    auto grid = SimulationBatch::pidGrid(base, true, {5.0, 10.0, 20.0}, {600, 1800}, {60}, {1, 2});
+
+    SimulationBatch batch(4);
+    auto start = std::chrono::steady_clock::now();
+    auto parallel = batch.run(grid);
+    auto parallelTime = std::chrono::steady_clock::now() - start;
+
+    BOOST_REQUIRE_EQUAL(parallel.size(), grid.size());
+    start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < grid.size(); i++){
+        SimulationSummary sequential = SimulationBatch::runSingle(grid[i]);
+        BOOST_CHECK_EQUAL(parallel[i].settlingTime, sequential.settlingTime);
+        BOOST_CHECK_EQUAL(parallel[i].settled, sequential.settled);
+        BOOST_CHECK_EQUAL(parallel[i].overshoot, sequential.overshoot);
+        BOOST_CHECK_EQUAL(parallel[i].heaterDuty, sequential.heaterDuty);
+        BOOST_CHECK_EQUAL(parallel[i].coolerDuty, sequential.coolerDuty);
+    }
+    auto sequentialTime = std::chrono::steady_clock::now() - start;
+
+    BOOST_TEST_MESSAGE("simulated " << grid.size() << " parameter sets on " << batch.threads() << " threads in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(parallelTime).count() << " ms, sequential: "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(sequentialTime).count() << " ms");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -39,6 +39,7 @@
 #include "SensorSetPointPair.h"
 #include "SetPointDelegate.h"
 
+#include "Simulation.h"
 #include "runner.h"
 #include <iostream>
 #include <fstream>
@@ -104,97 +105,6 @@ public:
     Pid beerToFridgePid;
 };
 
-/* This class simulates a fridge is a simple way:
- * There are 3 heat capacities: the beer itself, the air in the fridge and the fridge walls.
- * The heater heats the air in the fridge directly.
- * The cooler cools the fridge walls, which in turn cool the fridge air.
- * This causes an extra delay when cooling and a potential source of overshoot
- */
-
-
-struct Simulation{
-    Simulation(){
-        beerTemp = 20.0;
-        airTemp = 20.0;
-        wallTemp = 20.0;
-        envTemp = 20.0;
-        heaterTemp = 20.0;
-
-        beerCapacity = 4.2 * 1.0 * 20; // heat capacity water * density of water * 20L volume (in kJ per kelvin).
-        airCapacity = 1.005 * 1.225 * 0.200; // heat capacity of dry air * density of air * 200L volume (in kJ per kelvin).
-        // Moist air has only slightly higher heat capacity, 1.02 when saturated at 20C.
-        wallCapacity = 5.0; // just a guess
-        heaterCapacity = 1.0; // also a guess, to simulate that heater first heats itself, then starts heating the air
-
-        heaterPower = 0.1; // 100W, in kW.
-        coolerPower = 0.1; // 100W, in kW. Assuming 200W at 50% efficiency
-
-        airBeerTransfer= 1.0/300;
-        wallAirTransfer= 1.0/300;
-        heaterAirTransfer= 1.0/30;
-        envWallTransfer = 0.001; // losses to environment
-
-        heaterToBeer = 0.0; // ratio of heater transfered directly to beer instead of fridge air
-        heaterToAir = 1.0 - heaterToBeer;
-
-    }
-    virtual ~Simulation(){}
-
-    void update(bool heaterActive, bool coolerActive){
-        double beerTempNew = beerTemp;
-        double airTempNew = airTemp;
-        double wallTempNew = wallTemp;
-        double heaterTempNew = heaterTemp;
-
-        beerTempNew += (airTemp - beerTemp) * airBeerTransfer / beerCapacity;
-
-        if(heaterActive){
-            heaterTempNew += heaterPower / heaterCapacity;
-        }
-        if(coolerActive){
-            wallTempNew -= coolerPower / wallCapacity;
-        }
-
-        airTempNew += (heaterTemp - airTemp) * heaterAirTransfer / airCapacity;
-        airTempNew += (wallTemp - airTemp) * wallAirTransfer / airCapacity;
-        airTempNew += (beerTemp - airTemp) * airBeerTransfer / airCapacity;
-
-
-        beerTempNew += (airTemp - beerTemp) * airBeerTransfer / beerCapacity;
-
-        heaterTempNew += (airTemp - heaterTemp) * heaterAirTransfer / heaterCapacity;
-
-        wallTempNew += (envTemp - wallTemp) * envWallTransfer / wallCapacity;
-        wallTempNew += (airTemp - wallTemp) * wallAirTransfer/ wallCapacity;
-
-        airTemp = airTempNew;
-        beerTemp = beerTempNew;
-        wallTemp = wallTempNew;
-        heaterTemp = heaterTempNew;
-    }
-
-    double beerTemp;
-    double airTemp;
-    double wallTemp;
-    double envTemp;
-    double heaterTemp;
-
-    double beerCapacity;
-    double airCapacity;
-    double wallCapacity;
-    double heaterCapacity;
-
-    double heaterPower;
-    double coolerPower;
-
-    double airBeerTransfer;
-    double wallAirTransfer;
-    double envWallTransfer;
-    double heaterAirTransfer;
-
-    double heaterToBeer;
-    double heaterToAir;
-};
 
 /* Below are a few static setups that show how control can be set up.
  * The first 4 are simple: a single actuator, acting on beer or fridge temperature
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed size thread pool in which every worker owns a task queue.
+ * Tasks are distributed round robin over the queues. A worker takes tasks from the front of its own queue and
+ * steals from the back of the other queues when its own queue is empty, so long and short tasks even out.
+ * This is used on the host to run independent simulations on all cores.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    WorkStealingPool(unsigned nrOfWorkers = 0) :
+        queued(0),
+        pending(0),
+        nextQueue(0),
+        stopping(false)
+    {
+        if(nrOfWorkers == 0){
+            nrOfWorkers = std::thread::hardware_concurrency();
+        }
+        if(nrOfWorkers == 0){
+            nrOfWorkers = 1; // hardware_concurrency can return 0 if unknown
+        }
+        for(unsigned i = 0; i < nrOfWorkers; i++){
+            queues.emplace_back(new Queue());
+        }
+        for(unsigned i = 0; i < nrOfWorkers; i++){
+            workers.emplace_back(&WorkStealingPool::work, this, i);
+        }
+    }
+
+    ~WorkStealingPool(){
+        {
+            std::lock_guard<std::mutex> lock(stateLock);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for(auto & w : workers){
+            w.join();
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool & operator=(const WorkStealingPool &) = delete;
+
+    unsigned size() const {
+        return unsigned(workers.size());
+    }
+
+    // submit is not thread safe: tasks should be submitted from a single thread
+    void submit(Task task){
+        {
+            // count before pushing, so a worker never decrements below zero
+            std::lock_guard<std::mutex> lock(stateLock);
+            ++pending;
+            ++queued;
+        }
+        {
+            Queue & q = *queues[nextQueue];
+            std::lock_guard<std::mutex> lock(q.lock);
+            q.tasks.push_back(std::move(task));
+        }
+        nextQueue = (nextQueue + 1) % queues.size();
+        wakeUp.notify_one();
+    }
+
+    // blocks until all submitted tasks have finished
+    void wait(){
+        std::unique_lock<std::mutex> lock(stateLock);
+        finished.wait(lock, [this]{ return pending == 0; });
+    }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    bool pop(unsigned index, Task & task){
+        Queue & q = *queues[index];
+        std::lock_guard<std::mutex> lock(q.lock);
+        if(q.tasks.empty()){
+            return false;
+        }
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+
+    bool steal(unsigned index, Task & task){
+        for(size_t i = 1; i < queues.size(); i++){
+            Queue & q = *queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.lock);
+            if(!q.tasks.empty()){
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(unsigned index){
+        Task task;
+        while(true){
+            if(pop(index, task) || steal(index, task)){
+                --queued;
+                task();
+                task = nullptr;
+                std::lock_guard<std::mutex> lock(stateLock);
+                if(--pending == 0){
+                    finished.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(stateLock);
+            if(stopping && queued == 0){
+                return;
+            }
+            wakeUp.wait(lock, [this]{ return stopping || queued > 0; });
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex stateLock;
+    std::condition_variable wakeUp;
+    std::condition_variable finished;
+    std::atomic<size_t> queued; // tasks waiting in a queue
+    size_t pending; // tasks submitted, but not finished yet
+    size_t nextQueue;
+    bool stopping;
+};
@@ -23,6 +23,11 @@
 #include <iostream>
 #include <cstdio>
 #include <boost/test/output_test_stream.hpp>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <cmath>
+#include <string>
 using boost::test_tools::output_test_stream;
 
 BOOST_AUTO_TEST_SUITE( temperature_suite )
@@ -680,6 +685,195 @@ BOOST_AUTO_TEST_CASE(temp_disabled_or_invalid_prints_null){
     BOOST_REQUIRE_MESSAGE(strcmp(s1, s2) == 0, "\"" << s1 << "\" should be \"" << s2 << "\"" << " converting " << t);
 }
 
+// reference implementations of the saturating operators, as they were written before the overflow builtins were used
+template<typename T>
+int64_t referenceAdd(int64_t a, int64_t b) {
+    if (b > 0 && a > T::max_val - b) {
+        return T::max_val;
+    }
+    if (b < 0 && a < T::min_val - b) {
+        return T::min_val;
+    }
+    return a + b;
+}
+
+template<typename T>
+int64_t referenceSubtract(int64_t a, int64_t b) {
+    if (b < 0 && a > T::max_val + b) {
+        return T::max_val;
+    }
+    if (b > 0 && a < T::min_val + b) {
+        return T::min_val;
+    }
+    return a - b;
+}
+
+template<typename T>
+int64_t referenceMultiply(int64_t a, int64_t b) {
+    int64_t result = (a * b) >> T::fractional_bit_count;
+    return std::max(std::min(result, int64_t(T::max_val)), int64_t(T::min_val));
+}
+
+template<typename T>
+int64_t referenceDivide(int64_t a, int64_t b) {
+    return decltype(T().getRaw())((a << T::fractional_bit_count) / b);
+}
+
+template<typename T>
+void checkOperatorsMatchReference() {
+    typedef decltype(T().getRaw()) raw_t;
+    std::vector<int64_t> values = {
+        0, 1, -1, 2, -2, 255, 256, -256,
+        std::numeric_limits<raw_t>::min(), std::numeric_limits<raw_t>::min() + 1, std::numeric_limits<raw_t>::min() + 2,
+        std::numeric_limits<raw_t>::max(), std::numeric_limits<raw_t>::max() - 1,
+    };
+    // the edges of the 32 bit division fast path
+    int64_t narrow = int64_t(1) << (31 - T::fractional_bit_count);
+    for (int64_t v : {narrow - 1, narrow, narrow + 1}) {
+        if (v <= std::numeric_limits<raw_t>::max()) {
+            values.push_back(v);
+            values.push_back(-v);
+        }
+    }
+    srand(1);
+    for (int i = 0; i < 300; i++) {
+        raw_t r = raw_t((int64_t(rand()) << 16) ^ rand());
+        values.push_back(r);
+        values.push_back(r >> (rand() % 24)); // smaller values are more common
+    }
+
+    int mismatches = 0;
+    for (int64_t a : values) {
+        for (int64_t b : values) {
+            T x; x.setRaw(raw_t(a));
+            T y; y.setRaw(raw_t(b));
+            T result;
+
+            result = x; result += y;
+            mismatches += result.getRaw() != referenceAdd<T>(a, b);
+            result = x; result -= y;
+            mismatches += result.getRaw() != referenceSubtract<T>(a, b);
+            result = x; result *= y;
+            mismatches += result.getRaw() != referenceMultiply<T>(a, b);
+            if (b != 0) {
+                result = x; result /= y;
+                mismatches += result.getRaw() != referenceDivide<T>(a, b);
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(saturating_operators_match_reference){
+    checkOperatorsMatchReference<temp_t>();
+    checkOperatorsMatchReference<temp_long_t>();
+    checkOperatorsMatchReference<temp_precise_t>();
+}
+
+BOOST_AUTO_TEST_CASE(constants_are_converted_at_compile_time){
+    constexpr temp_t a(0.2);
+    constexpr temp_long_t b(-1000.5);
+    constexpr temp_precise_t c(0.001);
+    temp_t x = a;
+    temp_long_t y = b;
+    temp_precise_t z = c;
+    BOOST_CHECK_EQUAL(x.getRaw(), 51);
+    BOOST_CHECK_EQUAL(y.getRaw(), -256128);
+    BOOST_CHECK_EQUAL(z, temp_precise_t(0.001));
+}
+
+BOOST_AUTO_TEST_CASE(every_temp_round_trips_through_string){
+    int mismatches = 0;
+    for (int32_t raw = temp_t::min().getRaw() + 1; raw <= temp_t::max().getRaw(); raw++) {
+        temp_t t = temp_t::raw(raw);
+        char buf[12];
+        for (char format : {'C', 'F'}) {
+            temp_t back;
+            // 3 decimals in C or F is finer than half the resolution of temp_t
+            bool ok = back.fromTempString(t.toTempString(buf, 3, sizeof(buf), format, true), format, true);
+            mismatches += !ok || back != t;
+        }
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(long_and_precise_temps_round_trip_through_string){
+    srand(2);
+    int mismatches = 0;
+    for (int i = 0; i < 100000; i++) {
+        int32_t raw = int32_t((int64_t(rand()) << 16) ^ rand());
+        raw >>= rand() % 24; // smaller values are more common
+
+        temp_long_t l = temp_long_t::raw(raw);
+        temp_long_t lBack;
+        char buf[24];
+        mismatches += !lBack.fromString(l.toString(buf, 3, sizeof(buf))) || lBack != l;
+
+        temp_precise_t p = temp_precise_t::raw(raw);
+        temp_precise_t pBack;
+        mismatches += !pBack.fromString(p.toString(buf, 8, sizeof(buf))) || pBack != p;
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(parsing_decimals_rounds_to_nearest){
+    // rounding after each digit would give -32725 for -127.83 (-32724.48)
+    temp_t t;
+    BOOST_REQUIRE(t.fromString("-127.83"));
+    BOOST_CHECK_EQUAL(t.getRaw(), -32724);
+
+    srand(3);
+    int mismatches = 0;
+    for (int i = 0; i < 100000; i++) {
+        // up to 6 decimals cannot be halfway between two values with 8 fraction bits
+        int decimals = 1 + rand() % 6;
+        double scale = std::pow(10.0, decimals);
+        double value = std::round((rand() % 25000 - 12500) / 100.0 * scale) / scale;
+        char s[24];
+        snprintf(s, sizeof(s), "%.*f", decimals, value);
+        BOOST_REQUIRE(t.fromString(s));
+        mismatches += t.getRaw() != std::lround(value * 256);
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(batch_formatting_matches_formatting_one_by_one){
+    temp_t values[] = { 21.5, -3.25, temp_t::invalid(), 0.0, temp_t::max(), temp_t::min() + temp_t::raw(1), -0.001 };
+    const uint8_t count = sizeof(values) / sizeof(values[0]);
+    for (char format : {'C', 'F'}) {
+        char batch[128];
+        uint16_t written = temp_t::toTempStrings(values, count, batch, sizeof(batch), 2, ',', format, true);
+
+        std::string expected;
+        for (temp_t & v : values) {
+            char buf[12];
+            expected += v.toTempString(buf, 2, sizeof(buf), format, true);
+            expected += ',';
+        }
+        BOOST_CHECK_EQUAL(std::string(batch), expected);
+        BOOST_CHECK_EQUAL(written, expected.size());
+    }
+
+    // with \0 as separator, the buffer holds consecutive strings
+    char strings[32];
+    temp_t::toTempStrings(values, 2, strings, sizeof(strings), 1, '\0', 'C', true);
+    BOOST_CHECK_EQUAL(std::string(strings), "21.5");
+    BOOST_CHECK_EQUAL(std::string(strings + 5), "-3.3"); // rounded away from zero
+
+    temp_long_t longValues[] = { 1000.5, -250000.25 };
+    char longBatch[32];
+    temp_long_t::toStrings(longValues, 2, longBatch, sizeof(longBatch), 2, ' ');
+    BOOST_CHECK_EQUAL(std::string(longBatch), "1000.50 -250000.25 ");
+}
+
+BOOST_AUTO_TEST_CASE(batch_formatting_stops_at_the_first_value_that_does_not_fit){
+    temp_t values[] = { 21.5, -3.25, 10.0 };
+    char batch[13]; // room for two values and the \0
+    uint16_t written = temp_t::toTempStrings(values, 3, batch, sizeof(batch), 2, ',', 'C', true);
+    BOOST_CHECK_EQUAL(std::string(batch), "21.50,-3.25,");
+    BOOST_CHECK_EQUAL(written, 12u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
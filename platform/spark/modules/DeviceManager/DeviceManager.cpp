@@ -5,6 +5,7 @@
 
 #if !BREWPI_SIMULATE
 OneWire primaryOneWireBus(oneWirePin);
+OneWireTopology primaryOneWireTopology(primaryOneWireBus);
 #endif
 
 OneWire* DeviceManager::oneWireBus(uint8_t pin) {
@@ -15,6 +16,14 @@ OneWire* DeviceManager::oneWireBus(uint8_t pin) {
     return NULL;
 }
 
+OneWireTopology* DeviceManager::oneWireTopology(uint8_t pin) {
+#if !BREWPI_SIMULATE
+    if (pin==oneWirePin)
+            return &primaryOneWireTopology;
+#endif
+    return NULL;
+}
+
 
 int8_t  DeviceManager::enumerateActuatorPins(uint8_t offset)
 {
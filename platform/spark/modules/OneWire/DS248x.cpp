@@ -31,11 +31,6 @@ Updates:
 #include "spark_wiring_i2c.h"
 
 
-#define PTR_STATUS 0xf0
-#define PTR_READ 0xe1
-#define PTR_CONFIG 0xc3
-#define PTR_PORTCONFIG 0xb4 //DS2484 only
-
 //-------helpers
 
 void DS248x::setReadPtr(uint8_t readPtr) {
@@ -52,7 +47,7 @@ uint8_t DS248x::readByte() {
 
 uint8_t DS248x::wireReadStatus(bool setPtr) {
     if (setPtr)
-        setReadPtr(PTR_STATUS);
+        setReadPtr(DS248X_PTR_STATUS);
 
     return readByte();
 }
@@ -171,7 +166,7 @@ uint8_t DS248x::read() {
     Wire.write(DS248X_1WRB);
     Wire.endTransmission();
     busyWait();
-    setReadPtr(PTR_READ);
+    setReadPtr(DS248X_PTR_READ);
     return readByte();
 }
 
@@ -20,32 +20,7 @@
 
 #include <inttypes.h>
 #include "OneWireLowLevelInterface.h"
-
-#define DS248X_CONFIG_APU (0x1<<0)
-#define DS248X_CONFIG_PPM (0x1<<1)
-#define DS248X_CONFIG_SPU (0x1<<2)
-#define DS2484_CONFIG_WS  (0x1<<3)
-
-#define DS248X_STATUS_BUSY 	(0x1<<0)
-#define DS248X_STATUS_PPD 	(0x1<<1)
-#define DS248X_STATUS_SD	(0x1<<2)
-#define DS248X_STATUS_LL	(0x1<<3)
-#define DS248X_STATUS_RST	(0x1<<4)
-#define DS248X_STATUS_SBR	(0x1<<5)
-#define DS248X_STATUS_TSB	(0x1<<6)
-#define DS248X_STATUS_DIR	(0x1<<7)
-
-// I2C commands
-#define DS248X_DRST	0xf0 // Device Reset
-#define DS248X_WCFG	0xd2 // Write Configuration
-#define DS248X_CHSL	0xc3 // Channel Select (DS248X-800 only)
-#define DS248X_SRP	0xe1 // Set Read Pointer
-#define DS248X_1WRS	0xb4 // 1-Wire Reset
-#define DS248X_1WWB	0xa5 // 1-Wire Write Byte
-#define DS248X_1WRB	0x96 // 1-Wire Read Byte
-#define DS248X_1WSB	0x87 // 1-Wire Single Bit
-#define DS248X_1WT	0x78 // 1-Wire Triplet
-#define DS248X_ADJP	0xc3 // Adjust OneWire port config (DS2484 only))
+#include "DS248xRegisters.h"
 
 
 class DS248x /*: public OneWireLowLevelInterface */ {
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2017 BrewPi/Elco Jacobs.
+ *
+ * This file is part of BrewPi.
+ *
+ * BrewPi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BrewPi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BrewPi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "DS248xAsync.h"
+#include "spark_wiring_i2c.h"
+
+/**
+ * I2C access to a DS248x on the Wire bus, for DS248xAsync.
+ * The bus master must be initialized with the blocking DS248x driver first.
+ */
+class DS248xWire final : public DS248xI2C {
+public:
+    //Address is 0-3
+    DS248xWire(uint8_t address) : mAddress(0x18 | address) {}
+
+    void writeCommand(uint8_t command) override final {
+        Wire.beginTransmission(mAddress);
+        Wire.write(command);
+        Wire.endTransmission();
+    }
+
+    void writeCommand(uint8_t command, uint8_t parameter) override final {
+        Wire.beginTransmission(mAddress);
+        Wire.write(command);
+        Wire.write(parameter);
+        Wire.endTransmission();
+    }
+
+    uint8_t readRegister() override final {
+        Wire.requestFrom(mAddress, (uint8_t) 1);
+        return Wire.read();
+    }
+
+private:
+    uint8_t mAddress;
+};
@@ -39,6 +39,9 @@ inline void watchdogCheckin(){}
 #define BREWPI_DS2413 1
 #define BREWPI_DS2408 (PLATFORM_ID != 0)
 #define BREWPI_USE_WIFI (PLATFORM_ID != 0)
+#ifndef BREWPI_PROFILING
+#define BREWPI_PROFILING 0 // set to 1 to collect loop timing, see LoopProfiler.h
+#endif
 
 /**
  * Retrieves a pointer to the device id.
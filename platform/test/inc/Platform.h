@@ -12,7 +12,7 @@
 
 #define TWO_PI 6.283185307179586476925286766559
 
-#define ONEWIRE_NULL
+#define ONEWIRE_EMULATED // behaves like ONEWIRE_NULL on pins without an emulated bus
 
 #include <stdio.h> // for vsnprintf
 #include <stdint.h>
@@ -27,6 +27,11 @@ typedef uint8_t ticks_seconds_tiny_t;
 #define BREWPI_DS2413 1
 #define BREWPI_DS2408 1
 #define BREWPI_USE_WIFI 0
+#ifndef BREWPI_PROFILING
+#define BREWPI_PROFILING 1
+#endif
+// simulation batches run controllers on a thread pool, each with its own ticks and profiler
+#define PROFILER_THREAD_LOCAL thread_local
 
 #endif	/* PLATFORM_H */
 
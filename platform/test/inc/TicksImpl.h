@@ -1,5 +1,6 @@
 #pragma once
 #include <stdint.h>
 
-extern ExternalTicks ticks;
+// thread local, so simulations can run in parallel with each their own clock
+extern thread_local ExternalTicks ticks;
 extern NoOpDelay wait;
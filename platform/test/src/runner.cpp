@@ -46,7 +46,7 @@
 #include "Platform.h"
 #include "Ticks.h"
 
-ExternalTicks ticks;
+thread_local ExternalTicks ticks;
 NoOpDelay wait;
 
 // delay ms milliseconds and return current time afterwards